@@ -71,6 +71,22 @@ class analyzer
         return counts;
     }
 
+    /**
+     * Tokenizes a document into a feature_buffer that is reused across
+     * documents.
+     * @param doc The document to be tokenized
+     * @param buffer Cleared, then filled with the observed features and
+     *  their counts in the document, sorted by feature
+     */
+    template <class T>
+    void analyze(const corpus::document& doc, feature_buffer<T>& buffer)
+    {
+        buffer.clear();
+        featurizer feats{buffer};
+        tokenize(doc, feats);
+        buffer.sort();
+    }
+
     /**
      * Clones this analyzer.
      */
@@ -0,0 +1,300 @@
+/**
+ * @file feature_matrix.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_ANALYZERS_FEATURE_MATRIX_H_
+#define META_ANALYZERS_FEATURE_MATRIX_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "meta/analyzers/analyzer.h"
+#include "meta/config.h"
+#include "meta/corpus/document.h"
+#include "meta/parallel/parallel_for.h"
+#include "meta/util/array_view.h"
+
+namespace meta
+{
+namespace analyzers
+{
+
+/**
+ * A compressed sparse row (CSR) matrix of feature values for a batch of
+ * documents. Row i contains the features for the i-th document that was
+ * analyzed, with feature ids referring to positions in a vocabulary that
+ * is shared across all rows. The vocabulary is sorted, and the features
+ * within each row are sorted by id.
+ */
+template <class T>
+class feature_matrix
+{
+  public:
+    /**
+     * Constructs an empty feature_matrix.
+     */
+    feature_matrix() : offsets_(1, 0)
+    {
+        // nothing
+    }
+
+    /**
+     * Constructs a feature_matrix from its constituent arrays.
+     *
+     * @param offsets The starting position of each row in the id and
+     * value arrays, followed by the total number of non-zero entries
+     * @param ids The feature ids for each non-zero entry
+     * @param values The feature values for each non-zero entry
+     * @param vocab The feature strings, indexed by feature id
+     */
+    feature_matrix(std::vector<uint64_t>&& offsets, std::vector<uint64_t>&& ids,
+                   std::vector<T>&& values, std::vector<std::string>&& vocab)
+        : offsets_{std::move(offsets)},
+          ids_{std::move(ids)},
+          values_{std::move(values)},
+          vocab_{std::move(vocab)}
+    {
+        // nothing
+    }
+
+    /**
+     * @return the number of rows (documents) in the matrix
+     */
+    uint64_t rows() const
+    {
+        return offsets_.size() - 1;
+    }
+
+    /**
+     * @return the number of non-zero entries in the matrix
+     */
+    uint64_t nnz() const
+    {
+        return ids_.size();
+    }
+
+    /**
+     * @param row The row to obtain feature ids for
+     * @return the (sorted) feature ids for the given row
+     */
+    util::array_view<const uint64_t> features(uint64_t row) const
+    {
+        return {ids_.data() + offsets_[row], ids_.data() + offsets_[row + 1]};
+    }
+
+    /**
+     * @param row The row to obtain feature values for
+     * @return the feature values for the given row, parallel to
+     * features(row)
+     */
+    util::array_view<const T> values(uint64_t row) const
+    {
+        return {values_.data() + offsets_[row],
+                values_.data() + offsets_[row + 1]};
+    }
+
+    /**
+     * @param id The feature id to look up
+     * @return the feature string for the given id
+     */
+    const std::string& feature(uint64_t id) const
+    {
+        return vocab_[id];
+    }
+
+    /**
+     * @return the row offsets array
+     */
+    const std::vector<uint64_t>& offsets() const
+    {
+        return offsets_;
+    }
+
+    /**
+     * @return the feature ids array
+     */
+    const std::vector<uint64_t>& feature_ids() const
+    {
+        return ids_;
+    }
+
+    /**
+     * @return the feature values array
+     */
+    const std::vector<T>& values() const
+    {
+        return values_;
+    }
+
+    /**
+     * @return the shared vocabulary, indexed by feature id
+     */
+    const std::vector<std::string>& vocabulary() const
+    {
+        return vocab_;
+    }
+
+  private:
+    /// the starting position of each row, plus one past the last row
+    std::vector<uint64_t> offsets_;
+    /// the feature id of each non-zero entry
+    std::vector<uint64_t> ids_;
+    /// the value of each non-zero entry
+    std::vector<T> values_;
+    /// the feature strings, indexed by feature id
+    std::vector<std::string> vocab_;
+};
+
+namespace detail
+{
+/**
+ * The partial result of analyzing a contiguous block of documents on a
+ * single thread. Feature ids are local to the block.
+ */
+template <class T>
+struct feature_block
+{
+    /// the starting position of each row within this block
+    std::vector<uint64_t> offsets;
+    /// the block-local feature id of each non-zero entry
+    std::vector<uint64_t> ids;
+    /// the value of each non-zero entry
+    std::vector<T> values;
+    /// the feature strings, indexed by block-local id
+    std::vector<std::string> vocab;
+};
+}
+
+/**
+ * Analyzes a batch of documents in parallel, producing a single CSR
+ * feature_matrix with a shared vocabulary. Each worker thread tokenizes a
+ * contiguous block of the documents with its own clone of the analyzer,
+ * into a feature_buffer that it reuses for every document in the block;
+ * the block-local vocabularies are then merged, sorted, and used to remap
+ * the rows in parallel. The result does not depend on the number of
+ * threads used.
+ *
+ * @param ana The analyzer to use (it is cloned for each thread)
+ * @param begin The beginning of the range of documents
+ * @param end The end of the range of documents
+ * @param pool The thread_pool to run on
+ * @return a feature_matrix with one row per document, in order
+ */
+template <class T, class Iterator>
+feature_matrix<T> analyze_batch(const analyzer& ana, Iterator begin,
+                                Iterator end, parallel::thread_pool& pool)
+{
+    if (begin == end)
+        return {};
+
+    auto futures = parallel::for_each_block(
+        begin, end, pool, [&](Iterator first, Iterator last) {
+            auto local = ana.clone();
+            detail::feature_block<T> block;
+            hashing::probe_map<std::string, uint64_t> local_ids;
+            feature_buffer<T> counts;
+            for (; first != last; ++first)
+            {
+                block.offsets.push_back(block.ids.size());
+                local->analyze(*first, counts);
+                for (const auto& count : counts)
+                {
+                    auto it = local_ids.find(count.first);
+                    if (it == local_ids.end())
+                    {
+                        it = local_ids.emplace(count.first, block.vocab.size());
+                        block.vocab.push_back(count.first);
+                    }
+                    block.ids.push_back(it->value());
+                    block.values.push_back(count.second);
+                }
+            }
+            return block;
+        });
+
+    std::vector<detail::feature_block<T>> blocks;
+    blocks.reserve(futures.size());
+    for (auto& fut : futures)
+        blocks.emplace_back(fut.get());
+
+    // merge the block-local vocabularies into one sorted vocabulary
+    std::vector<std::string> vocab;
+    uint64_t num_rows = 0;
+    uint64_t nnz = 0;
+    for (const auto& block : blocks)
+    {
+        vocab.insert(vocab.end(), block.vocab.begin(), block.vocab.end());
+        num_rows += block.offsets.size();
+        nnz += block.ids.size();
+    }
+    std::sort(vocab.begin(), vocab.end());
+    vocab.erase(std::unique(vocab.begin(), vocab.end()), vocab.end());
+
+    std::vector<uint64_t> offsets(num_rows + 1);
+    std::vector<uint64_t> ids(nnz);
+    std::vector<T> values(nnz);
+    offsets.back() = nnz;
+
+    // remap each block to the global vocabulary, writing its rows into
+    // their final positions in the output arrays
+    std::vector<std::future<void>> remaps;
+    uint64_t row_start = 0;
+    uint64_t nnz_start = 0;
+    for (const auto& block : blocks)
+    {
+        remaps.emplace_back(pool.submit_task([&, row_start, nnz_start]() {
+            std::vector<uint64_t> global_ids(block.vocab.size());
+            for (uint64_t i = 0; i < block.vocab.size(); ++i)
+            {
+                auto it = std::lower_bound(vocab.begin(), vocab.end(),
+                                           block.vocab[i]);
+                global_ids[i]
+                    = static_cast<uint64_t>(std::distance(vocab.begin(), it));
+            }
+
+            // rows are sorted by feature text, as is the vocabulary, so
+            // their global ids are already in order
+            for (uint64_t r = 0; r < block.offsets.size(); ++r)
+                offsets[row_start + r] = nnz_start + block.offsets[r];
+            for (uint64_t i = 0; i < block.ids.size(); ++i)
+            {
+                ids[nnz_start + i] = global_ids[block.ids[i]];
+                values[nnz_start + i] = block.values[i];
+            }
+        }));
+        row_start += block.offsets.size();
+        nnz_start += block.ids.size();
+    }
+    for (auto& fut : remaps)
+        fut.get();
+
+    return {std::move(offsets), std::move(ids), std::move(values),
+            std::move(vocab)};
+}
+
+/**
+ * Analyzes a batch of documents in parallel, producing a single CSR
+ * feature_matrix with a shared vocabulary.
+ *
+ * @param ana The analyzer to use (it is cloned for each thread)
+ * @param docs The documents to analyze
+ * @param pool The thread_pool to run on
+ * @return a feature_matrix with one row per document, in order
+ */
+template <class T>
+feature_matrix<T> analyze_batch(const analyzer& ana,
+                                const std::vector<corpus::document>& docs,
+                                parallel::thread_pool& pool)
+{
+    return analyze_batch<T>(ana, docs.begin(), docs.end(), pool);
+}
+}
+}
+#endif
@@ -10,7 +10,11 @@
 #ifndef META_ANALYZERS_FEATURIZER_H_
 #define META_ANALYZERS_FEATURIZER_H_
 
+#include <algorithm>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include "meta/config.h"
 #include "meta/hashing/probe_map.h"
@@ -34,6 +38,158 @@ class featurizer_exception : public std::runtime_error
 template <class T>
 using feature_map = hashing::probe_map<std::string, T>;
 
+/**
+ * Collects the feature values of one document at a time in a buffer that
+ * is reused from document to document, instead of building a new
+ * feature_map for each one. Each distinct feature gets one entry, found
+ * through an index of slots that is also reused, and sort() then orders
+ * the entries by feature.
+ */
+template <class T>
+class feature_buffer
+{
+  public:
+    using value_type = std::pair<std::string, T>;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    /**
+     * Constructs an empty feature_buffer.
+     */
+    feature_buffer() : size_{0}, doc_{1}
+    {
+        // nothing
+    }
+
+    /**
+     * @param feat The feature identifier
+     * @return a reference to the value of the feature's entry, which is
+     * added (with a value of zero) if the feature has no entry yet
+     */
+    T& operator[](const std::string& feat)
+    {
+        if (2 * (size_ + 1) > slots_.size())
+            grow();
+
+        auto idx = find(feat);
+        if (slots_[idx].doc == doc_)
+            return entries_[slots_[idx].entry].second;
+
+        slots_[idx] = {doc_, size_};
+        if (size_ == entries_.size())
+            entries_.emplace_back();
+        auto& entry = entries_[size_++];
+        // reuses the storage of the entries of earlier documents
+        entry.first.assign(feat);
+        entry.second = T{};
+        return entry.second;
+    }
+
+    /**
+     * Sorts the entries by feature. No features may be added afterwards
+     * until the buffer is cleared.
+     */
+    void sort()
+    {
+        auto last = entries_.begin() + static_cast<std::ptrdiff_t>(size_);
+        std::sort(entries_.begin(), last,
+                  [](const value_type& a, const value_type& b)
+                  {
+                      return a.first < b.first;
+                  });
+    }
+
+    /**
+     * Removes all entries, keeping their storage for later documents.
+     */
+    void clear()
+    {
+        size_ = 0;
+        // every slot is stamped with an earlier document, so all of them
+        // are now free
+        ++doc_;
+    }
+
+    /**
+     * @return the number of entries
+     */
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    /**
+     * @return whether there are no entries
+     */
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    /**
+     * @return an iterator to the first entry
+     */
+    const_iterator begin() const
+    {
+        return entries_.begin();
+    }
+
+    /**
+     * @return an iterator past the last entry
+     */
+    const_iterator end() const
+    {
+        return entries_.begin() + static_cast<std::ptrdiff_t>(size_);
+    }
+
+  private:
+    /**
+     * A slot in the index, which is in use if it is stamped with the
+     * current document.
+     */
+    struct slot
+    {
+        uint64_t doc;
+        std::size_t entry;
+    };
+
+    /**
+     * Linearly probes the index (whose size is a power of two).
+     * @return the slot holding feat's entry, or the free slot where it
+     * belongs
+     */
+    std::size_t find(const std::string& feat) const
+    {
+        auto mask = slots_.size() - 1;
+        auto idx = hash_(feat) & mask;
+        while (slots_[idx].doc == doc_
+               && entries_[slots_[idx].entry].first != feat)
+            idx = (idx + 1) & mask;
+        return idx;
+    }
+
+    /**
+     * Doubles the size of the index and reinserts the current entries.
+     */
+    void grow()
+    {
+        slots_.assign(std::max<std::size_t>(16, 2 * slots_.size()),
+                      slot{0, 0});
+        for (std::size_t i = 0; i < size_; ++i)
+            slots_[find(entries_[i].first)] = {doc_, i};
+    }
+
+    /// The entries, of which only the first size_ are in use
+    std::vector<value_type> entries_;
+    /// The number of entries in use
+    std::size_t size_;
+    /// The index of the entry of each feature in the current document
+    std::vector<slot> slots_;
+    /// The stamp of the current document, which is never 0
+    uint64_t doc_;
+    /// The hash function for features
+    hashing::hash<> hash_;
+};
+
 /**
  * Used by analyzers to increment feature values in feature_maps
  * generically. This class type-erases a specific map class so that the
@@ -46,13 +202,26 @@ class featurizer
      * Constructs a featurizer that writes to a specific feature_map.
      */
     template <class T>
-    featurizer(feature_map<T>& map) : map_{make_unique<concrete_map<T>>(map)}
+    featurizer(feature_map<T>& map)
+        : map_{make_unique<concrete_map<feature_map<T>, T>>(map)}
     {
         static_assert(std::is_same<T, uint64_t>::value
                           || std::is_same<T, double>::value,
                       "feature map must map to uint64_t or double");
     }
 
+    /**
+     * Constructs a featurizer that appends to a feature_buffer.
+     */
+    template <class T>
+    featurizer(feature_buffer<T>& buffer)
+        : map_{make_unique<concrete_map<feature_buffer<T>, T>>(buffer)}
+    {
+        static_assert(std::is_same<T, uint64_t>::value
+                          || std::is_same<T, double>::value,
+                      "feature buffer must hold uint64_t or double");
+    }
+
     /**
      * Observes the given feature occurring val times.
      * @param feat The feature identifier
@@ -80,11 +249,11 @@ class featurizer
         virtual ~map_concept() = default;
     };
 
-    template <class T>
+    template <class Map, class T>
     class concrete_map : public map_concept
     {
       public:
-        concrete_map(feature_map<T>& map) : map_(map)
+        concrete_map(Map& map) : map_(map)
         {
             // nothing
         }
@@ -103,7 +272,7 @@ class featurizer
         }
 
       private:
-        feature_map<T>& map_;
+        Map& map_;
     };
 
     std::unique_ptr<map_concept> map_;
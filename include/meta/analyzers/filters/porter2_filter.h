@@ -10,11 +10,17 @@
 #define META_FILTER_PORTER2_FILTER_H_
 
 #include <memory>
-#include "meta/analyzers/token_stream.h"
+#include "meta/analyzers/filter_factory.h"
+#include "meta/caching/direct_mapped_cache.h"
 #include "meta/util/clonable.h"
 #include "meta/util/optional.h"
 #include "meta/util/string_view.h"
 
+namespace cpptoml
+{
+class table;
+}
+
 namespace meta
 {
 namespace analyzers
@@ -26,18 +32,33 @@ namespace filters
  * Filter that stems words according to the porter2 stemmer algorithm.
  * Requires that the porter2 stemmer project submodule be downloaded.
  *
+ * Since token frequencies are heavily skewed, recently computed stems are
+ * memoized in a small direct-mapped cache. Each filter (and thus each
+ * analyzer clone) owns its own cache, so no synchronization is needed.
+ *
  * Required config parameters: none.
- * Optional config parameters: none.
+ * Optional config parameters:
+ * ~~~toml
+ * cache-size = 4096 # number of cached stems; 0 disables the cache
+ * ~~~
  */
 class porter2_filter : public util::clonable<token_stream, porter2_filter>
 {
   public:
+    /// The type of the cache used to memoize stems
+    using cache_type = caching::direct_mapped_cache<std::string, std::string>;
+
+    /// The default number of stems to cache
+    const static constexpr uint64_t default_cache_size = 4096;
+
     /**
      * Constructs a new porter2 stemmer filter, reading tokens from
      * the given source.
      * @param source The source to construct the filter from
+     * @param cache_size The number of stems to memoize
      */
-    porter2_filter(std::unique_ptr<token_stream> source);
+    porter2_filter(std::unique_ptr<token_stream> source,
+                   uint64_t cache_size = default_cache_size);
 
     /**
      * Copy constructor.
@@ -61,6 +82,11 @@ class porter2_filter : public util::clonable<token_stream, porter2_filter>
      */
     operator bool() const override;
 
+    /**
+     * @return the stem cache, which can be used to inspect its hit rate
+     */
+    const cache_type& cache() const;
+
     /// Identifier for this filter
     const static util::string_view id;
 
@@ -75,7 +101,18 @@ class porter2_filter : public util::clonable<token_stream, porter2_filter>
 
     /// The buffered next token.
     util::optional<std::string> token_;
+
+    /// Recently computed stems
+    cache_type cache_;
 };
+
+/**
+ * Specialization of the factory method used to create porter2_filters.
+ */
+template <>
+std::unique_ptr<token_stream>
+    make_filter<porter2_filter>(std::unique_ptr<token_stream>,
+                                const cpptoml::table&);
 }
 }
 }
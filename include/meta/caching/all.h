@@ -1,4 +1,6 @@
 #include "meta/caching/dblru_cache.h"
+#include "meta/caching/direct_mapped_cache.h"
 #include "meta/caching/no_evict_cache.h"
 #include "meta/caching/shard_cache.h"
 #include "meta/caching/splay_cache.h"
+#include "meta/caching/tinylfu_cache.h"
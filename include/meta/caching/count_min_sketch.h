@@ -0,0 +1,96 @@
+/**
+ * @file count_min_sketch.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_CACHING_COUNT_MIN_SKETCH_H_
+#define META_CACHING_COUNT_MIN_SKETCH_H_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/hashing/hash.h"
+
+namespace meta
+{
+namespace caching
+{
+
+/**
+ * An approximate frequency counter for use as a cache admission policy
+ * (as in TinyLFU). Each key increments one small saturating counter in
+ * each of four rows; its estimated frequency is the minimum of those
+ * counters. To let the estimates follow a changing workload, every
+ * counter is halved once the number of increments reaches ten times the
+ * width of the sketch.
+ *
+ * @see https://arxiv.org/abs/1512.00727
+ */
+template <class Key, class Hash = hashing::hash<>>
+class count_min_sketch
+{
+  public:
+    /**
+     * @param width The number of counters per row, which should be
+     * around the number of distinct keys expected to be tracked (rounded
+     * up to a power of two)
+     */
+    count_min_sketch(uint64_t width);
+
+    /**
+     * Records an occurrence of the key.
+     * @param key The key observed
+     */
+    void increment(const Key& key);
+
+    /**
+     * @param key The key to look up
+     * @return the estimated (recent) frequency of the key
+     */
+    uint8_t frequency(const Key& key) const;
+
+    /**
+     * Resets all counters to zero.
+     */
+    void clear();
+
+  private:
+    /// The number of rows (independent hash functions)
+    const static constexpr std::size_t depth = 4;
+
+    /// The largest value a counter can hold
+    const static constexpr uint8_t max_count = 15;
+
+    /**
+     * @param key The key to locate
+     * @return the position of the key's counter in each row
+     */
+    std::array<uint64_t, depth> positions(const Key& key) const;
+
+    /**
+     * Halves every counter.
+     */
+    void age();
+
+    /// The counters for every row, stored row after row
+    std::vector<uint8_t> counters_;
+    /// The number of counters per row
+    uint64_t width_;
+    /// The number of increments since the last aging
+    uint64_t additions_;
+    /// The number of increments that triggers aging
+    uint64_t sample_size_;
+    /// The hash function for keys
+    Hash hash_;
+};
+}
+}
+
+#include "meta/caching/count_min_sketch.tcc"
+#endif
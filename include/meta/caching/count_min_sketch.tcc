@@ -0,0 +1,93 @@
+/**
+ * @file count_min_sketch.tcc
+ * @author Chase Geigle
+ */
+
+#include <algorithm>
+
+#include "meta/caching/count_min_sketch.h"
+
+namespace meta
+{
+namespace caching
+{
+
+template <class Key, class Hash>
+const constexpr std::size_t count_min_sketch<Key, Hash>::depth;
+
+template <class Key, class Hash>
+const constexpr uint8_t count_min_sketch<Key, Hash>::max_count;
+
+template <class Key, class Hash>
+count_min_sketch<Key, Hash>::count_min_sketch(uint64_t width)
+    : width_{1}, additions_{0}
+{
+    while (width_ < width)
+        width_ <<= 1;
+    counters_.resize(width_ * depth, 0);
+    sample_size_ = 10 * width_;
+}
+
+template <class Key, class Hash>
+auto count_min_sketch<Key, Hash>::positions(const Key& key) const
+    -> std::array<uint64_t, depth>
+{
+    // derive the row hashes from one hash by double hashing
+    auto hash = static_cast<uint64_t>(hash_(key));
+    auto h1 = hash & 0xffffffff;
+    auto h2 = (hash >> 32) | 1;
+
+    std::array<uint64_t, depth> pos;
+    for (std::size_t row = 0; row < depth; ++row)
+        pos[row] = row * width_ + ((h1 + row * h2) & (width_ - 1));
+    return pos;
+}
+
+template <class Key, class Hash>
+void count_min_sketch<Key, Hash>::increment(const Key& key)
+{
+    auto pos = positions(key);
+
+    // conservative update: only raise the counters that are at the
+    // current minimum, which reduces the overestimation of rare keys
+    auto min = max_count;
+    for (const auto& p : pos)
+        min = std::min(min, counters_[p]);
+    if (min == max_count)
+        return;
+
+    for (const auto& p : pos)
+    {
+        if (counters_[p] == min)
+            ++counters_[p];
+    }
+
+    if (++additions_ == sample_size_)
+        age();
+}
+
+template <class Key, class Hash>
+uint8_t count_min_sketch<Key, Hash>::frequency(const Key& key) const
+{
+    auto min = max_count;
+    for (const auto& p : positions(key))
+        min = std::min(min, counters_[p]);
+    return min;
+}
+
+template <class Key, class Hash>
+void count_min_sketch<Key, Hash>::age()
+{
+    for (auto& counter : counters_)
+        counter >>= 1;
+    additions_ /= 2;
+}
+
+template <class Key, class Hash>
+void count_min_sketch<Key, Hash>::clear()
+{
+    std::fill(counters_.begin(), counters_.end(), 0);
+    additions_ = 0;
+}
+}
+}
@@ -21,6 +21,7 @@
 #include <functional>
 #include <vector>
 
+#include "meta/caching/maps/concurrent_map.h"
 #include "meta/caching/maps/locking_map.h"
 #include "meta/util/optional.h"
 
@@ -43,12 +44,13 @@ namespace caching
  *
  * It is assumed that the Maps are internally synchronized (i.e., they
  * contain a mutex or have some other way of guaranteeing concurrency
- * safety).
+ * safety). The default, concurrent_map, allows finds to proceed without
+ * taking any locks.
  *
  * @see https://issues.apache.org/jira/browse/LUCENE-2075
  */
 template <class Key, class Value,
-          template <class, class> class Map = locking_map>
+          template <class, class> class Map = concurrent_map>
 class dblru_cache
 {
   public:
@@ -0,0 +1,111 @@
+/**
+ * @file direct_mapped_cache.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_DIRECT_MAPPED_CACHE_H_
+#define META_DIRECT_MAPPED_CACHE_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/hashing/hash.h"
+#include "meta/meta.h"
+#include "meta/util/optional.h"
+
+namespace meta
+{
+namespace caching
+{
+
+/**
+ * A fixed-size, direct-mapped memoization cache. Each key hashes to
+ * exactly one slot, and inserting a key evicts whatever was previously
+ * in that slot. There is no locking: this cache is intended to be owned
+ * by a single thread (e.g., a member of a token_stream, which is cloned
+ * per thread during analysis) where it can absorb the head of a Zipfian
+ * request distribution at the cost of a hash and a key comparison.
+ *
+ * The cache also keeps track of the number of hits and misses observed
+ * by find() so that its effectiveness can be monitored.
+ */
+template <class Key, class Value, class Hash = hashing::hash<>>
+class direct_mapped_cache
+{
+  public:
+    /**
+     * Creates a direct-mapped cache with (at least) the given number of
+     * slots. The number of slots is rounded up to the next power of two;
+     * a size of zero creates a cache that never stores anything.
+     *
+     * @param size The number of slots in the cache
+     */
+    direct_mapped_cache(uint64_t size = 4096);
+
+    /**
+     * @param key The key to insert
+     * @param value The value to insert
+     *
+     * Any existing entry in the slot for the key will be overwritten.
+     */
+    void insert(const Key& key, const Value& value);
+
+    /**
+     * @param key The key to find the corresponding value for
+     * @return an optional containing the associated value for the given
+     * key, if found
+     */
+    util::optional<Value> find(const Key& key);
+
+    /**
+     * @return the number of slots in the cache
+     */
+    uint64_t capacity() const;
+
+    /**
+     * @return the number of calls to find() that succeeded
+     */
+    uint64_t hits() const;
+
+    /**
+     * @return the number of calls to find() that failed
+     */
+    uint64_t misses() const;
+
+    /**
+     * @return the fraction of calls to find() that succeeded
+     */
+    double hit_rate() const;
+
+    /**
+     * Empties the cache and resets the hit and miss counters.
+     */
+    void clear();
+
+  private:
+    /**
+     * @param key The key to locate
+     * @return the slot the given key maps to
+     */
+    uint64_t slot(const Key& key) const;
+
+    /// the slots of the cache
+    std::vector<util::optional<std::pair<Key, Value>>> slots_;
+    /// the number of successful finds
+    uint64_t hits_;
+    /// the number of unsuccessful finds
+    uint64_t misses_;
+    /// the hash function used to map keys to slots
+    Hash hash_;
+};
+}
+}
+
+#include "meta/caching/direct_mapped_cache.tcc"
+#endif
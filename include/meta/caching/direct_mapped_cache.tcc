@@ -0,0 +1,93 @@
+/**
+ * @file direct_mapped_cache.tcc
+ * @author Chase Geigle
+ */
+
+#include "meta/caching/direct_mapped_cache.h"
+
+namespace meta
+{
+namespace caching
+{
+
+template <class Key, class Value, class Hash>
+direct_mapped_cache<Key, Value, Hash>::direct_mapped_cache(uint64_t size)
+    : hits_{0}, misses_{0}
+{
+    if (size == 0)
+        return;
+
+    uint64_t capacity = 1;
+    while (capacity < size)
+        capacity <<= 1;
+    slots_.resize(capacity);
+}
+
+template <class Key, class Value, class Hash>
+uint64_t direct_mapped_cache<Key, Value, Hash>::slot(const Key& key) const
+{
+    return static_cast<uint64_t>(hash_(key)) & (slots_.size() - 1);
+}
+
+template <class Key, class Value, class Hash>
+void direct_mapped_cache<Key, Value, Hash>::insert(const Key& key,
+                                                   const Value& value)
+{
+    if (slots_.empty())
+        return;
+    slots_[slot(key)] = std::make_pair(key, value);
+}
+
+template <class Key, class Value, class Hash>
+util::optional<Value> direct_mapped_cache<Key, Value, Hash>::find(const Key& key)
+{
+    if (!slots_.empty())
+    {
+        const auto& entry = slots_[slot(key)];
+        if (entry && entry->first == key)
+        {
+            ++hits_;
+            return entry->second;
+        }
+    }
+    ++misses_;
+    return util::nullopt;
+}
+
+template <class Key, class Value, class Hash>
+uint64_t direct_mapped_cache<Key, Value, Hash>::capacity() const
+{
+    return slots_.size();
+}
+
+template <class Key, class Value, class Hash>
+uint64_t direct_mapped_cache<Key, Value, Hash>::hits() const
+{
+    return hits_;
+}
+
+template <class Key, class Value, class Hash>
+uint64_t direct_mapped_cache<Key, Value, Hash>::misses() const
+{
+    return misses_;
+}
+
+template <class Key, class Value, class Hash>
+double direct_mapped_cache<Key, Value, Hash>::hit_rate() const
+{
+    auto total = hits_ + misses_;
+    if (total == 0)
+        return 0.0;
+    return static_cast<double>(hits_) / total;
+}
+
+template <class Key, class Value, class Hash>
+void direct_mapped_cache<Key, Value, Hash>::clear()
+{
+    for (auto& entry : slots_)
+        entry = util::nullopt;
+    hits_ = 0;
+    misses_ = 0;
+}
+}
+}
@@ -0,0 +1,253 @@
+/**
+ * @file concurrent_map.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_CONCURRENT_MAP_H_
+#define META_CONCURRENT_MAP_H_
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/hashing/hash.h"
+#include "meta/parallel/epoch_domain.h"
+#include "meta/util/optional.h"
+
+namespace meta
+{
+namespace caching
+{
+
+/**
+ * A hash map designed for caches that are read far more often than they
+ * are written, like the maps inside dblru_cache. It is a drop-in
+ * replacement for locking_map (minus iteration).
+ *
+ * Keys are split across a number of stripes, each of which is an open
+ * addressing (linear probing) table of atomic pointers to immutable (key,
+ * value) nodes. Writers take the mutex of a single stripe; readers take
+ * no locks at all: they load the stripe's current table and the nodes in
+ * it and copy the value out of a node that can no longer change. A
+ * stripe's table is only allocated on its first insert.
+ *
+ * Tables replaced when a stripe grows and nodes replaced or erased are
+ * retired to a per-stripe list rather than freed, since readers may still
+ * be looking at them. They are reclaimed by epoch (see
+ * parallel::epoch_domain): each reading thread announces the epoch its
+ * read started in, in memory of its own, and a writer frees the retired
+ * memory that every read in progress started after. Reads therefore
+ * write nothing shared, and retired memory is freed by the next write
+ * once the reads that were in progress when it was retired are done,
+ * however many reads have started since.
+ */
+template <class Key, class Value>
+class concurrent_map
+{
+  public:
+    /// The default number of stripes
+    const static constexpr std::size_t default_num_stripes = 16;
+
+    /**
+     * @param num_stripes The number of independently locked stripes to
+     * split the keys across (rounded up to a power of two)
+     */
+    explicit concurrent_map(std::size_t num_stripes = default_num_stripes);
+
+    /**
+     * concurrent_map may be move constructed.
+     */
+    concurrent_map(concurrent_map&&);
+
+    /**
+     * concurrent_map may be assigned.
+     * @return the current concurrent_map
+     */
+    concurrent_map& operator=(concurrent_map rhs);
+
+    /**
+     * Frees all tables and nodes.
+     */
+    ~concurrent_map();
+
+    /**
+     * Swaps the current instance of concurrent_map with the parameter.
+     * This is not thread safe.
+     *
+     * @param other the map to swap with
+     */
+    void swap(concurrent_map& other);
+
+    /**
+     * Inserts a given (key, value) pair into the map, replacing any
+     * existing value for the key.
+     * @param key
+     * @param value
+     */
+    void insert(const Key& key, const Value& value);
+
+    /**
+     * Inserts a (key, value) pair into the map, using in-place
+     * construction. Like std::unordered_map::emplace, an existing value
+     * for the key is not replaced.
+     *
+     * @param args the parameters to be used for creating the (key,
+     * value) pair
+     */
+    template <class... Args>
+    void emplace(Args&&... args);
+
+    /**
+     * Removes a key from the map.
+     * @param key the key to remove
+     * @return whether the key was in the map
+     */
+    bool erase(const Key& key);
+
+    /**
+     * Finds a value in the map without taking any locks. If it exists,
+     * the optional will be engaged, otherwise, it will be disengaged.
+     *
+     * @param key the key to find the corresponding value for
+     * @return an optional that may contain the value, if found
+     */
+    util::optional<Value> find(const Key& key) const;
+
+    /**
+     * @return the number of elements in the map
+     */
+    uint64_t size() const;
+
+    /**
+     * @return the number of stripes
+     */
+    std::size_t num_stripes() const;
+
+    /**
+     * @return the number of replaced tables and replaced or erased nodes
+     * that have not been freed yet
+     */
+    uint64_t num_retired() const;
+
+  private:
+    /// An immutable (key, value) pair
+    struct node
+    {
+        template <class... Args>
+        node(Args&&... args) : kv(std::forward<Args>(args)...)
+        {
+            // nothing
+        }
+
+        std::pair<const Key, Value> kv;
+    };
+
+    /// A power-of-two sized table of node pointers
+    struct table
+    {
+        table(std::size_t capacity) : slots(capacity)
+        {
+            for (auto& slot : slots)
+                slot.store(nullptr, std::memory_order_relaxed);
+        }
+
+        std::vector<std::atomic<node*>> slots;
+    };
+
+    /// Memory that has been unlinked but may still be read
+    template <class T>
+    struct retired
+    {
+        /// The tag from parallel::epoch_domain::retire()
+        uint64_t epoch;
+        /// The memory to free
+        std::unique_ptr<T> ptr;
+    };
+
+    /// An independently locked portion of the map
+    struct stripe
+    {
+        stripe();
+        ~stripe();
+
+        /// The current table, read by lock-free readers (null until the
+        /// first insert)
+        std::atomic<table*> current;
+        /// The number of nodes in the current table
+        std::atomic<uint64_t> size;
+        /// The number of slots holding a node or a tombstone
+        uint64_t used;
+        /// Synchronizes writers
+        std::mutex mutex;
+        /// Tables that have been replaced but may still be read, oldest
+        /// first
+        std::vector<retired<table>> retired_tables;
+        /// Nodes that have been replaced but may still be read, oldest
+        /// first
+        std::vector<retired<node>> retired_nodes;
+    };
+
+    /// The initial number of slots in each stripe's table
+    const static constexpr std::size_t initial_capacity = 16;
+
+    /**
+     * @return the marker left in the slot of an erased node; it is never
+     * dereferenced
+     */
+    static node* tombstone();
+
+    /**
+     * Inserts a node into the map while holding its stripe's lock.
+     * @param n The node to insert
+     * @param hash The hash of the node's key
+     * @param replace Whether to replace an existing node for the key
+     */
+    void insert_node(std::unique_ptr<node> n, uint64_t hash, bool replace);
+
+    /**
+     * Rebuilds a stripe's table without its tombstones, doubling its
+     * capacity if it is more than a quarter full. Must be called with the
+     * stripe's lock held.
+     */
+    void grow(stripe& s);
+
+    /**
+     * Retires a table or node that has just been unlinked from a stripe.
+     * Must be called with the stripe's lock held.
+     */
+    template <class T>
+    static void retire(std::vector<retired<T>>& list, T* ptr);
+
+    /**
+     * Frees the retired tables and nodes of a stripe that no read in
+     * progress can be looking at. Must be called with the stripe's lock
+     * held.
+     */
+    static void reclaim(stripe& s);
+
+    /**
+     * @param hash The hash of a key
+     * @return the stripe responsible for the key
+     */
+    stripe& stripe_for(uint64_t hash) const;
+
+    /// The hash function used for keys
+    hashing::hash<> hash_;
+
+    /// The number of stripes (a power of two)
+    std::size_t num_stripes_;
+
+    /// The stripes
+    std::unique_ptr<stripe[]> stripes_;
+};
+}
+}
+
+#include "meta/caching/maps/concurrent_map.tcc"
+#endif
@@ -0,0 +1,320 @@
+/**
+ * @file concurrent_map.tcc
+ */
+
+#include <algorithm>
+
+#include "meta/caching/maps/concurrent_map.h"
+#include "meta/util/shim.h"
+
+namespace meta
+{
+namespace caching
+{
+
+// Readers and writers use sequentially consistent operations on the
+// epochs, the table pointers, and the slots. A read that announces an
+// epoch later than a retired node or table's tag loaded the epoch after
+// the writer advanced it, which was after the unlink, so the read cannot
+// see it; reads that announce their epoch after the writer looks are
+// ordered after the unlink as well.
+
+template <class Key, class Value>
+const constexpr std::size_t concurrent_map<Key, Value>::default_num_stripes;
+
+template <class Key, class Value>
+const constexpr std::size_t concurrent_map<Key, Value>::initial_capacity;
+
+template <class Key, class Value>
+concurrent_map<Key, Value>::stripe::stripe()
+    : current{nullptr}, size{0}, used{0}
+{
+    // nothing
+}
+
+template <class Key, class Value>
+concurrent_map<Key, Value>::stripe::~stripe()
+{
+    auto tbl = current.load();
+    if (!tbl)
+        return;
+    for (auto& slot : tbl->slots)
+    {
+        auto n = slot.load();
+        if (n != tombstone())
+            delete n;
+    }
+    delete tbl;
+}
+
+template <class Key, class Value>
+concurrent_map<Key, Value>::concurrent_map(std::size_t num_stripes)
+    : num_stripes_{1}
+{
+    while (num_stripes_ < num_stripes)
+        num_stripes_ *= 2;
+    stripes_ = make_unique<stripe[]>(num_stripes_);
+}
+
+template <class Key, class Value>
+concurrent_map<Key, Value>::concurrent_map(concurrent_map&& other)
+    : hash_{std::move(other.hash_)},
+      num_stripes_{other.num_stripes_},
+      stripes_{std::move(other.stripes_)}
+{
+    // nothing
+}
+
+template <class Key, class Value>
+concurrent_map<Key, Value>::~concurrent_map() = default;
+
+template <class Key, class Value>
+concurrent_map<Key, Value>& concurrent_map<Key, Value>::
+operator=(concurrent_map rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+template <class Key, class Value>
+void concurrent_map<Key, Value>::swap(concurrent_map& other)
+{
+    std::swap(hash_, other.hash_);
+    std::swap(num_stripes_, other.num_stripes_);
+    std::swap(stripes_, other.stripes_);
+}
+
+template <class Key, class Value>
+auto concurrent_map<Key, Value>::tombstone() -> node*
+{
+    static char marker;
+    return reinterpret_cast<node*>(&marker);
+}
+
+template <class Key, class Value>
+auto concurrent_map<Key, Value>::stripe_for(uint64_t hash) const -> stripe&
+{
+    // the high bits pick the stripe, the low bits pick the slot
+    return stripes_[(hash >> 32) & (num_stripes_ - 1)];
+}
+
+template <class Key, class Value>
+void concurrent_map<Key, Value>::insert(const Key& key, const Value& value)
+{
+    auto hash = static_cast<uint64_t>(hash_(key));
+    insert_node(make_unique<node>(key, value), hash, true);
+}
+
+template <class Key, class Value>
+template <class... Args>
+void concurrent_map<Key, Value>::emplace(Args&&... args)
+{
+    auto n = make_unique<node>(std::forward<Args>(args)...);
+    auto hash = static_cast<uint64_t>(hash_(n->kv.first));
+    insert_node(std::move(n), hash, false);
+}
+
+template <class Key, class Value>
+void concurrent_map<Key, Value>::insert_node(std::unique_ptr<node> n,
+                                             uint64_t hash, bool replace)
+{
+    auto& s = stripe_for(hash);
+    std::lock_guard<std::mutex> lock{s.mutex};
+
+    // keep the load factor (counting tombstones) at or below 1/2 so
+    // probes stay short and readers always reach an empty slot
+    auto tbl = s.current.load(std::memory_order_relaxed);
+    if (!tbl || (s.used + 1) * 2 > tbl->slots.size())
+    {
+        grow(s);
+        tbl = s.current.load(std::memory_order_relaxed);
+    }
+
+    auto mask = tbl->slots.size() - 1;
+    std::atomic<node*>* free_slot = nullptr;
+    for (auto idx = hash & mask;; idx = (idx + 1) & mask)
+    {
+        auto& slot = tbl->slots[idx];
+        auto existing = slot.load(std::memory_order_relaxed);
+        if (existing == tombstone())
+        {
+            if (!free_slot)
+                free_slot = &slot;
+            continue;
+        }
+
+        if (!existing)
+        {
+            if (!free_slot)
+            {
+                free_slot = &slot;
+                ++s.used;
+            }
+            free_slot->store(n.release());
+            s.size.fetch_add(1, std::memory_order_relaxed);
+            break;
+        }
+
+        if (existing->kv.first == n->kv.first)
+        {
+            if (!replace)
+                return;
+            slot.store(n.release());
+            // readers may still hold the old node
+            retire(s.retired_nodes, existing);
+            break;
+        }
+    }
+    reclaim(s);
+}
+
+template <class Key, class Value>
+bool concurrent_map<Key, Value>::erase(const Key& key)
+{
+    auto hash = static_cast<uint64_t>(hash_(key));
+    auto& s = stripe_for(hash);
+    std::lock_guard<std::mutex> lock{s.mutex};
+
+    auto tbl = s.current.load(std::memory_order_relaxed);
+    if (!tbl)
+        return false;
+
+    auto mask = tbl->slots.size() - 1;
+    for (auto idx = hash & mask;; idx = (idx + 1) & mask)
+    {
+        auto& slot = tbl->slots[idx];
+        auto existing = slot.load(std::memory_order_relaxed);
+        if (!existing)
+            return false;
+        if (existing != tombstone() && existing->kv.first == key)
+        {
+            // the tombstone keeps probes for later keys going
+            slot.store(tombstone());
+            s.size.fetch_sub(1, std::memory_order_relaxed);
+            retire(s.retired_nodes, existing);
+            reclaim(s);
+            return true;
+        }
+    }
+}
+
+template <class Key, class Value>
+void concurrent_map<Key, Value>::grow(stripe& s)
+{
+    auto old_tbl = s.current.load(std::memory_order_relaxed);
+    auto capacity = initial_capacity;
+    if (old_tbl)
+    {
+        capacity = old_tbl->slots.size();
+        if (s.size.load(std::memory_order_relaxed) * 4 >= capacity)
+            capacity *= 2;
+    }
+
+    auto new_tbl = make_unique<table>(capacity);
+    auto mask = capacity - 1;
+    if (old_tbl)
+    {
+        for (const auto& slot : old_tbl->slots)
+        {
+            auto n = slot.load(std::memory_order_relaxed);
+            if (!n || n == tombstone())
+                continue;
+
+            auto idx = static_cast<uint64_t>(hash_(n->kv.first)) & mask;
+            while (new_tbl->slots[idx].load(std::memory_order_relaxed))
+                idx = (idx + 1) & mask;
+            new_tbl->slots[idx].store(n, std::memory_order_relaxed);
+        }
+    }
+    s.used = s.size.load(std::memory_order_relaxed);
+
+    // publishing the new table makes its contents visible to readers;
+    // readers may still be probing the old one
+    s.current.store(new_tbl.release());
+    if (old_tbl)
+        retire(s.retired_tables, old_tbl);
+}
+
+template <class Key, class Value>
+template <class T>
+void concurrent_map<Key, Value>::retire(std::vector<retired<T>>& list,
+                                        T* ptr)
+{
+    auto epoch = parallel::epoch_domain::global().retire();
+    list.push_back(retired<T>{epoch, std::unique_ptr<T>{ptr}});
+}
+
+template <class Key, class Value>
+void concurrent_map<Key, Value>::reclaim(stripe& s)
+{
+    if (s.retired_tables.empty() && s.retired_nodes.empty())
+        return;
+
+    // the lists are in the order the memory was retired, so everything
+    // before the first entry that may still be read can go
+    auto min_epoch = parallel::epoch_domain::global().min_active();
+    auto free_before = [&](auto& list)
+    {
+        auto first = std::find_if(list.begin(), list.end(),
+                                  [&](const auto& r)
+                                  {
+                                      return r.epoch >= min_epoch;
+                                  });
+        list.erase(list.begin(), first);
+    };
+    free_before(s.retired_tables);
+    free_before(s.retired_nodes);
+}
+
+template <class Key, class Value>
+util::optional<Value> concurrent_map<Key, Value>::find(const Key& key) const
+{
+    auto hash = static_cast<uint64_t>(hash_(key));
+    auto& s = stripe_for(hash);
+    parallel::epoch_domain::read_guard guard{
+        parallel::epoch_domain::global()};
+
+    auto tbl = s.current.load();
+    if (!tbl)
+        return util::nullopt;
+
+    auto mask = tbl->slots.size() - 1;
+    for (auto idx = hash & mask;; idx = (idx + 1) & mask)
+    {
+        auto n = tbl->slots[idx].load();
+        if (!n)
+            return util::nullopt;
+        if (n != tombstone() && n->kv.first == key)
+            return n->kv.second;
+    }
+}
+
+template <class Key, class Value>
+uint64_t concurrent_map<Key, Value>::size() const
+{
+    uint64_t total = 0;
+    for (std::size_t i = 0; i < num_stripes_; ++i)
+        total += stripes_[i].size.load(std::memory_order_relaxed);
+    return total;
+}
+
+template <class Key, class Value>
+std::size_t concurrent_map<Key, Value>::num_stripes() const
+{
+    return num_stripes_;
+}
+
+template <class Key, class Value>
+uint64_t concurrent_map<Key, Value>::num_retired() const
+{
+    uint64_t total = 0;
+    for (std::size_t i = 0; i < num_stripes_; ++i)
+    {
+        std::lock_guard<std::mutex> lock{stripes_[i].mutex};
+        total += stripes_[i].retired_tables.size()
+                 + stripes_[i].retired_nodes.size();
+    }
+    return total;
+}
+}
+}
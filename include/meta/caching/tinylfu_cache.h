@@ -0,0 +1,198 @@
+/**
+ * @file tinylfu_cache.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_CACHING_TINYLFU_CACHE_H_
+#define META_CACHING_TINYLFU_CACHE_H_
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "meta/caching/count_min_sketch.h"
+#include "meta/caching/weigher.h"
+#include "meta/config.h"
+#include "meta/util/optional.h"
+#include "meta/util/shim.h"
+
+namespace meta
+{
+namespace caching
+{
+
+/**
+ * A cache bounded by the total number of bytes its values occupy rather
+ * than by the number of entries, as determined by a Weigher (see
+ * default_weigher). Entries are kept in least-recently-used order.
+ *
+ * Once the cache is full, a new entry is only admitted if it has been
+ * requested more often (recently) than every entry that would have to be
+ * evicted to make room for it, as estimated by a count_min_sketch of all
+ * requests (the TinyLFU admission policy). This keeps a scan over many
+ * rarely used keys from flushing out the frequently used ones.
+ *
+ * The cache keeps counters of its hits, misses, evictions, and rejected
+ * insertions so that its effectiveness can be monitored. It is internally
+ * synchronized.
+ *
+ * @see https://arxiv.org/abs/1512.00727
+ */
+template <class Key, class Value, class Weigher = default_weigher<Value>>
+class tinylfu_cache
+{
+  public:
+    /**
+     * @param max_bytes The maximum total weight of the values in the cache
+     * @param expected_entries The approximate number of distinct keys
+     * whose frequencies should be tracked (sizes the frequency sketch)
+     * @param weigher The function used to weigh values
+     */
+    tinylfu_cache(uint64_t max_bytes, uint64_t expected_entries = 4096,
+                  Weigher weigher = Weigher{});
+
+    /**
+     * tinylfu_cache may be move constructed
+     */
+    tinylfu_cache(tinylfu_cache&&) = default;
+
+    /**
+     * tinylfu_cache may be move assigned
+     */
+    tinylfu_cache& operator=(tinylfu_cache&&) = default;
+
+    /**
+     * Inserts the given key, value pair into the cache, if the admission
+     * policy allows it. An existing value for the key is replaced without
+     * going through the admission policy again, unless the new value is
+     * larger than the whole cache (in which case the old one is kept).
+     *
+     * @param key The key to insert
+     * @param value The value to insert
+     */
+    void insert(const Key& key, const Value& value);
+
+    /**
+     * Records a request for the key and finds its value.
+     *
+     * @param key The key to find the corresponding value for
+     * @return an optional containing the associated value for the given
+     * key, if found
+     */
+    util::optional<Value> find(const Key& key);
+
+    /**
+     * @return the number of entries in the cache
+     */
+    uint64_t size() const;
+
+    /**
+     * @return the total weight of the values in the cache
+     */
+    uint64_t bytes() const;
+
+    /**
+     * @return the maximum total weight of the values in the cache
+     */
+    uint64_t max_bytes() const;
+
+    /**
+     * @return the number of calls to find() that succeeded
+     */
+    uint64_t hits() const;
+
+    /**
+     * @return the number of calls to find() that failed
+     */
+    uint64_t misses() const;
+
+    /**
+     * @return the fraction of calls to find() that succeeded
+     */
+    double hit_rate() const;
+
+    /**
+     * @return the number of entries evicted to make room for others
+     */
+    uint64_t evictions() const;
+
+    /**
+     * @return the number of insertions refused by the admission policy
+     * (or because the value alone was larger than the cache)
+     */
+    uint64_t rejections() const;
+
+    /**
+     * Empties the cache and resets the frequency sketch and counters.
+     */
+    void clear();
+
+  private:
+    /// An entry in the cache
+    struct entry
+    {
+        Key key;
+        Value value;
+        uint64_t weight;
+    };
+
+    using list_type = std::list<entry>;
+
+    /**
+     * All of the state of the cache, kept behind a pointer so the cache
+     * is movable despite its mutex.
+     */
+    struct state
+    {
+        state(uint64_t max_bytes, uint64_t expected_entries, Weigher weigher);
+
+        /// Synchronizes all access
+        std::mutex mutex;
+        /// Entries, from most to least recently used
+        list_type lru;
+        /// Locates the entry for each key
+        std::unordered_map<Key, typename list_type::iterator> index;
+        /// Estimated request frequencies
+        count_min_sketch<Key> sketch;
+        /// Weighs values
+        Weigher weigher;
+        /// The total weight of the entries
+        uint64_t bytes;
+        /// The maximum total weight of the entries
+        uint64_t max_bytes;
+        /// The number of successful finds
+        uint64_t hits;
+        /// The number of unsuccessful finds
+        uint64_t misses;
+        /// The number of evicted entries
+        uint64_t evictions;
+        /// The number of refused insertions
+        uint64_t rejections;
+    };
+
+    /**
+     * Removes an entry from the cache. Must be called with the lock held.
+     * @param it The entry to remove
+     */
+    void erase(typename list_type::iterator it);
+
+    /// The state of the cache
+    std::unique_ptr<state> state_;
+};
+
+/**
+ * A tinylfu_cache that uses the default_weigher, for use where a cache
+ * taking two template parameters is needed (e.g., cached_index).
+ */
+template <class Key, class Value>
+using default_tinylfu_cache = tinylfu_cache<Key, Value>;
+}
+}
+
+#include "meta/caching/tinylfu_cache.tcc"
+#endif
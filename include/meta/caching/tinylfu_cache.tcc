@@ -0,0 +1,204 @@
+/**
+ * @file tinylfu_cache.tcc
+ * @author Chase Geigle
+ */
+
+#include "meta/caching/tinylfu_cache.h"
+
+namespace meta
+{
+namespace caching
+{
+
+template <class Key, class Value, class Weigher>
+tinylfu_cache<Key, Value, Weigher>::state::state(uint64_t max_size,
+                                                 uint64_t expected_entries,
+                                                 Weigher weigh)
+    : sketch{expected_entries},
+      weigher(std::move(weigh)),
+      bytes{0},
+      max_bytes{max_size},
+      hits{0},
+      misses{0},
+      evictions{0},
+      rejections{0}
+{
+    // nothing
+}
+
+template <class Key, class Value, class Weigher>
+tinylfu_cache<Key, Value, Weigher>::tinylfu_cache(uint64_t max_bytes,
+                                                  uint64_t expected_entries,
+                                                  Weigher weigher)
+    : state_{make_unique<state>(max_bytes, expected_entries,
+                                std::move(weigher))}
+{
+    // nothing
+}
+
+template <class Key, class Value, class Weigher>
+void tinylfu_cache<Key, Value, Weigher>::erase(
+    typename list_type::iterator it)
+{
+    state_->bytes -= it->weight;
+    state_->index.erase(it->key);
+    state_->lru.erase(it);
+}
+
+template <class Key, class Value, class Weigher>
+void tinylfu_cache<Key, Value, Weigher>::insert(const Key& key,
+                                                const Value& value)
+{
+    auto weight = state_->weigher(value);
+
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    if (weight > state_->max_bytes)
+    {
+        ++state_->rejections;
+        return;
+    }
+
+    auto existing = state_->index.find(key);
+    if (existing != state_->index.end())
+    {
+        // the key was already admitted, so its new value replaces the old
+        // one without being checked again, and makes room for itself from
+        // the least recently used entries
+        auto it = existing->second;
+        state_->bytes = state_->bytes - it->weight + weight;
+        it->value = value;
+        it->weight = weight;
+        state_->lru.splice(state_->lru.begin(), state_->lru, it);
+        while (state_->bytes > state_->max_bytes)
+        {
+            erase(std::prev(state_->lru.end()));
+            ++state_->evictions;
+        }
+        return;
+    }
+
+    // find the least recently used entries that would have to go to make
+    // room, and only evict them if the candidate is more popular than all
+    // of them
+    if (state_->bytes + weight > state_->max_bytes)
+    {
+        auto candidate_freq = state_->sketch.frequency(key);
+        auto needed = state_->bytes + weight - state_->max_bytes;
+        uint64_t freed = 0;
+        auto victim = state_->lru.end();
+        while (freed < needed)
+        {
+            --victim;
+            if (state_->sketch.frequency(victim->key) >= candidate_freq)
+            {
+                ++state_->rejections;
+                return;
+            }
+            freed += victim->weight;
+        }
+
+        while (victim != state_->lru.end())
+        {
+            auto next = std::next(victim);
+            erase(victim);
+            ++state_->evictions;
+            victim = next;
+        }
+    }
+
+    state_->lru.push_front(entry{key, value, weight});
+    state_->index.emplace(key, state_->lru.begin());
+    state_->bytes += weight;
+}
+
+template <class Key, class Value, class Weigher>
+util::optional<Value> tinylfu_cache<Key, Value, Weigher>::find(const Key& key)
+{
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    state_->sketch.increment(key);
+
+    auto it = state_->index.find(key);
+    if (it == state_->index.end())
+    {
+        ++state_->misses;
+        return util::nullopt;
+    }
+
+    ++state_->hits;
+    state_->lru.splice(state_->lru.begin(), state_->lru, it->second);
+    return it->second->value;
+}
+
+template <class Key, class Value, class Weigher>
+uint64_t tinylfu_cache<Key, Value, Weigher>::size() const
+{
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    return state_->lru.size();
+}
+
+template <class Key, class Value, class Weigher>
+uint64_t tinylfu_cache<Key, Value, Weigher>::bytes() const
+{
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    return state_->bytes;
+}
+
+template <class Key, class Value, class Weigher>
+uint64_t tinylfu_cache<Key, Value, Weigher>::max_bytes() const
+{
+    return state_->max_bytes;
+}
+
+template <class Key, class Value, class Weigher>
+uint64_t tinylfu_cache<Key, Value, Weigher>::hits() const
+{
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    return state_->hits;
+}
+
+template <class Key, class Value, class Weigher>
+uint64_t tinylfu_cache<Key, Value, Weigher>::misses() const
+{
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    return state_->misses;
+}
+
+template <class Key, class Value, class Weigher>
+double tinylfu_cache<Key, Value, Weigher>::hit_rate() const
+{
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    auto total = state_->hits + state_->misses;
+    if (total == 0)
+        return 0.0;
+    return static_cast<double>(state_->hits) / total;
+}
+
+template <class Key, class Value, class Weigher>
+uint64_t tinylfu_cache<Key, Value, Weigher>::evictions() const
+{
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    return state_->evictions;
+}
+
+template <class Key, class Value, class Weigher>
+uint64_t tinylfu_cache<Key, Value, Weigher>::rejections() const
+{
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    return state_->rejections;
+}
+
+template <class Key, class Value, class Weigher>
+void tinylfu_cache<Key, Value, Weigher>::clear()
+{
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    state_->lru.clear();
+    state_->index.clear();
+    state_->sketch.clear();
+    state_->bytes = 0;
+    state_->hits = 0;
+    state_->misses = 0;
+    state_->evictions = 0;
+    state_->rejections = 0;
+}
+}
+}
@@ -0,0 +1,72 @@
+/**
+ * @file weigher.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_CACHING_WEIGHER_H_
+#define META_CACHING_WEIGHER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "meta/config.h"
+
+namespace meta
+{
+namespace caching
+{
+
+namespace detail
+{
+template <class T>
+auto weigh(const T& value, int) -> decltype(uint64_t{value.bytes_used()})
+{
+    return value.bytes_used();
+}
+
+template <class T>
+uint64_t weigh(const T&, long)
+{
+    return sizeof(T);
+}
+
+inline uint64_t weigh(const std::string& str, int)
+{
+    return sizeof(str) + str.capacity();
+}
+
+template <class T>
+uint64_t weigh(const std::shared_ptr<T>& ptr, int)
+{
+    return sizeof(ptr) + (ptr ? weigh(*ptr, 0) : 0);
+}
+}
+
+/**
+ * The default function used by byte-budgeted caches to determine how
+ * many bytes a value occupies. Values with a `bytes_used()` member
+ * function (like postings_data) report their own size; std::strings are
+ * weighed by their capacity; std::shared_ptrs are weighed by what they
+ * point to; everything else is weighed by its sizeof.
+ */
+template <class Value>
+struct default_weigher
+{
+    /**
+     * @param value The value to weigh
+     * @return the (approximate) number of bytes the value occupies
+     */
+    uint64_t operator()(const Value& value) const
+    {
+        return detail::weigh(value, 0);
+    }
+};
+}
+}
+#endif
@@ -19,12 +19,65 @@
 #include "meta/meta.h"
 
 #include "meta/classify/multiclass_dataset.h"
+#include "meta/learn/streaming_dataset.h"
 
 namespace meta
 {
 namespace classify
 {
 
+/**
+ * A multiclass_dataset that is read from a forward_index a batch at a
+ * time.
+ */
+using streaming_multiclass_dataset = learn::streaming_dataset<multiclass_dataset>;
+
+/**
+ * Creates a streaming_multiclass_dataset that decodes its batches from a
+ * forward_index.
+ *
+ * @param idx The index to read documents from
+ * @param docs The ids of the documents in the dataset
+ * @param batch_size The number of documents in each batch
+ * @return the dataset
+ */
+template <class Index>
+std::unique_ptr<streaming_multiclass_dataset>
+make_streaming_dataset(Index& idx, std::vector<doc_id> docs,
+                       uint64_t batch_size)
+{
+    using iterator = streaming_multiclass_dataset::iterator;
+    return make_unique<streaming_multiclass_dataset>(
+        std::move(docs), batch_size, [idx](iterator begin, iterator end)
+        {
+            return multiclass_dataset{idx, begin, end,
+                                      printing::no_progress_trait{}};
+        });
+}
+
+/**
+ * This trains a classifier in an online fashion on one pass over a
+ * streaming dataset. The next batch is read in the background while the
+ * classifier trains on the current one.
+ *
+ * @param cls The classifier to train. This must be a classifier
+ * supporting online learning (e.g., sgd or an ensemble of sgd)
+ * @param data The training data
+ */
+template <class Classifier>
+void batch_train(Classifier& cls, streaming_multiclass_dataset& data)
+{
+    uint64_t i = 0;
+    while (auto batch = data.next())
+    {
+        LOG(progress) << "Training batch " << ++i << "/" << data.num_batches()
+                      << '\n'
+                      << ENDLG;
+        cls.train(*batch);
+    }
+    LOG(progress) << '\n' << ENDLG;
+}
+
 /**
  * This trains a classifier in an online fashion, using batches of size
  * batch_size from the training_set.
@@ -42,24 +95,8 @@ template <class Index, class Classifier>
 void batch_train(Index& idx, Classifier& cls,
                  const std::vector<doc_id>& training_set, uint64_t batch_size)
 {
-    using diff_type = decltype(training_set.begin())::difference_type;
-
-    // integer-math ceil(training_set.size() / batch_size)
-    auto num_batches = (training_set.size() + batch_size - 1) / batch_size;
-    for (uint64_t i = 0; i < num_batches; ++i)
-    {
-        LOG(progress) << "Training batch " << i + 1 << "/" << num_batches
-                      << '\n'
-                      << ENDLG;
-        auto end
-            = std::min<uint64_t>((i + 1) * batch_size, training_set.size());
-
-        classify::multiclass_dataset batch{
-            idx, training_set.begin() + static_cast<diff_type>(i * batch_size),
-            training_set.begin() + static_cast<diff_type>(end)};
-        cls.train(batch);
-    }
-    LOG(progress) << '\n' << ENDLG;
+    auto data = make_streaming_dataset(idx, training_set, batch_size);
+    batch_train(cls, *data);
 }
 }
 }
@@ -11,6 +11,7 @@
 
 #include "meta/classify/multiclass_dataset_view.h"
 #include "meta/config.h"
+#include "meta/learn/csr_dataset.h"
 #include "meta/learn/dataset_view.h"
 
 namespace meta
@@ -105,6 +106,19 @@ class binary_dataset_view : public learn::dataset_view
     /// function to obtain the labels for instances
     std::function<bool(const instance_type&)> label_fn_;
 };
+
+/**
+ * A dataset with binary class labels, stored in compact CSR form.
+ * Classifiers that accept a binary_csr_view (like sgd) can be trained from
+ * one loaded straight from a forward_index, without building a
+ * binary_dataset.
+ */
+using binary_csr_dataset = learn::labeled_csr_dataset<bool>;
+
+/**
+ * A non-owning view of a binary_csr_dataset.
+ */
+using binary_csr_view = learn::csr_dataset_view<binary_csr_dataset>;
 }
 }
 #endif
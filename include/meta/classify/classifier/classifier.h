@@ -9,12 +9,16 @@
 #ifndef META_CLASSIFIER_H_
 #define META_CLASSIFIER_H_
 
+#include <algorithm>
+#include <memory>
 #include <ostream>
 #include <vector>
 #include "meta/classify/confusion_matrix.h"
 #include "meta/index/forward_index.h"
 #include "meta/learn/dataset.h"
 #include "meta/classify/multiclass_dataset_view.h"
+#include "meta/parallel/thread_pool.h"
+#include "meta/util/shim.h"
 
 namespace meta
 {
@@ -33,6 +37,11 @@ class classifier
     using feature_vector = learn::feature_vector;
     using dataset_view_type = multiclass_dataset_view;
 
+    /// Datasets with fewer documents than this are tested (or trained, by
+    /// classifiers that train in parallel) on the calling thread, since
+    /// starting threads for them would cost more than it saves
+    const static constexpr uint64_t min_parallel_size = 1000;
+
     /**
      * Default destructor is virtual for polymorphic delete.
      */
@@ -41,6 +50,10 @@ class classifier
     /**
      * Classifies an instance_type into a specific group, as determined by
      * training data.
+     *
+     * test() and cross_validate() may call this from several threads at
+     * once, so implementations must not share any state between calls
+     * that they modify (such as files they write).
      * @param instance The instance to classify
      * @return the class it belongs to
      */
@@ -49,13 +62,27 @@ class classifier
     /**
      * Classifies a collection document into specific groups, as determined
      * by training data; this function will make repeated calls to
-     * classify().
+     * classify(), splitting the documents into blocks that are classified
+     * in parallel (unless there are fewer than min_parallel_size).
      * @param docs The documents to classify
      * @return a confusion_matrix detailing the performance of the
      * classifier
      */
     virtual confusion_matrix test(dataset_view_type docs) const;
 
+    /**
+     * Classifies a collection of documents like test(dataset_view_type),
+     * but on an existing thread_pool, so that callers testing many times
+     * do not start threads for every call. The pool must not be the one
+     * running the caller, which would wait on its own workers.
+     * @param docs The documents to classify
+     * @param pool The thread_pool to classify on
+     * @return a confusion_matrix detailing the performance of the
+     * classifier
+     */
+    virtual confusion_matrix test(dataset_view_type docs,
+                                  parallel::thread_pool& pool) const;
+
     /**
      * Saves the classifier model to the output stream.
      * @param out The stream to write the model to
@@ -75,18 +102,25 @@ class classifier_exception : public std::runtime_error
 /**
  * Performs k-fold cross-validation on a set of documents.
  *
+ * Up to max_concurrent_folds folds are trained and tested at once. Every
+ * fold in flight holds its own classifier, so this bounds the memory used
+ * as well as the parallelism; the results are the same for any value.
+ *
  * @param creator A function to create classifiers given a
- * multiclass_dataset_view
+ * multiclass_dataset_view; if more than one fold runs at once, this is
+ * called from several threads
  * @param docs Testing documents
  * @param k The number of folds
  * @param even_split Whether to evenly split the data by class for a fair
  * baseline
+ * @param max_concurrent_folds The maximum number of folds to run at once
  * @return a confusion_matrix containing the results over all the folds
  */
 template <class Creator>
 confusion_matrix cross_validate(Creator&& creator,
                                 classifier::dataset_view_type docs, size_t k,
-                                bool even_split = false)
+                                bool even_split = false,
+                                std::size_t max_concurrent_folds = 1)
 {
     using diff_type = decltype(docs.begin())::difference_type;
 
@@ -96,22 +130,60 @@ confusion_matrix cross_validate(Creator&& creator,
     // docs might be ordered by class, so make sure things are shuffled
     docs.shuffle();
 
-    confusion_matrix matrix;
     auto step_size = docs.size() / k;
-    for (size_t i = 0; i < k; ++i)
+
+    // every fold is tested on the same threads, which are separate from
+    // the ones running concurrent folds
+    std::unique_ptr<parallel::thread_pool> test_pool;
+    if (step_size >= classifier::min_parallel_size)
+        test_pool = make_unique<parallel::thread_pool>();
+
+    auto run_fold = [&](size_t i)
     {
         LOG(info) << "Cross-validating fold " << (i + 1) << "/" << k << ENDLG;
+
+        // the ith fold's test documents are rotated to the front, just as
+        // if the previous folds had each rotated theirs to the back
+        auto fold_docs = docs;
+        fold_docs.rotate(i * step_size);
         multiclass_dataset_view train_view{
-            docs, docs.begin() + static_cast<diff_type>(step_size), docs.end()};
+            fold_docs, fold_docs.begin() + static_cast<diff_type>(step_size),
+            fold_docs.end()};
 
         auto cls = creator(train_view);
         multiclass_dataset_view test_view{
-            docs, docs.begin(),
-            docs.begin() + static_cast<diff_type>(step_size)};
-        auto m = cls->test(test_view);
+            fold_docs, fold_docs.begin(),
+            fold_docs.begin() + static_cast<diff_type>(step_size)};
+        return test_pool ? cls->test(test_view, *test_pool)
+                         : cls->test(test_view);
+    };
+
+    std::vector<confusion_matrix> results;
+    results.reserve(k);
+    if (max_concurrent_folds <= 1)
+    {
+        for (size_t i = 0; i < k; ++i)
+            results.push_back(run_fold(i));
+    }
+    else
+    {
+        parallel::thread_pool pool{std::min(max_concurrent_folds, k)};
+        std::vector<std::future<confusion_matrix>> futures;
+        futures.reserve(k);
+        for (size_t i = 0; i < k; ++i)
+            futures.push_back(pool.submit_task([&, i]()
+                                               {
+                                                   return run_fold(i);
+                                               }));
+        for (auto& fut : futures)
+            results.push_back(fut.get());
+    }
+
+    confusion_matrix matrix;
+    for (const auto& m : results)
+    {
         matrix.add_fold_accuracy(m.accuracy());
         matrix += m;
-        docs.rotate(step_size);
     }
 
     return matrix;
@@ -125,11 +197,13 @@ confusion_matrix cross_validate(Creator&& creator,
  * @param k The number of folds
  * @param even_split Whether to evenly split the data by class for a fair
  * baseline
+ * @param max_concurrent_folds The maximum number of folds to run at once
  * @return a confusion_matrix containing the results over all the folds
  */
 confusion_matrix cross_validate(const cpptoml::table& config,
                                 classifier::dataset_view_type docs, size_t k,
-                                bool even_split = false);
+                                bool even_split = false,
+                                std::size_t max_concurrent_folds = 1);
 }
 }
 #endif
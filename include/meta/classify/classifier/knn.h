@@ -9,7 +9,7 @@
 #ifndef META_KNN_H_
 #define META_KNN_H_
 
-#include <unordered_set>
+#include <vector>
 #include "meta/index/inverted_index.h"
 #include "meta/index/forward_index.h"
 #include "meta/index/ranker/ranker.h"
@@ -24,6 +24,13 @@ namespace classify
 /**
  * Implements the k-Nearest Neighbor lazy learning classification algorithm.
  *
+ * Each document is classified by querying the inverted index with its
+ * term ids directly, restricted to the training documents by a bitmap
+ * over the index's doc ids. The training documents' labels are looked up
+ * once, when the classifier is created, so voting does not go back to
+ * the index. classify() keeps no state between calls, so test() can
+ * classify blocks of documents in parallel.
+ *
  * Required config parameters:
  * ~~~toml
  * [classifier]
@@ -77,13 +84,21 @@ class knn : public classifier
 
   private:
     /**
-     * @param scored
-     * @param sorted
-     * @return the best label
+     * Marks the training documents as legal results and records their
+     * labels.
+     */
+    template <class ForwardIterator>
+    void set_legal_docs(ForwardIterator begin, ForwardIterator end);
+
+    /**
+     * @param scored The nearest neighbors, best first
+     * @param votes The votes for each label id
+     * @return the best label; ties go to the label of the best-ranked
+     * neighbor
      */
     class_label select_best_label(
         const std::vector<index::search_result>& scored,
-        const std::vector<std::pair<class_label, uint16_t>>& sorted) const;
+        const std::vector<double>& votes) const;
 
     /** the inverted index used for ranking */
     std::shared_ptr<index::inverted_index> inv_idx_;
@@ -96,8 +111,17 @@ class knn : public classifier
      */
     std::unique_ptr<index::ranker> ranker_;
 
-    /** documents that are "legal" to be used in the results */
-    std::unordered_set<doc_id> legal_docs_;
+    /** whether each document is "legal" to be used in the results */
+    std::vector<bool> legal_docs_;
+
+    /** the number of legal documents */
+    uint64_t num_legal_docs_ = 0;
+
+    /** the label id of each legal document */
+    std::vector<uint32_t> doc_labels_;
+
+    /** the label for each label id */
+    std::vector<class_label> labels_;
 
     /** Whether we want the neighbors to be weighted by distance or not */
     const bool weighted_;
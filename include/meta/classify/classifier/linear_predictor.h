@@ -0,0 +1,56 @@
+/**
+ * @file linear_predictor.h
+ * @author Chase Geigle
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_CLASSIFY_LINEAR_PREDICTOR_H_
+#define META_CLASSIFY_LINEAR_PREDICTOR_H_
+
+#include <cstdint>
+
+#include "meta/config.h"
+#include "meta/meta.h"
+#include "meta/learn/instance.h"
+
+namespace meta
+{
+namespace classify
+{
+
+/**
+ * An interface for binary classifiers whose predictions are a linear
+ * function \f$w^T x + b\f$ of the features, exposing \f$w\f$ and \f$b\f$
+ * so that the model can be copied into other representations (like a
+ * mapped_linear_model).
+ */
+class linear_predictor
+{
+  public:
+    /**
+     * Default destructor is virtual for polymorphic delete.
+     */
+    virtual ~linear_predictor() = default;
+
+    /**
+     * @return the number of features with weights; every other feature
+     * has a weight of zero
+     */
+    virtual uint64_t num_features() const = 0;
+
+    /**
+     * @param feature A feature less than num_features()
+     * @return the weight of the feature
+     */
+    virtual double weight(learn::feature_id feature) const = 0;
+
+    /**
+     * @return the bias term
+     */
+    virtual double bias() const = 0;
+};
+}
+}
+#endif
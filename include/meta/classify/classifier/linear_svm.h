@@ -0,0 +1,137 @@
+/**
+ * @file linear_svm.h
+ * @author Chase Geigle
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_CLASSIFY_LINEAR_SVM_H_
+#define META_CLASSIFY_LINEAR_SVM_H_
+
+#include <vector>
+
+#include "meta/classify/binary_classifier_factory.h"
+#include "meta/classify/classifier/binary_classifier.h"
+#include "meta/classify/classifier/linear_predictor.h"
+#include "meta/meta.h"
+
+namespace meta
+{
+namespace classify
+{
+
+/**
+ * Trains a binary linear support vector machine in-process with the dual
+ * coordinate descent method of Hsieh et al. (2008), which is the default
+ * solver in liblinear. Unlike svm_wrapper, the training data is read
+ * directly from the dataset view, so nothing is written to disk and any
+ * number of these can be trained at once. Use the one_vs_all adapter for
+ * multiclass problems: it trains the binary classifiers in parallel.
+ *
+ * Required config parameters:
+ * ~~~toml
+ * [classifier]
+ * method = "linear-svm"
+ * ~~~
+ *
+ * Optional config parameters:
+ * ~~~toml
+ * [classifier]
+ * loss = "l2" # or "l1" for the hinge loss
+ * cost = 1.0
+ * tolerance = 0.1
+ * max-iter = 1000
+ * bias = true
+ * ~~~
+ */
+class linear_svm : public binary_classifier, public linear_predictor
+{
+  public:
+    /**
+     * The loss the svm minimizes.
+     */
+    enum class loss_type
+    {
+        /// The hinge loss, \f$\max(0, 1 - y w^T x)\f$
+        L1,
+        /// The squared hinge loss, \f$\max(0, 1 - y w^T x)^2\f$
+        L2
+    };
+
+    /// The default cost (\f$C\f$) parameter.
+    const static constexpr double default_cost = 1.0;
+
+    /// The default tolerance for the stopping condition.
+    const static constexpr double default_tolerance = 0.1;
+
+    /// The default maximum number of passes over the training data.
+    const static constexpr uint64_t default_max_iter = 1000;
+
+    /**
+     * @param docs The training documents
+     * @param loss The loss to minimize
+     * @param cost \f$C\f$, the penalty for violating the margin
+     * @param tolerance The largest violation of the optimality conditions
+     * allowed when training stops
+     * @param max_iter The maximum number of passes over the training data
+     * @param bias Whether to learn a bias term
+     */
+    linear_svm(binary_dataset_view docs, loss_type loss = loss_type::L2,
+               double cost = default_cost,
+               double tolerance = default_tolerance,
+               uint64_t max_iter = default_max_iter, bool bias = true);
+
+    /**
+     * Loads a linear_svm from a stream.
+     * @param in The stream to read from
+     */
+    linear_svm(std::istream& in);
+
+    void save(std::ostream& out) const override;
+
+    /**
+     * @param doc The document to compute the decision value of
+     * @return \f$w^T x + b\f$ for the document
+     */
+    double predict(const feature_vector& doc) const override;
+
+    uint64_t num_features() const override;
+
+    double weight(learn::feature_id feature) const override;
+
+    double bias() const override;
+
+    /**
+     * The identifier for this classifier.
+     */
+    const static util::string_view id;
+
+  private:
+    /**
+     * Runs dual coordinate descent over the training documents.
+     */
+    void train(binary_dataset_view docs, loss_type loss, double cost,
+               double tolerance, uint64_t max_iter);
+
+    /// The weight vector
+    std::vector<double> weights_;
+
+    /// The bias term
+    double bias_ = 0;
+
+    /// Whether the bias term is learned
+    bool use_bias_;
+};
+
+/**
+ * Specialization of the factory method used to create linear_svm
+ * classifiers.
+ */
+template <>
+std::unique_ptr<binary_classifier>
+    make_binary_classifier<linear_svm>(const cpptoml::table& config,
+                                       binary_dataset_view training);
+}
+}
+#endif
@@ -0,0 +1,68 @@
+/**
+ * @file mapped_linear_classifier.h
+ * @author Chase Geigle
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_CLASSIFY_MAPPED_LINEAR_CLASSIFIER_H_
+#define META_CLASSIFY_MAPPED_LINEAR_CLASSIFIER_H_
+
+#include <string>
+
+#include "meta/classify/classifier/classifier.h"
+#include "meta/classify/models/mapped_linear_model.h"
+#include "meta/meta.h"
+
+namespace meta
+{
+namespace classify
+{
+
+/**
+ * A classifier for serving a linear model from a memory mapped file (see
+ * mapped_linear_model), such as one written by one_vs_all::save_mapped().
+ * The model is used in place: it is ready as soon as the file is mapped,
+ * and processes mapping the same file share its memory.
+ *
+ * Saving this classifier only saves the path to the model file, so
+ * loading it maps that file again.
+ */
+class mapped_linear_classifier : public classifier
+{
+  public:
+    /**
+     * @param path The path to the model file
+     * @param options Hints for how the file should be mapped
+     */
+    mapped_linear_classifier(const std::string& path,
+                             const io::mmap_options& options = {});
+
+    /**
+     * Loads a mapped_linear_classifier from a stream.
+     * @param in The stream to read from
+     */
+    mapped_linear_classifier(std::istream& in);
+
+    void save(std::ostream& out) const override;
+
+    class_label classify(const feature_vector& doc) const override;
+
+    /**
+     * @return the model being classified with
+     */
+    const mapped_linear_model& model() const;
+
+    /**
+     * The identifier for this classifier.
+     */
+    const static util::string_view id;
+
+  private:
+    /// The model
+    mapped_linear_model model_;
+};
+}
+}
+#endif
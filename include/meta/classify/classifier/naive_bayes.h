@@ -10,6 +10,7 @@
 #define META_NAIVE_BAYES_H_
 
 #include <unordered_map>
+#include <vector>
 #include "meta/index/forward_index.h"
 #include "meta/classify/classifier/classifier.h"
 #include "meta/classify/classifier_factory.h"
@@ -56,6 +57,29 @@ class naive_bayes : public classifier
     naive_bayes(dataset_view_type docs, double alpha = default_alpha,
                 double beta = default_beta);
 
+    /**
+     * Constructor: learns class models like the one above, counting terms
+     * on the threads of an existing pool rather than starting new ones.
+     * @param docs The training data
+     * @param pool The thread_pool to count on, which must not be the one
+     * running the caller
+     * @param alpha Optional smoothing parameter for term frequencies
+     * @param beta Optional smoothing parameter for class frequencies
+     */
+    naive_bayes(dataset_view_type docs, parallel::thread_pool& pool,
+                double alpha = default_alpha, double beta = default_beta);
+
+    /**
+     * Constructor: learns class models like the one above, from a compact
+     * dataset (which may be loaded from a forward_index without building
+     * a multiclass_dataset).
+     * @param docs The training data
+     * @param alpha Optional smoothing parameter for term frequencies
+     * @param beta Optional smoothing parameter for class frequencies
+     */
+    naive_bayes(multiclass_csr_view docs, double alpha = default_alpha,
+                double beta = default_beta);
+
     /**
      * Constructor: loads a pre-trained model from an input stream.
      * @param in The input stream to load from
@@ -82,8 +106,31 @@ class naive_bayes : public classifier
     const static util::string_view id;
 
   private:
+    /**
+     * Creates an empty term distribution for each class.
+     * @param labels The classes, in increasing order
+     * @param num_features The number of distinct terms
+     * @param alpha Smoothing parameter for term frequencies
+     * @param beta Smoothing parameter for class frequencies
+     */
+    naive_bayes(const std::vector<class_label>& labels, uint64_t num_features,
+                double alpha, double beta);
 
-    void train(const dataset_view_type& docs);
+    /**
+     * Counts the terms in each class, merging the per-thread counts
+     * before adding them to the class distributions. Counting is done on
+     * pool, unless it is null or there are fewer than min_parallel_size
+     * documents.
+     * @param docs A multiclass_dataset_view or a multiclass_csr_view
+     */
+    template <class View>
+    void train(const View& docs, parallel::thread_pool* pool);
+
+    /**
+     * Builds the score matrix from term_probs_ and class_probs_. This is
+     * run after training or loading.
+     */
+    void build_scorer();
 
     /**
      * Contains P(term|class) for each class.
@@ -94,6 +141,32 @@ class naive_bayes : public classifier
      * Contains the number of documents in each class
      */
     stats::multinomial<class_label> class_probs_;
+
+    /**
+     * \f$\log P(class)\f$ for each class, in the order of term_probs_.
+     */
+    std::vector<double> log_priors_;
+
+    /**
+     * \f$\log P(term|class)\f$ of a term never seen in each class.
+     */
+    std::vector<double> log_unseen_;
+
+    /**
+     * The entries for term t are in [offsets_[t], offsets_[t + 1]).
+     */
+    std::vector<uint64_t> offsets_;
+
+    /**
+     * The class (index into term_probs_) of each entry.
+     */
+    std::vector<uint32_t> classes_;
+
+    /**
+     * \f$\log P(term|class)\f$ less that of an unseen term for each entry,
+     * so classes a term was never seen in need no entry.
+     */
+    std::vector<double> deltas_;
 };
 
 class naive_bayes_exception : public std::runtime_error
@@ -9,6 +9,8 @@
 #ifndef META_NEAREST_CENTROID_H_
 #define META_NEAREST_CENTROID_H_
 
+#include <vector>
+
 #include "meta/index/inverted_index.h"
 #include "meta/index/forward_index.h"
 #include "meta/classify/classifier_factory.h"
@@ -44,6 +46,28 @@ class nearest_centroid : public classifier
     nearest_centroid(multiclass_dataset_view docs,
                      std::shared_ptr<index::inverted_index> idx);
 
+    /**
+     * Like the constructor above, but sums the class term counts on the
+     * threads of an existing pool rather than starting new ones.
+     * @param docs The training documents
+     * @param idx The index to run the classifier on
+     * @param pool The thread_pool to count on, which must not be the one
+     * running the caller
+     */
+    nearest_centroid(multiclass_dataset_view docs,
+                     std::shared_ptr<index::inverted_index> idx,
+                     parallel::thread_pool& pool);
+
+    /**
+     * Like the first constructor, but trains from a compact dataset
+     * (which may be loaded from a forward_index without building a
+     * multiclass_dataset).
+     * @param docs The training documents
+     * @param idx The index to run the classifier on
+     */
+    nearest_centroid(multiclass_csr_view docs,
+                     std::shared_ptr<index::inverted_index> idx);
+
     /**
      * Loads a nearest_centroid classifier from a stream.
      * @param in The stream to read from
@@ -62,21 +86,40 @@ class nearest_centroid : public classifier
 
   private:
     /**
-     * @param d_id
-     * @param centroid
-     * @return the cosine similarity between the query and a centroid
+     * Sums the term counts of each class and builds their centroids. The
+     * counts are summed on pool, unless it is null or there are fewer
+     * than min_parallel_size documents.
+     * @param docs A multiclass_dataset_view or a multiclass_csr_view
+     */
+    template <class View>
+    void train(const View& docs, parallel::thread_pool* pool);
+
+    /**
+     * Builds the centroid matrix.
+     * @param labels The classes
+     * @param centroids The (term, weight) pairs of each class's centroid
      */
-    template <class ForwardIterator>
-    double
-        cosine_sim(ForwardIterator begin, ForwardIterator end,
-                   const std::unordered_map<term_id, double>& centroid) const;
+    void set_centroids(
+        std::vector<class_label> labels,
+        const std::vector<std::vector<std::pair<term_id, double>>>& centroids);
 
     /// Inverted index used for ranking
     std::shared_ptr<index::inverted_index> inv_idx_;
 
-    /// The document centroids for this learner
-    std::unordered_map<class_label, std::unordered_map<term_id, double>>
-        centroids_;
+    /// The classes, which are the columns of the centroid matrix
+    std::vector<class_label> labels_;
+
+    /// The magnitude of each class's centroid
+    std::vector<double> norms_;
+
+    /// The entries for term t are in [offsets_[t], offsets_[t + 1])
+    std::vector<uint64_t> offsets_;
+
+    /// The class (index into labels_) of each entry
+    std::vector<uint32_t> classes_;
+
+    /// The centroid weight of each entry
+    std::vector<double> weights_;
 };
 
 /**
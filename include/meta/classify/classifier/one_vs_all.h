@@ -12,6 +12,7 @@
 #include "meta/classify/classifier/binary_classifier.h"
 #include "meta/classify/classifier_factory.h"
 #include "meta/classify/classifier/online_classifier.h"
+#include "meta/classify/models/mapped_linear_model.h"
 #include "meta/meta.h"
 
 namespace meta
@@ -55,6 +56,18 @@ class one_vs_all : public online_classifier
 
     void save(std::ostream& out) const override;
 
+    /**
+     * Writes the ensemble to a file that a mapped_linear_classifier can
+     * serve from in place. Every binary classifier must be a
+     * linear_predictor (like sgd or linear_svm).
+     *
+     * @param path The path to the model file to write
+     * @param encoding How to store the weights
+     */
+    void save_mapped(const std::string& path,
+                     weight_encoding encoding
+                     = weight_encoding::float32) const;
+
     class_label classify(const feature_vector& doc) const override;
 
     void train(dataset_view_type docs) override;
@@ -11,6 +11,7 @@
 
 #include "meta/classify/binary_classifier_factory.h"
 #include "meta/classify/classifier/binary_classifier.h"
+#include "meta/classify/classifier/linear_predictor.h"
 #include "meta/classify/classifier/online_binary_classifier.h"
 #include "meta/learn/loss/loss_function.h"
 #include "meta/learn/sgd.h"
@@ -44,9 +45,26 @@ namespace classify
  * l1-regularization = 0
  * max-iter = 5
  * calibrate = false
+ * train-threads = 1
+ * batch-size = 1
+ * averaged = false
  * ~~~
+ *
+ * With more than one training thread, each pass over the training data is
+ * split between the threads, which update the weights without locking
+ * (see learn::sgd_model::train_hogwild()), and convergence is checked
+ * after every pass rather than every tenth of one.
+ *
+ * With a batch size above one, the model is trained on mini-batches (see
+ * learn::sgd_model::train_batch()). Averaged models predict with the
+ * average of the weights over training, and are always trained from one
+ * thread, even when given a thread_pool.
+ *
+ * An sgd classifier can also be trained from a binary_csr_view, which
+ * reads every instance from a single contiguous CSR layout (see
+ * learn::basic_csr_dataset).
  */
-class sgd : public online_binary_classifier
+class sgd : public online_binary_classifier, public linear_predictor
 {
   public:
     /// The default \f$\gamma\f$ parameter.
@@ -62,11 +80,51 @@ class sgd : public online_binary_classifier
      * @param bias \f$b\f$, the bias
      * @param lambda \f$\lambda\f$, the regularization constant
      * @param max_iter The maximum number of iterations for training.
+     * @param calibrate Whether to calibrate the learning rate first
+     * @param num_threads The number of threads to train with
+     * @param batch_size The number of documents in each mini-batch
      */
     sgd(binary_dataset_view docs,
         std::unique_ptr<learn::loss::loss_function> loss,
         learn::sgd_model::options_type options, double gamma = default_gamma,
-        size_t max_iter = default_max_iter, bool calibrate = false);
+        size_t max_iter = default_max_iter, bool calibrate = false,
+        std::size_t num_threads = 1, std::size_t batch_size = 1);
+
+    /**
+     * Trains on the instances of a compact dataset.
+     *
+     * @param docs The training documents
+     * @param loss The loss function to train with
+     * @param options The options for the model
+     * @param gamma \f$gamma\f$, the error threshold
+     * @param max_iter The maximum number of iterations for training.
+     * @param calibrate Whether to calibrate the learning rate first
+     * @param num_threads The number of threads to train with
+     * @param batch_size The number of documents in each mini-batch
+     */
+    sgd(binary_csr_view docs, std::unique_ptr<learn::loss::loss_function> loss,
+        learn::sgd_model::options_type options, double gamma = default_gamma,
+        size_t max_iter = default_max_iter, bool calibrate = false,
+        std::size_t num_threads = 1, std::size_t batch_size = 1);
+
+    /**
+     * Trains on the threads of an existing pool rather than starting
+     * new ones. The pool must not be the one running the caller.
+     *
+     * @param docs The training documents
+     * @param loss The loss function to train with
+     * @param options The options for the model
+     * @param pool The thread_pool to train on
+     * @param gamma \f$gamma\f$, the error threshold
+     * @param max_iter The maximum number of iterations for training.
+     * @param calibrate Whether to calibrate the learning rate first
+     * @param batch_size The number of documents in each mini-batch
+     */
+    sgd(binary_dataset_view docs,
+        std::unique_ptr<learn::loss::loss_function> loss,
+        learn::sgd_model::options_type options, parallel::thread_pool& pool,
+        double gamma = default_gamma, size_t max_iter = default_max_iter,
+        bool calibrate = false, std::size_t batch_size = 1);
 
     /**
      * Loads an sgd classifier from a stream.
@@ -76,8 +134,24 @@ class sgd : public online_binary_classifier
 
     void save(std::ostream& out) const override;
 
+    /**
+     * Trains on docs, from num_threads_ threads if there are at least
+     * classifier::min_parallel_size of them and from the calling thread
+     * otherwise.
+     * @param docs The training documents
+     */
     void train(binary_dataset_view docs) override;
 
+    /**
+     * Trains on docs from the threads of an existing pool (or from the
+     * calling thread, if there are fewer than
+     * classifier::min_parallel_size of them).
+     * @param docs The training documents
+     * @param pool The thread_pool to train on, which must not be the one
+     * running the caller
+     */
+    void train(binary_dataset_view docs, parallel::thread_pool& pool);
+
     void train_one(const feature_vector& doc, bool label) override;
 
     /**
@@ -90,6 +164,12 @@ class sgd : public online_binary_classifier
      */
     double predict(const feature_vector& doc) const override;
 
+    uint64_t num_features() const override;
+
+    double weight(learn::feature_id feature) const override;
+
+    double bias() const override;
+
     /**
      * The identifier for this classifier.
      */
@@ -101,6 +181,50 @@ class sgd : public online_binary_classifier
      */
     double train_instance(const feature_vector& doc, bool label);
 
+    /**
+     * Calibrates the learning rate of the model on docs.
+     * @param docs A binary_dataset_view or a binary_csr_view
+     */
+    template <class View>
+    void calibrate(const View& docs);
+
+    /**
+     * Trains on docs from num_threads_ threads if there are at least
+     * classifier::min_parallel_size of them and from the calling thread
+     * otherwise.
+     * @param docs A binary_dataset_view or a binary_csr_view
+     */
+    template <class View>
+    void train_view(View& docs);
+
+    /**
+     * Trains on docs from the threads of pool, or from the calling thread
+     * if pool is null, there are too few documents to split, or the model
+     * is averaged.
+     * @param docs A binary_dataset_view or a binary_csr_view
+     */
+    template <class View>
+    void train(View& docs, parallel::thread_pool* pool);
+
+    /**
+     * Trains on docs from one thread, in batches of batch_size_, until
+     * the loss converges or max_iter_ passes have been made.
+     * @param docs A binary_dataset_view or a binary_csr_view
+     * @param labeler Gives the +1/-1 label of an instance of docs
+     */
+    template <class View, class LabelFunction>
+    void train_epochs(View& docs, LabelFunction&& labeler);
+
+    /**
+     * Trains on docs from every thread of pool at once.
+     * @param docs A binary_dataset_view or a binary_csr_view
+     * @param labeler Gives the +1/-1 label of an instance of docs
+     * @param pool The thread_pool to train on
+     */
+    template <class View, class LabelFunction>
+    void train_hogwild(View& docs, LabelFunction&& labeler,
+                       parallel::thread_pool& pool);
+
     /// The model
     learn::sgd_model model_;
 
@@ -112,6 +236,13 @@ class sgd : public online_binary_classifier
 
     /// The loss function to be used for the update.
     std::unique_ptr<learn::loss::loss_function> loss_;
+
+    /// The number of threads to train with (not saved with the model)
+    std::size_t num_threads_ = 1;
+
+    /// The number of documents in each mini-batch (not saved with the
+    /// model)
+    std::size_t batch_size_ = 1;
 };
 
 /**
@@ -31,6 +31,12 @@ namespace classify
  * submodule and have compiled both libsvm and liblinear.
  *
  * If no kernel is selected, liblinear is used. Otherwise, libsvm is used.
+ * Each classifier keeps its model in its own file in the working
+ * directory, which is deleted along with it, and each call to classify()
+ * or test() uses its own temporary files.
+ * For linear SVMs, prefer the linear_svm binary classifier (wrapped in
+ * one_vs_all), which trains in-process instead of round-tripping the data
+ * through files.
  *
  * Required config parameters:
  * ~~~toml
@@ -78,6 +84,11 @@ class svm_wrapper : public classifier
      */
     svm_wrapper(std::istream& in);
 
+    /**
+     * Deletes the model file.
+     */
+    ~svm_wrapper();
+
     void save(std::ostream& out) const override;
 
     /**
@@ -98,15 +109,37 @@ class svm_wrapper : public classifier
      */
     confusion_matrix test(dataset_view_type docs) const override;
 
+    /**
+     * Classifies a collection of documents with liblinear/libsvm, as
+     * test(dataset_view_type) does; the pool is not used.
+     *
+     * @param docs The documents to classify
+     * @param pool Unused
+     * @return a confusion_matrix detailing the performance of the
+     * classifier
+     */
+    confusion_matrix test(dataset_view_type docs,
+                          parallel::thread_pool& pool) const override;
+
     /**
      * The identifier for this classifier.
      */
     const static util::string_view id;
 
   private:
+    /**
+     * Runs liblinear/libsvm's predict executable.
+     * @param input The file of instances to classify
+     * @param output The file to write the predicted label ids to
+     */
+    void predict(const std::string& input, const std::string& output) const;
+
     /** the path to the liblinear/libsvm library */
     const std::string svm_path_;
 
+    /** the file the model is kept in */
+    std::string model_file_;
+
     /** keeps track of which arguments are necessary for which kernel
      * function */
     const static std::unordered_map<kernel, std::string, hashing::hash<>>
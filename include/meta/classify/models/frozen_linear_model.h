@@ -0,0 +1,171 @@
+/**
+ * @file frozen_linear_model.h
+ * @author Chase Geigle
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_CLASSIFY_MODEL_FROZEN_LINEAR_MODEL_H_
+#define META_CLASSIFY_MODEL_FROZEN_LINEAR_MODEL_H_
+
+#include <vector>
+
+#include "meta/classify/models/linear_model.h"
+#include "meta/hashing/probe_map.h"
+#include "meta/meta.h"
+#include "meta/util/aligned_allocator.h"
+
+namespace meta
+{
+namespace classify
+{
+
+/**
+ * A read-only copy of a linear_model that is laid out for fast scoring.
+ * It is built once training is finished and gives exactly the same
+ * results as the linear_model it was built from.
+ *
+ * Features are found with a single lookup in a group-probed hash table
+ * that maps them to a row of weights. Classes are numbered densely, so
+ * scores accumulate into a flat array rather than a sparse_vector. Rows
+ * with weights for enough of the classes are stored densely, padded to a
+ * multiple of 32 bytes, so their loop over the classes can be vectorized.
+ * The remaining rows are stored as contiguous (class, weight) pairs,
+ * which keeps the memory used close to the linear_model's when most
+ * features only have weights for a few classes.
+ */
+template <class FeatureId, class FeatureValue, class ClassId>
+class frozen_linear_model
+{
+  public:
+    using model_type = linear_model<FeatureId, FeatureValue, ClassId>;
+    using feature_id = typename model_type::feature_id;
+    using feature_value = typename model_type::feature_value;
+    using class_id = typename model_type::class_id;
+    using scored_class = typename model_type::scored_class;
+    using scored_classes = typename model_type::scored_classes;
+
+    /// The default fraction of the classes a feature must have weights
+    /// for to be stored densely
+    const static constexpr double default_min_density = 0.25;
+
+    /**
+     * Creates an empty model, which scores every class as the default
+     * class id.
+     */
+    frozen_linear_model() = default;
+
+    /**
+     * Builds a frozen copy of a linear_model. Features without any
+     * weights are left out.
+     *
+     * @param model The model to copy
+     * @param min_density The fraction of the classes a feature must have
+     * weights for to be stored densely
+     */
+    explicit frozen_linear_model(const model_type& model,
+                                 double min_density = default_min_density);
+
+    /**
+     * Rebuilds the linear_model this was built from, so a model that was
+     * only kept frozen can still be saved or trained further.
+     *
+     * @return a linear_model with the same weights
+     */
+    model_type to_linear_model() const;
+
+    /**
+     * @see linear_model::best_class
+     */
+    template <class FeatureVector, class Filter>
+    class_id best_class(FeatureVector&& features, Filter&& filter) const;
+
+    /**
+     * @see linear_model::best_class
+     */
+    template <class FeatureVector>
+    class_id best_class(FeatureVector&& features) const;
+
+    /**
+     * @see linear_model::best_classes
+     */
+    template <class FeatureVector, class Filter>
+    scored_classes best_classes(FeatureVector&& features, uint64_t num,
+                                Filter&& filter) const;
+
+    /**
+     * @see linear_model::best_classes
+     */
+    template <class FeatureVector>
+    scored_classes best_classes(FeatureVector&& features, uint64_t num) const;
+
+    /**
+     * @return whether the model has no features
+     */
+    bool empty() const;
+
+    /**
+     * @return the number of features in the model
+     */
+    uint64_t num_features() const;
+
+    /**
+     * @return the number of classes in the model
+     */
+    uint64_t num_classes() const;
+
+    /**
+     * @return the number of features stored densely
+     */
+    uint64_t num_dense_features() const;
+
+  private:
+    /**
+     * Adds up the scores for each class over a feature vector, and marks
+     * which classes any of the features had a weight for.
+     */
+    template <class FeatureVector>
+    void score(const FeatureVector& features,
+               std::vector<feature_value>& scores,
+               std::vector<uint64_t>& touched) const;
+
+    /**
+     * @return whether class column col was marked in touched
+     */
+    static bool is_touched(const std::vector<uint64_t>& touched,
+                           uint64_t col);
+
+    /// Maps features to their rows: the low bit says whether the row is
+    /// dense, and the rest is its index among the dense or sparse rows
+    hashing::probe_map<feature_id, uint64_t, hashing::probing::group> rows_;
+
+    /// The class id for each column, in increasing order
+    std::vector<class_id> classes_;
+
+    /// The number of weights in each dense row
+    uint64_t stride_ = 0;
+
+    /// The number of 64-bit words in each row of present_
+    uint64_t mask_words_ = 0;
+
+    /// The weights of the dense rows
+    util::aligned_vector<feature_value, 32> dense_;
+
+    /// For each dense row, a bit for each class it has a weight for
+    std::vector<uint64_t> present_;
+
+    /// The offset of each sparse row's weights, plus one past the last
+    std::vector<uint64_t> sparse_offsets_;
+
+    /// The columns of the weights in the sparse rows
+    std::vector<uint32_t> sparse_cols_;
+
+    /// The weights of the sparse rows
+    std::vector<feature_value> sparse_vals_;
+};
+}
+}
+
+#include "meta/classify/models/frozen_linear_model.tcc"
+#endif
@@ -0,0 +1,265 @@
+/**
+ * @file frozen_linear_model.tcc
+ * @author Chase Geigle
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "meta/classify/models/frozen_linear_model.h"
+#include "meta/util/fixed_heap.h"
+
+namespace meta
+{
+namespace classify
+{
+
+template <class FeatureId, class FeatureValue, class ClassId>
+const constexpr double
+    frozen_linear_model<FeatureId, FeatureValue, ClassId>::default_min_density;
+
+template <class FeatureId, class FeatureValue, class ClassId>
+frozen_linear_model<FeatureId, FeatureValue, ClassId>::frozen_linear_model(
+    const model_type& model, double min_density)
+{
+    for (const auto& feat_vec : model.weights())
+        for (const auto& weight : feat_vec.second)
+            classes_.push_back(weight.first);
+    std::sort(classes_.begin(), classes_.end());
+    classes_.erase(std::unique(classes_.begin(), classes_.end()),
+                   classes_.end());
+
+    if (classes_.size() > std::numeric_limits<uint32_t>::max())
+        throw linear_model_exception{"too many classes to freeze model"};
+
+    // pad dense rows out to a multiple of 32 bytes
+    const uint64_t per_block = std::max<uint64_t>(1, 32 / sizeof(feature_value));
+    stride_ = (classes_.size() + per_block - 1) / per_block * per_block;
+    mask_words_ = (classes_.size() + 63) / 64;
+
+    auto column = [&](const class_id& cid)
+    {
+        return static_cast<uint64_t>(
+            std::lower_bound(classes_.begin(), classes_.end(), cid)
+            - classes_.begin());
+    };
+
+    uint64_t num_dense = 0;
+    sparse_offsets_.push_back(0);
+    for (const auto& feat_vec : model.weights())
+    {
+        // a feature without weights never affects a score, and would
+        // otherwise give an empty model a dense row of no classes
+        const auto& weights = feat_vec.second;
+        if (weights.empty())
+            continue;
+
+        if (weights.size() >= min_density * classes_.size())
+        {
+            rows_[feat_vec.first] = (num_dense << 1) | 1;
+            dense_.resize(dense_.size() + stride_, feature_value{});
+            present_.resize(present_.size() + mask_words_, 0);
+
+            auto row = &dense_[num_dense * stride_];
+            auto mask = &present_[num_dense * mask_words_];
+            for (const auto& weight : weights)
+            {
+                auto col = column(weight.first);
+                row[col] = weight.second;
+                mask[col / 64] |= uint64_t{1} << (col % 64);
+            }
+            ++num_dense;
+        }
+        else
+        {
+            rows_[feat_vec.first] = (sparse_offsets_.size() - 1) << 1;
+            for (const auto& weight : weights)
+            {
+                sparse_cols_.push_back(
+                    static_cast<uint32_t>(column(weight.first)));
+                sparse_vals_.push_back(weight.second);
+            }
+            sparse_offsets_.push_back(sparse_cols_.size());
+        }
+    }
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+auto frozen_linear_model<FeatureId, FeatureValue, ClassId>::to_linear_model()
+    const -> model_type
+{
+    model_type model;
+    for (const auto& pr : rows_)
+    {
+        auto row = pr.value();
+        auto idx = row >> 1;
+        if (row & 1)
+        {
+            const feature_value* weights = &dense_[idx * stride_];
+            const uint64_t* mask = &present_[idx * mask_words_];
+            for (uint64_t col = 0; col < classes_.size(); ++col)
+            {
+                if ((mask[col / 64] >> (col % 64)) & 1)
+                    model.update(classes_[col], pr.key(), weights[col]);
+            }
+        }
+        else
+        {
+            for (auto i = sparse_offsets_[idx]; i < sparse_offsets_[idx + 1];
+                 ++i)
+                model.update(classes_[sparse_cols_[i]], pr.key(),
+                             sparse_vals_[i]);
+        }
+    }
+    return model;
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+template <class FeatureVector>
+void frozen_linear_model<FeatureId, FeatureValue, ClassId>::score(
+    const FeatureVector& features, std::vector<feature_value>& scores,
+    std::vector<uint64_t>& touched) const
+{
+    scores.assign(stride_, feature_value{});
+    touched.assign(mask_words_, 0);
+
+    for (const auto& feat : features)
+    {
+        auto it = rows_.find(feat.first);
+        if (it == rows_.end())
+            continue;
+
+        auto val = feat.second;
+        auto row = it->value();
+        auto idx = row >> 1;
+        if (row & 1)
+        {
+            // weights for absent classes are zero, so adding them in
+            // leaves those scores unchanged
+            const feature_value* weights = &dense_[idx * stride_];
+            feature_value* out = scores.data();
+            for (uint64_t col = 0; col < stride_; ++col)
+                out[col] += val * weights[col];
+
+            const uint64_t* mask = &present_[idx * mask_words_];
+            for (uint64_t i = 0; i < mask_words_; ++i)
+                touched[i] |= mask[i];
+        }
+        else
+        {
+            for (auto i = sparse_offsets_[idx]; i < sparse_offsets_[idx + 1];
+                 ++i)
+            {
+                auto col = sparse_cols_[i];
+                scores[col] += val * sparse_vals_[i];
+                touched[col / 64] |= uint64_t{1} << (col % 64);
+            }
+        }
+    }
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+bool frozen_linear_model<FeatureId, FeatureValue, ClassId>::is_touched(
+    const std::vector<uint64_t>& touched, uint64_t col)
+{
+    return (touched[col / 64] >> (col % 64)) & 1;
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+template <class FeatureVector, class Filter>
+auto frozen_linear_model<FeatureId, FeatureValue, ClassId>::best_class(
+    FeatureVector&& features, Filter&& filter) const -> class_id
+{
+    std::vector<feature_value> scores;
+    std::vector<uint64_t> touched;
+    score(features, scores, touched);
+
+    // only classes some feature had a weight for are considered, in
+    // increasing order, to match linear_model::best_class
+    auto best_score = std::numeric_limits<feature_value>::lowest();
+    class_id best_class{};
+    for (uint64_t col = 0; col < classes_.size(); ++col)
+    {
+        if (is_touched(touched, col) && scores[col] > best_score
+            && filter(classes_[col]))
+        {
+            best_class = classes_[col];
+            best_score = scores[col];
+        }
+    }
+
+    return best_class;
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+template <class FeatureVector>
+auto frozen_linear_model<FeatureId, FeatureValue, ClassId>::best_class(
+    FeatureVector&& features) const -> class_id
+{
+    return best_class(std::forward<FeatureVector>(features),
+                      [](const class_id&) { return true; });
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+template <class FeatureVector, class Filter>
+auto frozen_linear_model<FeatureId, FeatureValue, ClassId>::best_classes(
+    FeatureVector&& features, uint64_t num, Filter&& filter) const
+    -> scored_classes
+{
+    std::vector<feature_value> scores;
+    std::vector<uint64_t> touched;
+    score(features, scores, touched);
+
+    auto heap = util::make_fixed_heap<scored_class>(
+        num, [](const scored_class& lhs, const scored_class& rhs) {
+            return lhs.second > rhs.second;
+        });
+    for (uint64_t col = 0; col < classes_.size(); ++col)
+    {
+        if (is_touched(touched, col) && filter(classes_[col]))
+            heap.emplace(classes_[col], scores[col]);
+    }
+
+    return heap.extract_top();
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+template <class FeatureVector>
+auto frozen_linear_model<FeatureId, FeatureValue, ClassId>::best_classes(
+    FeatureVector&& features, uint64_t num) const -> scored_classes
+{
+    return best_classes(std::forward<FeatureVector>(features), num,
+                        [](const class_id&) { return true; });
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+bool frozen_linear_model<FeatureId, FeatureValue, ClassId>::empty() const
+{
+    return rows_.empty();
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+uint64_t
+frozen_linear_model<FeatureId, FeatureValue, ClassId>::num_features() const
+{
+    return rows_.size();
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+uint64_t
+frozen_linear_model<FeatureId, FeatureValue, ClassId>::num_classes() const
+{
+    return classes_.size();
+}
+
+template <class FeatureId, class FeatureValue, class ClassId>
+uint64_t frozen_linear_model<FeatureId, FeatureValue,
+                             ClassId>::num_dense_features() const
+{
+    return stride_ == 0 ? 0 : dense_.size() / stride_;
+}
+}
+}
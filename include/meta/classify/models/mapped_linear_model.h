@@ -0,0 +1,245 @@
+/**
+ * @file mapped_linear_model.h
+ * @author Chase Geigle
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_CLASSIFY_MODELS_MAPPED_LINEAR_MODEL_H_
+#define META_CLASSIFY_MODELS_MAPPED_LINEAR_MODEL_H_
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/io/mmap_file.h"
+#include "meta/meta.h"
+#include "meta/learn/instance.h"
+
+namespace meta
+{
+namespace classify
+{
+
+/**
+ * How the weights of a mapped_linear_model are stored.
+ */
+enum class weight_encoding : uint64_t
+{
+    /// Single precision floats
+    float32 = 0,
+    /// IEEE half precision floats (about three significant digits)
+    float16 = 1,
+    /// Signed bytes, scaled per feature by the largest weight's magnitude
+    int8 = 2
+};
+
+/**
+ * A read-only multiclass linear model that is used in place from a memory
+ * mapped file written by mapped_linear_model_writer (see its
+ * documentation for the file format). Opening one only reads its header
+ * and class labels and checks its row table, so it is ready immediately,
+ * and every process that maps the same file shares its pages.
+ *
+ * The score of a class c for a document x is \f$w_c^T x + b_c\f$, and the
+ * weights of each feature for every class are stored together, so scoring
+ * reads one contiguous row per feature in the document.
+ */
+class mapped_linear_model
+{
+  public:
+    /**
+     * @param path The path to the model file
+     * @param options Hints for how the file should be mapped
+     */
+    mapped_linear_model(const std::string& path,
+                        const io::mmap_options& options = {});
+
+    /**
+     * Move constructs a mapped_linear_model.
+     */
+    mapped_linear_model(mapped_linear_model&&) = default;
+
+    /**
+     * Move assigns a mapped_linear_model.
+     */
+    mapped_linear_model& operator=(mapped_linear_model&&) = default;
+
+    /**
+     * Computes the score of every class for a document. Features that
+     * the model has no weights for are ignored.
+     *
+     * @param doc The document to score
+     * @param scores Set to the score of each class, in the order of
+     * classes()
+     */
+    void score(const learn::feature_vector& doc,
+               std::vector<double>& scores) const;
+
+    /**
+     * @param doc The document to classify
+     * @return the class with the highest score, with ties going to the
+     * class that comes first in classes()
+     */
+    class_label best_class(const learn::feature_vector& doc) const;
+
+    /**
+     * @return the classes of the model
+     */
+    const std::vector<class_label>& classes() const;
+
+    /**
+     * @return the number of features the model has weights for
+     */
+    uint64_t num_features() const;
+
+    /**
+     * @return how the weights are stored
+     */
+    weight_encoding encoding() const;
+
+    /**
+     * @return the path to the model file
+     */
+    std::string path() const;
+
+  private:
+    /// The model file
+    io::mmap_file file_;
+
+    /// The classes, read from the file when it is opened
+    std::vector<class_label> classes_;
+
+    /// The number of features
+    uint64_t num_features_;
+
+    /// How the weights are stored
+    weight_encoding encoding_;
+
+    /// The bias of each class
+    const double* biases_;
+
+    /// The scale of each stored row
+    const float* scales_;
+
+    /// The stored row of each feature
+    const uint32_t* rows_;
+
+    /// The first stored row
+    const char* weights_;
+};
+
+/**
+ * Writes a mapped_linear_model file.
+ *
+ * The file begins with a 128-byte header containing a magic number, the
+ * format version, the weight encoding, the number of classes, features,
+ * and stored rows, and the position of each of the following sections:
+ *
+ * - the class labels, as packed strings;
+ * - the bias of each class, as doubles;
+ * - the weight rows, beginning on a 64-byte boundary: each row holds a
+ *   feature's weight for every class, in the encoding of the file;
+ * - the scale of each row, as floats: stored weights are multiplied by
+ *   it (it is only different from one for int8 rows);
+ * - the row of each feature, as 32-bit integers, where features whose
+ *   weights are all zero have no row.
+ *
+ * The file is only complete once finish() has been called; a writer that
+ * is destroyed before then deletes what it has written.
+ *
+ * Like front_coded_vocabulary_writer, the file is not portable across
+ * endianness.
+ */
+class mapped_linear_model_writer
+{
+  public:
+    /// The alignment of the weight rows in the file
+    const static constexpr uint64_t alignment = 64;
+
+    /**
+     * @param path The path to the model file to write
+     * @param classes The classes of the model; scores are computed in this
+     * order
+     * @param biases The bias of each class
+     * @param encoding How to store the weights
+     */
+    mapped_linear_model_writer(const std::string& path,
+                               const std::vector<class_label>& classes,
+                               const std::vector<double>& biases,
+                               weight_encoding encoding
+                               = weight_encoding::float32);
+
+    /**
+     * Deletes the file if finish() was not called.
+     */
+    ~mapped_linear_model_writer();
+
+    /**
+     * Adds the weights of the next feature, starting from feature zero.
+     * @param weights The weight of the feature for each class
+     */
+    void insert(const std::vector<double>& weights);
+
+    /**
+     * Writes the row scales and indices and the header, completing the
+     * file. No more features may be inserted afterward.
+     * @throw mapped_linear_model_exception if the file could not be
+     * written
+     */
+    void finish();
+
+  private:
+    /**
+     * Writes null bytes until the write position is a multiple of the
+     * given alignment.
+     */
+    void pad_to(uint64_t align);
+
+    /**
+     * Writes a block of bytes to the file.
+     */
+    void write(const void* data, uint64_t size);
+
+    /// The path to the file being written
+    std::string path_;
+    /// The file being written
+    std::ofstream file_;
+    /// Whether finish() has been called
+    bool finished_;
+    /// The current write position in file_
+    uint64_t file_write_pos_;
+    /// The number of classes
+    uint64_t num_classes_;
+    /// How the weights are stored
+    weight_encoding encoding_;
+    /// The position of the class labels in file_
+    uint64_t labels_pos_;
+    /// The position of the biases in file_
+    uint64_t biases_pos_;
+    /// The position of the first weight row in file_
+    uint64_t weights_pos_;
+    /// The scale of each stored row
+    std::vector<float> scales_;
+    /// The stored row of each feature
+    std::vector<uint32_t> rows_;
+    /// The encoded row being written
+    std::vector<char> buffer_;
+};
+
+/**
+ * An exception that can be thrown while reading or writing a
+ * mapped_linear_model.
+ */
+class mapped_linear_model_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+}
+#endif
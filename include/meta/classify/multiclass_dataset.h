@@ -57,11 +57,14 @@ class multiclass_dataset : public learn::labeled_dataset<class_label>
      * Creates an in-memory dataset from a forward_index and a range of
      * doc_ids, represented as iterators.
      */
-    template <class ForwardIterator>
+    template <class ForwardIterator,
+              class ProgressTrait = printing::default_progress_trait>
     multiclass_dataset(std::shared_ptr<index::forward_index> idx,
-                       ForwardIterator begin, ForwardIterator end)
+                       ForwardIterator begin, ForwardIterator end,
+                       ProgressTrait = ProgressTrait{})
         : labeled_dataset{idx, begin, end,
-                          [&](doc_id did) { return idx->label(did); }}
+                          [&](doc_id did) { return idx->label(did); },
+                          ProgressTrait{}}
     {
         // build label_id_mapping
         for (const auto& lbl : idx->class_labels())
@@ -11,6 +11,7 @@
 
 #include "meta/classify/multiclass_dataset.h"
 #include "meta/config.h"
+#include "meta/learn/csr_dataset.h"
 #include "meta/learn/dataset_view.h"
 #include "meta/logging/logger.h"
 
@@ -134,6 +135,19 @@ class multiclass_dataset_view : public learn::dataset_view
         return dset<multiclass_dataset>().print_liblinear(os, instance);
     }
 };
+
+/**
+ * A dataset with categorical class labels, stored in compact CSR form.
+ * Classifiers that accept a multiclass_csr_view (like naive_bayes) can be
+ * trained from one loaded straight from a forward_index, without building
+ * a multiclass_dataset.
+ */
+using multiclass_csr_dataset = learn::labeled_csr_dataset<class_label>;
+
+/**
+ * A non-owning view of a multiclass_csr_dataset.
+ */
+using multiclass_csr_view = learn::csr_dataset_view<multiclass_csr_dataset>;
 }
 }
 #endif
@@ -84,6 +84,20 @@ class corpus
      */
     virtual metadata::schema_type schema() const;
 
+    /**
+     * Splits the remaining documents of this corpus into (at most) n
+     * corpora over disjoint, contiguous ranges of document ids, which can
+     * then be consumed concurrently without any synchronization. The
+     * documents are no longer available from this corpus afterwards.
+     *
+     * Corpora that can only be read sequentially do not support this and
+     * return an empty vector (the default).
+     *
+     * @param n The number of ranges to create
+     * @return the corpora for each range
+     */
+    virtual std::vector<std::unique_ptr<corpus>> split(std::size_t n);
+
     /**
      * Destructor.
      */
@@ -113,6 +127,12 @@ class corpus
      */
     std::vector<metadata::field> next_metadata();
 
+    /**
+     * @return whether this corpus has a metadata schema (other than the
+     * full text, if stored), which requires reading metadata sequentially
+     */
+    bool has_metadata() const;
+
   private:
     friend std::unique_ptr<corpus> make_corpus(const cpptoml::table&);
 
@@ -136,7 +156,11 @@ class corpus_exception : public std::runtime_error
 };
 
 /**
- * Consumes each document in a corpus using a pool of threads.
+ * Consumes each document in a corpus using a pool of threads. If the
+ * corpus can be split into ranges (see corpus::split()), each thread
+ * reads its own range without locking; otherwise, documents are read
+ * from the corpus one at a time under a mutex.
+ *
  * @param docs The corpus to consume
  * @param pool The thread pool to use
  * @param ls_fn A function to create thread-specific storage
@@ -146,6 +170,25 @@ template <class LocalStorage, class ConsumeFunction>
 void parallel_consume(corpus& docs, parallel::thread_pool& pool,
                       LocalStorage&& ls_fn, ConsumeFunction&& consume_fn)
 {
+    auto ranges = docs.split(pool.size());
+    if (!ranges.empty())
+    {
+        std::vector<std::future<void>> futures;
+        futures.reserve(ranges.size());
+        for (auto& range : ranges)
+        {
+            auto range_ptr = range.get();
+            futures.emplace_back(pool.submit_task([&, range_ptr]() {
+                auto local_storage = ls_fn();
+                while (range_ptr->has_next())
+                    consume_fn(local_storage, range_ptr->next());
+            }));
+        }
+        for (auto& fut : futures)
+            fut.get();
+        return;
+    }
+
     std::mutex mutex;
     auto task = [&]() {
         auto local_storage = ls_fn();
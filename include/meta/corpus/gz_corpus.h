@@ -22,7 +22,20 @@ namespace corpus
 
 /**
  * Fills document objects with content line-by-line from gzip-compressed
- * input files.
+ * input files. The document file is decompressed on a background thread
+ * ahead of the reader; if it was written by bgzip, its blocks are
+ * decompressed in parallel.
+ *
+ * Required config parameters:
+ * ~~~toml
+ * num-docs = 1000
+ * ~~~
+ *
+ * Optional config parameters:
+ * ~~~toml
+ * encoding = "utf-8" # default value
+ * decompression-threads = 4 # default is 1; only used for bgzip files
+ * ~~~
  */
 class gz_corpus : public corpus
 {
@@ -35,8 +48,11 @@ class gz_corpus : public corpus
      * represents a document
      * @param encoding The encoding for the file
      * @param num_docs The number of documents in this corpus
+     * @param num_threads The number of threads to use for decompressing
+     * bgzip-formatted files
      */
-    gz_corpus(const std::string& file, std::string encoding, uint64_t num_docs);
+    gz_corpus(const std::string& file, std::string encoding, uint64_t num_docs,
+              std::size_t num_threads = 1);
 
     /**
      * @return whether there is another document in this corpus
@@ -61,7 +77,7 @@ class gz_corpus : public corpus
     uint64_t num_lines_;
 
     /// The stream for reading the corpus
-    io::gzifstream corpus_stream_;
+    io::readahead_gzifstream corpus_stream_;
 
     /// The stream to read the class labels
     io::gzifstream class_stream_;
@@ -0,0 +1,139 @@
+/**
+ * @file mmap_line_corpus.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_MMAP_LINE_CORPUS_H_
+#define META_MMAP_LINE_CORPUS_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/corpus/corpus.h"
+#include "meta/corpus/corpus_factory.h"
+#include "meta/io/mmap_file.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace corpus
+{
+
+/**
+ * A line_corpus that memory maps its input file instead of streaming it.
+ * The byte offset of each line is computed once and cached next to the
+ * corpus file (in a ".offsets" file) so that later loads only need to
+ * read the offsets back, as long as the corpus file's size and
+ * modification time have not changed.
+ *
+ * Because documents can be located directly, this corpus can be split
+ * into contiguous ranges of document ids that are consumed concurrently
+ * without any shared lock (see corpus::split() and parallel_consume()).
+ * This is only possible when the corpus has no metadata schema, since
+ * metadata.dat must be read sequentially.
+ *
+ * Optional config parameters:
+ * ~~~toml
+ * encoding = "utf-8" # default value
+ * ~~~
+ */
+class mmap_line_corpus : public corpus
+{
+  public:
+    /// The identifier for this corpus
+    const static util::string_view id;
+
+    /**
+     * @param file The path to the corpus file, where each line represents
+     * a document
+     * @param encoding The encoding for the file
+     */
+    mmap_line_corpus(const std::string& file, std::string encoding);
+
+    /**
+     * @return whether there is another document in this corpus
+     */
+    bool has_next() const override;
+
+    /**
+     * @return the next document from this corpus
+     */
+    document next() override;
+
+    /**
+     * @return the number of documents in this corpus
+     */
+    uint64_t size() const override;
+
+    /**
+     * Splits the remaining documents into at most n contiguous ranges
+     * that contain roughly the same number of bytes.
+     *
+     * @param n The number of ranges to create
+     * @return the corpora for each range, or an empty vector if the
+     * corpus has metadata and therefore cannot be split
+     */
+    std::vector<std::unique_ptr<corpus>> split(std::size_t n) override;
+
+    /**
+     * @param d_id The document to obtain the content for
+     * @return a view of the document's (unconverted) content in the mapped
+     * file, which is valid for the lifetime of this corpus
+     */
+    util::string_view content(doc_id d_id) const;
+
+  private:
+    /**
+     * The state shared between a corpus and the ranges split from it.
+     */
+    struct shared_state
+    {
+        /// The mapped corpus file (empty if the file is empty)
+        util::optional<io::mmap_file> file;
+        /// The starting byte of each line, followed by the end of the file
+        std::vector<uint64_t> offsets;
+        /// The class labels for each document, if present
+        std::vector<class_label> labels;
+    };
+
+    /**
+     * Constructs a corpus over a range of documents.
+     * @param state The shared corpus state
+     * @param encoding The encoding for the file
+     * @param begin The first document in the range
+     * @param end One past the last document in the range
+     */
+    mmap_line_corpus(std::shared_ptr<const shared_state> state,
+                     std::string encoding, doc_id begin, doc_id end);
+
+    /// The corpus state shared with split ranges
+    std::shared_ptr<const shared_state> state_;
+
+    /// The current document we are on
+    doc_id cur_id_;
+
+    /// One past the last document in this corpus
+    doc_id end_id_;
+
+    /// Whether this corpus is a range split from another corpus
+    bool is_range_;
+};
+
+/**
+ * Specialization of the factory method used to create mmap_line_corpus
+ * instances.
+ */
+template <>
+std::unique_ptr<corpus>
+make_corpus<mmap_line_corpus>(util::string_view prefix,
+                              util::string_view dataset,
+                              const cpptoml::table& config);
+}
+}
+#endif
@@ -201,7 +201,7 @@ class cooccurrence_counter
     const std::size_t merge_fanout_;
     const std::size_t window_size_;
     const bool break_on_tags_;
-    const hashing::probe_map<std::string, uint64_t> vocab_;
+    const hashing::string_arena_map<uint64_t> vocab_;
     parallel::thread_pool& pool_;
     std::size_t chunk_num_{0};
     std::atomic_size_t num_tokenizing_{0};
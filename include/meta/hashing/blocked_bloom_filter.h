@@ -0,0 +1,294 @@
+/**
+ * @file blocked_bloom_filter.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_HASHING_BLOCKED_BLOOM_FILTER_H_
+#define META_HASHING_BLOCKED_BLOOM_FILTER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "meta/config.h"
+#include "meta/hashing/hash.h"
+#include "meta/io/packed.h"
+#include "meta/util/aligned_allocator.h"
+
+namespace meta
+{
+namespace hashing
+{
+
+/**
+ * An exception thrown when a blocked_bloom_filter cannot be read.
+ */
+class bloom_filter_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * A Bloom filter whose bits are split into cache-line sized blocks. Each
+ * key hashes to a single block and sets all of its bits within it, so a
+ * lookup touches one cache line no matter how many hash functions are
+ * used. This costs a slightly higher false positive rate than a standard
+ * Bloom filter of the same size.
+ *
+ * The hash is seeded with a fixed value that is saved along with the bits,
+ * so a filter written with save() can be loaded in another process.
+ *
+ * @see http://algo2.iti.kit.edu/documents/cacheefficientbloomfilters-jea.pdf
+ */
+class blocked_bloom_filter
+{
+  public:
+    /// The number of bits in each block (one cache line)
+    const static uint64_t block_bits = 512;
+
+    /**
+     * @param expected_keys The number of keys that will be inserted
+     * @param bits_per_key The number of bits to use per expected key
+     * @param seed The seed for the hash function
+     */
+    blocked_bloom_filter(uint64_t expected_keys, double bits_per_key = 10.0,
+                         uint64_t seed = 0x2545f4914f6cdd1d)
+        : hash_{seed},
+          num_blocks_{std::max<uint64_t>(
+              1, static_cast<uint64_t>(std::ceil(expected_keys * bits_per_key
+                                                 / block_bits)))},
+          // k = ln(2) * bits per key minimizes the false positive rate
+          num_hashes_{static_cast<uint64_t>(std::min(
+              16.0, std::max(1.0, std::round(bits_per_key * 0.693))))},
+          num_keys_{0},
+          bits_(num_blocks_ * words_per_block, 0)
+    {
+        // nothing
+    }
+
+    /**
+     * Loads a filter written by save().
+     * @param filename The file to read from
+     */
+    explicit blocked_bloom_filter(const std::string& filename) : hash_{0}
+    {
+        std::ifstream in{filename, std::ios::binary};
+        load(in, filename);
+    }
+
+    /**
+     * Loads a filter written by save() to a stream.
+     * @param in The stream to read from
+     */
+    explicit blocked_bloom_filter(std::istream& in) : hash_{0}
+    {
+        load(in, "stream");
+    }
+
+    /**
+     * @param key The key to add to the filter
+     */
+    template <class T>
+    void insert(const T& key)
+    {
+        auto h = hash_(key);
+        auto block = &bits_[block_for(h) * words_per_block];
+        for (uint64_t i = 0; i < num_hashes_; ++i)
+        {
+            auto pos = bit_for(h, i);
+            block[pos / 64] |= uint64_t{1} << (pos % 64);
+        }
+        ++num_keys_;
+    }
+
+    /**
+     * @param key The key to check
+     * @return false if the key was definitely never inserted, true if it
+     * probably was
+     */
+    template <class T>
+    bool contains(const T& key) const
+    {
+        auto h = hash_(key);
+        auto block = &bits_[block_for(h) * words_per_block];
+        for (uint64_t i = 0; i < num_hashes_; ++i)
+        {
+            auto pos = bit_for(h, i);
+            if (!(block[pos / 64] & (uint64_t{1} << (pos % 64))))
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * Writes the filter to a file, which can be read back in with the
+     * filename constructor.
+     * @param filename The file to write to
+     */
+    void save(const std::string& filename) const
+    {
+        std::ofstream out{filename, std::ios::binary};
+        save(out);
+    }
+
+    /**
+     * Writes the filter to a stream, which can be read back in with the
+     * stream constructor.
+     * @param out The stream to write to
+     */
+    void save(std::ostream& out) const
+    {
+        io::packed::write(out, hash_.seed());
+        io::packed::write(out, num_blocks_);
+        io::packed::write(out, num_hashes_);
+        io::packed::write(out, num_keys_);
+        out.write(reinterpret_cast<const char*>(bits_.data()),
+                  static_cast<std::streamsize>(bits_.size() * sizeof(uint64_t)));
+    }
+
+    /**
+     * @return the number of keys that have been inserted
+     */
+    uint64_t size() const
+    {
+        return num_keys_;
+    }
+
+    /**
+     * @return the number of bits set per key
+     */
+    uint64_t num_hashes() const
+    {
+        return num_hashes_;
+    }
+
+    /**
+     * @return the number of bytes used by the filter's bits
+     */
+    uint64_t bytes_used() const
+    {
+        return bits_.size() * sizeof(uint64_t);
+    }
+
+    /**
+     * Estimates the false positive rate for the keys inserted so far. The
+     * number of keys landing in each block is Poisson distributed, so the
+     * rate is the standard Bloom filter rate for a single block averaged
+     * over the block loads.
+     *
+     * @return the expected fraction of keys that were not inserted that
+     * contains() will accept
+     */
+    double false_positive_rate() const
+    {
+        auto lambda = static_cast<double>(num_keys_) / num_blocks_;
+        auto k = static_cast<double>(num_hashes_);
+        auto max_load
+            = static_cast<uint64_t>(lambda + 10 * std::sqrt(lambda) + 20);
+
+        double rate = 0;
+        for (uint64_t load = 0; load <= max_load; ++load)
+        {
+            // computed in log space so large loads don't underflow
+            auto log_prob = -lambda + load * std::log(lambda + 1e-300)
+                            - std::lgamma(load + 1.0);
+            auto bit_set = 1 - std::pow(1 - 1.0 / block_bits, k * load);
+            rate += std::exp(log_prob) * std::pow(bit_set, k);
+        }
+        return rate;
+    }
+
+  private:
+    /// The number of 64-bit words in a block
+    const static uint64_t words_per_block = block_bits / 64;
+
+    /**
+     * Reads a filter written by save().
+     * @param in The stream to read from
+     * @param source The name of the stream, for error messages
+     */
+    void load(std::istream& in, const std::string& source)
+    {
+        uint64_t seed;
+        io::packed::read(in, seed);
+        io::packed::read(in, num_blocks_);
+        io::packed::read(in, num_hashes_);
+        io::packed::read(in, num_keys_);
+        if (!in)
+            throw bloom_filter_exception{"unable to read bloom filter from "
+                                         + source};
+
+        hash_ = seeded_hash<farm_hash_seeded>{seed};
+        bits_.resize(num_blocks_ * words_per_block);
+        in.read(reinterpret_cast<char*>(bits_.data()),
+                static_cast<std::streamsize>(bits_.size() * sizeof(uint64_t)));
+        if (!in)
+            throw bloom_filter_exception{"bloom filter " + source
+                                         + " is truncated"};
+    }
+
+    /**
+     * @param h A key's hash
+     * @return the block the key belongs to
+     */
+    uint64_t block_for(uint64_t h) const
+    {
+        return mix(h) % num_blocks_;
+    }
+
+    /**
+     * @param h A key's hash
+     * @param i Which of the key's bits to find
+     * @return the position of the ith bit within the key's block
+     */
+    static uint64_t bit_for(uint64_t h, uint64_t i)
+    {
+        // each 64-bit hash yields seven independent 9-bit positions; double
+        // hashing within a block this small has too few distinct patterns
+        // and noticeably raises the false positive rate
+        const uint64_t bits_per_hash = 7;
+        if (i >= bits_per_hash)
+            h = mix(h + i / bits_per_hash);
+        return (h >> (9 * (i % bits_per_hash))) % block_bits;
+    }
+
+    /**
+     * Scrambles a hash so that the block and the bits within it don't
+     * depend on the same bits of the hash.
+     */
+    static uint64_t mix(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccd;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53;
+        h ^= h >> 33;
+        return h;
+    }
+
+    /// The hash function for keys
+    seeded_hash<farm_hash_seeded> hash_;
+
+    /// The number of blocks in the filter
+    uint64_t num_blocks_;
+
+    /// The number of bits set per key
+    uint64_t num_hashes_;
+
+    /// The number of keys inserted
+    uint64_t num_keys_;
+
+    /// The bits of the filter, aligned so each block is one cache line
+    util::aligned_vector<uint64_t, 64> bits_;
+};
+}
+}
+#endif
@@ -10,10 +10,14 @@
 #ifndef META_HASHING_HASH_H_
 #define META_HASHING_HASH_H_
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <cstdint>
+#include <iterator>
 #include <random>
+#include <string>
+#include <type_traits>
 
 #include "hashes/farm_hash.h"
 #include "hashes/metro_hash.h"
@@ -299,6 +303,87 @@ inline uint64_t get_process_seed()
     static uint64_t seed = std::random_device{}();
     return seed;
 }
+
+/**
+ * Whether a hash algorithm has a hash_string() member for hashing whole
+ * strings at once.
+ */
+template <class HashAlgorithm, class = void>
+struct has_hash_string : public std::false_type
+{
+};
+
+template <class HashAlgorithm>
+struct has_hash_string<HashAlgorithm,
+                       decltype(void(std::declval<HashAlgorithm&>().hash_string(
+                           std::declval<const char*>(), std::size_t{})))>
+    : public std::true_type
+{
+};
+
+/**
+ * Whether a type is a string (or string_view) of chars.
+ */
+template <class T, class = void>
+struct is_char_string : public std::false_type
+{
+};
+
+template <class T>
+struct is_char_string<T, typename std::enable_if<std::is_same<
+                             typename T::traits_type,
+                             std::char_traits<char>>::value>::type>
+    : public std::true_type
+{
+};
+
+/**
+ * Hashes a value with a freshly constructed hash algorithm.
+ */
+template <class HashAlgorithm, class T>
+typename std::enable_if<!has_hash_string<HashAlgorithm>::value
+                            || !is_char_string<T>::value,
+                        typename HashAlgorithm::result_type>::type
+hash_value(HashAlgorithm& h, const T& t)
+{
+    using hashing::hash_append;
+    hash_append(h, t);
+    return static_cast<typename HashAlgorithm::result_type>(h);
+}
+
+/**
+ * Hashes a string with a freshly constructed hash algorithm that has a
+ * fast path for whole strings.
+ */
+template <class HashAlgorithm, class T>
+typename std::enable_if<has_hash_string<HashAlgorithm>::value
+                            && is_char_string<T>::value,
+                        typename HashAlgorithm::result_type>::type
+hash_value(HashAlgorithm& h, const T& t)
+{
+    return h.hash_string(t.data(), t.size());
+}
+
+/**
+ * Starts loading the bytes of a string that will be hashed soon.
+ */
+template <class T>
+typename std::enable_if<is_char_string<T>::value>::type
+prefetch_key(const T& t)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(t.data());
+#else
+    (void)t;
+#endif
+}
+
+template <class T>
+typename std::enable_if<!is_char_string<T>::value>::type
+prefetch_key(const T&)
+{
+    // nothing; other keys are hashed in place
+}
 }
 
 /**
@@ -320,9 +405,7 @@ class seeded_hash
     result_type operator()(const T& t) const
     {
         HashAlgorithm h(seed_);
-        using hashing::hash_append;
-        hash_append(h, t);
-        return static_cast<result_type>(h);
+        return detail::hash_value(h, t);
     }
 
     SeedType seed() const
@@ -349,11 +432,43 @@ struct hash
     {
         auto seed = detail::get_process_seed();
         HashAlgorithm h(seed);
-        using hashing::hash_append;
-        hash_append(h, t);
-        return static_cast<result_type>(h);
+        return detail::hash_value(h, t);
     }
 };
+
+/**
+ * Hashes a batch of keys, writing the hash of each to out. Keys are
+ * hashed in lanes of a few at a time, and the bytes of the strings in
+ * the next lane are prefetched while the current one is hashed, so the
+ * cache misses for keys that live in different places in memory overlap
+ * instead of being paid one at a time.
+ *
+ * @param hash The hash function to use
+ * @param first The beginning of the keys to hash
+ * @param last The end of the keys to hash
+ * @param out Where to write the hashes
+ * @return the end of the hashes written
+ */
+template <class Hash, class RandomAccessIterator, class OutputIterator>
+OutputIterator hash_many(const Hash& hash, RandomAccessIterator first,
+                         RandomAccessIterator last, OutputIterator out)
+{
+    using difference_type =
+        typename std::iterator_traits<RandomAccessIterator>::difference_type;
+    const difference_type lane_size = 8;
+
+    auto size = std::distance(first, last);
+    for (difference_type lane = 0; lane < size; lane += lane_size)
+    {
+        auto lane_end = std::min(lane + lane_size, size);
+        auto next_end = std::min(lane_end + lane_size, size);
+        for (auto i = lane_end; i < next_end; ++i)
+            detail::prefetch_key(first[i]);
+        for (auto i = lane; i < lane_end; ++i)
+            *out++ = hash(first[i]);
+    }
+    return out;
+}
 }
 }
 #endif
@@ -3,10 +3,13 @@
  * @author Chase Geigle
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <functional>
 #include <iterator>
+#include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -14,6 +17,16 @@
 #include "meta/config.h"
 #include "meta/util/aligned_allocator.h"
 #include "meta/util/optional.h"
+#include "meta/util/string_arena.h"
+#include "meta/util/string_view.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #ifndef META_HASHING_HASH_STORAGE_H_
 #define META_HASHING_HASH_STORAGE_H_
@@ -26,6 +39,11 @@ namespace hashing
 template <class T>
 struct key_traits;
 
+namespace probing
+{
+class group;
+}
+
 /**
  * Pair class used by the hash tables. This can be implicitly converted to
  * a std::pair, but is itself a lightweight wrapper around references to
@@ -359,6 +377,154 @@ struct hash_idx
     std::size_t idx = 0;
 };
 
+/**
+ * Extra per-slot state kept by the storage classes for a probing
+ * strategy. Most strategies need none, so this is empty, and since
+ * storage_base derives from it, it takes up no space in their tables.
+ */
+template <class ProbingStrategy>
+class control_bytes
+{
+  public:
+    void reset(std::size_t /*capacity*/)
+    {
+        // nothing
+    }
+
+    void set(std::size_t /*idx*/, std::size_t /*hc*/)
+    {
+        // nothing
+    }
+
+    std::size_t bytes_used() const
+    {
+        return 0;
+    }
+};
+
+/**
+ * The control bytes used for probing::group. Each byte is either empty
+ * or holds the top seven bits of the hash code of the key stored in the
+ * corresponding slot. The array is padded to a whole number of groups
+ * with bytes that never match a tag and are never empty.
+ */
+template <>
+class control_bytes<probing::group>
+{
+  public:
+    const static std::size_t group_size = 16;
+
+    enum : int8_t
+    {
+        empty = -128,
+        padding = -2
+    };
+
+    /**
+     * Marks every slot as empty.
+     * @param capacity The number of slots in the table
+     */
+    void reset(std::size_t capacity)
+    {
+        auto groups = (capacity + group_size - 1) / group_size;
+        bytes_.assign(groups * group_size, padding);
+        std::fill_n(bytes_.begin(), capacity, empty);
+    }
+
+    /**
+     * Marks a slot as occupied by a key with the given hash code.
+     * @param idx The slot
+     * @param hc The hash code of the key in the slot
+     */
+    void set(std::size_t idx, std::size_t hc)
+    {
+        bytes_[idx] = tag(hc);
+    }
+
+    /**
+     * Finds the slot containing a key, or the empty slot where it would
+     * be inserted, visiting slots in the same order as probing::group.
+     *
+     * @param hc The hash code of the key
+     * @param capacity The number of slots in the table
+     * @param equal A predicate for whether an (occupied) slot contains
+     * the key
+     */
+    template <class Equal>
+    std::size_t find(std::size_t hc, std::size_t capacity,
+                     Equal&& equal) const
+    {
+        auto t = tag(hc);
+        auto idx = (hc % capacity) & ~(group_size - 1);
+        while (true)
+        {
+            for (auto mask = match(idx, t); mask; mask &= mask - 1)
+            {
+                auto slot = idx + first_slot(mask);
+                if (equal(slot))
+                    return slot;
+            }
+
+            // keys are never removed, so the key can't be past an empty
+            // slot
+            if (auto mask = match(idx, empty))
+                return idx + first_slot(mask);
+
+            idx += group_size;
+            if (idx >= capacity)
+                idx = 0;
+        }
+    }
+
+    std::size_t bytes_used() const
+    {
+        return bytes_.capacity();
+    }
+
+  private:
+    /**
+     * @param mask A nonzero mask from match()
+     * @return the offset of the first slot set in the mask
+     */
+    static std::size_t first_slot(uint32_t mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return static_cast<std::size_t>(__builtin_ctz(mask));
+#endif
+    }
+
+    static int8_t tag(std::size_t hc)
+    {
+        return static_cast<int8_t>(hc >> (sizeof(std::size_t) * 8 - 7));
+    }
+
+    /**
+     * @return a mask with bit i set if the control byte at idx + i is
+     * equal to byte
+     */
+    uint32_t match(std::size_t idx, int8_t byte) const
+    {
+#if defined(__SSE2__)
+        auto group = _mm_load_si128(
+            reinterpret_cast<const __m128i*>(bytes_.data() + idx));
+        return static_cast<uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(byte))));
+#else
+        uint32_t mask = 0;
+        for (std::size_t i = 0; i < group_size; ++i)
+            mask |= static_cast<uint32_t>(bytes_[idx + i] == byte) << i;
+        return mask;
+#endif
+    }
+
+    /// The control bytes, aligned so each group can be loaded at once
+    util::aligned_vector<int8_t> bytes_;
+};
+
 /**
  * A traits class used internally for configuring the following types for
  * the storage classes:
@@ -377,6 +543,7 @@ struct storage_traits;
  */
 template <class Derived>
 class storage_base
+    : private control_bytes<typename storage_traits<Derived>::probing_strategy>
 {
   public:
     using iterator = typename storage_traits<Derived>::iterator;
@@ -461,13 +628,8 @@ class storage_base
     std::size_t get_idx(const key_type& key,
                         typename hash_type::result_type hc) const
     {
-        probing_strategy strategy(hc, as_derived().capacity());
-        auto idx = strategy.probe();
-        while (as_derived().occupied(idx) && !as_derived().equal(idx, hc, key))
-        {
-            idx = strategy.probe();
-        }
-        return idx;
+        return get_idx(key, hc,
+                       std::is_same<probing_strategy, probing::group>{});
     }
 
     /**
@@ -485,6 +647,7 @@ class storage_base
         auto hc = hash_(key);
         auto idx = get_idx(key, hc);
         as_derived().put(idx, hc, std::move(stored));
+        control().set(idx, hc);
 
         return {as_derived(), idx};
     }
@@ -551,7 +714,60 @@ class storage_base
         return hash_(key);
     }
 
+  protected:
+    /**
+     * Marks every slot in the control bytes (if any) as empty. Storage
+     * classes must call this whenever they (re)create their table.
+     * @param capacity The number of slots in the table
+     */
+    void reset_control(std::size_t capacity)
+    {
+        control().reset(capacity);
+    }
+
+    /**
+     * Marks a slot in the control bytes (if any) as occupied. Storage
+     * classes must call this when they place a key without emplace().
+     * @param idx The slot
+     * @param hc The hash code of the key in the slot
+     */
+    void set_control(std::size_t idx, std::size_t hc)
+    {
+        control().set(idx, hc);
+    }
+
+    /**
+     * @return the number of bytes used by the control bytes
+     */
+    std::size_t control_bytes_used() const
+    {
+        return control().bytes_used();
+    }
+
   private:
+    std::size_t get_idx(const key_type& key,
+                        typename hash_type::result_type hc,
+                        std::false_type /*group*/) const
+    {
+        probing_strategy strategy(hc, as_derived().capacity());
+        auto idx = strategy.probe();
+        while (as_derived().occupied(idx) && !as_derived().equal(idx, hc, key))
+        {
+            idx = strategy.probe();
+        }
+        return idx;
+    }
+
+    std::size_t get_idx(const key_type& key,
+                        typename hash_type::result_type hc,
+                        std::true_type /*group*/) const
+    {
+        return control().find(hc, as_derived().capacity(),
+                             [&](std::size_t idx) {
+                                 return as_derived().equal(idx, hc, key);
+                             });
+    }
+
     Derived& as_derived()
     {
         return static_cast<Derived&>(*this);
@@ -562,6 +778,16 @@ class storage_base
         return static_cast<const Derived&>(*this);
     }
 
+    control_bytes<probing_strategy>& control()
+    {
+        return *this;
+    }
+
+    const control_bytes<probing_strategy>& control() const
+    {
+        return *this;
+    }
+
     hash_type hash_;
     equal_type equal_;
     double max_load_factor_ = default_max_load_factor();
@@ -585,7 +811,7 @@ class external_key_storage
 
     external_key_storage(std::size_t capacity) : table_(capacity)
     {
-        // nothing
+        this->reset_control(capacity);
     }
 
     bool occupied(std::size_t idx) const
@@ -637,6 +863,7 @@ class external_key_storage
     {
         key_vector_type{}.swap(keys_);
         std::fill(std::begin(table_), std::end(table_), hash_idx{});
+        this->reset_control(capacity());
     }
 
     void resize(std::size_t new_cap)
@@ -645,6 +872,7 @@ class external_key_storage
 
         table_.resize(new_cap);
         std::fill(std::begin(table_), std::end(table_), hash_idx{});
+        this->reset_control(new_cap);
 
         for (std::size_t i = 0; i < keys_.size(); ++i)
         {
@@ -652,13 +880,14 @@ class external_key_storage
             auto nidx = this->get_idx(keys_[i], hc);
             table_[nidx].hc = hc;
             table_[nidx].idx = i + 1;
+            this->set_control(nidx, hc);
         }
     }
 
     std::size_t bytes_used() const
     {
         return sizeof(hash_idx) * table_.capacity()
-               + sizeof(T) * keys_.capacity();
+               + sizeof(T) * keys_.capacity() + this->control_bytes_used();
     }
 
     key_vector_type extract_keys()
@@ -711,7 +940,7 @@ class inline_key_storage
     inline_key_storage(std::size_t capacity)
         : table_(capacity, key_traits<T>::sentinel()), size_{0}
     {
-        // nothing
+        this->reset_control(capacity);
     }
 
     bool occupied(std::size_t idx) const
@@ -757,6 +986,7 @@ class inline_key_storage
         std::fill(std::begin(table_), std::end(table_),
                   key_traits<T>::sentinel());
         size_ = 0;
+        this->reset_control(capacity());
     }
 
     void resize(std::size_t new_cap)
@@ -766,21 +996,24 @@ class inline_key_storage
         vector_type temptable(new_cap, key_traits<T>::sentinel());
         using std::swap;
         swap(table_, temptable);
+        this->reset_control(new_cap);
 
         for (std::size_t idx = 0; idx < temptable.size(); ++idx)
         {
             if (!this->key_equal(temptable[idx], key_traits<T>::sentinel()))
             {
                 auto hc = this->hash(temptable[idx]);
-                table_[this->get_idx(temptable[idx], hc)]
-                    = std::move(temptable[idx]);
+                auto nidx = this->get_idx(temptable[idx], hc);
+                table_[nidx] = std::move(temptable[idx]);
+                this->set_control(nidx, hc);
             }
         }
     }
 
     std::size_t bytes_used() const
     {
-        return sizeof(T) * table_.capacity() + sizeof(std::size_t);
+        return sizeof(T) * table_.capacity() + sizeof(std::size_t)
+               + this->control_bytes_used();
     }
 
     std::vector<T> extract_keys()
@@ -841,7 +1074,7 @@ class inline_key_value_storage
                                           key_traits<V>::sentinel())),
           size_{0}
     {
-        // nothing
+        this->reset_control(capacity);
     }
 
     bool occupied(std::size_t idx) const
@@ -890,6 +1123,7 @@ class inline_key_value_storage
                   std::make_pair(key_traits<K>::sentinel(),
                                  key_traits<V>::sentinel()));
         size_ = 0;
+        this->reset_control(capacity());
     }
 
     void resize(std::size_t new_cap)
@@ -901,14 +1135,16 @@ class inline_key_value_storage
                                              key_traits<V>::sentinel()));
         using std::swap;
         swap(table_, temptable);
+        this->reset_control(new_cap);
 
         for (std::size_t i = 0; i < temptable.size(); ++i)
         {
             if (!this->key_equal(temptable[i].first, key_traits<K>::sentinel()))
             {
                 auto hc = this->hash(temptable[i].first);
-                table_[this->get_idx(temptable[i].first, hc)]
-                    = std::move(temptable[i]);
+                auto nidx = this->get_idx(temptable[i].first, hc);
+                table_[nidx] = std::move(temptable[i]);
+                this->set_control(nidx, hc);
             }
         }
     }
@@ -916,7 +1152,7 @@ class inline_key_value_storage
     std::size_t bytes_used() const
     {
         return sizeof(std::pair<K, V>) * table_.capacity()
-               + sizeof(std::size_t);
+               + sizeof(std::size_t) + this->control_bytes_used();
     }
 
     vector_type extract() &&
@@ -981,7 +1217,7 @@ class inline_key_external_value_storage
         : table_(capacity,
                  std::make_pair(key_traits<K>::sentinel(), std::size_t{0}))
     {
-        // nothing
+        this->reset_control(capacity);
     }
 
     bool occupied(std::size_t idx) const
@@ -1037,6 +1273,7 @@ class inline_key_external_value_storage
         std::fill(std::begin(table_), std::end(table_),
                   std::make_pair(key_traits<K>::sentinel(), std::size_t{0}));
         std::vector<V>{}.swap(values_);
+        this->reset_control(capacity());
     }
 
     void resize(std::size_t new_cap)
@@ -1047,14 +1284,16 @@ class inline_key_external_value_storage
                                   std::make_pair(key_traits<K>::sentinel(), 0));
         using std::swap;
         swap(table_, temptable);
+        this->reset_control(new_cap);
 
         for (std::size_t i = 0; i < temptable.size(); ++i)
         {
             if (!this->key_equal(temptable[i].first, key_traits<K>::sentinel()))
             {
                 auto hc = this->hash(temptable[i].first);
-                table_[this->get_idx(temptable[i].first, hc)]
-                    = std::move(temptable[i]);
+                auto nidx = this->get_idx(temptable[i].first, hc);
+                table_[nidx] = std::move(temptable[i]);
+                this->set_control(nidx, hc);
             }
         }
     }
@@ -1062,7 +1301,7 @@ class inline_key_external_value_storage
     std::size_t bytes_used() const
     {
         return sizeof(std::pair<K, std::size_t>) * table_.capacity()
-               + sizeof(V) * values_.capacity();
+               + sizeof(V) * values_.capacity() + this->control_bytes_used();
     }
 
     std::vector<std::pair<K, V>> extract() &&
@@ -1131,7 +1370,7 @@ class external_key_value_storage
 
     external_key_value_storage(std::size_t capacity) : table_(capacity)
     {
-        // nothing
+        this->reset_control(capacity);
     }
 
     bool occupied(std::size_t idx) const
@@ -1186,6 +1425,7 @@ class external_key_value_storage
     {
         kv_vector_type{}.swap(storage_);
         std::fill(std::begin(table_), std::end(table_), hash_idx{});
+        this->reset_control(capacity());
     }
 
     void resize(std::size_t new_cap)
@@ -1194,6 +1434,7 @@ class external_key_value_storage
 
         table_.resize(new_cap);
         std::fill(std::begin(table_), std::end(table_), hash_idx{});
+        this->reset_control(new_cap);
 
         for (std::size_t i = 0; i < storage_.size(); ++i)
         {
@@ -1201,13 +1442,15 @@ class external_key_value_storage
             auto nidx = this->get_idx(storage_[i].first, hc);
             table_[nidx].hc = hc;
             table_[nidx].idx = i + 1;
+            this->set_control(nidx, hc);
         }
     }
 
     std::size_t bytes_used() const
     {
         return sizeof(hash_idx) * table_.capacity()
-               + sizeof(std::pair<K, V>) * storage_.capacity();
+               + sizeof(std::pair<K, V>) * storage_.capacity()
+               + this->control_bytes_used();
     }
 
     kv_vector_type extract() &&
@@ -1245,6 +1488,164 @@ struct storage_traits<external_key_value_storage<K, V, ProbingStrategy, Hash,
         return st.first;
     }
 };
+
+/**
+ * Storage class for hash tables with string keys whose bytes are kept in
+ * a util::string_arena instead of in individually allocated
+ * std::strings. The hash code of each key is cached in the probing
+ * table, and all of the keys are released at once on clear(). Keys are
+ * exposed as util::string_views into the arena, which remain valid until
+ * the table is cleared or destroyed.
+ *
+ * This is selected by using string_arena_traits as the Traits parameter
+ * of probe_map (see string_arena_map).
+ */
+template <class V, class ProbingStrategy, class Hash, class KeyEqual>
+class arena_key_value_storage
+    : public storage_base<arena_key_value_storage<V, ProbingStrategy, Hash,
+                                                  KeyEqual>>
+{
+  public:
+    using value_type = kv_pair<util::string_view, V>;
+    using const_value_type = kv_pair<util::string_view, const V>;
+
+    using idx_vector_type = util::aligned_vector<hash_idx>;
+    using kv_vector_type
+        = util::aligned_vector<std::pair<util::string_view, V>>;
+
+    arena_key_value_storage(std::size_t capacity) : table_(capacity)
+    {
+        this->reset_control(capacity);
+    }
+
+    bool occupied(std::size_t idx) const
+    {
+        return table_[idx].idx != 0;
+    }
+
+    bool equal(std::size_t idx, std::size_t hc,
+               const util::string_view& key) const
+    {
+        return table_[idx].hc == hc && this->key_equal((*this)[idx].key(), key);
+    }
+
+    const_value_type operator[](std::size_t idx) const
+    {
+        const auto& pr = storage_[table_[idx].idx - 1];
+        return {pr.first, pr.second};
+    }
+
+    value_type operator[](std::size_t idx)
+    {
+        auto& pr = storage_[table_[idx].idx - 1];
+        return {pr.first, pr.second};
+    }
+
+    template <class... Args>
+    void put(std::size_t idx, std::size_t hc, Args&&... args)
+    {
+        auto pr = std::pair<util::string_view, V>(std::forward<Args>(args)...);
+        if (occupied(idx))
+        {
+            // the key is already in the arena
+            storage_[table_[idx].idx - 1].second = std::move(pr.second);
+        }
+        else
+        {
+            table_[idx].idx = storage_.size() + 1;
+            storage_.emplace_back(arena_.intern(pr.first),
+                                  std::move(pr.second));
+        }
+        table_[idx].hc = hc;
+    }
+
+    std::size_t size() const
+    {
+        return storage_.size();
+    }
+
+    std::size_t capacity() const
+    {
+        return table_.size();
+    }
+
+    void clear()
+    {
+        kv_vector_type{}.swap(storage_);
+        arena_.clear();
+        std::fill(std::begin(table_), std::end(table_), hash_idx{});
+        this->reset_control(capacity());
+    }
+
+    void resize(std::size_t new_cap)
+    {
+        assert(new_cap > capacity());
+
+        table_.resize(new_cap);
+        std::fill(std::begin(table_), std::end(table_), hash_idx{});
+        this->reset_control(new_cap);
+
+        for (std::size_t i = 0; i < storage_.size(); ++i)
+        {
+            auto hc = this->hash(storage_[i].first);
+            auto nidx = this->get_idx(storage_[i].first, hc);
+            table_[nidx].hc = hc;
+            table_[nidx].idx = i + 1;
+            this->set_control(nidx, hc);
+        }
+    }
+
+    std::size_t bytes_used() const
+    {
+        return sizeof(hash_idx) * table_.capacity()
+               + sizeof(std::pair<util::string_view, V>) * storage_.capacity()
+               + arena_.bytes_used() + this->control_bytes_used();
+    }
+
+    /**
+     * @return the (key, value) pairs in the table, with the keys copied
+     * out of the arena
+     */
+    std::vector<std::pair<std::string, V>> extract() &&
+    {
+        std::vector<std::pair<std::string, V>> ret;
+        ret.reserve(storage_.size());
+        for (auto& pr : storage_)
+            ret.emplace_back(pr.first.to_string(), std::move(pr.second));
+
+        idx_vector_type{}.swap(table_);
+        kv_vector_type{}.swap(storage_);
+        arena_.clear();
+        return ret;
+    }
+
+    idx_vector_type table_;
+    kv_vector_type storage_;
+    util::string_arena arena_;
+};
+
+/**
+ * A specialization of the storage_traits configuration point for
+ * arena_key_value_storage.
+ */
+template <class V, class ProbingStrategy, class Hash, class KeyEqual>
+struct storage_traits<arena_key_value_storage<V, ProbingStrategy, Hash,
+                                              KeyEqual>>
+{
+    using type = arena_key_value_storage<V, ProbingStrategy, Hash, KeyEqual>;
+    using iterator = key_value_storage_iterator<type>;
+    using const_iterator = key_value_storage_iterator<const type>;
+    using stored_type = std::pair<util::string_view, V>;
+    using key_type = util::string_view;
+    using probing_strategy = ProbingStrategy;
+    using hash_type = Hash;
+    using equal_type = KeyEqual;
+
+    static const key_type& get_key(const stored_type& st)
+    {
+        return st.first;
+    }
+};
 }
 }
 #endif
@@ -121,6 +121,32 @@ struct hash_traits<kv_pair<K, V>>
         typename std::conditional<key_traits<K>::inlineable,
                                   key_inlineable_probe_entry, hash_idx>::type;
 };
+
+/**
+ * A traits class for hash *tables* with std::string keys that stores the
+ * bytes of the keys in a contiguous arena (see arena_key_value_storage)
+ * rather than as individual std::strings. This avoids one allocation per
+ * key longer than the small-string buffer, and releases all of the keys
+ * at once on clear().
+ *
+ * Use it as the Traits parameter of probe_map (or use string_arena_map).
+ * Keys are exposed as util::string_views, and equality defaults to
+ * comparing the views.
+ */
+template <class V>
+struct string_arena_traits
+{
+    template <class ProbingStrategy, class Hash, class KeyEqual>
+    using storage_type = arena_key_value_storage<
+        V, ProbingStrategy, Hash,
+        typename std::conditional<std::is_same<KeyEqual,
+                                               std::equal_to<std::string>>::
+                                      value,
+                                  std::equal_to<util::string_view>,
+                                  KeyEqual>::type>;
+
+    using probe_entry = hash_idx;
+};
 }
 }
 #endif
@@ -166,6 +166,96 @@ inline uint64_t hash_len_33_to_64(const uint8_t* data, std::size_t len)
     return hash_len_16(rotate(e + f, 43) + rotate(g, 30) + h,
                        e + rotate(f + a, 18) + g, mul);
 }
+
+#if defined(_MSC_VER)                                                          \
+    || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define META_FARM_HASH_LITTLE_ENDIAN 1
+/**
+ * Loads 1 to 7 bytes as an integer, as fetch() would if the bytes past
+ * the end were zero.
+ */
+inline uint64_t fetch_partial(const uint8_t* data, std::size_t len)
+{
+    if (len >= 4)
+        return uint64_t{fetch<uint32_t>(data)}
+               | uint64_t{fetch<uint32_t>(data + len - 4)} << (8 * (len - 4));
+    return uint64_t{data[0]} | uint64_t{data[len / 2]} << (8 * (len / 2))
+           | uint64_t{data[len - 1]} << (8 * (len - 1));
+}
+#endif
+
+/**
+ * Computes the hash of the len bytes at data followed by len itself (as a
+ * std::size_t), which is what hash_append() feeds a hasher for a string,
+ * for inputs of at most 64 bytes.
+ *
+ * On little endian machines the key is read in place, rather than being
+ * copied into a buffer along with its length.
+ */
+inline uint64_t hash_len_with_length(const uint8_t* data, std::size_t len)
+{
+    const auto total = len + sizeof(std::size_t);
+    assert(total <= 64);
+#ifdef META_FARM_HASH_LITTLE_ENDIAN
+    if (sizeof(std::size_t) == 8)
+    {
+        // the last 8 bytes of the input are always the length
+        const auto mul = k2 + total * 2;
+        const uint64_t length = len;
+        if (len <= 8)
+        {
+            // same as hash_len_0_to_16(), where the first 8 bytes are
+            // the key followed by the start of the length
+            uint64_t a = 0;
+            if (len == 8)
+                a = fetch<uint64_t>(data);
+            else if (len > 0)
+                a = fetch_partial(data, len) | length << (8 * len);
+            a += k2;
+            auto c = rotate(length, 37) * mul + a;
+            auto d = (rotate(a, 25) + length) * mul;
+            return hash_len_16(c, d, mul);
+        }
+
+        if (len <= 24)
+        {
+            // same as hash_len_17_to_32()
+            auto a = fetch<uint64_t>(data) * k1;
+            auto b = len >= 16 ? fetch<uint64_t>(data + 8)
+                               : fetch_partial(data + 8, len - 8)
+                                     | length << (8 * (len - 8));
+            auto c = length * mul;
+            auto d = fetch<uint64_t>(data + len - 8) * k2;
+            return hash_len_16(rotate(a + b, 43) + rotate(c, 30) + d,
+                               a + rotate(b + k2, 18) + c, mul);
+        }
+
+        // same as hash_len_33_to_64()
+        auto a = fetch<uint64_t>(data) * k2;
+        auto b = fetch<uint64_t>(data + 8);
+        auto c = length * mul;
+        auto d = fetch<uint64_t>(data + len - 8) * k2;
+        auto y = rotate(a + b, 43) + rotate(c, 30) + d;
+        auto z = hash_len_16(y, a + rotate(b + k2, 18) + c, mul);
+        auto e = fetch<uint64_t>(data + 16) * mul;
+        auto f = len >= 32 ? fetch<uint64_t>(data + 24)
+                           : fetch_partial(data + 24, len - 24)
+                                 | length << (8 * (len - 24));
+        auto g = (y + fetch<uint64_t>(data + len - 24)) * mul;
+        auto h = (z + fetch<uint64_t>(data + len - 16)) * mul;
+        return hash_len_16(rotate(e + f, 43) + rotate(g, 30) + h,
+                           e + rotate(f + a, 18) + g, mul);
+    }
+#endif
+    std::array<uint8_t, 64> buffer;
+    std::memcpy(buffer.data(), data, len);
+    std::memcpy(buffer.data() + len, &len, sizeof(std::size_t));
+    if (total <= 16)
+        return hash_len_0_to_16(buffer.data(), total);
+    if (total <= 32)
+        return hash_len_17_to_32(buffer.data(), total);
+    return hash_len_33_to_64(buffer.data(), total);
+}
 }
 
 /**
@@ -302,6 +392,26 @@ class farm_hash
         buf_pos_ = buf_start + (len - bytes);
     }
 
+    /**
+     * Hashes a string's characters followed by its length, giving the
+     * same result as hash_append() on the string and then converting to
+     * result_type, but without going through the streaming buffer for
+     * short strings. Must only be called on a freshly constructed hasher.
+     *
+     * @param data The characters of the string
+     * @param len The length of the string
+     */
+    inline result_type hash_string(const char* data, std::size_t len)
+    {
+        if (len + sizeof(std::size_t) <= 64)
+            return farm::hash_len_with_length(
+                reinterpret_cast<const uint8_t*>(data), len);
+
+        (*this)(data, len);
+        (*this)(&len, sizeof(len));
+        return static_cast<result_type>(*this);
+    }
+
     inline explicit operator result_type()
     {
         auto buf_start = reinterpret_cast<uint8_t*>(buffer_.data());
@@ -354,6 +464,15 @@ class farm_hash_seeded : public farm_hash
         // nothing
     }
 
+    /**
+     * @see farm_hash::hash_string
+     */
+    inline result_type hash_string(const char* data, std::size_t len)
+    {
+        auto result = farm_hash::hash_string(data, len);
+        return farm::hash_len_16(result - seed_.low, seed_.high);
+    }
+
     inline explicit operator result_type()
     {
         auto result = static_cast<result_type>(static_cast<farm_hash&>(*this));
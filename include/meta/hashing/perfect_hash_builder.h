@@ -11,10 +11,13 @@
 #define META_HASHING_PERFECT_HASH_BUILDER_H_
 
 #include <cstdint>
+#include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "meta/config.h"
+#include "meta/parallel/thread_pool.h"
 
 namespace meta
 {
@@ -49,6 +52,13 @@ namespace hashing
  * Empirically, our algorithm approaches somewhere in the neighborhood of
  * ~2.7 bits per key with our default settings.
  *
+ * Hashing and sorting the buffered chunks, and the seed search itself, run
+ * on a thread_pool of options::num_threads threads. Buckets are always
+ * placed in the same order (by size, then by bucket id) and each bucket
+ * always gets the smallest seed that works, so the hash written is
+ * identical for any number of threads (and any max_ram) given the same
+ * keys and options::seed.
+ *
  * @see http://cmph.sourceforge.net/papers/esa09.pdf
  */
 template <class K>
@@ -62,6 +72,8 @@ class perfect_hash_builder
         uint64_t num_keys;
         uint64_t num_per_bucket = 4;
         float load_factor = 0.99f;
+        uint64_t seed = 0x9e3779b97f4a7c15; // seed for the bucket hash
+        std::size_t num_threads = std::thread::hardware_concurrency();
 
         options() = default;
         options(const options&) = default;
@@ -94,6 +106,8 @@ class perfect_hash_builder
     template <class Iterator>
     void flush_bucket_chunk(Iterator begin, Iterator end);
 
+    std::vector<uint64_t> empty_slots(const std::vector<bool>& occupied);
+
     void merge_chunks_by_bucket_size();
     void sort_buckets_by_size();
     void construct_perfect_hash();
@@ -110,6 +124,9 @@ class perfect_hash_builder
     /// The current number of chunks that have been flushed to disk
     uint64_t num_chunks_;
 
+    /// The threads used for hashing, sorting, and the seed search
+    std::unique_ptr<parallel::thread_pool> pool_;
+
     struct hashed_key
     {
         uint64_t idx;
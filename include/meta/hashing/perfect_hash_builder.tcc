@@ -9,19 +9,20 @@
 
 #include <algorithm>
 #include <fstream>
-#include <random>
 #include "meta/hashing/hash.h"
 #include "meta/hashing/probe_set.h"
 #include "meta/io/filesystem.h"
 #include "meta/io/moveable_stream.h"
 #include "meta/io/packed.h"
 #include "meta/logging/logger.h"
+#include "meta/parallel/algorithm.h"
 #include "meta/succinct/compressed_vector.h"
 #include "meta/succinct/sarray.h"
 #include "meta/util/array_view.h"
 #include "meta/util/disk_vector.h"
 #include "meta/util/multiway_merge.h"
 #include "meta/util/printing.h"
+#include "meta/util/shim.h"
 #include "perfect_hash_builder.h"
 
 namespace meta
@@ -91,16 +92,29 @@ farm_hash_seeded::result_type hash(const K& key, uint64_t seed)
     hash_append(hasher, key);
     return static_cast<farm_hash_seeded::result_type>(hasher);
 }
+
+/**
+ * The order buckets are placed in: larger buckets first, with ties broken
+ * by bucket id so that the order doesn't depend on how the buckets were
+ * chunked.
+ */
+inline bool place_before(std::size_t a_size, uint64_t a_idx,
+                         std::size_t b_size, uint64_t b_idx)
+{
+    return a_size > b_size || (a_size == b_size && a_idx < b_idx);
+}
 }
 
 template <class K>
 perfect_hash_builder<K>::perfect_hash_builder(options opts)
     : opts_(opts), // parens to force bad compilers to locate cctor
       num_buckets_{opts.num_keys / opts.num_per_bucket + 1},
-      num_chunks_{0}
+      num_chunks_{0},
+      pool_{make_unique<parallel::thread_pool>(
+          std::max<std::size_t>(opts.num_threads, 1))}
 {
     filesystem::make_directory(opts_.prefix);
-    bucket_seed_ = std::random_device{}();
+    bucket_seed_ = opts_.seed;
 
     buffer_.reserve(opts_.max_ram / sizeof(hashed_key));
 }
@@ -114,7 +128,14 @@ void perfect_hash_builder<K>::flush_chunk()
     auto filename
         = opts_.prefix + "/chunk-" + std::to_string(num_chunks_) + ".bin";
 
-    std::sort(buffer_.begin(), buffer_.end());
+    parallel::parallel_for(buffer_.begin(), buffer_.end(), *pool_,
+                           [&](hashed_key& hk)
+                           {
+                               hk.idx = mph::hash(hk.key, bucket_seed_)
+                                        % num_buckets_;
+                           });
+    parallel::sort(buffer_.begin(), buffer_.end(), *pool_);
+
     std::ofstream output{filename, std::ios::binary};
     for (auto it = buffer_.begin(); it != buffer_.end();)
     {
@@ -138,7 +159,8 @@ void perfect_hash_builder<K>::operator()(const K& key)
 {
     if (buffer_.size() == buffer_.capacity())
         flush_chunk();
-    buffer_.emplace_back(mph::hash(key, bucket_seed_) % num_buckets_, key);
+    // the bucket is assigned when the chunk is flushed, in parallel
+    buffer_.emplace_back(0, key);
 }
 
 template <class K>
@@ -194,20 +216,21 @@ void perfect_hash_builder<K>::sort_buckets_by_size()
     //
     // the total RAM usage is approximately
     // num_buf_keys * sizeof(K)
-    // + num_buckets / num_keys * num_buf_keys * sizeof(array_view)
+    // + num_buckets / num_keys * num_buf_keys * sizeof(bucket_view)
     // which is solved to get the number of buffered keys we should have
 
+    using bucket_view = std::pair<uint64_t, util::array_view<K>>;
     auto num_buf_keys = static_cast<std::size_t>(
         opts_.max_ram
         / (sizeof(K)
-           + sizeof(util::array_view<K>) * static_cast<double>(num_buckets_)
+           + sizeof(bucket_view) * static_cast<double>(num_buckets_)
                  / opts_.num_keys));
 
     auto num_buf_buckets = static_cast<std::size_t>(
         num_buf_keys * static_cast<double>(num_buckets_) / opts_.num_keys);
 
     std::vector<K> buffered_keys(num_buf_keys);
-    std::vector<util::array_view<K>> buckets(num_buf_buckets);
+    std::vector<bucket_view> buckets(num_buf_buckets);
 
     auto insert_it = buffered_keys.begin();
     auto bucket_it = buckets.begin();
@@ -234,7 +257,8 @@ void perfect_hash_builder<K>::sort_buckets_by_size()
 
         auto bucket_end
             = std::move(bucket.keys.begin(), bucket.keys.end(), insert_it);
-        *bucket_it++ = util::array_view<K>{&*insert_it, bucket.keys.size()};
+        *bucket_it++ = bucket_view{
+            bucket.idx, util::array_view<K>{&*insert_it, bucket.keys.size()}};
         insert_it = bucket_end;
     }
 
@@ -246,22 +270,22 @@ template <class K>
 template <class Iterator>
 void perfect_hash_builder<K>::flush_bucket_chunk(Iterator begin, Iterator end)
 {
-    std::sort(begin, end,
-              [](const util::array_view<K>& a, const util::array_view<K>& b)
-              {
-                  return a.size() > b.size();
-              });
+    using bucket_view = std::pair<uint64_t, util::array_view<K>>;
+    parallel::sort(begin, end, *pool_,
+                   [](const bucket_view& a, const bucket_view& b)
+                   {
+                       return mph::place_before(a.second.size(), a.first,
+                                                b.second.size(), b.first);
+                   });
 
     std::ofstream chunk{opts_.prefix + "/chunk-" + std::to_string(num_chunks_)
                             + ".bin",
                         std::ios::binary};
-    std::for_each(begin, end, [&](const util::array_view<K>& bucket)
+    std::for_each(begin, end, [&](const bucket_view& bucket)
                   {
-                      io::packed::write(chunk, bucket.size());
-                      io::packed::write(chunk,
-                                        mph::hash(bucket[0], bucket_seed_)
-                                            % num_buckets_);
-                      for (const auto& key : bucket)
+                      io::packed::write(chunk, bucket.second.size());
+                      io::packed::write(chunk, bucket.first);
+                      for (const auto& key : bucket.second)
                           io::packed::write(chunk, key);
                   });
     ++num_chunks_;
@@ -284,7 +308,8 @@ void perfect_hash_builder<K>::merge_chunks_by_bucket_size()
         // (descending) rather than their bucket index
         [](const mph::bucket_record<K>& a, const mph::bucket_record<K>& b)
         {
-            return a.keys.size() > b.keys.size();
+            return mph::place_before(a.keys.size(), a.idx, b.keys.size(),
+                                     b.idx);
         },
         // never merge two records together
         [](const mph::bucket_record<K>&, const mph::bucket_record<K>&)
@@ -360,6 +385,49 @@ inline bool insert_bucket(std::vector<uint64_t>& indices,
         return true;
     }
 }
+
+/**
+ * A bucket waiting to be placed during the seed search.
+ */
+template <class K>
+struct pending_bucket
+{
+    bucket_record<K> record;
+    std::vector<uint64_t> hashes;
+    /// No seed smaller than this one can place the bucket
+    uint32_t first_seed;
+};
+
+/**
+ * Finds the first seed, starting at first_seed, that places all of a
+ * bucket's keys into distinct unoccupied slots without modifying
+ * occupied_slots.
+ *
+ * @return the seed, or max_seed if there isn't one
+ */
+inline uint32_t find_seed(const std::vector<uint64_t>& hashes,
+                          const std::vector<bool>& occupied_slots,
+                          std::size_t num_bins, uint32_t first_seed,
+                          uint32_t max_seed)
+{
+    std::vector<uint64_t> indices(hashes.size());
+    for (auto seed = first_seed; seed < max_seed; ++seed)
+    {
+        hashes_to_indices(hashes.begin(), hashes.end(), indices.begin(), seed,
+                          num_bins);
+        if (std::any_of(indices.begin(), indices.end(), [&](uint64_t i)
+                        {
+                            return occupied_slots[i];
+                        }))
+            continue;
+
+        std::sort(indices.begin(), indices.end());
+        if (std::adjacent_find(indices.begin(), indices.end())
+            == indices.end())
+            return seed;
+    }
+    return max_seed;
+}
 }
 
 template <class K>
@@ -374,34 +442,67 @@ void perfect_hash_builder<K>::construct_perfect_hash()
                                           num_buckets_};
 
         {
+            // buckets are read in batches, and each bucket in a batch
+            // searches for a seed in parallel against the slots occupied
+            // before the batch. Slots are only ever added, so any seed
+            // rejected there would also be rejected after the earlier
+            // buckets in the batch are placed; placing the buckets in
+            // order starting from those seeds yields exactly the seeds
+            // a sequential search would find.
+            const uint32_t max_probes = std::numeric_limits<uint16_t>::max();
+            const std::size_t batch_size = 1024 * pool_->size();
+            std::vector<mph::pending_bucket<K>> batch;
+            batch.reserve(batch_size);
+
             mph::chunk_iterator<K> it{opts_.prefix + "/buckets.bin"};
             printing::progress progress{" > Constructing hash: ",
                                         it.total_bytes()};
-            for (; it != mph::chunk_iterator<K>{}; ++it)
+            while (it != mph::chunk_iterator<K>{})
             {
+                batch.clear();
+                for (; it != mph::chunk_iterator<K>{}
+                       && batch.size() < batch_size;
+                     ++it)
+                {
+                    batch.emplace_back();
+                    batch.back().record = std::move(*it);
+                }
                 progress(it.bytes_read());
-                const auto& bucket = *it;
-
-                auto hashes = mph::hashes_for_bucket(bucket, bucket_seed_);
 
-                std::vector<uint64_t> indices(bucket.keys.size());
-                bool success = false;
-                const uint16_t max_probes
-                    = std::numeric_limits<uint16_t>::max();
-                for (uint16_t i = 0; i < max_probes && !success; ++i)
+                parallel::parallel_for(
+                    batch.begin(), batch.end(), *pool_,
+                    [&](mph::pending_bucket<K>& bucket)
+                    {
+                        bucket.hashes = mph::hashes_for_bucket(bucket.record,
+                                                               bucket_seed_);
+                        bucket.first_seed
+                            = mph::find_seed(bucket.hashes, occupied_slots,
+                                             num_bins, 0, max_probes);
+                    });
+
+                for (const auto& bucket : batch)
                 {
-                    auto seed = static_cast<uint64_t>(i);
-
-                    mph::hashes_to_indices(hashes.begin(), hashes.end(),
-                                           indices.begin(), seed, num_bins);
-
-                    success = mph::insert_bucket(indices, occupied_slots,
-                                                 bucket.idx, i, seeds);
+                    std::vector<uint64_t> indices(bucket.hashes.size());
+                    bool success = false;
+                    for (auto i = bucket.first_seed; i < max_probes && !success;
+                         ++i)
+                    {
+                        auto seed = static_cast<uint64_t>(i);
+
+                        mph::hashes_to_indices(bucket.hashes.begin(),
+                                               bucket.hashes.end(),
+                                               indices.begin(), seed,
+                                               num_bins);
+
+                        success = mph::insert_bucket(
+                            indices, occupied_slots, bucket.record.idx,
+                            static_cast<uint16_t>(i), seeds);
+                    }
+                    if (!success)
+                        throw std::runtime_error{
+                            "could not find a seed for a bucket in "
+                            "minimal perfect hash generation"};
                 }
-                if (!success)
-                    throw std::runtime_error{
-                        "could not find a seed for a bucket in "
-                        "minimal perfect hash generation"};
             }
         }
 
@@ -418,13 +519,7 @@ void perfect_hash_builder<K>::construct_perfect_hash()
 
     // minify the hash using a succinct::sarray + sarray_rank to compress
     // the range via rank() queries
-    std::vector<uint64_t> positions;
-    positions.reserve(occupied_slots.size() - opts_.num_keys);
-    for (std::size_t i = 0; i < occupied_slots.size(); ++i)
-    {
-        if (!occupied_slots[i])
-            positions.push_back(i);
-    }
+    auto positions = empty_slots(occupied_slots);
     std::vector<bool>{}.swap(occupied_slots);
     auto storage = succinct::make_sarray(
         opts_.prefix + "/sarray", positions.begin(), positions.end(), num_bins);
@@ -437,5 +532,37 @@ void perfect_hash_builder<K>::construct_perfect_hash()
 
     LOG(progress) << "> Minimum perfect hash constructed\n" << ENDLG;
 }
+template <class K>
+std::vector<uint64_t>
+perfect_hash_builder<K>::empty_slots(const std::vector<bool>& occupied)
+{
+    // each thread scans a contiguous block of slots; the blocks are
+    // concatenated in order, so the positions stay sorted
+    auto block_size = occupied.size() / pool_->size() + 1;
+    std::vector<std::future<std::vector<uint64_t>>> futures;
+    for (std::size_t start = 0; start < occupied.size(); start += block_size)
+    {
+        futures.emplace_back(pool_->submit_task([&, start]()
+                                                {
+            std::vector<uint64_t> positions;
+            auto end = std::min(start + block_size, occupied.size());
+            for (auto i = start; i < end; ++i)
+            {
+                if (!occupied[i])
+                    positions.push_back(i);
+            }
+            return positions;
+        }));
+    }
+
+    std::vector<uint64_t> positions;
+    positions.reserve(occupied.size() - opts_.num_keys);
+    for (auto& fut : futures)
+    {
+        auto block = fut.get();
+        positions.insert(positions.end(), block.begin(), block.end());
+    }
+    return positions;
+}
 }
 }
@@ -27,7 +27,8 @@ namespace hashing
  * - Key: the data type to be stored, which must have a valid hash function
  * - Value: the data type to be mapped to
  * - ProbingStrategy: The strategy to use when probing the table (defaults
- *   to probing::binary)
+ *   to probing::binary). probing::group additionally keeps a control byte
+ *   per slot so that lookups compare a whole group of slots at once.
  * - ResizingRatio: The ratio (> 1) to increase the table size by when
  *   resizing (defaults to std::ratio<3, 2>)
  * - Hash: The hash function to use (defaults to hashing::hash<>)
@@ -119,6 +120,15 @@ class probe_map
         return it->value();
     }
 };
+
+/**
+ * A probe_map from std::string keys whose bytes are stored in an arena
+ * (see string_arena_traits). Keys are exposed as util::string_views.
+ */
+template <class Value, class ProbingStrategy = probing::binary>
+using string_arena_map
+    = probe_map<std::string, Value, ProbingStrategy, hash<>,
+                std::equal_to<std::string>, string_arena_traits<Value>>;
 }
 }
 #endif
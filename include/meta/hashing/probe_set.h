@@ -30,7 +30,8 @@ namespace hashing
  * The behavior of the set is configurable via the template parameters:
  * - Key: the data type to be stored, which must have a valid hash function
  * - ProbingStrategy: The strategy to use when probing the table (defaults
- *   to probing::binary)
+ *   to probing::binary). probing::group additionally keeps a control byte
+ *   per slot so that lookups compare a whole group of slots at once.
  * - ResizingRatio: The ratio (> 1) to increase the table size by when
  *   resizing (defaults to std::ratio<3, 2>)
  * - Hash: The hash function to use (defaults to hashing::hash<>)
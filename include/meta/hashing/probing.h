@@ -147,6 +147,46 @@ class binary_hybrid
     std::size_t max_;
 };
 
+/**
+ * Group probing in the style of Swiss tables (Abseil, F14). Slots are
+ * probed linearly, starting at the beginning of the group of group_size
+ * slots that the hash falls into.
+ *
+ * When used with probe_map or probe_set, the storage additionally keeps
+ * one control byte per slot holding seven bits of the slot's hash code
+ * (or a flag for an empty slot). Each group of control bytes is then
+ * compared against a key's tag at once (with SSE2, if available), and
+ * full key comparisons are only made for slots whose tag matches. The
+ * slots visited, and therefore the table layout, are identical to the
+ * ones given by probe().
+ */
+class group
+{
+  public:
+    const static std::size_t group_size = 16;
+
+    group(std::size_t hash, std::size_t capacity)
+        : idx_{(hash % capacity) & ~(group_size - 1)}, capacity_{capacity}
+    {
+        // nothing
+    }
+
+    /**
+     * @return the next index to probe in the table
+     */
+    std::size_t probe()
+    {
+        auto idx = idx_++;
+        if (idx_ == capacity_)
+            idx_ = 0;
+        return idx;
+    }
+
+  private:
+    std::size_t idx_;
+    std::size_t capacity_;
+};
+
 // http://stackoverflow.com/questions/2348187
 //     /moving-from-linear-probing-to-quadratic-probing-hash-collisons
 class quadratic
@@ -13,6 +13,7 @@
 #include <memory>
 
 #include "meta/config.h"
+#include "meta/index/postings_data.h"
 
 namespace cpptoml
 {
@@ -66,11 +67,19 @@ class cached_index : public Index
      */
     void clear_cache();
 
+    using cache_type
+        = Cache<primary_key_type, std::shared_ptr<postings_data_type>>;
+
+    /**
+     * @return the underlying cache, e.g. for reading its hit rate
+     */
+    const cache_type& cache() const;
+
   private:
     /**
      * The internal cache object.
      */
-    mutable Cache<primary_key_type, std::shared_ptr<postings_data_type>> cache_;
+    mutable cache_type cache_;
 };
 }
 }
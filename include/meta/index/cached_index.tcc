@@ -36,5 +36,11 @@ void cached_index<Index, Cache>::clear_cache()
 {
     cache_.clear();
 }
+
+template <class Index, template <class, class> class Cache>
+auto cached_index<Index, Cache>::cache() const -> const cache_type&
+{
+    return cache_;
+}
 }
 }
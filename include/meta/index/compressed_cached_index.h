@@ -0,0 +1,117 @@
+/**
+ * @file compressed_cached_index.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_COMPRESSED_CACHED_INDEX_H_
+#define META_COMPRESSED_CACHED_INDEX_H_
+
+#include <memory>
+#include <string>
+
+#include "meta/config.h"
+#include "meta/index/postings_data.h"
+#include "meta/util/optional.h"
+
+namespace cpptoml
+{
+class table;
+}
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Decorator class for wrapping indexes with a cache of their compressed
+ * postings lists. Unlike cached_index, which caches fully decoded
+ * postings_data objects (roughly 16 bytes per posting), this caches the
+ * packed bytes of each postings list as they appear in the postings file
+ * (typically a few bytes per posting) and decodes them lazily as the
+ * postings_stream returned by stream_for() is iterated. This fits
+ * several times more postings lists into the same cache budget, which
+ * matters most when the index lives on slow or networked storage.
+ *
+ * The cache holds postings_streams that own their bytes. Streams
+ * returned from stream_for() share them, so they remain valid after the
+ * bytes are evicted; iterators must not outlive the stream that created
+ * them.
+ *
+ * Like other indexes, you shouldn't construct this directly, but rather
+ * use make_index():
+ *
+ * ~~~cpp
+ * using index_type
+ *     = index::compressed_cached_index<index::inverted_index,
+ *                                      caching::default_tinylfu_cache>;
+ * auto idx = index::make_index<index_type>(config, uint64_t{1 << 26});
+ * ~~~
+ */
+template <class Index, template <class, class> class Cache>
+class compressed_cached_index : public Index
+{
+  public:
+    /**
+     * Forwarding constructor: construct the Index part using the
+     * config, but then forward the additional arguments to the
+     * underlying cache.
+     *
+     * @param config the configuration that specifies how the index
+     *  should be constructed
+     * @param args The remaining arguments to send to the Cache
+     *  constructor
+     */
+    template <class... Args>
+    compressed_cached_index(const cpptoml::table& config, Args&&... args);
+
+    using primary_key_type = typename Index::primary_key_type;
+    using secondary_key_type = typename Index::secondary_key_type;
+    using postings_data_type = typename Index::postings_data_type;
+    using postings_stream_type = typename Index::postings_stream_type;
+    using cache_type = Cache<primary_key_type, postings_stream_type>;
+
+    /**
+     * Overload for stream_for() that first attempts to find the
+     * compressed postings list in the cache. Failing that, it will copy
+     * the bytes out of the postings file and store them in the cache.
+     *
+     * @param p_id the primary key to search the postings file for
+     */
+    virtual util::optional<postings_stream_type>
+    stream_for(primary_key_type p_id) const override;
+
+    /**
+     * Overload for search_primary() that decodes the (possibly cached)
+     * postings stream for the primary key.
+     *
+     * @param p_id the primary key to search the postings file for
+     */
+    virtual std::shared_ptr<postings_data_type>
+    search_primary(primary_key_type p_id) const override;
+
+    /**
+     * Clears the cache for the index.
+     */
+    void clear_cache();
+
+    /**
+     * @return the underlying cache, e.g. for reading its hit rate
+     */
+    const cache_type& cache() const;
+
+  private:
+    /**
+     * The internal cache object.
+     */
+    mutable cache_type cache_;
+};
+}
+}
+
+#include "meta/index/compressed_cached_index.tcc"
+#endif
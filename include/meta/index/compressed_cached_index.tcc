@@ -0,0 +1,61 @@
+/**
+ * @file compressed_cached_index.tcc
+ * @author Chase Geigle
+ */
+
+#include "meta/index/compressed_cached_index.h"
+
+namespace meta
+{
+namespace index
+{
+
+template <class Index, template <class, class> class Cache>
+template <class... Args>
+compressed_cached_index<Index, Cache>::compressed_cached_index(
+    const cpptoml::table& config, Args&&... args)
+    : Index{config}, cache_(std::forward<Args>(args)...)
+{
+    /* nothing */
+}
+
+template <class Index, template <class, class> class Cache>
+auto compressed_cached_index<Index, Cache>::stream_for(
+    primary_key_type p_id) const -> util::optional<postings_stream_type>
+{
+    auto opt = cache_.find(p_id);
+    if (opt)
+        return opt;
+
+    auto bytes = Index::postings_bytes(p_id);
+    if (!bytes)
+        return util::nullopt;
+
+    postings_stream_type result{bytes->to_string()};
+    cache_.insert(p_id, result);
+    return {std::move(result)};
+}
+
+template <class Index, template <class, class> class Cache>
+auto compressed_cached_index<Index, Cache>::search_primary(
+    primary_key_type p_id) const -> std::shared_ptr<postings_data_type>
+{
+    auto pdata = std::make_shared<postings_data_type>(p_id);
+    if (auto stream = stream_for(p_id))
+        pdata->set_counts(stream->begin(), stream->end());
+    return pdata;
+}
+
+template <class Index, template <class, class> class Cache>
+void compressed_cached_index<Index, Cache>::clear_cache()
+{
+    cache_.clear();
+}
+
+template <class Index, template <class, class> class Cache>
+auto compressed_cached_index<Index, Cache>::cache() const -> const cache_type&
+{
+    return cache_;
+}
+}
+}
@@ -12,6 +12,7 @@
 #define META_DISK_INDEX_H_
 
 #include <memory>
+#include <stdexcept>
 #include <vector>
 
 #include "meta/config.h"
@@ -45,10 +46,40 @@ namespace meta
 namespace index
 {
 
+/**
+ * Basic exception for disk_index interactions.
+ */
+class disk_index_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
 /**
  * Holds generic data structures and functions that inverted_index and
  * forward_index both use. Provides common interface for both and is implemented
  * using the pointer-to-implementation method.
+ *
+ * Optional config parameters, which tune how each kind of index file is
+ * memory mapped when the index is loaded (see io::mmap_options):
+ * ~~~toml
+ * [mmap.postings] # also: mmap.vocabulary, mmap.metadata
+ * access = "random" # or "normal" (default), "sequential"
+ * populate = true # prefault the file at load; default false
+ * huge-pages = true # request transparent huge pages; default false
+ * lock = false # mlock() the file; default false
+ * ~~~
+ *
+ * Setting `term-id-hash = true` additionally builds a minimal perfect hash
+ * from terms to term_ids when the index is loaded for the first time, which
+ * get_term_id() then uses instead of searching the vocabulary's B+-tree.
+ *
+ * Setting `term-bloom-filter = true` builds a blocked bloom filter over the
+ * vocabulary the same way; get_term_id() consults it first, so most terms
+ * that aren't in the index are rejected after touching a single cache line.
+ *
+ * Setting `term-dictionary = true` builds a sorted, front-coded copy of the
+ * vocabulary the same way, which prefix_terms() searches.
  */
 class disk_index
 {
@@ -164,6 +195,16 @@ class disk_index
      */
     term_id get_term_id(const std::string& term);
 
+    /**
+     * @param prefix The prefix to search for
+     * @return the ids of every term that starts with prefix, ordered by
+     * the terms' text
+     * @throw disk_index_exception if the index has no term dictionary
+     * (because `term-dictionary` isn't set, or the index is a forward
+     * index read from libsvm files)
+     */
+    std::vector<term_id> prefix_terms(const std::string& prefix) const;
+
     /**
      * @param t_id The term_id to get the original text for
      * @return the string representation of the term
@@ -10,13 +10,18 @@
 #ifndef META_INDEX_DISK_INDEX_IMPL_H_
 #define META_INDEX_DISK_INDEX_IMPL_H_
 
+#include <memory>
 #include <mutex>
 
 #include "meta/config.h"
+#include "meta/hashing/blocked_bloom_filter.h"
+#include "meta/hashing/perfect_hash_map.h"
 #include "meta/index/disk_index.h"
+#include "meta/index/front_coded_vocabulary.h"
 #include "meta/index/metadata_file.h"
 #include "meta/index/string_list.h"
 #include "meta/index/vocabulary_map.h"
+#include "meta/io/mmap_file.h"
 #include "meta/util/disk_vector.h"
 #include "meta/util/invertible_map.h"
 #include "meta/util/optional.h"
@@ -40,7 +45,8 @@ enum index_file
     TERM_IDS_MAPPING,
     TERM_IDS_MAPPING_INVERSE,
     METADATA_DB,
-    METADATA_INDEX
+    METADATA_INDEX,
+    TERM_IDS_DICTIONARY
 };
 
 /**
@@ -73,6 +79,34 @@ class disk_index::disk_index_impl
      */
     void load_term_id_mapping();
 
+    /**
+     * Builds the minimal perfect hash from terms to term_ids out of the
+     * vocabulary_map, which must already be loaded, replacing any that
+     * was built before, and records which vocabulary it was built from.
+     */
+    void build_term_id_hash();
+
+    /**
+     * Builds the bloom filter over the terms in the vocabulary_map, which
+     * must already be loaded, and saves it to disk after a record of
+     * which vocabulary it was built from.
+     */
+    void build_term_filter();
+
+    /**
+     * Builds the front-coded term dictionary out of the vocabulary_map,
+     * which must already be loaded.
+     *
+     * @return whether the dictionary could be written
+     */
+    bool build_term_dictionary();
+
+    /**
+     * @param term The term to look up
+     * @return the term_id for the term, if it is in the vocabulary
+     */
+    util::optional<term_id> find_term_id(const std::string& term) const;
+
     /**
      * Loads the label_id mapping.
      */
@@ -106,6 +140,11 @@ class disk_index::disk_index_impl
      */
     label_id get_label_id(const class_label& lbl);
 
+    /**
+     * @return the options for mapping the postings file
+     */
+    const io::mmap_options& postings_mmap_options() const;
+
   private:
     /// the location of this index
     std::string index_name_;
@@ -122,9 +161,42 @@ class disk_index::disk_index_impl
     /// Maps string terms to term_ids.
     util::optional<vocabulary_map> term_id_mapping_;
 
+    /// Sorted, front-coded term dictionary for prefix queries, if enabled
+    util::optional<front_coded_vocabulary> term_dictionary_;
+
+    /// Whether term_dictionary_ should be built and used
+    bool use_term_dictionary_ = false;
+
+    /// The type of the hash-based term to term_id map
+    using term_id_hash_type
+        = hashing::perfect_hash_map<util::string_view, uint64_t>;
+
+    /// Hash-based term lookup, if enabled; term_id_mapping_ is still used
+    /// for going from term_ids to terms
+    std::unique_ptr<term_id_hash_type> term_id_hash_;
+
+    /// Whether term_id_hash_ should be built and used
+    bool use_term_id_hash_ = false;
+
+    /// Rejects most terms that aren't in the vocabulary before they are
+    /// searched for, if enabled
+    util::optional<hashing::blocked_bloom_filter> term_filter_;
+
+    /// Whether term_filter_ should be built and used
+    bool use_term_filter_ = false;
+
     /// Assigns an integer to each class label (used for liblinear mappings)
     util::invertible_map<class_label, label_id> label_ids_;
 
+    /// how to map the postings file
+    io::mmap_options postings_mmap_;
+
+    /// how to map the vocabulary file
+    io::mmap_options vocabulary_mmap_;
+
+    /// how to map the metadata database
+    io::mmap_options metadata_mmap_;
+
     /// mutex for thread-safe operations
     mutable std::mutex mutex_;
 };
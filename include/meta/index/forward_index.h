@@ -20,6 +20,7 @@
 #include "meta/meta.h"
 #include "meta/util/disk_vector.h"
 #include "meta/util/optional.h"
+#include "meta/util/string_view.h"
 
 namespace meta
 {
@@ -81,6 +82,7 @@ class forward_index : public disk_index
     using primary_key_type = doc_id;
     using secondary_key_type = term_id;
     using postings_data_type = postings_data<doc_id, term_id, double>;
+    using postings_stream_type = postings_stream<term_id, double>;
     using inverted_pdata_type = postings_data<term_id, doc_id, uint64_t>;
     using index_pdata_type = postings_data<doc_id, term_id, uint64_t>;
     using exception = forward_index_exception;
@@ -130,9 +132,16 @@ class forward_index : public disk_index
      * @param d_id The doc_id to search for
      * @return the postings stream for a given doc_id
      */
-    util::optional<postings_stream<term_id, double>>
+    virtual util::optional<postings_stream_type>
     stream_for(doc_id d_id) const;
 
+    /**
+     * @param d_id The doc_id to search for
+     * @return the compressed bytes of the postings list for a given
+     * doc_id, which are valid for the lifetime of this index
+     */
+    util::optional<util::string_view> postings_bytes(doc_id d_id) const;
+
     /**
      * @param d_id The document id of the doc to convert to liblinear format
      * @return the string representation liblinear format
@@ -0,0 +1,212 @@
+/**
+ * @file front_coded_vocabulary.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_FRONT_CODED_VOCABULARY_H_
+#define META_INDEX_FRONT_CODED_VOCABULARY_H_
+
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "meta/config.h"
+#include "meta/io/mmap_file.h"
+#include "meta/meta.h"
+#include "meta/util/optional.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * A read-only, front-coded dictionary of the terms in an index, written
+ * by front_coded_vocabulary_writer (see its documentation for the file
+ * format). Terms are stored in sorted order and the term_id of a term is
+ * its rank, so the dictionary supports ordered operations like
+ * lower_bound() and prefix_range() in addition to exact lookup in both
+ * directions.
+ */
+class front_coded_vocabulary
+{
+  public:
+    /**
+     * A forward iterator over the terms in the dictionary, in sorted
+     * order. Dereferencing yields the current term; id() yields its
+     * term_id.
+     */
+    class const_iterator
+    {
+      public:
+        using value_type = std::string;
+        using reference = const std::string&;
+        using pointer = const std::string*;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::forward_iterator_tag;
+
+        /**
+         * Constructs an invalid iterator.
+         */
+        const_iterator();
+
+        /**
+         * Advances to the next term.
+         */
+        const_iterator& operator++();
+
+        /**
+         * Postfix increment.
+         */
+        const_iterator operator++(int);
+
+        /**
+         * @return the current term
+         */
+        reference operator*() const;
+
+        /**
+         * @return a pointer to the current term
+         */
+        pointer operator->() const;
+
+        /**
+         * @return the term_id of the current term
+         */
+        term_id id() const;
+
+        /**
+         * @param other The iterator to compare with
+         * @return whether both iterators point at the same term
+         */
+        bool operator==(const const_iterator& other) const;
+
+        /**
+         * @param other The iterator to compare with
+         * @return whether the iterators point at different terms
+         */
+        bool operator!=(const const_iterator& other) const;
+
+      private:
+        friend front_coded_vocabulary;
+
+        /**
+         * Constructs an iterator pointing at the first term of a bucket.
+         * @param vocab The dictionary being iterated over
+         * @param id The id of the first term in the bucket (or the size
+         * of the dictionary for the end iterator)
+         */
+        const_iterator(const front_coded_vocabulary* vocab, term_id id);
+
+        /// The dictionary being iterated over
+        const front_coded_vocabulary* vocab_;
+        /// The id of the current term
+        term_id id_;
+        /// The position of the next encoded term in the current bucket
+        const char* pos_;
+        /// The current (decoded) term
+        std::string term_;
+    };
+
+    /**
+     * @param path The path to the dictionary file written by a
+     * front_coded_vocabulary_writer
+     * @param options Hints for how the file should be mapped
+     */
+    front_coded_vocabulary(const std::string& path,
+                           const io::mmap_options& options = {});
+
+    /**
+     * Move constructs a front_coded_vocabulary.
+     */
+    front_coded_vocabulary(front_coded_vocabulary&&) = default;
+
+    /**
+     * Move assigns a front_coded_vocabulary.
+     */
+    front_coded_vocabulary& operator=(front_coded_vocabulary&&) = default;
+
+    /**
+     * @param term The term to find
+     * @return the term_id of the term, if it exists
+     */
+    util::optional<term_id> find(util::string_view term) const;
+
+    /**
+     * Finds the term associated with the given id. No bounds checking is
+     * performed---accessing beyond the maximum term_id is undefined
+     * behavior.
+     *
+     * @param t_id The term_id to find the string representation of
+     */
+    std::string find_term(term_id t_id) const;
+
+    /**
+     * @param term The term to search for
+     * @return an iterator to the first term that is not less than term
+     */
+    const_iterator lower_bound(util::string_view term) const;
+
+    /**
+     * @param prefix The prefix to search for
+     * @return the range of terms (in sorted order) that start with prefix
+     */
+    std::pair<const_iterator, const_iterator>
+    prefix_range(util::string_view prefix) const;
+
+    /**
+     * @return an iterator to the first term
+     */
+    const_iterator begin() const;
+
+    /**
+     * @return an iterator past the last term
+     */
+    const_iterator end() const;
+
+    /**
+     * @return the number of terms in the dictionary
+     */
+    uint64_t size() const;
+
+  private:
+    /**
+     * @param bucket The bucket to read the head term of
+     * @return the first term in the bucket
+     */
+    util::string_view bucket_head(uint64_t bucket) const;
+
+    /// The file containing the front-coded buckets
+    io::mmap_file file_;
+
+    /// The byte position of each bucket in file_
+    const uint64_t* buckets_;
+
+    /// The number of buckets
+    uint64_t num_buckets_;
+
+    /// The number of terms in the dictionary
+    uint64_t size_;
+
+    /// The number of terms in each bucket
+    uint64_t bucket_size_;
+};
+
+/**
+ * An exception that can be thrown while reading a front_coded_vocabulary.
+ */
+class front_coded_vocabulary_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+}
+}
+#endif
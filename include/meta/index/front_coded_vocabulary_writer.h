@@ -0,0 +1,95 @@
+/**
+ * @file front_coded_vocabulary_writer.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_INDEX_FRONT_CODED_VOCABULARY_WRITER_H_
+#define META_INDEX_FRONT_CODED_VOCABULARY_WRITER_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "meta/config.h"
+
+namespace meta
+{
+namespace index
+{
+
+/**
+ * Writes a sorted list of terms as a front-coded dictionary that can be
+ * read with front_coded_vocabulary.
+ *
+ * The terms are split into buckets of a fixed number of terms. The first
+ * term in each bucket is stored in full (its packed length followed by its
+ * bytes); every other term is stored as the packed length of the prefix it
+ * shares with the previous term, the packed length of the remaining
+ * suffix, and the suffix bytes. Each bucket begins on a 64-byte
+ * (cache line) boundary, so decoding a term touches as few cache lines as
+ * possible, and lookups can binary search on the bucket heads before
+ * scanning a single bucket.
+ *
+ * The file begins with a 64-byte header containing the number of terms,
+ * the bucket size, the number of buckets, and the position of the bucket
+ * offset array, which follows the last bucket.
+ *
+ * The terms must be inserted in sorted order, and the file is not
+ * portable across endianness.
+ */
+class front_coded_vocabulary_writer
+{
+  public:
+    /// The alignment of each bucket in the file
+    const static constexpr uint64_t alignment = 64;
+
+    /**
+     * @param path The path to the dictionary file to write
+     * @param bucket_size The number of terms in each bucket
+     */
+    front_coded_vocabulary_writer(const std::string& path,
+                                  uint64_t bucket_size = 16);
+
+    /**
+     * Writes the bucket offsets and the header.
+     */
+    ~front_coded_vocabulary_writer();
+
+    /**
+     * Inserts this term into the dictionary. It must be lexicographically
+     * larger than every term inserted so far.
+     *
+     * @param term The term to insert
+     * @throw vocabulary_map_writer_exception if term is not larger than
+     * the last term inserted
+     */
+    void insert(const std::string& term);
+
+  private:
+    /**
+     * Writes null bytes until the write position is a multiple of the
+     * given alignment.
+     */
+    void pad_to(uint64_t align);
+
+    /// The file being written
+    std::ofstream file_;
+    /// The current write position in file_
+    uint64_t file_write_pos_;
+    /// The number of terms in each bucket
+    uint64_t bucket_size_;
+    /// The number of terms inserted so far
+    uint64_t num_terms_;
+    /// The position of each bucket in file_
+    std::vector<uint64_t> buckets_;
+    /// The last term inserted
+    std::string prev_;
+};
+}
+}
+#endif
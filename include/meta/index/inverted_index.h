@@ -19,6 +19,8 @@
 #include "meta/index/disk_index.h"
 #include "meta/index/make_index.h"
 #include "meta/index/postings_stream.h"
+#include "meta/util/optional.h"
+#include "meta/util/string_view.h"
 
 namespace meta
 {
@@ -68,6 +70,7 @@ class inverted_index : public disk_index
     using primary_key_type = term_id;
     using secondary_key_type = doc_id;
     using postings_data_type = postings_data<term_id, doc_id, uint64_t>;
+    using postings_stream_type = postings_stream<doc_id>;
     using index_pdata_type = postings_data<std::string, doc_id, uint64_t>;
     using exception = inverted_index_exception;
 
@@ -142,7 +145,15 @@ class inverted_index : public disk_index
      * @param t_id The trem_id to search for
      * @return the postings stream for a given term_id
      */
-    util::optional<postings_stream<doc_id>> stream_for(term_id t_id) const;
+    virtual util::optional<postings_stream_type>
+    stream_for(term_id t_id) const;
+
+    /**
+     * @param t_id The term_id to search for
+     * @return the compressed bytes of the postings list for a given
+     * term_id, which are valid for the lifetime of this index
+     */
+    util::optional<util::string_view> postings_bytes(term_id t_id) const;
 
     /**
      * @param t_id The term to search for
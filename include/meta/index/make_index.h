@@ -16,6 +16,7 @@
 #include "meta/config.h"
 #include "meta/corpus/corpus_factory.h"
 #include "meta/index/cached_index.h"
+#include "meta/index/compressed_cached_index.h"
 #include "meta/io/filesystem.h"
 
 namespace meta
@@ -53,7 +53,8 @@ class metadata_file
     /**
      * Opens the metadata file stored at prefix.
      */
-    metadata_file(const std::string& prefix);
+    metadata_file(const std::string& prefix,
+                  const io::mmap_options& options = {});
 
     /**
      * Obtains metadata for a document. The object returned is a proxy and
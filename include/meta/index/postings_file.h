@@ -10,18 +10,32 @@
 #ifndef META_INDEX_POSTINGS_FILE_H_
 #define META_INDEX_POSTINGS_FILE_H_
 
+#include <stdexcept>
+#include <string>
+
 #include "meta/config.h"
 #include "meta/index/postings_data.h"
 #include "meta/index/postings_stream.h"
 #include "meta/io/mmap_file.h"
+#include "meta/io/packed.h"
 #include "meta/util/disk_vector.h"
 #include "meta/util/optional.h"
+#include "meta/util/string_view.h"
 
 namespace meta
 {
 namespace index
 {
 
+/**
+ * An exception that can be thrown while reading a postings_file.
+ */
+class postings_file_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
 /**
  * File that stores the postings list for an index on disk. Each postings
  * list is indexed via PrimaryKey and consists of pairs of (SecondaryKey,
@@ -37,9 +51,11 @@ class postings_file
     /**
      * Opens a postings file.
      * @param filename The path to the file
+     * @param options Hints for how the file should be mapped
      */
-    postings_file(const std::string& filename)
-        : postings_{filename}, byte_locations_{filename + "_index"}
+    postings_file(const std::string& filename,
+                  const io::mmap_options& options = {})
+        : postings_{filename, options}, byte_locations_{filename + "_index"}
     {
         // nothing
     }
@@ -59,6 +75,40 @@ class postings_file
         return util::nullopt;
     }
 
+    /**
+     * Obtains the still-compressed bytes of the postings list for the
+     * given primary key, including its size and total counts. A
+     * postings_stream can be constructed over a copy of these bytes.
+     *
+     * @param pk The primary key to look up
+     * @return a view of the bytes in the postings file, if the primary
+     * key is in the postings file
+     */
+    util::optional<util::string_view> find_bytes(PrimaryKey pk) const
+    {
+        if (pk >= byte_locations_.size())
+            return util::nullopt;
+
+        // every written list takes at least two bytes, so only the first
+        // key may start at zero; later keys at zero were never written
+        auto begin = byte_locations_.at(pk);
+        if (begin == 0 && pk != PrimaryKey{0})
+            return util::nullopt;
+        if (begin >= postings_.size())
+            throw postings_file_exception{
+                "postings for key " + std::to_string(uint64_t{pk})
+                + " begin past the end of " + postings_.path()};
+
+        // the next key's location only bounds this list if that key was
+        // written; otherwise, measure the list by decoding it
+        auto end = pk + 1 < byte_locations_.size()
+                       ? byte_locations_.at(pk + 1)
+                       : postings_.size();
+        if (end <= begin || end > postings_.size())
+            end = begin + packed_length(pk, begin);
+        return util::string_view{postings_.begin() + begin, end - begin};
+    }
+
     /**
      * Obtains a postings data object for the given primary key.
      * @param pk The primary key to look up
@@ -81,6 +131,56 @@ class postings_file
     }
 
   private:
+    /**
+     * A char stream over the postings file that refuses to read past its
+     * end.
+     */
+    struct bounded_input_stream
+    {
+        char get()
+        {
+            if (input_ == end_)
+                throw postings_file_exception{
+                    "postings list runs past the end of the postings file"};
+            return *input_++;
+        }
+
+        const char* input_;
+        const char* end_;
+    };
+
+    /**
+     * @param pk The primary key of the postings list
+     * @param begin The location of the postings list
+     * @return the number of bytes taken by the packed postings list
+     */
+    uint64_t packed_length(PrimaryKey pk, uint64_t begin) const
+    {
+        bounded_input_stream stream{postings_.begin() + begin,
+                                    postings_.begin() + postings_.size()};
+        uint64_t size;
+        FeatureValue value;
+        try
+        {
+            io::packed::read(stream, size);
+            io::packed::read(stream, value);
+            for (uint64_t i = 0; i < size; ++i)
+            {
+                uint64_t gap;
+                io::packed::read(stream, gap);
+                io::packed::read(stream, value);
+            }
+        }
+        catch (const postings_file_exception&)
+        {
+            throw postings_file_exception{
+                "postings for key " + std::to_string(uint64_t{pk})
+                + " run past the end of " + postings_.path()};
+        }
+        return static_cast<uint64_t>(stream.input_ - postings_.begin())
+               - begin;
+    }
+
     io::mmap_file postings_;
     util::disk_vector<const uint64_t> byte_locations_;
 };
@@ -39,6 +39,16 @@ class postings_file_writer
         // nothing
     }
 
+    /**
+     * Marks the keys that were never written as empty. Without this, the
+     * last location holds whatever byte was used to size the file.
+     */
+    ~postings_file_writer()
+    {
+        for (; id_ < byte_locations_.size(); ++id_)
+            byte_locations_[id_] = 0;
+    }
+
     /**
      * Writes a postings data object to the file.
      *
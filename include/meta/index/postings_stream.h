@@ -10,7 +10,9 @@
 #ifndef META_INDEX_POSTINGS_STREAM_H_
 #define META_INDEX_POSTINGS_STREAM_H_
 
+#include <atomic>
 #include <iterator>
+#include <string>
 #include <tuple>
 #include <utility>
 
@@ -47,7 +49,30 @@ class postings_stream
         const char* input_;
     };
 
+    /**
+     * A copy of the bytes of a postings list, shared by the streams that
+     * read from it.
+     */
+    struct shared_bytes
+    {
+        shared_bytes(std::string buffer) : bytes{std::move(buffer)}, refs{1}
+        {
+            // nothing
+        }
+
+        std::string bytes;
+        std::atomic<uint64_t> refs;
+    };
+
   public:
+    /**
+     * Creates an empty postings stream.
+     */
+    postings_stream() : start_{nullptr}, size_{0}, total_counts_{0}
+    {
+        // nothing
+    }
+
     /**
      * Creates a postings stream reading from the given buffer. Assumes
      * that the size and total counts are the first two values in the
@@ -55,13 +80,25 @@ class postings_stream
      *
      * @param buffer The buffer position to the start of the postings
      */
-    postings_stream(const char* buffer) : start_{buffer}
+    postings_stream(const char* buffer)
     {
-        char_input_stream stream{start_};
+        read_header(buffer);
+    }
 
-        io::packed::read(stream, size_);
-        io::packed::read(stream, total_counts_);
-        start_ = stream.input_;
+    /**
+     * Creates a postings stream that owns a copy of the bytes it reads
+     * from, which it shares with its copies, so they remain valid after
+     * whatever cache produced them has evicted its own. Streams created
+     * any other way own nothing and never touch a reference count.
+     * Assumes that the size and total counts are the first two values in
+     * the buffer.
+     *
+     * @param buffer The bytes of the postings list
+     */
+    explicit postings_stream(std::string buffer)
+        : owner_{new shared_bytes{std::move(buffer)}}
+    {
+        read_header(owner_->bytes.data());
     }
 
     /**
@@ -77,6 +114,53 @@ class postings_stream
         // nothing
     }
 
+    /**
+     * Copies a postings stream, sharing the bytes it owns, if any.
+     */
+    postings_stream(const postings_stream& other)
+        : start_{other.start_},
+          size_{other.size_},
+          total_counts_{other.total_counts_},
+          owner_{other.owner_}
+    {
+        if (owner_)
+            owner_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Moves a postings stream, taking over the bytes it owns, if any.
+     */
+    postings_stream(postings_stream&& other) noexcept
+        : start_{other.start_},
+          size_{other.size_},
+          total_counts_{other.total_counts_},
+          owner_{other.owner_}
+    {
+        other.owner_ = nullptr;
+    }
+
+    /**
+     * Assigns a postings stream by copying or moving it.
+     */
+    postings_stream& operator=(postings_stream other) noexcept
+    {
+        std::swap(start_, other.start_);
+        std::swap(size_, other.size_);
+        std::swap(total_counts_, other.total_counts_);
+        std::swap(owner_, other.owner_);
+        return *this;
+    }
+
+    /**
+     * Releases the bytes this stream owns, if any.
+     */
+    ~postings_stream()
+    {
+        if (owner_
+            && owner_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete owner_;
+    }
+
     /**
      * @return the number of SecondaryKeys in this postings list.
      */
@@ -94,6 +178,16 @@ class postings_stream
         return total_counts_;
     }
 
+    /**
+     * @return the number of bytes used by this stream and the bytes it
+     * owns, for byte-budgeted caches
+     */
+    uint64_t bytes_used() const
+    {
+        return sizeof(*this)
+               + (owner_ ? sizeof(*owner_) + owner_->bytes.capacity() : 0);
+    }
+
     /**
      * Writes this postings stream to an output stream in packed format.
      * @return the number of bytes written
@@ -213,9 +307,24 @@ class postings_stream
     }
 
   private:
+    /**
+     * Reads the size and total counts from the front of the buffer and
+     * starts the postings after them.
+     */
+    void read_header(const char* buffer)
+    {
+        char_input_stream stream{buffer};
+
+        io::packed::read(stream, size_);
+        io::packed::read(stream, total_counts_);
+        start_ = stream.input_;
+    }
+
     const char* start_;
     uint64_t size_;
     FeatureValue total_counts_;
+    /// The bytes start_ points into, if this stream owns them
+    shared_bytes* owner_ = nullptr;
 };
 }
 }
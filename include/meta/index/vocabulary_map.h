@@ -74,8 +74,10 @@ class vocabulary_map
      *
      * @param path the location of the tree file
      * @param block_size the size of the nodes in the tree
+     * @param options hints for how the tree file should be mapped
      */
-    vocabulary_map(const std::string& path, uint16_t block_size = 4096);
+    vocabulary_map(const std::string& path, uint16_t block_size = 4096,
+                   const io::mmap_options& options = {});
 
     /**
      * Move constructs a vocabulary_map.
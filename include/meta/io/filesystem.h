@@ -81,6 +81,13 @@ bool exists(const std::string& path);
  */
 uint64_t file_size(const std::string& filename);
 
+/**
+ * @param filename The path for the file
+ * @return the time the file was last modified, in seconds since the
+ * epoch, or zero if it could not be determined
+ */
+int64_t last_modified(const std::string& filename);
+
 /**
  * Copies a file source to file dest.
  * @param source The source file
@@ -14,16 +14,28 @@
 
 #include <istream>
 #include <ostream>
+#include <stdexcept>
 #include <streambuf>
 #include <vector>
 
 #include "meta/config.h"
+#include "meta/io/readahead_streambuf.h"
 
 namespace meta
 {
 namespace io
 {
 
+/**
+ * An exception that can be thrown while opening, reading, or inflating a
+ * gzip file.
+ */
+class gz_exception : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
 class gzstreambuf : public std::streambuf
 {
   public:
@@ -58,6 +70,36 @@ class gzifstream : public std::istream
     gzstreambuf buffer_;
 };
 
+/**
+ * An input stream for gzip-compressed files that decompresses on a
+ * background thread, using large blocks, ahead of the reader.
+ *
+ * If the file consists of BGZF members (as written by bgzip), whose
+ * headers record their compressed size, the members are additionally
+ * inflated in parallel using the given number of threads. Any other gzip
+ * file (including plain multi-member files) is inflated sequentially on
+ * the background thread.
+ */
+class readahead_gzifstream : public std::istream
+{
+  public:
+    /**
+     * @param name The name of the file to read
+     * @param num_threads The number of threads to use to inflate BGZF
+     * members (ignored for other gzip files)
+     * @param block_size The (approximate) size of the blocks passed to the
+     * reader
+     */
+    explicit readahead_gzifstream(const std::string& name,
+                                  std::size_t num_threads = 1,
+                                  std::size_t block_size = 1024 * 1024);
+
+    readahead_streambuf* rdbuf() const;
+
+  private:
+    readahead_streambuf buffer_;
+};
+
 class gzofstream : public std::ostream
 {
   public:
@@ -21,6 +21,40 @@ namespace meta
 namespace io
 {
 
+/**
+ * The expected pattern of access to a memory mapped file, used to tune
+ * the kernel's readahead behavior.
+ */
+enum class access_pattern
+{
+    normal,
+    sequential,
+    random
+};
+
+/**
+ * Hints and requirements for how a file should be memory mapped. The
+ * defaults leave all behavior to the operating system. Hints that are not
+ * supported on the current platform are ignored.
+ */
+struct mmap_options
+{
+    /// The expected access pattern (via madvise())
+    access_pattern access = access_pattern::normal;
+
+    /// Whether to prefault the whole file into the page cache at map time
+    /// (MAP_POPULATE, or MADV_WILLNEED where that is unavailable)
+    bool populate = false;
+
+    /// Whether to request transparent huge pages for the mapping; this is
+    /// only honored for file mappings by kernels that support it
+    bool huge_pages = false;
+
+    /// Whether to pin the mapping in memory (mlock()); failure to do so
+    /// (e.g., due to RLIMIT_MEMLOCK) is an error
+    bool lock = false;
+};
+
 /**
  * Memory maps a text file readonly.
  */
@@ -30,8 +64,9 @@ class mmap_file
     /**
      * Constructor.
      * @param path Path to the text file to open
+     * @param options Hints for how the file should be mapped
      */
-    mmap_file(const std::string& path);
+    mmap_file(const std::string& path, const mmap_options& options = {});
 
     /**
      * Move constructor.
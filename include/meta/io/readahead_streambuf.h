@@ -0,0 +1,93 @@
+/**
+ * @file readahead_streambuf.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_IO_READAHEAD_STREAMBUF_H_
+#define META_IO_READAHEAD_STREAMBUF_H_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#include "meta/config.h"
+
+namespace meta
+{
+namespace io
+{
+
+/**
+ * An input streambuf that produces its blocks of data on a background
+ * thread. A producer function is repeatedly invoked on that thread to
+ * fill (large) blocks of bytes, and up to a fixed number of filled blocks
+ * are queued ahead of the reader. This allows expensive work like
+ * decompression to proceed concurrently with parsing the data that was
+ * already produced.
+ *
+ * The producer is called with an empty block to fill and returns whether
+ * there may be more data after this block. Any exception thrown by the
+ * producer is rethrown from underflow() once all of the blocks produced
+ * before it have been consumed.
+ */
+class readahead_streambuf : public std::streambuf
+{
+  public:
+    /// The type of the function used to produce blocks
+    using producer_type = std::function<bool(std::vector<char>&)>;
+
+    /**
+     * @param producer The function used to fill blocks
+     * @param num_buffers The maximum number of filled blocks to queue
+     * ahead of the reader (the default of 2 is double buffering)
+     */
+    readahead_streambuf(producer_type producer, std::size_t num_buffers = 2);
+
+    /**
+     * Stops and joins the background thread.
+     */
+    ~readahead_streambuf();
+
+    int_type underflow() override;
+
+  private:
+    /**
+     * The loop run by the background thread.
+     */
+    void run();
+
+    /// The function used to fill blocks
+    producer_type producer_;
+    /// The maximum number of filled blocks to queue
+    std::size_t num_buffers_;
+    /// The block currently being read from
+    std::vector<char> current_;
+    /// Filled blocks waiting to be read
+    std::deque<std::vector<char>> full_;
+    /// Consumed blocks waiting to be reused by the producer
+    std::vector<std::vector<char>> free_;
+    /// Whether the producer has finished
+    bool done_;
+    /// Whether the background thread should stop early
+    bool stop_;
+    /// The exception thrown by the producer, if any
+    std::exception_ptr error_;
+    /// The mutex protecting the queues and flags
+    std::mutex mutex_;
+    /// The condition variable used to signal queue changes
+    std::condition_variable cond_;
+    /// The background thread running the producer
+    std::thread thread_;
+};
+}
+}
+#endif
@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "meta/config.h"
+#include "meta/io/readahead_streambuf.h"
 
 namespace meta
 {
@@ -87,6 +88,26 @@ class xzifstream : public std::istream
     xzstreambuf buffer_;
 };
 
+/**
+ * An input stream for xz-compressed files that decompresses on a
+ * background thread, using large blocks, ahead of the reader.
+ */
+class readahead_xzifstream : public std::istream
+{
+  public:
+    /**
+     * @param name The name of the file to read
+     * @param block_size The size of the blocks passed to the reader
+     */
+    explicit readahead_xzifstream(const std::string& name,
+                                  std::size_t block_size = 1024 * 1024);
+
+    readahead_streambuf* rdbuf() const;
+
+  private:
+    readahead_streambuf buffer_;
+};
+
 class xzofstream : public std::ostream
 {
   public:
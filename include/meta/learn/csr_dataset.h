@@ -0,0 +1,602 @@
+/**
+ * @file csr_dataset.h
+ * @author Chase Geigle
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_LEARN_CSR_DATASET_H_
+#define META_LEARN_CSR_DATASET_H_
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/learn/dataset.h"
+#include "meta/util/comparable.h"
+#include "meta/util/random.h"
+
+namespace meta
+{
+namespace learn
+{
+
+namespace detail
+{
+/**
+ * Converts a feature weight to the type it is stored as. Integral types
+ * hold rounded weights, saturated to the type's range.
+ */
+template <class Value>
+Value quantize(double weight, std::true_type /* is_integral */)
+{
+    auto rounded = std::round(weight);
+    if (rounded <= static_cast<double>(std::numeric_limits<Value>::lowest()))
+        return std::numeric_limits<Value>::lowest();
+    if (rounded >= static_cast<double>(std::numeric_limits<Value>::max()))
+        return std::numeric_limits<Value>::max();
+    return static_cast<Value>(rounded);
+}
+
+template <class Value>
+Value quantize(double weight, std::false_type /* is_integral */)
+{
+    return static_cast<Value>(weight);
+}
+
+template <class Value>
+Value quantize(double weight)
+{
+    return quantize<Value>(weight, std::is_integral<Value>{});
+}
+}
+
+/**
+ * A non-owning view of the features of one instance in a
+ * basic_csr_dataset. Iterating over it yields (feature_id, double) pairs
+ * by value, so it can be used in place of a feature_vector by code that
+ * only reads the pairs' first and second members.
+ */
+template <class Value>
+class basic_feature_span
+{
+  public:
+    using value_type = std::pair<feature_id, double>;
+
+    class iterator
+        : public std::iterator<std::input_iterator_tag, value_type,
+                               std::ptrdiff_t, const value_type*, value_type>
+    {
+      public:
+        iterator(const uint32_t* id, const Value* value)
+            : id_{id}, value_{value}
+        {
+            // nothing
+        }
+
+        value_type operator*() const
+        {
+            return {feature_id{*id_}, static_cast<double>(*value_)};
+        }
+
+        iterator& operator++()
+        {
+            ++id_;
+            ++value_;
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            auto ret = *this;
+            ++(*this);
+            return ret;
+        }
+
+        bool operator==(const iterator& other) const
+        {
+            return id_ == other.id_;
+        }
+
+        bool operator!=(const iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+      private:
+        const uint32_t* id_;
+        const Value* value_;
+    };
+
+    basic_feature_span(const uint32_t* ids, const Value* values,
+                       std::size_t size)
+        : ids_{ids}, values_{values}, size_{size}
+    {
+        // nothing
+    }
+
+    iterator begin() const
+    {
+        return {ids_, values_};
+    }
+
+    iterator end() const
+    {
+        return {ids_ + size_, values_ + size_};
+    }
+
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    /**
+     * @return the feature ids, in increasing order
+     */
+    const uint32_t* ids() const
+    {
+        return ids_;
+    }
+
+    /**
+     * @return the feature weights, parallel to ids()
+     */
+    const Value* values() const
+    {
+        return values_;
+    }
+
+    /**
+     * @return a copy of the features as a feature_vector
+     */
+    feature_vector to_feature_vector() const
+    {
+        return feature_vector{begin(), end()};
+    }
+
+  private:
+    const uint32_t* ids_;
+    const Value* values_;
+    std::size_t size_;
+};
+
+/**
+ * Stores the feature vectors of a set of instances in compressed sparse
+ * row (CSR) form: the feature ids and weights of all instances are held in
+ * two contiguous arrays, and a third array holds the offset of each
+ * instance's features within them.
+ *
+ * Compared to a dataset, whose instances each own a separate vector of
+ * 16-byte (feature_id, double) pairs, this stores 32-bit feature ids and
+ * Value weights with no per-instance allocation. Training loops that walk
+ * the instances in order then read memory sequentially.
+ *
+ * Value may be float, or an integral type (like uint16_t for term counts)
+ * in which case weights are rounded and saturated to its range.
+ */
+template <class Value = float>
+class basic_csr_dataset
+{
+  public:
+    using value_type = Value;
+    using feature_span = basic_feature_span<Value>;
+    using size_type = std::size_t;
+
+    /**
+     * An instance in the dataset. Unlike learn::instance, this is a
+     * lightweight handle that is returned by value.
+     */
+    struct instance_type
+    {
+        /// the id within the dataset that contains this instance
+        instance_id id;
+        /// the weights of the features in this instance
+        feature_span weights;
+    };
+
+    /**
+     * Compacts an in-memory dataset. The instances keep their positions,
+     * so instance ids (and labels) carry over.
+     */
+    explicit basic_csr_dataset(const dataset& dset)
+        : basic_csr_dataset{dset.total_features()}
+    {
+        reserve(dset.size(), std::accumulate(
+                                 dset.begin(), dset.end(), uint64_t{0},
+                                 [](uint64_t accum, const instance& inst)
+                                 {
+                                     return accum + inst.weights.size();
+                                 }));
+        for (const auto& inst : dset)
+            push_back(inst.weights);
+    }
+
+    /**
+     * Creates a dataset from a forward_index and a range of doc_ids,
+     * represented as iterators. Each document's postings are decoded
+     * straight into the CSR arrays.
+     */
+    template <class ForwardIterator,
+              class ProgressTrait = printing::default_progress_trait>
+    basic_csr_dataset(std::shared_ptr<index::forward_index> idx,
+                      ForwardIterator begin, ForwardIterator end,
+                      ProgressTrait = ProgressTrait{})
+        : basic_csr_dataset{idx->unique_terms()}
+    {
+        auto size = static_cast<uint64_t>(std::distance(begin, end));
+        offsets_.reserve(size + 1);
+
+        typename ProgressTrait::type progress{
+            " > Loading instances into memory: ", size};
+        for (uint64_t doc = 0; begin != end; ++begin, ++doc)
+        {
+            progress(doc);
+            auto stream = idx->stream_for(*begin);
+            push_back(*stream);
+        }
+    }
+
+    /**
+     * @param idx The index of the instance in the dataset
+     * @return the instance at that index
+     */
+    instance_type operator()(size_type idx) const
+    {
+        auto first = offsets_.at(idx);
+        auto last = offsets_.at(idx + 1);
+        return {instance_id{idx},
+                feature_span{ids_.data() + first, values_.data() + first,
+                             static_cast<std::size_t>(last - first)}};
+    }
+
+    /**
+     * @return the number of instances in the dataset
+     */
+    size_type size() const
+    {
+        return offsets_.size() - 1;
+    }
+
+    /**
+     * @return the number of features in the dataset
+     */
+    size_type total_features() const
+    {
+        return total_features_;
+    }
+
+    /**
+     * @return the total number of nonzero features over all instances
+     */
+    uint64_t num_nonzeros() const
+    {
+        return ids_.size();
+    }
+
+    /**
+     * @return the number of bytes used to store the instances
+     */
+    uint64_t bytes_used() const
+    {
+        return offsets_.capacity() * sizeof(uint64_t)
+               + ids_.capacity() * sizeof(uint32_t)
+               + values_.capacity() * sizeof(Value);
+    }
+
+  private:
+    basic_csr_dataset(size_type total_features)
+        : offsets_(1, 0), total_features_{total_features}
+    {
+        if (total_features_ > std::numeric_limits<uint32_t>::max())
+            throw std::runtime_error{
+                "too many features for a csr_dataset (ids are 32 bits)"};
+    }
+
+    void reserve(size_type num_instances, uint64_t num_nonzeros)
+    {
+        offsets_.reserve(num_instances + 1);
+        ids_.reserve(num_nonzeros);
+        values_.reserve(num_nonzeros);
+    }
+
+    template <class FeatureRange>
+    void push_back(const FeatureRange& weights)
+    {
+        for (const auto& pr : weights)
+        {
+            ids_.push_back(static_cast<uint32_t>(pr.first));
+            values_.push_back(detail::quantize<Value>(pr.second));
+        }
+        offsets_.push_back(ids_.size());
+    }
+
+    /// the offset of each instance's features, plus one past the last
+    std::vector<uint64_t> offsets_;
+    /// the feature ids of all instances
+    std::vector<uint32_t> ids_;
+    /// the feature weights of all instances
+    std::vector<Value> values_;
+    /// the total number of unique features in the dataset
+    size_type total_features_;
+};
+
+using csr_dataset = basic_csr_dataset<float>;
+
+/**
+ * A basic_csr_dataset that also stores a label for each instance.
+ */
+template <class LabelType, class Value = float>
+class labeled_csr_dataset : public basic_csr_dataset<Value>
+{
+  public:
+    using label_type = LabelType;
+    using instance_type = typename basic_csr_dataset<Value>::instance_type;
+
+    /**
+     * Compacts an in-memory labeled dataset, like a multiclass_dataset.
+     */
+    explicit labeled_csr_dataset(const labeled_dataset<LabelType>& dset)
+        : basic_csr_dataset<Value>{dset}
+    {
+        labels_.reserve(dset.size());
+        for (const auto& inst : dset)
+            labels_.push_back(dset.label(inst));
+    }
+
+    /**
+     * Creates a dataset from a forward_index, a range of doc_ids, and a
+     * LabelFunction to assign labels to doc_ids.
+     */
+    template <class ForwardIterator, class LabelFunction,
+              class ProgressTrait = printing::default_progress_trait>
+    labeled_csr_dataset(std::shared_ptr<index::forward_index> idx,
+                        ForwardIterator begin, ForwardIterator end,
+                        LabelFunction&& labeller,
+                        ProgressTrait = ProgressTrait{})
+        : basic_csr_dataset<Value>{idx, begin, end, ProgressTrait{}}
+    {
+        labels_.reserve(this->size());
+        std::transform(begin, end, std::back_inserter(labels_), labeller);
+    }
+
+    /**
+     * @return the label for an instance
+     */
+    label_type label(const instance_type& inst) const
+    {
+        return labels_.at(inst.id);
+    }
+
+  private:
+    /// the (dense) mapping from instance_id -> label
+    std::vector<label_type> labels_;
+};
+
+/**
+ * A non-owning, shuffleable view of a basic_csr_dataset (or a
+ * labeled_csr_dataset), analogous to dataset_view. Its iterators yield
+ * instances by value.
+ */
+template <class Dataset>
+class csr_dataset_view
+{
+  public:
+    using instance_type = typename Dataset::instance_type;
+    using size_type = typename Dataset::size_type;
+
+    class iterator : public std::iterator<std::random_access_iterator_tag,
+                                          instance_type, std::ptrdiff_t,
+                                          const instance_type*, instance_type>,
+                     public util::comparable<iterator>
+    {
+      public:
+        using difference_type = std::ptrdiff_t;
+
+        /**
+         * Holds an instance so that operator-> can return a pointer to it.
+         */
+        struct arrow_proxy
+        {
+            instance_type inst;
+
+            const instance_type* operator->() const
+            {
+                return &inst;
+            }
+        };
+
+        iterator(const Dataset* dset,
+                 typename std::vector<size_type>::const_iterator it)
+            : dset_{dset}, it_{it}
+        {
+            // nothing
+        }
+
+        instance_type operator*() const
+        {
+            return (*dset_)(*it_);
+        }
+
+        arrow_proxy operator->() const
+        {
+            return {**this};
+        }
+
+        iterator& operator++()
+        {
+            ++it_;
+            return *this;
+        }
+
+        iterator operator++(int)
+        {
+            auto ret = *this;
+            ++(*this);
+            return ret;
+        }
+
+        iterator& operator--()
+        {
+            --it_;
+            return *this;
+        }
+
+        iterator operator--(int)
+        {
+            auto ret = *this;
+            --(*this);
+            return ret;
+        }
+
+        iterator& operator+=(difference_type n)
+        {
+            it_ += n;
+            return *this;
+        }
+
+        iterator& operator-=(difference_type n)
+        {
+            it_ -= n;
+            return *this;
+        }
+
+        friend iterator operator+(iterator it, difference_type n)
+        {
+            return it += n;
+        }
+
+        friend iterator operator+(difference_type n, iterator it)
+        {
+            return it += n;
+        }
+
+        friend iterator operator-(iterator it, difference_type n)
+        {
+            return it -= n;
+        }
+
+        friend difference_type operator-(iterator first, iterator last)
+        {
+            return first.it_ - last.it_;
+        }
+
+        instance_type operator[](difference_type n) const
+        {
+            return *(*this + n);
+        }
+
+        bool operator<(const iterator& it) const
+        {
+            return it_ < it.it_;
+        }
+
+        /**
+         * @return the index of the current instance in the dataset
+         */
+        size_type index() const
+        {
+            return *it_;
+        }
+
+      private:
+        const Dataset* dset_;
+        typename std::vector<size_type>::const_iterator it_;
+    };
+
+    using const_iterator = iterator;
+
+    template <class RandomEngine = std::mt19937_64>
+    csr_dataset_view(const Dataset& dset,
+                     RandomEngine&& rng = std::mt19937_64{47})
+        : dset_{&dset},
+          indices_(dset.size()),
+          rng_(std::forward<RandomEngine>(rng))
+    {
+        std::iota(indices_.begin(), indices_.end(), size_type{0});
+    }
+
+    /**
+     * Creates a view of some of the instances of a dataset.
+     * @param dset The dataset
+     * @param indices The index of each viewed instance, in order
+     * @param rng The random number generator used for shuffling
+     */
+    template <class RandomEngine = std::mt19937_64>
+    csr_dataset_view(const Dataset& dset, std::vector<size_type> indices,
+                     RandomEngine&& rng = std::mt19937_64{47})
+        : dset_{&dset},
+          indices_(std::move(indices)),
+          rng_(std::forward<RandomEngine>(rng))
+    {
+        // nothing
+    }
+
+    /**
+     * Creates a view of the instances in [first, last) of another view,
+     * like dataset_view's subset constructor.
+     */
+    csr_dataset_view(const csr_dataset_view& view, iterator first,
+                     iterator last)
+        : dset_{view.dset_}, rng_{view.rng_}
+    {
+        indices_.reserve(static_cast<std::size_t>(last - first));
+        for (; first != last; ++first)
+            indices_.push_back(first.index());
+    }
+
+    void shuffle()
+    {
+        // use meta::random::shuffle for reproducibility between compilers
+        random::shuffle(indices_.begin(), indices_.end(), rng_);
+    }
+
+    iterator begin() const
+    {
+        return {dset_, indices_.begin()};
+    }
+
+    iterator end() const
+    {
+        return {dset_, indices_.end()};
+    }
+
+    size_type size() const
+    {
+        return indices_.size();
+    }
+
+    size_type total_features() const
+    {
+        return dset_->total_features();
+    }
+
+    /**
+     * @return the label for an instance; only available for views of
+     * labeled_csr_datasets
+     */
+    auto label(const instance_type& inst) const
+    {
+        return dset_->label(inst);
+    }
+
+  private:
+    const Dataset* dset_;
+    std::vector<size_type> indices_;
+    random::any_rng rng_;
+};
+}
+}
+#endif
@@ -233,11 +233,12 @@ class labeled_dataset : public dataset
      * Creates an in-memory dataset from a forward_index and a range of
      * doc_ids, represented as iterators.
      */
-    template <class ForwardIterator, class LabelFunction>
+    template <class ForwardIterator, class LabelFunction,
+              class ProgressTrait = printing::default_progress_trait>
     labeled_dataset(std::shared_ptr<index::forward_index> idx,
                     ForwardIterator begin, ForwardIterator end,
-                    LabelFunction&& labeller)
-        : dataset{idx, begin, end}
+                    LabelFunction&& labeller, ProgressTrait = ProgressTrait{})
+        : dataset{idx, begin, end, ProgressTrait{}}
     {
         labels_.reserve(size());
         std::transform(begin, end, std::back_inserter(labels_), labeller);
@@ -9,11 +9,14 @@
 #ifndef META_LEARN_SGD_H_
 #define META_LEARN_SGD_H_
 
+#include <stdexcept>
 #include <vector>
 
 #include "meta/config.h"
 #include "meta/learn/dataset.h"
+#include "meta/learn/csr_dataset.h"
 #include "meta/learn/loss/loss_function.h"
+#include "meta/parallel/parallel_for.h"
 
 namespace meta
 {
@@ -31,8 +34,19 @@ namespace learn
  * efficient shrinking during training, and L1 regularization is performed
  * using the cumulative penalty method of Tsuruoka, Tsujii, and Ananiadou.
  *
+ * Training can also be run from several threads at once with
+ * train_hogwild(), which updates the weights without any locking, or on
+ * mini-batches with train_batch().
+ *
+ * If the model is averaged, predictions use the average of the weights
+ * after every training example (averaged SGD) rather than the latest
+ * weights, which is usually more accurate after a single pass. The
+ * average is kept lazily, so it costs O(1) per feature updated.
+ *
  * @see http://arxiv.org/abs/1305.6646
  * @see http://www.aclweb.org/anthology/P09-1054
+ * @see https://arxiv.org/abs/1106.5730
+ * @see https://arxiv.org/abs/1107.2490
  */
 class sgd_model
 {
@@ -55,6 +69,7 @@ class sgd_model
         double learning_rate = default_learning_rate;
         double l2_regularizer = default_l2_regularizer;
         double l1_regularizer = default_l1_regularizer;
+        bool averaged = false;
 
         options_type()
         {
@@ -146,11 +161,42 @@ class sgd_model
     }
 
     /**
-     * Gives a prediction for an input vector. This is simply \f$w^T x\f$.
+     * Gives a prediction for an input vector. This is simply \f$w^T x\f$,
+     * using the averaged weights if the model is averaged.
      * @return the prediction
      */
     double predict(const feature_vector& x) const;
 
+    /**
+     * Gives a prediction for an instance in a csr_dataset.
+     * @return the prediction
+     */
+    double predict(const basic_feature_span<float>& x) const;
+
+    /**
+     * @return the number of features the model has weights for
+     */
+    std::size_t num_features() const;
+
+    /**
+     * @param feature The feature to get the weight of
+     * @return the weight the model predicts with for the feature (the
+     * averaged weight if the model is averaged)
+     */
+    double weight(feature_id feature) const;
+
+    /**
+     * @return the bias the model predicts with (the averaged bias if the
+     * model is averaged)
+     */
+    double bias() const;
+
+    /**
+     * @return whether the model predicts with the averaged weights (in
+     * which case it cannot be trained with train_hogwild())
+     */
+    bool averaged() const;
+
     /**
      * Updates the model for a specific instance.
      *
@@ -163,6 +209,122 @@ class sgd_model
     double train_one(const feature_vector& x, double expected_label,
                      const loss::loss_function& loss);
 
+    /**
+     * Updates the model for a specific instance in a csr_dataset.
+     *
+     * @param x The instance to update with
+     * @param expected_label The ground truth label
+     * @param loss The loss function to use for the update
+     *
+     * @return the loss incurred for this example
+     */
+    double train_one(const basic_feature_span<float>& x,
+                     double expected_label, const loss::loss_function& loss);
+
+    /**
+     * Updates the model for a mini-batch of instances. First each
+     * instance in turn is normalized (which, as in train_one(), may
+     * rescale the weights of its features) and predicted, so the
+     * predictions see none of the batch's updates but do see the
+     * normalization of the instances before them. Then each instance's
+     * update is applied in turn. With one instance per batch this is the
+     * same as train_one().
+     *
+     * @param begin An iterator to the first instance in the batch
+     * @param end An iterator to one past the last instance in the batch
+     * @param loss The loss function to use for the updates
+     * @param labeler A unary function object to convert an instance ->
+     *  double label
+     *
+     * @return the total loss incurred on the batch
+     */
+    template <class ForwardIterator, class LabelFunction>
+    double train_batch(ForwardIterator begin, ForwardIterator end,
+                       const loss::loss_function& loss,
+                       LabelFunction&& labeler)
+    {
+        std::vector<double> predictions;
+        for (auto it = begin; it != end; ++it)
+            predictions.push_back(prepare(it->weights));
+
+        auto total_loss = 0.0;
+        auto predicted = predictions.begin();
+        for (; begin != end; ++begin, ++predicted)
+            total_loss += update(begin->weights, *predicted,
+                                 labeler(*begin), loss);
+        return total_loss;
+    }
+
+    /**
+     * Makes one pass over a set of instances, training on disjoint blocks
+     * of them from each thread in the pool at once. Threads update the
+     * shared weights without any locking (the "Hogwild!" scheme of Niu,
+     * Recht, Re, and Wright): instances are sparse, so concurrent updates
+     * rarely touch the same weights, and the occasional lost update does
+     * not hurt convergence in practice.
+     *
+     * Each thread keeps its own count of examples, its own adaptive
+     * normalizer, and its own copy of the bias (which every instance
+     * updates, so sharing it would race on every step); these are merged
+     * back into the model once every thread has finished. The
+     * shared weight scale is folded into the weights first, and L2
+     * shrinkage is applied only to the weights of the features in each
+     * instance, rather than to the whole weight vector.
+     *
+     * @param view The instances to train on, which should already be
+     *  shuffled
+     * @param loss The loss function to use for the updates
+     * @param labeler A unary function object to convert an instance ->
+     *  double label
+     * @param pool The thread pool to train with
+     *
+     * @return the total loss incurred on the instances
+     */
+    template <class View, class LabelFunction>
+    double train_hogwild(const View& view, const loss::loss_function& loss,
+                         LabelFunction&& labeler, parallel::thread_pool& pool)
+    {
+        using iterator = decltype(view.begin());
+
+        if (averaged_)
+            throw std::logic_error{
+                "averaged sgd models cannot be trained with hogwild"};
+
+        fold_scale();
+        auto futures = parallel::for_each_block(
+            view.begin(), view.end(), pool, [&](iterator begin, iterator end)
+            {
+                hogwild_state state{t_, update_scale_, pool.size(), bias_};
+                auto total_loss = 0.0;
+                for (; begin != end; ++begin)
+                    total_loss += train_one(begin->weights, labeler(*begin),
+                                            loss, state);
+                return std::make_pair(total_loss, state);
+            });
+
+        // threads read t_, update_scale_, and bias_ until they finish, so
+        // nothing is merged until all of them have
+        std::vector<std::pair<double, hogwild_state>> results;
+        results.reserve(futures.size());
+        for (auto& fut : futures)
+            results.push_back(fut.get());
+
+        auto total_loss = 0.0;
+        auto t = t_;
+        auto update_scale = update_scale_;
+        auto bias = bias_;
+        for (const auto& result : results)
+        {
+            const auto& state = result.second;
+            total_loss += result.first;
+            t_ += state.t - t;
+            update_scale_ += state.update_scale - update_scale;
+            bias_.weight += state.bias.weight - bias.weight;
+            bias_.grad_squared += state.bias.grad_squared - bias.grad_squared;
+        }
+        return total_loss;
+    }
+
   private:
     /**
      * Per-feature representation of the weight vector.
@@ -182,6 +344,17 @@ class sgd_model
         double cumulative_penalty = 0;
     };
 
+    /**
+     * The running average of a weight, kept lazily: sum is the total of
+     * the weight over every training example up to the last time it
+     * changed, and mark is the value of scale_sum_ at that time.
+     */
+    struct average_type
+    {
+        double sum = 0;
+        double mark = 0;
+    };
+
     template <class SampleView, class LabelFunction>
     double avg_loss_on_sample(const SampleView& sample,
                               const loss::loss_function& loss,
@@ -201,8 +374,118 @@ class sgd_model
         return avg_loss;
     }
 
+    /**
+     * The training state that is kept per thread by train_hogwild().
+     */
+    struct hogwild_state
+    {
+        /// The number of examples seen, including those before training
+        std::size_t t;
+        /// The update scale factor, including that before training
+        double update_scale;
+        /// The number of threads training at once
+        std::size_t num_threads;
+        /// This thread's copy of the bias, starting from the model's
+        weight_type bias;
+    };
+
+    /**
+     * Updates the model for a specific instance from one of the threads
+     * of train_hogwild().
+     */
+    double train_one(const feature_vector& x, double expected_label,
+                     const loss::loss_function& loss, hogwild_state& state);
+
+    double train_one(const basic_feature_span<float>& x,
+                     double expected_label, const loss::loss_function& loss,
+                     hogwild_state& state);
+
+    /**
+     * Starts a training step on an instance for train_batch().
+     * @return the prediction for the instance using the latest (not
+     * averaged) weights
+     */
+    double prepare(const feature_vector& x);
+
+    double prepare(const basic_feature_span<float>& x);
+
+    /**
+     * Finishes a training step on an instance for train_batch(), given
+     * the prediction that was made for it.
+     */
+    double update(const feature_vector& x, double predicted,
+                  double expected_label, const loss::loss_function& loss);
+
+    double update(const basic_feature_span<float>& x, double predicted,
+                  double expected_label, const loss::loss_function& loss);
+
+    /**
+     * The implementations of predict() and train_one(), for any range of
+     * (feature_id, weight) pairs.
+     */
+    template <class FeatureRange>
+    double predict_impl(const FeatureRange& x) const;
+
+    /**
+     * @return \f$w^T x\f$ using the latest (not averaged) weights
+     */
+    template <class FeatureRange>
+    double predict_raw(const FeatureRange& x) const;
+
+    /**
+     * Starts a training step on an instance: adjusts the weights' scales
+     * for the instance's feature values.
+     */
+    template <class FeatureRange>
+    void normalize(const FeatureRange& x);
+
+    /**
+     * Finishes a training step, given the prediction for the instance:
+     * updates the weights using the loss's gradient.
+     * @return the loss incurred for the instance
+     */
+    template <class FeatureRange>
+    double apply_update(const FeatureRange& x, double predicted,
+                        double expected_label,
+                        const loss::loss_function& loss);
+
+    template <class FeatureRange>
+    double train_one_impl(const FeatureRange& x, double expected_label,
+                          const loss::loss_function& loss);
+
+    template <class FeatureRange>
+    double train_one_impl(const FeatureRange& x, double expected_label,
+                          const loss::loss_function& loss,
+                          hogwild_state& state);
+
+    /**
+     * Adds a weight's contribution to its running average since the
+     * average was last brought up to date. This must be called before the
+     * weight changes.
+     */
+    void accumulate(const weight_type& weight_val, average_type& avg) const;
+
+    /**
+     * Brings the averages of the weights of x's features up to date.
+     */
+    template <class FeatureRange>
+    void accumulate(const FeatureRange& x);
+
+    /**
+     * @return the average of a weight over all training examples so far
+     */
+    double average(const weight_type& weight_val,
+                   const average_type& avg) const;
+
     void penalize(weight_type& weight_val);
 
+    void penalize(weight_type& weight_val, std::size_t t);
+
+    /**
+     * Multiplies the weights by scale_ and resets it to 1.
+     */
+    void fold_scale();
+
     void reset();
 
     double l2norm() const;
@@ -232,6 +515,18 @@ class sgd_model
 
     /// The total number of observed examples
     std::size_t t_;
+
+    /// Whether predictions use the averaged weights
+    bool averaged_;
+
+    /// The running averages of the weights, if the model is averaged
+    std::vector<average_type> averages_;
+
+    /// The running average of the bias term
+    average_type bias_average_;
+
+    /// The sum of scale_ after every training example so far
+    double scale_sum_ = 0;
 };
 }
 }
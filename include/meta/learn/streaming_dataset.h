@@ -0,0 +1,227 @@
+/**
+ * @file streaming_dataset.h
+ * @author Chase Geigle
+ *
+ * All files in META are released under the MIT license. For more details,
+ * consult the file LICENSE in the root of the project.
+ */
+
+#ifndef META_LEARN_STREAMING_DATASET_H_
+#define META_LEARN_STREAMING_DATASET_H_
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/meta.h"
+#include "meta/parallel/thread_pool.h"
+#include "meta/util/optional.h"
+#include "meta/util/random.h"
+
+namespace meta
+{
+namespace learn
+{
+
+/**
+ * A dataset that is too large to hold in memory, read a batch at a time.
+ * Each batch is an ordinary in-memory Dataset (e.g. a multiclass_dataset)
+ * built from a slice of the document ids by a loader function, typically
+ * by decoding the documents' postings from a forward_index.
+ *
+ * While the caller trains on one batch, the next one is loaded on a
+ * background thread, so at most two batches are in memory at once.
+ *
+ * The document ids are grouped into blocks of consecutive documents, and
+ * shuffle() permutes the order of the blocks rather than the documents, so
+ * each batch still reads mostly contiguous regions of the index. Learners
+ * that shuffle their own view of a batch will see a random order within
+ * it.
+ */
+template <class Dataset>
+class streaming_dataset
+{
+  public:
+    using batch_type = Dataset;
+    using iterator = std::vector<doc_id>::const_iterator;
+    using loader_type = std::function<Dataset(iterator, iterator)>;
+
+    /// The default number of consecutive documents that are shuffled as
+    /// a unit
+    const static constexpr uint64_t default_block_size = 1024;
+
+    /**
+     * @param docs The ids of the documents in the dataset
+     * @param batch_size The number of documents in each batch
+     * @param loader A function to create a batch from a range of document
+     * ids; this is called from a background thread
+     * @param block_size The number of consecutive documents that are
+     * shuffled as a unit
+     * @param rng The random number generator to use for shuffling
+     */
+    streaming_dataset(std::vector<doc_id> docs, uint64_t batch_size,
+                      loader_type loader,
+                      uint64_t block_size = default_block_size,
+                      std::mt19937_64 rng = std::mt19937_64{47})
+        : docs_(std::move(docs)),
+          order_(docs_),
+          batch_size_{batch_size},
+          block_size_{block_size},
+          loader_{std::move(loader)},
+          rng_{std::move(rng)}
+    {
+        if (batch_size_ == 0 || block_size_ == 0)
+            throw std::invalid_argument{
+                "batch and block sizes must be positive"};
+        rewind();
+    }
+
+    /**
+     * Destroys the dataset, waiting for any batch being loaded.
+     */
+    ~streaming_dataset()
+    {
+        wait();
+    }
+
+    /**
+     * Randomly permutes the blocks of documents and starts a new pass over
+     * the dataset in that order.
+     */
+    void shuffle()
+    {
+        wait();
+
+        auto num_blocks = (docs_.size() + block_size_ - 1) / block_size_;
+        std::vector<uint64_t> blocks(num_blocks);
+        std::iota(blocks.begin(), blocks.end(), 0);
+        // use meta::random::shuffle for reproducibility between compilers
+        random::shuffle(blocks.begin(), blocks.end(), rng_);
+
+        order_.clear();
+        for (const auto& block : blocks)
+        {
+            auto first = block * block_size_;
+            auto last = std::min<uint64_t>(first + block_size_, docs_.size());
+            order_.insert(order_.end(), docs_.begin() + offset(first),
+                          docs_.begin() + offset(last));
+        }
+        rewind();
+    }
+
+    /**
+     * Starts a new pass over the dataset in the current order.
+     */
+    void rewind()
+    {
+        wait();
+        batch_ = 0;
+        prefetch();
+    }
+
+    /**
+     * @return the next batch in this pass over the dataset, or nothing if
+     * the pass is over
+     */
+    util::optional<Dataset> next()
+    {
+        if (!pending_.valid())
+            return util::nullopt;
+
+        util::optional<Dataset> batch{pending_.get()};
+        ++batch_;
+        prefetch();
+        return batch;
+    }
+
+    /**
+     * @return the number of documents in the dataset
+     */
+    uint64_t size() const
+    {
+        return docs_.size();
+    }
+
+    /**
+     * @return the number of documents in each batch
+     */
+    uint64_t batch_size() const
+    {
+        return batch_size_;
+    }
+
+    /**
+     * @return the number of batches in a pass over the dataset
+     */
+    uint64_t num_batches() const
+    {
+        // integer-math ceil(size() / batch_size)
+        return (docs_.size() + batch_size_ - 1) / batch_size_;
+    }
+
+  private:
+    using diff_type = iterator::difference_type;
+
+    static diff_type offset(uint64_t pos)
+    {
+        return static_cast<diff_type>(pos);
+    }
+
+    /**
+     * Starts loading the current batch on the background thread.
+     */
+    void prefetch()
+    {
+        if (batch_ >= num_batches())
+            return;
+
+        auto first = batch_ * batch_size_;
+        auto last = std::min<uint64_t>(first + batch_size_, order_.size());
+        auto begin = order_.cbegin() + offset(first);
+        auto end = order_.cbegin() + offset(last);
+        pending_ = pool_.submit_task([this, begin, end]()
+                                     {
+                                         return loader_(begin, end);
+                                     });
+    }
+
+    /**
+     * Waits for the batch being loaded, if any, and discards it.
+     */
+    void wait()
+    {
+        if (pending_.valid())
+            pending_.wait();
+        pending_ = {};
+    }
+
+    /// The document ids in their original order
+    std::vector<doc_id> docs_;
+    /// The document ids in the order of the current pass
+    std::vector<doc_id> order_;
+    /// The number of documents in each batch
+    uint64_t batch_size_;
+    /// The number of consecutive documents shuffled as a unit
+    uint64_t block_size_;
+    /// Creates a batch from a range of document ids
+    loader_type loader_;
+    /// The random number generator used for shuffling
+    std::mt19937_64 rng_;
+    /// The index of the batch being loaded
+    uint64_t batch_ = 0;
+    /// The batch being loaded
+    std::future<Dataset> pending_;
+    /// The thread that loads batches
+    parallel::thread_pool pool_{1};
+};
+
+template <class Dataset>
+const constexpr uint64_t streaming_dataset<Dataset>::default_block_size;
+}
+}
+#endif
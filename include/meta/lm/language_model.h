@@ -17,10 +17,12 @@
 
 #include "cpptoml.h"
 #include "meta/config.h"
+#include "meta/hashing/blocked_bloom_filter.h"
 #include "meta/lm/lm_state.h"
 #include "meta/lm/sentence.h"
 #include "meta/lm/static_probe_map.h"
 #include "meta/lm/token_list.h"
+#include "meta/util/optional.h"
 
 namespace meta
 {
@@ -51,6 +53,7 @@ class language_model_exception : public std::runtime_error
  * ~~~toml
  * [language-model]
  * arpa-file = "path-to-arpa-file" # if no binary files have yet been created
+ * bloom-filter = true # check a bloom filter before the vocabulary
  * ~~~
  */
 class language_model
@@ -142,12 +145,21 @@ class language_model
      */
     void load_vocab();
 
+    /**
+     * Loads the bloom filter over the vocabulary, building it first if
+     * it doesn't exist yet
+     */
+    void load_vocab_filter();
+
     uint64_t N_; /// The "n" value for this n-gram language model
 
     std::vector<static_probe_map> lm_;
 
     std::unordered_map<std::string, term_id> vocabulary_;
 
+    /// Rejects most tokens that aren't in vocabulary_, if enabled
+    util::optional<hashing::blocked_bloom_filter> vocab_filter_;
+
     std::string prefix_;
 
     term_id unk_id_;
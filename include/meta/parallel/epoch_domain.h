@@ -0,0 +1,197 @@
+/**
+ * @file epoch_domain.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For
+ * more details, consult the file LICENSE.mit and LICENSE.ncsa in the root
+ * of the project.
+ */
+
+#ifndef META_PARALLEL_EPOCH_DOMAIN_H_
+#define META_PARALLEL_EPOCH_DOMAIN_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+#include "meta/config.h"
+
+namespace meta
+{
+namespace parallel
+{
+
+/**
+ * Epoch-based reclamation of memory that lock-free readers may still be
+ * looking at after a writer has unlinked it.
+ *
+ * Each thread that reads announces the epoch it started in, in a slot of
+ * its own (on its own cache line), so readers never write to memory that
+ * other threads use. A writer that unlinks memory calls retire(), which
+ * advances the epoch and returns a tag for it; the memory may be freed
+ * once min_active() is greater than the tag, since every read that
+ * started before it was unlinked has then finished.
+ *
+ * A thread's slot is reused by later threads once it exits. There is a
+ * single domain per process, shared by everything that uses it.
+ */
+class epoch_domain
+{
+  public:
+    /// The epoch announced by threads that are not reading
+    const static constexpr uint64_t quiescent
+        = std::numeric_limits<uint64_t>::max();
+
+    /**
+     * @return the domain for this process
+     */
+    static epoch_domain& global()
+    {
+        static epoch_domain domain;
+        return domain;
+    }
+
+    /**
+     * Announces that the calling thread is reading while it is alive.
+     * Guards may be nested; the outermost one determines the epoch.
+     */
+    class read_guard
+    {
+      public:
+        read_guard(epoch_domain& domain)
+        {
+            auto& rec = domain.local_record();
+            epoch_ = &rec.epoch;
+            depth_ = &rec.depth;
+
+            // the announcement must be visible before anything is read
+            if ((*depth_)++ == 0)
+                epoch_->store(domain.epoch_.load());
+        }
+
+        ~read_guard()
+        {
+            if (--(*depth_) == 0)
+                epoch_->store(quiescent, std::memory_order_release);
+        }
+
+      private:
+        /// The calling thread's announced epoch
+        std::atomic<uint64_t>* epoch_;
+        /// The calling thread's number of read_guards
+        uint64_t* depth_;
+    };
+
+    /**
+     * Advances the epoch. Must be called after the memory being retired
+     * has been unlinked.
+     *
+     * @return the tag for the retired memory, which may be freed once
+     * min_active() is greater than it
+     */
+    uint64_t retire()
+    {
+        return epoch_.fetch_add(1);
+    }
+
+    /**
+     * @return the oldest epoch announced by a thread that is reading, or
+     * quiescent if none is
+     */
+    uint64_t min_active() const
+    {
+        auto min = quiescent;
+        for (auto rec = head_.load(); rec; rec = rec->next)
+        {
+            auto epoch = rec->epoch.load();
+            if (epoch < min)
+                min = epoch;
+        }
+        return min;
+    }
+
+  private:
+    /// The state of one thread
+    struct record
+    {
+        /// The epoch the thread's current read started in
+        std::atomic<uint64_t> epoch{quiescent};
+        /// The number of read_guards the thread holds
+        uint64_t depth = 0;
+        /// Keeps the fields the thread writes to on every read off of the
+        /// cache line of any other record's
+        char padding[64];
+        /// Whether a thread owns the record
+        std::atomic<bool> in_use{true};
+        /// The next record in the domain
+        record* next = nullptr;
+    };
+
+    /// Gives a thread a record for its lifetime
+    class record_holder
+    {
+      public:
+        record_holder(epoch_domain& domain) : rec_{domain.acquire()}
+        {
+            // nothing
+        }
+
+        ~record_holder()
+        {
+            rec_->epoch.store(quiescent);
+            rec_->in_use.store(false, std::memory_order_release);
+        }
+
+        record& get()
+        {
+            return *rec_;
+        }
+
+      private:
+        record* rec_;
+    };
+
+    epoch_domain() : epoch_{0}, head_{nullptr}
+    {
+        // nothing
+    }
+
+    /**
+     * @return the calling thread's record
+     */
+    record& local_record()
+    {
+        thread_local record_holder holder{*this};
+        return holder.get();
+    }
+
+    /**
+     * @return a record for a new thread, reusing one whose thread has
+     * exited if possible; records are never freed, since min_active() may
+     * be reading them
+     */
+    record* acquire()
+    {
+        for (auto rec = head_.load(); rec; rec = rec->next)
+        {
+            auto in_use = rec->in_use.load();
+            if (!in_use && rec->in_use.compare_exchange_strong(in_use, true))
+                return rec;
+        }
+
+        auto rec = new record;
+        rec->next = head_.load();
+        while (!head_.compare_exchange_weak(rec->next, rec))
+            ; // rec->next now holds the new head
+        return rec;
+    }
+
+    /// The current epoch
+    std::atomic<uint64_t> epoch_;
+
+    /// The most recently created record
+    std::atomic<record*> head_;
+};
+}
+}
+#endif
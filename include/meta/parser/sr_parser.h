@@ -13,6 +13,7 @@
 #include <random>
 #include <unordered_map>
 
+#include "meta/classify/models/frozen_linear_model.h"
 #include "meta/classify/models/linear_model.h"
 #include "meta/config.h"
 #include "meta/meta.h"
@@ -266,10 +267,17 @@ class sr_parser
     transition_map trans_;
 
     /**
-     * Storage for the weights for each possible transition
+     * Storage for the weights for each possible transition, used for
+     * scoring while training and after (and empty once frozen_ is built)
      */
     classify::linear_model<std::string, float, trans_id> model_;
 
+    /**
+     * The weights laid out for fast scoring, built in place of model_
+     * when the model is loaded
+     */
+    classify::frozen_linear_model<std::string, float, trans_id> frozen_;
+
     /**
      * Beam size used during training.
      */
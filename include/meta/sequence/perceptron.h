@@ -11,6 +11,7 @@
 
 #include <random>
 
+#include "meta/classify/models/frozen_linear_model.h"
 #include "meta/classify/models/linear_model.h"
 #include "meta/config.h"
 #include "meta/sequence/sequence_analyzer.h"
@@ -87,9 +88,16 @@ class perceptron
     sequence_analyzer analyzer_;
 
     /**
-     * The model storage.
+     * The model storage, used for tagging while training and after (and
+     * empty once frozen_ is built).
      */
     classify::linear_model<feature_id, double, label_id> model_;
+
+    /**
+     * The weights laid out for fast scoring, built in place of model_
+     * when the model is loaded.
+     */
+    classify::frozen_linear_model<feature_id, double, label_id> frozen_;
 };
 }
 }
@@ -0,0 +1,142 @@
+/**
+ * @file string_arena.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_UTIL_STRING_ARENA_H_
+#define META_UTIL_STRING_ARENA_H_
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "meta/config.h"
+#include "meta/util/string_view.h"
+
+namespace meta
+{
+namespace util
+{
+
+/**
+ * Stores the bytes of many strings contiguously in large chunks, so that
+ * adding a string is (usually) a pointer bump and all of the strings are
+ * released at once when the arena is cleared or destroyed. Individual
+ * strings cannot be freed.
+ *
+ * The views returned by intern() remain valid until the arena is cleared
+ * or destroyed; moving the arena does not invalidate them.
+ */
+class string_arena
+{
+  public:
+    /// The size of the first chunk allocated
+    const static std::size_t min_chunk_size = 4096;
+
+    /// The size chunks stop doubling at
+    const static std::size_t max_chunk_size = 1 << 20;
+
+    string_arena() = default;
+
+    /**
+     * Move constructs a string_arena.
+     */
+    string_arena(string_arena&& other)
+        : chunks_{std::move(other.chunks_)},
+          pos_{other.pos_},
+          remaining_{other.remaining_},
+          bytes_{other.bytes_}
+    {
+        other.clear();
+    }
+
+    /**
+     * Move assigns a string_arena.
+     */
+    string_arena& operator=(string_arena&& rhs)
+    {
+        if (this != &rhs)
+        {
+            chunks_ = std::move(rhs.chunks_);
+            pos_ = rhs.pos_;
+            remaining_ = rhs.remaining_;
+            bytes_ = rhs.bytes_;
+            rhs.clear();
+        }
+        return *this;
+    }
+
+    /**
+     * Copies a string into the arena.
+     * @param str The string to copy
+     * @return a view of the copy
+     */
+    string_view intern(string_view str)
+    {
+        if (str.size() > remaining_)
+            grow(str.size());
+
+        auto dest = pos_;
+        std::memcpy(dest, str.data(), str.size());
+        pos_ += str.size();
+        remaining_ -= str.size();
+        return {dest, str.size()};
+    }
+
+    /**
+     * Releases all of the strings in the arena.
+     */
+    void clear()
+    {
+        std::vector<std::unique_ptr<char[]>>{}.swap(chunks_);
+        pos_ = nullptr;
+        remaining_ = 0;
+        bytes_ = 0;
+    }
+
+    /**
+     * @return the number of bytes allocated by the arena
+     */
+    std::size_t bytes_used() const
+    {
+        return bytes_;
+    }
+
+  private:
+    /**
+     * Starts a new chunk that can hold at least min_size bytes.
+     */
+    void grow(std::size_t min_size)
+    {
+        // double the total size of the arena until chunks get large;
+        // the unused tail of the current chunk is abandoned
+        auto size = std::max(min_chunk_size,
+                             std::min<std::size_t>(bytes_, max_chunk_size));
+        size = std::max(size, min_size);
+
+        chunks_.emplace_back(new char[size]);
+        pos_ = chunks_.back().get();
+        remaining_ = size;
+        bytes_ += size;
+    }
+
+    /// The chunks holding the strings
+    std::vector<std::unique_ptr<char[]>> chunks_;
+
+    /// The next free byte in the current chunk
+    char* pos_ = nullptr;
+
+    /// The number of free bytes left in the current chunk
+    std::size_t remaining_ = 0;
+
+    /// The total number of bytes allocated
+    std::size_t bytes_ = 0;
+};
+}
+}
+#endif
@@ -3,6 +3,7 @@
  * @author Chase Geigle
  */
 
+#include "cpptoml.h"
 #include "meta/analyzers/filters/porter2_filter.h"
 #include "meta/analyzers/filters/porter2_stemmer.h"
 
@@ -15,14 +16,19 @@ namespace filters
 
 const util::string_view porter2_filter::id = "porter2-filter";
 
-porter2_filter::porter2_filter(std::unique_ptr<token_stream> source)
-    : source_{std::move(source)}
+const constexpr uint64_t porter2_filter::default_cache_size;
+
+porter2_filter::porter2_filter(std::unique_ptr<token_stream> source,
+                               uint64_t cache_size)
+    : source_{std::move(source)}, cache_{cache_size}
 {
     next_token();
 }
 
 porter2_filter::porter2_filter(const porter2_filter& other)
-    : source_{other.source_->clone()}, token_{other.token_}
+    : source_{other.source_->clone()},
+      token_{other.token_},
+      cache_{other.cache_}
 {
     // nothing
 }
@@ -45,7 +51,16 @@ void porter2_filter::next_token()
     while (*source_)
     {
         auto tok = source_->next();
-        porter2::stem(tok);
+        if (auto stemmed = cache_.find(tok))
+        {
+            tok = std::move(*stemmed);
+        }
+        else
+        {
+            auto word = tok;
+            porter2::stem(tok);
+            cache_.insert(word, tok);
+        }
         if (!tok.empty())
         {
             token_ = std::move(tok);
@@ -59,6 +74,21 @@ porter2_filter::operator bool() const
 {
     return static_cast<bool>(token_);
 }
+
+auto porter2_filter::cache() const -> const cache_type&
+{
+    return cache_;
+}
+
+template <>
+std::unique_ptr<token_stream>
+    make_filter<porter2_filter>(std::unique_ptr<token_stream> src,
+                                const cpptoml::table& config)
+{
+    auto cache_size = config.get_as<uint64_t>("cache-size")
+                          .value_or(porter2_filter::default_cache_size);
+    return make_unique<porter2_filter>(std::move(src), cache_size);
+}
 }
 }
 }
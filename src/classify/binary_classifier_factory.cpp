@@ -4,6 +4,7 @@
  */
 
 #include "meta/classify/binary_classifier_factory.h"
+#include "meta/classify/classifier/linear_svm.h"
 #include "meta/classify/classifier/sgd.h"
 
 namespace meta
@@ -21,6 +22,7 @@ binary_classifier_factory::binary_classifier_factory()
 {
     // built-in binary classifiers
     reg<sgd>();
+    reg<linear_svm>();
 }
 
 std::unique_ptr<binary_classifier>
@@ -46,6 +48,7 @@ binary_classifier_loader::binary_classifier_loader()
 {
     // built-in binary classifiers
     reg<sgd>();
+    reg<linear_svm>();
 }
 
 std::unique_ptr<binary_classifier> load_binary_classifier(std::istream& in)
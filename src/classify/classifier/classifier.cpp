@@ -8,33 +8,71 @@
 #include "meta/logging/logger.h"
 #include "meta/classify/classifier/classifier.h"
 #include "meta/classify/classifier_factory.h"
+#include "meta/parallel/parallel_for.h"
 
 namespace meta
 {
 namespace classify
 {
 
+const constexpr uint64_t classifier::min_parallel_size;
+
+namespace
+{
+template <class Iterator>
+confusion_matrix test_block(const classifier& cls,
+                            const multiclass_dataset_view& docs,
+                            Iterator begin, Iterator end)
+{
+    confusion_matrix matrix;
+    for (; begin != end; ++begin)
+        matrix.add(predicted_label{cls.classify(begin->weights)},
+                   docs.label(*begin));
+    return matrix;
+}
+}
+
 confusion_matrix classifier::test(dataset_view_type docs) const
 {
+    if (docs.size() < min_parallel_size)
+        return test_block(*this, docs, docs.begin(), docs.end());
+
+    parallel::thread_pool pool;
+    return test(std::move(docs), pool);
+}
+
+confusion_matrix classifier::test(dataset_view_type docs,
+                                  parallel::thread_pool& pool) const
+{
+    using iterator = decltype(docs.begin());
+
+    if (docs.size() < min_parallel_size)
+        return test_block(*this, docs, docs.begin(), docs.end());
+
+    auto futures = parallel::for_each_block(
+        docs.begin(), docs.end(), pool, [&](iterator begin, iterator end)
+        {
+            return test_block(*this, docs, begin, end);
+        });
 
     confusion_matrix matrix;
-    for (const auto& instance : docs)
-        matrix.add(predicted_label{classify(instance.weights)},
-                   docs.label(instance));
+    for (auto& fut : futures)
+        matrix += fut.get();
 
     return matrix;
 }
 
 confusion_matrix cross_validate(const cpptoml::table& config,
                                 classifier::dataset_view_type docs, size_t k,
-                                bool even_split /* = false */)
+                                bool even_split /* = false */,
+                                std::size_t max_concurrent_folds /* = 1 */)
 {
     return cross_validate(
         [&](multiclass_dataset_view fold)
         {
             return make_classifier(config, std::move(fold));
         },
-        std::move(docs), k, even_split);
+        std::move(docs), k, even_split, max_concurrent_folds);
 }
 }
 }
@@ -3,8 +3,9 @@
  * @author Sean Massung
  */
 
-#include <vector>
+#include <algorithm>
 #include <unordered_map>
+#include <vector>
 
 #include "cpptoml.h"
 #include "meta/classify/classifier/knn.h"
@@ -28,9 +29,11 @@ knn::knn(multiclass_dataset_view docs,
       ranker_{std::move(ranker)},
       weighted_{weighted}
 {
-    legal_docs_.reserve(docs.size());
+    std::vector<doc_id> ids;
+    ids.reserve(docs.size());
     for (const auto& instance : docs)
-        legal_docs_.insert(doc_id(instance.id));
+        ids.push_back(doc_id(instance.id));
+    set_legal_docs(ids.begin(), ids.end());
 }
 
 knn::knn(std::istream& in)
@@ -45,11 +48,35 @@ knn::knn(std::istream& in)
     ranker_ = index::load_ranker(in);
 
     auto size = io::packed::read<std::size_t>(in);
-    legal_docs_.reserve(size);
-    for (std::size_t i = 0; i < size; ++i)
+    std::vector<doc_id> ids(size);
+    for (auto& id : ids)
+        io::packed::read(in, id);
+    set_legal_docs(ids.begin(), ids.end());
+}
+
+template <class ForwardIterator>
+void knn::set_legal_docs(ForwardIterator begin, ForwardIterator end)
+{
+    legal_docs_.assign(inv_idx_->num_docs(), false);
+    doc_labels_.assign(inv_idx_->num_docs(), 0);
+
+    std::unordered_map<class_label, uint32_t> label_ids;
+    for (; begin != end; ++begin)
     {
-        auto id = io::packed::read<doc_id>(in);
-        legal_docs_.insert(id);
+        auto d_id = *begin;
+        if (legal_docs_[d_id])
+            continue;
+        legal_docs_[d_id] = true;
+        ++num_legal_docs_;
+
+        auto lbl = inv_idx_->label(d_id);
+        auto it = label_ids.find(lbl);
+        if (it == label_ids.end())
+        {
+            it = label_ids.emplace(lbl, labels_.size()).first;
+            labels_.push_back(lbl);
+        }
+        doc_labels_[d_id] = it->second;
     }
 }
 
@@ -62,84 +89,65 @@ void knn::save(std::ostream& out) const
     io::packed::write(out, k_);
     ranker_->save(out);
 
-    io::packed::write(out, legal_docs_.size());
-    for (const auto& doc : legal_docs_)
-        io::packed::write(out, doc);
+    io::packed::write(out, static_cast<std::size_t>(num_legal_docs_));
+    for (doc_id d_id{0}; d_id < legal_docs_.size(); ++d_id)
+    {
+        if (legal_docs_[d_id])
+            io::packed::write(out, d_id);
+    }
 }
 
 class_label knn::classify(const feature_vector& instance) const
 {
-    if (k_ > legal_docs_.size())
+    if (k_ > num_legal_docs_)
         throw knn_exception{
             "k must be smaller than the "
             "number of documents in the index (training documents)"};
 
-    analyzers::feature_map<uint64_t> query(instance.size());
-    for (const auto& count : instance)
-        query[inv_idx_->term_text(count.first)] += count.second;
-    assert(query.size() > 0);
+    // the instance's term ids are the index's, so it can be used as the
+    // query as-is
+    auto scored = ranker_->score(*inv_idx_, instance.begin(), instance.end(),
+                                 k_, [&](doc_id d_id)
+                                 {
+                                     return legal_docs_[d_id];
+                                 });
 
-    auto scored = ranker_->score(
-        *inv_idx_, query.begin(), query.end(), k_, [&](doc_id d_id)
-        {
-            return legal_docs_.find(d_id) != legal_docs_.end();
-        });
+    if (scored.empty())
+        throw knn_exception{"label counts were empty"};
 
-    std::unordered_map<class_label, double> counts;
-    for (auto& s : scored)
+    std::vector<double> votes(labels_.size(), 0.0);
+    for (const auto& s : scored)
     {
         // normally, weighted k-nn weights neighbors by 1/distance, but since
         // our scores are similarity scores, we weight by the similarity
         if (weighted_)
-            counts[inv_idx_->label(s.d_id)] += s.score;
+            votes[doc_labels_[s.d_id]] += s.score;
         // if not weighted, each neighbor gets an equal vote
         else
-            ++counts[inv_idx_->label(s.d_id)];
+            votes[doc_labels_[s.d_id]] += 1;
     }
 
-    if (counts.empty())
-        throw knn_exception{"label counts were empty"};
-
-    using pair_t = std::pair<class_label, uint16_t>;
-    std::vector<pair_t> sorted{counts.begin(), counts.end()};
-    std::sort(sorted.begin(), sorted.end(), [](const pair_t& a, const pair_t& b)
-              {
-                  return a.second > b.second;
-              });
-
-    return select_best_label(scored, sorted);
+    return select_best_label(scored, votes);
 }
 
 class_label knn::select_best_label(
     const std::vector<index::search_result>& scored,
-    const std::vector<std::pair<class_label, uint16_t>>& sorted) const
+    const std::vector<double>& votes) const
 {
-    uint16_t highest = sorted.begin()->second;
-    auto it = sorted.begin();
-    std::unordered_set<class_label> best;
-    while (it != sorted.end() && it->second == highest)
-    {
-        best.insert(it->first);
-        ++it;
-    }
-
-    // now best contains all the class labels that are tied for the highest vote
-    if (best.size() == 1)
-        return *best.begin();
+    auto best = std::max_element(votes.begin(), votes.end());
 
-    // since there is a tie, return the class label that appeared first in the
+    // if there is a tie, return the class label that appeared first in the
     // rankings; this will usually only happen if the neighbor scores are not
     // weighted
-    for (auto& result : scored)
+    for (const auto& result : scored)
     {
-        class_label lbl{inv_idx_->label(result.d_id)};
-        auto f = best.find(lbl);
-        if (f != best.end())
-            return *f;
+        auto lbl = doc_labels_[result.d_id];
+        if (votes[lbl] == *best)
+            return labels_[lbl];
     }
 
     // suppress warnings
-    return sorted.begin()->first;
+    return labels_[static_cast<std::size_t>(best - votes.begin())];
 }
 
 template <>
@@ -0,0 +1,235 @@
+/**
+ * @file linear_svm.cpp
+ * @author Chase Geigle
+ */
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+#include "meta/classify/classifier/linear_svm.h"
+#include "meta/io/packed.h"
+#include "meta/util/random.h"
+
+namespace meta
+{
+namespace classify
+{
+
+const util::string_view linear_svm::id = "linear-svm";
+const constexpr double linear_svm::default_cost;
+const constexpr double linear_svm::default_tolerance;
+const constexpr uint64_t linear_svm::default_max_iter;
+
+linear_svm::linear_svm(binary_dataset_view docs, loss_type loss, double cost,
+                       double tolerance, uint64_t max_iter, bool bias)
+    : weights_(docs.total_features(), 0.0), use_bias_{bias}
+{
+    train(std::move(docs), loss, cost, tolerance, max_iter);
+}
+
+linear_svm::linear_svm(std::istream& in)
+{
+    io::packed::read(in, weights_);
+    io::packed::read(in, bias_);
+    io::packed::read(in, use_bias_);
+}
+
+void linear_svm::save(std::ostream& out) const
+{
+    io::packed::write(out, id);
+
+    io::packed::write(out, weights_);
+    io::packed::write(out, bias_);
+    io::packed::write(out, use_bias_);
+}
+
+void linear_svm::train(binary_dataset_view docs, loss_type loss, double cost,
+                       double tolerance, uint64_t max_iter)
+{
+    // the L1-loss dual is box-constrained by C; the L2-loss dual has no
+    // upper bound but adds 1/2C to the diagonal of Q instead
+    const double upper_bound = loss == loss_type::L1
+                                   ? cost
+                                   : std::numeric_limits<double>::infinity();
+    const double diag = loss == loss_type::L1 ? 0 : 0.5 / cost;
+    const double bias_feature = use_bias_ ? 1 : 0;
+
+    std::vector<const instance_type*> instances;
+    std::vector<double> labels;
+    std::vector<double> q_diag;
+    instances.reserve(docs.size());
+    labels.reserve(docs.size());
+    q_diag.reserve(docs.size());
+    for (const auto& instance : docs)
+    {
+        double sq_norm = bias_feature * bias_feature + diag;
+        for (const auto& feat : instance.weights)
+            sq_norm += feat.second * feat.second;
+
+        instances.push_back(&instance);
+        labels.push_back(docs.label(instance) ? +1 : -1);
+        q_diag.push_back(sq_norm);
+    }
+
+    const auto num_docs = instances.size();
+    std::vector<double> alpha(num_docs, 0.0);
+    std::vector<std::size_t> order(num_docs);
+    std::iota(order.begin(), order.end(), 0);
+
+    std::mt19937_64 rng{47};
+    using diff_type = decltype(order.begin())::difference_type;
+
+    // bounds on the projected gradient from the last pass, used to shrink
+    // the active set: variables stuck at a bound whose gradient is past
+    // these are unlikely to move again
+    auto max_pg_old = std::numeric_limits<double>::infinity();
+    auto min_pg_old = -std::numeric_limits<double>::infinity();
+    auto active = num_docs;
+
+    for (uint64_t iter = 0; iter < max_iter; ++iter)
+    {
+        auto max_pg = -std::numeric_limits<double>::infinity();
+        auto min_pg = std::numeric_limits<double>::infinity();
+
+        // use meta::random::shuffle for reproducibility between compilers
+        random::shuffle(order.begin(),
+                        order.begin() + static_cast<diff_type>(active), rng);
+
+        for (std::size_t s = 0; s < active; ++s)
+        {
+            auto i = order[s];
+            const auto& weights = instances[i]->weights;
+
+            auto grad = bias_ * bias_feature;
+            for (const auto& feat : weights)
+                grad += weights_[feat.first] * feat.second;
+            grad = labels[i] * grad - 1 + alpha[i] * diag;
+
+            double proj_grad = 0;
+            if (alpha[i] == 0)
+            {
+                if (grad > max_pg_old)
+                {
+                    std::swap(order[s], order[--active]);
+                    --s;
+                    continue;
+                }
+                proj_grad = std::min(grad, 0.0);
+            }
+            else if (alpha[i] == upper_bound)
+            {
+                if (grad < min_pg_old)
+                {
+                    std::swap(order[s], order[--active]);
+                    --s;
+                    continue;
+                }
+                proj_grad = std::max(grad, 0.0);
+            }
+            else
+            {
+                proj_grad = grad;
+            }
+
+            max_pg = std::max(max_pg, proj_grad);
+            min_pg = std::min(min_pg, proj_grad);
+
+            if (std::abs(proj_grad) > 1e-12)
+            {
+                auto old_alpha = alpha[i];
+                alpha[i] = std::min(
+                    std::max(alpha[i] - grad / q_diag[i], 0.0), upper_bound);
+
+                auto delta = (alpha[i] - old_alpha) * labels[i];
+                for (const auto& feat : weights)
+                    weights_[feat.first] += delta * feat.second;
+                bias_ += delta * bias_feature;
+            }
+        }
+
+        if (max_pg - min_pg <= tolerance)
+        {
+            // converged on the active set: check the rest of the
+            // variables with one more full pass before stopping
+            if (active == num_docs)
+                break;
+
+            active = num_docs;
+            max_pg_old = std::numeric_limits<double>::infinity();
+            min_pg_old = -std::numeric_limits<double>::infinity();
+            continue;
+        }
+
+        max_pg_old = max_pg > 0 ? max_pg
+                                : std::numeric_limits<double>::infinity();
+        min_pg_old = min_pg < 0 ? min_pg
+                                : -std::numeric_limits<double>::infinity();
+    }
+}
+
+double linear_svm::predict(const feature_vector& doc) const
+{
+    auto score = bias_;
+    for (const auto& feat : doc)
+    {
+        // features unseen in training have no weight
+        if (feat.first < weights_.size())
+            score += weights_[feat.first] * feat.second;
+    }
+    return score;
+}
+
+uint64_t linear_svm::num_features() const
+{
+    return weights_.size();
+}
+
+double linear_svm::weight(learn::feature_id feature) const
+{
+    return weights_.at(feature);
+}
+
+double linear_svm::bias() const
+{
+    return bias_;
+}
+
+template <>
+std::unique_ptr<binary_classifier>
+make_binary_classifier<linear_svm>(const cpptoml::table& config,
+                                   binary_dataset_view training)
+{
+    auto loss = linear_svm::loss_type::L2;
+    if (auto loss_name = config.get_as<std::string>("loss"))
+    {
+        if (*loss_name == "l1")
+            loss = linear_svm::loss_type::L1;
+        else if (*loss_name != "l2")
+            throw binary_classifier_factory::exception{
+                "unknown loss for linear-svm: " + *loss_name};
+    }
+
+    auto cost
+        = config.get_as<double>("cost").value_or(linear_svm::default_cost);
+    if (cost <= 0)
+        throw binary_classifier_factory::exception{
+            "cost must be positive for linear-svm"};
+
+    auto tolerance = config.get_as<double>("tolerance")
+                         .value_or(linear_svm::default_tolerance);
+
+    auto max_iter = config.get_as<int64_t>("max-iter").value_or(
+        static_cast<int64_t>(linear_svm::default_max_iter));
+    if (max_iter < 1)
+        throw binary_classifier_factory::exception{
+            "max-iter must be at least 1 for linear-svm"};
+
+    auto bias = config.get_as<bool>("bias").value_or(true);
+
+    return make_unique<linear_svm>(std::move(training), loss, cost, tolerance,
+                                   static_cast<uint64_t>(max_iter), bias);
+}
+}
+}
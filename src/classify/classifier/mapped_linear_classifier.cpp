@@ -0,0 +1,45 @@
+/**
+ * @file mapped_linear_classifier.cpp
+ * @author Chase Geigle
+ */
+
+#include "meta/classify/classifier/mapped_linear_classifier.h"
+#include "meta/io/packed.h"
+
+namespace meta
+{
+namespace classify
+{
+
+const util::string_view mapped_linear_classifier::id = "mapped-linear";
+
+mapped_linear_classifier::mapped_linear_classifier(
+    const std::string& path, const io::mmap_options& options)
+    : model_{path, options}
+{
+    // nothing
+}
+
+mapped_linear_classifier::mapped_linear_classifier(std::istream& in)
+    : model_{io::packed::read<std::string>(in)}
+{
+    // nothing
+}
+
+void mapped_linear_classifier::save(std::ostream& out) const
+{
+    io::packed::write(out, id);
+    io::packed::write(out, model_.path());
+}
+
+class_label mapped_linear_classifier::classify(const feature_vector& doc) const
+{
+    return model_.best_class(doc);
+}
+
+const mapped_linear_model& mapped_linear_classifier::model() const
+{
+    return model_;
+}
+}
+}
@@ -3,10 +3,14 @@
  * @author Sean Massung
  */
 
-#include <cassert>
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include "cpptoml.h"
 #include "meta/classify/classifier/naive_bayes.h"
+#include "meta/hashing/probe_map.h"
 #include "meta/io/packed.h"
+#include "meta/parallel/algorithm.h"
 
 namespace meta
 {
@@ -17,24 +21,82 @@ const util::string_view naive_bayes::id = "naive-bayes";
 const constexpr double naive_bayes::default_alpha;
 const constexpr double naive_bayes::default_beta;
 
-naive_bayes::naive_bayes(dataset_view_type docs, double alpha, double beta)
-    : class_probs_{stats::dirichlet<class_label>{beta, docs.total_labels()}}
+namespace
+{
+/**
+ * @return the classes of a multiclass_dataset_view, in increasing order
+ */
+std::vector<class_label> sorted_labels(const multiclass_dataset_view& docs)
 {
-    stats::dirichlet<term_id> term_prior{alpha, docs.total_features()};
-
     std::vector<class_label> labels(docs.total_labels());
-
     std::transform(docs.labels_begin(), docs.labels_end(), labels.begin(),
                    [](const std::pair<const class_label, label_id>& pr)
                    {
                        return pr.first;
                    });
     std::sort(labels.begin(), labels.end());
+    return labels;
+}
+
+/**
+ * @return the classes of the documents in a multiclass_csr_view, in
+ * increasing order
+ */
+std::vector<class_label> sorted_labels(const multiclass_csr_view& docs)
+{
+    std::vector<class_label> labels;
+    for (const auto& instance : docs)
+    {
+        auto lbl = docs.label(instance);
+        if (std::find(labels.begin(), labels.end(), lbl) == labels.end())
+            labels.push_back(std::move(lbl));
+    }
+    std::sort(labels.begin(), labels.end());
+    return labels;
+}
+}
+
+naive_bayes::naive_bayes(dataset_view_type docs, double alpha, double beta)
+    : naive_bayes{sorted_labels(docs), docs.total_features(), alpha, beta}
+{
+    if (docs.size() < min_parallel_size)
+    {
+        train(docs, nullptr);
+        return;
+    }
+
+    parallel::thread_pool pool;
+    train(docs, &pool);
+}
+
+naive_bayes::naive_bayes(dataset_view_type docs, parallel::thread_pool& pool,
+                         double alpha, double beta)
+    : naive_bayes{sorted_labels(docs), docs.total_features(), alpha, beta}
+{
+    train(docs, &pool);
+}
+
+naive_bayes::naive_bayes(multiclass_csr_view docs, double alpha, double beta)
+    : naive_bayes{sorted_labels(docs), docs.total_features(), alpha, beta}
+{
+    if (docs.size() < min_parallel_size)
+    {
+        train(docs, nullptr);
+        return;
+    }
+
+    parallel::thread_pool pool;
+    train(docs, &pool);
+}
+
+naive_bayes::naive_bayes(const std::vector<class_label>& labels,
+                         uint64_t num_features, double alpha, double beta)
+    : class_probs_{stats::dirichlet<class_label>{beta, labels.size()}}
+{
+    stats::dirichlet<term_id> term_prior{alpha, num_features};
     term_probs_.reserve(labels.size());
     for (const auto& lbl : labels)
         term_probs_.emplace_back(lbl, term_prior);
-
-    train(docs);
 }
 
 naive_bayes::naive_bayes(std::istream& in)
@@ -54,6 +116,7 @@ naive_bayes::naive_bayes(std::istream& in)
         term_probs_[label].load(in);
     }
     class_probs_.load(in);
+    build_scorer();
 }
 
 void naive_bayes::save(std::ostream& os) const
@@ -71,44 +134,176 @@ void naive_bayes::save(std::ostream& os) const
     class_probs_.save(os);
 }
 
-void naive_bayes::train(const dataset_view_type& docs)
+namespace
 {
-    for (const auto& instance : docs)
+/**
+ * The term and document counts of each class seen by one thread.
+ */
+struct class_counts
+{
+    std::vector<hashing::probe_map<term_id, double>> terms;
+    std::vector<uint64_t> docs;
+};
+}
+
+template <class View>
+void naive_bayes::train(const View& docs, parallel::thread_pool* pool)
+{
+    std::vector<class_label> labels;
+    labels.reserve(term_probs_.size());
+    for (const auto& dist : term_probs_)
+        labels.push_back(dist.first);
+
+    auto column = [&](const class_label& lbl)
+    {
+        return static_cast<std::size_t>(
+            std::lower_bound(labels.begin(), labels.end(), lbl)
+            - labels.begin());
+    };
+
+    auto make_counts = [&]()
+    {
+        class_counts local;
+        local.terms.resize(labels.size());
+        local.docs.resize(labels.size(), 0);
+        return local;
+    };
+
+    auto count = [&](class_counts& local,
+                     const typename View::instance_type& instance)
     {
+        auto col = column(docs.label(instance));
+        auto& terms = local.terms[col];
         for (const auto& p : instance.weights)
-        {
-            term_probs_[docs.label(instance)].increment(p.first, p.second);
-            assert(term_probs_[docs.label(instance)].probability(p.first) > 0);
-        }
-        class_probs_.increment(docs.label(instance), 1);
+            terms[p.first] += p.second;
+        ++local.docs[col];
+    };
+
+    auto counts = make_counts();
+    if (pool && docs.size() >= min_parallel_size)
+    {
+        counts = parallel::reduction(
+            docs.begin(), docs.end(), *pool, make_counts, count,
+            [](class_counts& result, const class_counts& local)
+            {
+                for (std::size_t col = 0; col < result.terms.size(); ++col)
+                {
+                    auto& terms = result.terms[col];
+                    for (const auto& pr : local.terms[col])
+                        terms[pr.key()] += pr.value();
+                    result.docs[col] += local.docs[col];
+                }
+            });
     }
+    else
+    {
+        for (const auto& instance : docs)
+            count(counts, instance);
+    }
+
+    using count_type = std::pair<term_id, double>;
+    for (std::size_t col = 0; col < labels.size(); ++col)
+    {
+        // add the terms in increasing order so that each one is appended
+        // to the distribution's sparse counts
+        auto terms = std::move(counts.terms[col]).extract();
+        std::sort(terms.begin(), terms.end(),
+                  [](const count_type& a, const count_type& b)
+                  {
+                      return a.first < b.first;
+                  });
+
+        auto& term_dist = term_probs_[labels[col]];
+        for (const auto& pr : terms)
+            term_dist.increment(pr.first, pr.second);
+
+        if (counts.docs[col] > 0)
+            class_probs_.increment(labels[col],
+                                   static_cast<double>(counts.docs[col]));
+    }
+
+    build_scorer();
 }
 
-class_label naive_bayes::classify(const feature_vector& instance) const
+void naive_bayes::build_scorer()
 {
-    class_label label;
-    double best = std::numeric_limits<double>::lowest();
+    log_priors_.clear();
+    log_unseen_.clear();
 
-    // calculate prob of test doc for each class
+    std::vector<uint64_t> sizes;
     for (const auto& cls : term_probs_)
     {
-        const auto& lbl = cls.first;
         const auto& term_dist = cls.second;
+        log_priors_.push_back(std::log(class_probs_.probability(cls.first)));
 
-        double sum = 0.0;
-        assert(class_probs_.probability(lbl) > 0);
-        sum += std::log(class_probs_.probability(lbl));
-        for (const auto& t : instance)
-        {
-            assert(term_dist.probability(t.first) > 0);
-            sum += t.second * std::log(term_dist.probability(t.first));
-        }
+        // the term prior is symmetric, so every unseen term in a class has
+        // the same probability
+        log_unseen_.push_back(std::log(
+            term_dist.prior().pseudo_counts(term_id{}) / term_dist.counts()));
+
+        term_dist.each_seen_event([&](const term_id& tid)
+                                  {
+                                      if (tid >= sizes.size())
+                                          sizes.resize(tid + 1, 0);
+                                      ++sizes[tid];
+                                  });
+    }
+
+    offsets_.assign(sizes.size() + 1, 0);
+    for (std::size_t tid = 0; tid < sizes.size(); ++tid)
+        offsets_[tid + 1] = offsets_[tid] + sizes[tid];
+    classes_.resize(offsets_.back());
+    deltas_.resize(offsets_.back());
+
+    // fill each term's entries in increasing order of class
+    std::vector<uint64_t> next(offsets_.begin(), offsets_.end() - 1);
+    uint32_t col = 0;
+    for (const auto& cls : term_probs_)
+    {
+        const auto& term_dist = cls.second;
+        term_dist.each_seen_event([&](const term_id& tid)
+                                  {
+                                      auto i = next[tid]++;
+                                      classes_[i] = col;
+                                      deltas_[i]
+                                          = std::log(
+                                                term_dist.probability(tid))
+                                            - log_unseen_[col];
+                                  });
+        ++col;
+    }
+}
 
+class_label naive_bayes::classify(const feature_vector& instance) const
+{
+    // the log probability of the document in a class is the unseen-term
+    // probability for every term plus a correction for each term that was
+    // seen in the class, so all classes are scored in one pass over the
+    // document's terms
+    std::vector<double> scores(log_priors_.size(), 0.0);
+    double length = 0;
+    for (const auto& t : instance)
+    {
+        length += t.second;
+        if (t.first + 1 >= offsets_.size())
+            continue;
+
+        for (auto i = offsets_[t.first]; i < offsets_[t.first + 1]; ++i)
+            scores[classes_[i]] += t.second * deltas_[i];
+    }
+
+    class_label label;
+    double best = std::numeric_limits<double>::lowest();
+    std::size_t col = 0;
+    for (const auto& cls : term_probs_)
+    {
+        auto sum = scores[col] + log_priors_[col] + length * log_unseen_[col];
         if (sum > best)
         {
             best = sum;
             label = cls.first;
         }
+        ++col;
     }
 
     return label;
@@ -3,13 +3,17 @@
  * @author Sean Massung
  */
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
-#include <unordered_map>
 
 #include "cpptoml.h"
 #include "meta/classify/classifier/nearest_centroid.h"
 #include "meta/corpus/document.h"
+#include "meta/hashing/probe_map.h"
 #include "meta/index/postings_data.h"
+#include "meta/parallel/algorithm.h"
 
 namespace meta
 {
@@ -18,31 +22,162 @@ namespace classify
 
 const util::string_view nearest_centroid::id = "nearest-centroid";
 
+namespace
+{
+/**
+ * The term and document counts of each class seen by one thread.
+ */
+struct class_counts
+{
+    std::vector<hashing::probe_map<term_id, double>> terms;
+    std::vector<uint64_t> docs;
+};
+
+/**
+ * @return the classes of a multiclass_dataset_view, in increasing order
+ */
+std::vector<class_label> sorted_labels(const multiclass_dataset_view& docs)
+{
+    std::vector<class_label> labels;
+    labels.reserve(docs.total_labels());
+    for (auto it = docs.labels_begin(); it != docs.labels_end(); ++it)
+        labels.push_back(it->first);
+    std::sort(labels.begin(), labels.end());
+    return labels;
+}
+
+/**
+ * @return the classes of the documents in a multiclass_csr_view, in
+ * increasing order
+ */
+std::vector<class_label> sorted_labels(const multiclass_csr_view& docs)
+{
+    std::vector<class_label> labels;
+    for (const auto& instance : docs)
+    {
+        auto lbl = docs.label(instance);
+        if (std::find(labels.begin(), labels.end(), lbl) == labels.end())
+            labels.push_back(std::move(lbl));
+    }
+    std::sort(labels.begin(), labels.end());
+    return labels;
+}
+}
+
 nearest_centroid::nearest_centroid(multiclass_dataset_view docs,
                                    std::shared_ptr<index::inverted_index> idx)
     : inv_idx_{std::move(idx)}
 {
-    double num_docs = inv_idx_->num_docs();
-    std::unordered_map<class_label, uint32_t> docs_per_class;
+    if (docs.size() < min_parallel_size)
+    {
+        train(docs, nullptr);
+        return;
+    }
 
-    // create document centroids based on averages of TF-IDF values
+    parallel::thread_pool pool;
+    train(docs, &pool);
+}
 
-    for (const auto& instance : docs)
+nearest_centroid::nearest_centroid(multiclass_dataset_view docs,
+                                   std::shared_ptr<index::inverted_index> idx,
+                                   parallel::thread_pool& pool)
+    : inv_idx_{std::move(idx)}
+{
+    train(docs, &pool);
+}
+
+nearest_centroid::nearest_centroid(multiclass_csr_view docs,
+                                   std::shared_ptr<index::inverted_index> idx)
+    : inv_idx_{std::move(idx)}
+{
+    if (docs.size() < min_parallel_size)
     {
-        const auto& label = docs.label(instance);
-        ++docs_per_class[label];
-        for (auto& pair : instance.weights)
+        train(docs, nullptr);
+        return;
+    }
+
+    parallel::thread_pool pool;
+    train(docs, &pool);
+}
+
+template <class View>
+void nearest_centroid::train(const View& docs, parallel::thread_pool* pool)
+{
+    auto labels = sorted_labels(docs);
+
+    auto column = [&](const class_label& lbl)
+    {
+        return static_cast<std::size_t>(
+            std::lower_bound(labels.begin(), labels.end(), lbl)
+            - labels.begin());
+    };
+
+    // the IDF weighting is the same for every document, so only the raw
+    // term counts of each class are summed (in parallel, for large sets)
+    auto make_counts = [&]()
+    {
+        class_counts local;
+        local.terms.resize(labels.size());
+        local.docs.resize(labels.size(), 0);
+        return local;
+    };
+
+    auto count = [&](class_counts& local,
+                     const typename View::instance_type& instance)
+    {
+        auto col = column(docs.label(instance));
+        auto& terms = local.terms[col];
+        for (const auto& pair : instance.weights)
+            terms[pair.first] += pair.second;
+        ++local.docs[col];
+    };
+
+    auto counts = make_counts();
+    if (pool && docs.size() >= min_parallel_size)
+    {
+        counts = parallel::reduction(
+            docs.begin(), docs.end(), *pool, make_counts, count,
+            [](class_counts& result, const class_counts& local)
+            {
+                for (std::size_t col = 0; col < result.terms.size(); ++col)
+                {
+                    auto& terms = result.terms[col];
+                    for (const auto& pr : local.terms[col])
+                        terms[pr.key()] += pr.value();
+                    result.docs[col] += local.docs[col];
+                }
+            });
+    }
+    else
+    {
+        for (const auto& instance : docs)
+            count(counts, instance);
+    }
+
+    // create document centroids based on averages of TF-IDF values
+    double num_docs = inv_idx_->num_docs();
+    std::vector<class_label> seen;
+    std::vector<std::vector<std::pair<term_id, double>>> centroids;
+    for (std::size_t col = 0; col < labels.size(); ++col)
+    {
+        if (counts.docs[col] == 0)
+            continue;
+
+        std::vector<std::pair<term_id, double>> centroid;
+        centroid.reserve(counts.terms[col].size());
+        for (const auto& pr : counts.terms[col])
         {
-            term_id tid = pair.first;
-            double count = pair.second;
-            double tfidf = count * std::log(num_docs / inv_idx_->doc_freq(tid));
-            centroids_[label][tid] += tfidf;
+            auto tid = pr.key();
+            double tfidf
+                = pr.value() * std::log(num_docs / inv_idx_->doc_freq(tid));
+            centroid.emplace_back(tid, tfidf / counts.docs[col]);
         }
+
+        seen.push_back(labels[col]);
+        centroids.push_back(std::move(centroid));
     }
 
-    for (auto& centroid : centroids_)
-        for (auto& term_pair : centroid.second)
-            term_pair.second /= docs_per_class[centroid.first];
+    set_centroids(std::move(seen), centroids);
 }
 
 nearest_centroid::nearest_centroid(std::istream& in)
@@ -53,18 +188,75 @@ nearest_centroid::nearest_centroid(std::istream& in)
     inv_idx_ = index::make_index<index::inverted_index>(*config);
 
     auto size = io::packed::read<std::size_t>(in);
+    std::vector<class_label> labels(size);
+    std::vector<std::vector<std::pair<term_id, double>>> centroids(size);
     for (std::size_t i = 0; i < size; ++i)
     {
-        auto lbl = io::packed::read<class_label>(in);
-        auto& map_ref = centroids_[lbl];
+        labels[i] = io::packed::read<class_label>(in);
 
         auto isize = io::packed::read<std::size_t>(in);
+        centroids[i].reserve(isize);
         for (std::size_t j = 0; j < isize; ++j)
         {
             auto id = io::packed::read<term_id>(in);
             auto weight = io::packed::read<double>(in);
-            map_ref.emplace(id, weight);
+            centroids[i].emplace_back(id, weight);
+        }
+    }
+
+    set_centroids(std::move(labels), centroids);
+}
+
+void nearest_centroid::set_centroids(
+    std::vector<class_label> labels,
+    const std::vector<std::vector<std::pair<term_id, double>>>& centroids)
+{
+    // order the classes so that ties go to the smallest label
+    std::vector<std::size_t> order(labels.size());
+    for (std::size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [&](std::size_t a, std::size_t b)
+              {
+                  return labels[a] < labels[b];
+              });
+
+    labels_.clear();
+    norms_.clear();
+    std::vector<uint64_t> sizes;
+    for (auto i : order)
+    {
+        labels_.push_back(std::move(labels[i]));
+
+        double norm = 0.0;
+        for (const auto& pr : centroids[i])
+        {
+            norm += pr.second * pr.second;
+            if (pr.first >= sizes.size())
+                sizes.resize(pr.first + 1, 0);
+            ++sizes[pr.first];
+        }
+        norms_.push_back(std::sqrt(norm));
+    }
+
+    offsets_.assign(sizes.size() + 1, 0);
+    for (std::size_t tid = 0; tid < sizes.size(); ++tid)
+        offsets_[tid + 1] = offsets_[tid] + sizes[tid];
+    classes_.resize(offsets_.back());
+    weights_.resize(offsets_.back());
+
+    // fill each term's entries in increasing order of class
+    std::vector<uint64_t> next(offsets_.begin(), offsets_.end() - 1);
+    uint32_t col = 0;
+    for (auto i : order)
+    {
+        for (const auto& pr : centroids[i])
+        {
+            auto idx = next[pr.first]++;
+            classes_[idx] = col;
+            weights_[idx] = pr.second;
         }
+        ++col;
     }
 }
 
@@ -74,68 +266,64 @@ void nearest_centroid::save(std::ostream& out) const
 
     io::packed::write(out, inv_idx_->index_name());
 
-    io::packed::write(out, centroids_.size());
-    for (const auto& pr : centroids_)
+    // gather each class's centroid back out of the term-indexed matrix
+    std::vector<std::vector<std::pair<term_id, double>>> centroids(
+        labels_.size());
+    for (std::size_t tid = 0; tid + 1 < offsets_.size(); ++tid)
+    {
+        for (auto i = offsets_[tid]; i < offsets_[tid + 1]; ++i)
+            centroids[classes_[i]].emplace_back(term_id{tid}, weights_[i]);
+    }
+
+    io::packed::write(out, labels_.size());
+    for (std::size_t col = 0; col < labels_.size(); ++col)
     {
-        io::packed::write(out, pr.first);
-        io::packed::write(out, pr.second.size());
-        for (const auto& ipr : pr.second)
+        io::packed::write(out, labels_[col]);
+        io::packed::write(out, centroids[col].size());
+        for (const auto& pr : centroids[col])
         {
-            io::packed::write(out, ipr.first);
-            io::packed::write(out, ipr.second);
+            io::packed::write(out, pr.first);
+            io::packed::write(out, pr.second);
         }
     }
 }
 
 class_label nearest_centroid::classify(const feature_vector& instance) const
 {
-    double best_score = std::numeric_limits<double>::lowest();
-    class_label best_label;
-
-    // convert to TF-IDF representation
+    // convert to TF-IDF representation and take its dot product with
+    // every centroid in one pass over the document's terms
     double num_docs = inv_idx_->num_docs();
-    auto counts(instance);
-    for (auto& count : counts)
-        count.second *= std::log(num_docs / inv_idx_->doc_freq(count.first));
+    std::vector<double> dots(labels_.size(), 0.0);
+    double doc_mag = 0.0;
+    for (const auto& count : instance)
+    {
+        double tfidf = count.second
+                       * std::log(num_docs / inv_idx_->doc_freq(count.first));
+        doc_mag += tfidf * tfidf;
+        if (count.first + 1 >= offsets_.size())
+            continue;
+
+        for (auto i = offsets_[count.first]; i < offsets_[count.first + 1]; ++i)
+            dots[classes_[i]] += weights_[i] * tfidf;
+    }
+    doc_mag = std::sqrt(doc_mag);
 
-    for (auto& centroid : centroids_)
+    // score each class by the cosine similarity with its centroid
+    double best_score = std::numeric_limits<double>::lowest();
+    class_label best_label;
+    for (std::size_t col = 0; col < labels_.size(); ++col)
     {
-        double score
-            = cosine_sim(counts.begin(), counts.end(), centroid.second);
+        double score = dots[col] / (doc_mag * norms_[col]);
         if (score > best_score)
         {
             best_score = score;
-            best_label = centroid.first;
+            best_label = labels_[col];
         }
     }
 
     return best_label;
 }
 
-template <class ForwardIterator>
-double nearest_centroid::cosine_sim(
-    ForwardIterator begin, ForwardIterator end,
-    const std::unordered_map<term_id, double>& centroid) const
-{
-    double centroid_mag = 0.0;
-    for (const auto& pair : centroid)
-        centroid_mag += pair.second * pair.second;
-
-    double dot = 0.0;
-    double doc_mag = 0.0;
-    for (; begin != end; ++begin)
-    {
-        doc_mag += begin->second * begin->second;
-        auto it = centroid.find(begin->first);
-        if (it != centroid.end())
-            dot += it->second * begin->second;
-    }
-
-    centroid_mag = std::sqrt(centroid_mag);
-    doc_mag = std::sqrt(doc_mag);
-    return dot / (doc_mag * centroid_mag);
-}
-
 template <>
 std::unique_ptr<classifier> make_multi_index_classifier<nearest_centroid>(
     const cpptoml::table&, multiclass_dataset_view training,
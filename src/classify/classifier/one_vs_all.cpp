@@ -3,7 +3,10 @@
  * @author Chase Geigle
  */
 
+#include <algorithm>
+
 #include "meta/classify/binary_classifier_factory.h"
+#include "meta/classify/classifier/linear_predictor.h"
 #include "meta/classify/classifier/one_vs_all.h"
 #include "meta/classify/classifier/online_binary_classifier.h"
 #include "meta/parallel/parallel_for.h"
@@ -58,6 +61,54 @@ void one_vs_all::save(std::ostream& out) const
     }
 }
 
+void one_vs_all::save_mapped(const std::string& path,
+                             weight_encoding encoding) const
+{
+    using model_type = std::pair<class_label, const linear_predictor*>;
+    std::vector<model_type> models;
+    models.reserve(classifiers_.size());
+    for (const auto& pr : classifiers_)
+    {
+        auto model = dynamic_cast<const linear_predictor*>(pr.second.get());
+        if (!model)
+            throw classifier_exception{
+                "base type in one_vs_all is not a linear_predictor"};
+        models.emplace_back(pr.first, model);
+    }
+
+    // store the classes in order so that ties are broken consistently
+    std::sort(models.begin(), models.end(),
+              [](const model_type& a, const model_type& b)
+              {
+                  return a.first < b.first;
+              });
+
+    std::vector<class_label> classes;
+    std::vector<double> biases;
+    uint64_t num_features = 0;
+    for (const auto& model : models)
+    {
+        classes.push_back(model.first);
+        biases.push_back(model.second->bias());
+        num_features = std::max(num_features, model.second->num_features());
+    }
+
+    mapped_linear_model_writer writer{path, classes, biases, encoding};
+    std::vector<double> weights(models.size());
+    for (uint64_t feature = 0; feature < num_features; ++feature)
+    {
+        for (std::size_t i = 0; i < models.size(); ++i)
+        {
+            const auto& model = *models[i].second;
+            weights[i] = feature < model.num_features()
+                             ? model.weight(learn::feature_id{feature})
+                             : 0;
+        }
+        writer.insert(weights);
+    }
+    writer.finish();
+}
+
 void one_vs_all::train(dataset_view_type docs)
 {
     parallel::parallel_for(
@@ -6,6 +6,7 @@
 #include <numeric>
 #include <random>
 
+#include "meta/classify/classifier/classifier.h"
 #include "meta/classify/classifier/sgd.h"
 #include "meta/learn/loss/loss_function_factory.h"
 #include "meta/index/postings_data.h"
@@ -22,22 +23,50 @@ const constexpr size_t sgd::default_max_iter;
 sgd::sgd(binary_dataset_view docs,
          std::unique_ptr<learn::loss::loss_function> loss,
          learn::sgd_model::options_type options, double gamma, size_t max_iter,
-         bool calibrate)
+         bool calibrate, std::size_t num_threads, std::size_t batch_size)
     : model_{docs.total_features(), options},
       gamma_{gamma},
       max_iter_{max_iter},
-      loss_{std::move(loss)}
+      loss_{std::move(loss)},
+      num_threads_{std::max<std::size_t>(1, num_threads)},
+      batch_size_{std::max<std::size_t>(1, batch_size)}
 {
     if (calibrate)
-    {
-        model_.calibrate(docs, *loss_, [&](const learn::instance& inst)
-                         {
-                             return docs.label(inst) ? +1 : -1;
-                         });
-    }
+        this->calibrate(docs);
     train(std::move(docs));
 }
 
+sgd::sgd(binary_csr_view docs, std::unique_ptr<learn::loss::loss_function> loss,
+         learn::sgd_model::options_type options, double gamma, size_t max_iter,
+         bool calibrate, std::size_t num_threads, std::size_t batch_size)
+    : model_{docs.total_features(), options},
+      gamma_{gamma},
+      max_iter_{max_iter},
+      loss_{std::move(loss)},
+      num_threads_{std::max<std::size_t>(1, num_threads)},
+      batch_size_{std::max<std::size_t>(1, batch_size)}
+{
+    if (calibrate)
+        this->calibrate(docs);
+    train_view(docs);
+}
+
+sgd::sgd(binary_dataset_view docs,
+         std::unique_ptr<learn::loss::loss_function> loss,
+         learn::sgd_model::options_type options, parallel::thread_pool& pool,
+         double gamma, size_t max_iter, bool calibrate, std::size_t batch_size)
+    : model_{docs.total_features(), options},
+      gamma_{gamma},
+      max_iter_{max_iter},
+      loss_{std::move(loss)},
+      num_threads_{std::max<std::size_t>(1, pool.size())},
+      batch_size_{std::max<std::size_t>(1, batch_size)}
+{
+    if (calibrate)
+        this->calibrate(docs);
+    train(std::move(docs), pool);
+}
+
 sgd::sgd(std::istream& in)
     : model_{[&]()
              {
@@ -59,8 +88,62 @@ void sgd::save(std::ostream& out) const
     loss_->save(out);
 }
 
+template <class View>
+void sgd::calibrate(const View& docs)
+{
+    model_.calibrate(docs, *loss_,
+                     [&](const typename View::instance_type& inst)
+                     {
+                         return docs.label(inst) ? +1 : -1;
+                     });
+}
+
 void sgd::train(binary_dataset_view docs)
 {
+    train_view(docs);
+}
+
+void sgd::train(binary_dataset_view docs, parallel::thread_pool& pool)
+{
+    train(docs, &pool);
+}
+
+template <class View>
+void sgd::train_view(View& docs)
+{
+    if (num_threads_ > 1 && !model_.averaged()
+        && docs.size() >= classifier::min_parallel_size)
+    {
+        parallel::thread_pool pool{num_threads_};
+        train(docs, &pool);
+    }
+    else
+    {
+        train(docs, nullptr);
+    }
+}
+
+template <class View>
+void sgd::train(View& docs, parallel::thread_pool* pool)
+{
+    auto labeler = [&](const typename View::instance_type& inst)
+    {
+        return docs.label(inst) ? +1 : -1;
+    };
+    // averaged models can't be trained with hogwild, so they always
+    // train from the calling thread
+    if (pool && pool->size() > 1 && !model_.averaged()
+        && docs.size() >= classifier::min_parallel_size)
+        train_hogwild(docs, labeler, *pool);
+    else
+        train_epochs(docs, labeler);
+}
+
+template <class View, class LabelFunction>
+void sgd::train_epochs(View& docs, LabelFunction&& labeler)
+{
+    using diff_type = typename decltype(docs.begin())::difference_type;
+
     size_t t = 0;
     double avg_loss = 0;
     double prev_avg_loss = 0;
@@ -68,13 +151,15 @@ void sgd::train(binary_dataset_view docs)
     for (size_t iter = 0; iter < max_iter_; ++iter)
     {
         docs.shuffle();
-        for (const auto& instance : docs)
+        for (auto it = docs.begin(), end = docs.end(); it != end;)
         {
-            t += 1;
+            auto batch_size = std::min<std::size_t>(
+                batch_size_, static_cast<std::size_t>(end - it));
 
             // check for convergence every 10th of the dataset or every
-            // 1000 documents, whichever comes later
-            if (t % check_interval == 0)
+            // 1000 documents, whichever comes later (rounded up to the
+            // next batch)
+            if (t / check_interval != (t + batch_size) / check_interval)
             {
                 avg_loss /= check_interval;
                 if (prev_avg_loss > 0
@@ -84,13 +169,41 @@ void sgd::train(binary_dataset_view docs)
                 prev_avg_loss = avg_loss;
                 avg_loss = 0;
             }
+            t += batch_size;
 
-            avg_loss += model_.train_one(
-                instance.weights, docs.label(instance) ? +1 : -1, *loss_);
+            if (batch_size_ == 1)
+            {
+                avg_loss += model_.train_one(it->weights, labeler(*it), *loss_);
+                ++it;
+            }
+            else
+            {
+                auto batch_end = it + static_cast<diff_type>(batch_size);
+                avg_loss += model_.train_batch(it, batch_end, *loss_, labeler);
+                it = batch_end;
+            }
         }
     }
 }
 
+template <class View, class LabelFunction>
+void sgd::train_hogwild(View& docs, LabelFunction&& labeler,
+                        parallel::thread_pool& pool)
+{
+    double prev_avg_loss = 0;
+    for (size_t iter = 0; iter < max_iter_ && docs.size() > 0; ++iter)
+    {
+        docs.shuffle();
+        auto avg_loss = model_.train_hogwild(docs, *loss_, labeler, pool)
+                        / docs.size();
+
+        if (prev_avg_loss > 0
+            && std::abs(prev_avg_loss - avg_loss) / prev_avg_loss < gamma_)
+            return;
+        prev_avg_loss = avg_loss;
+    }
+}
+
 void sgd::train_one(const feature_vector& doc, bool label)
 {
     model_.train_one(doc, label ? +1 : -1, *loss_);
@@ -101,6 +214,21 @@ double sgd::predict(const feature_vector& doc) const
     return model_.predict(doc);
 }
 
+uint64_t sgd::num_features() const
+{
+    return model_.num_features();
+}
+
+double sgd::weight(learn::feature_id feature) const
+{
+    return model_.weight(feature);
+}
+
+double sgd::bias() const
+{
+    return model_.bias();
+}
+
 template <>
 std::unique_ptr<binary_classifier>
 make_binary_classifier<sgd>(const cpptoml::table& config,
@@ -129,9 +257,26 @@ make_binary_classifier<sgd>(const cpptoml::table& config,
 
     auto calibrate = config.get_as<bool>("calibrate").value_or(false);
 
+    auto num_threads = config.get_as<int64_t>("train-threads").value_or(1);
+    if (num_threads < 1)
+        throw binary_classifier_factory::exception{
+            "train-threads must be at least 1 for sgd"};
+
+    auto batch_size = config.get_as<int64_t>("batch-size").value_or(1);
+    if (batch_size < 1)
+        throw binary_classifier_factory::exception{
+            "batch-size must be at least 1 for sgd"};
+
+    options.averaged = config.get_as<bool>("averaged").value_or(false);
+    if (options.averaged && num_threads > 1)
+        throw binary_classifier_factory::exception{
+            "averaged sgd must be trained with one thread"};
+
     return make_unique<sgd>(std::move(training),
                             learn::loss::make_loss_function(*loss), options,
-                            gamma, max_iter, calibrate);
+                            gamma, max_iter, calibrate,
+                            static_cast<std::size_t>(num_threads),
+                            static_cast<std::size_t>(batch_size));
 }
 }
 }
@@ -3,8 +3,10 @@
  * @author Sean Massung
  */
 
+#include <atomic>
 #include <fstream>
 #include "meta/classify/classifier/svm_wrapper.h"
+#include "meta/io/filesystem.h"
 #include "meta/utf/utf.h"
 
 namespace meta
@@ -22,10 +24,26 @@ decltype(svm_wrapper::options_) svm_wrapper::options_
        {svm_wrapper::kernel::RBF, " -t 2 "},
        {svm_wrapper::kernel::Sigmoid, " -t 3 "}};
 
+namespace
+{
+/**
+ * @return a prefix for liblinear/libsvm files that no other svm_wrapper
+ * (or call to one) in this process uses, so that classifiers can be
+ * trained and used from several threads at once
+ */
+std::string unique_prefix()
+{
+    static std::atomic<uint64_t> next{0};
+    return "svm-" + std::to_string(next++);
+}
+}
+
 svm_wrapper::svm_wrapper(dataset_view_type docs, const std::string& svm_path,
                          kernel kernel_opt /* = None */)
     : svm_path_{svm_path}, kernel_{kernel_opt}
 {
+    auto prefix = unique_prefix();
+    model_file_ = prefix + ".model";
 
     labels_.resize(docs.total_labels());
     for (auto it = docs.labels_begin(), end = docs.labels_end(); it != end;
@@ -39,8 +57,9 @@ svm_wrapper::svm_wrapper(dataset_view_type docs, const std::string& svm_path,
     else
         executable_ = "libsvm/build/svm-";
 
+    auto train_file = prefix + "-train";
     {
-        std::ofstream out{"svm-train"};
+        std::ofstream out{train_file};
         for (const auto& instance : docs)
         {
             docs.print_liblinear(out, instance);
@@ -50,19 +69,23 @@ svm_wrapper::svm_wrapper(dataset_view_type docs, const std::string& svm_path,
 
 #ifndef _WIN32
     std::string command = svm_path_ + executable_ + "train "
-                          + options_.at(kernel_) + " svm-train";
+                          + options_.at(kernel_) + " " + train_file + " "
+                          + model_file_;
     command += " > /dev/null 2>&1";
 #else
-    // see comment in classify()
+    // see comment in predict()
     auto command = "\"\"" + svm_path_ + executable_ + "train.exe\" "
-                   + options_.at(kernel_) + " svm-train";
+                   + options_.at(kernel_) + " " + train_file + " "
+                   + model_file_;
     command += " > NUL 2>&1\"";
 #endif
     system(command.c_str());
+    filesystem::delete_file(train_file);
 }
 
 svm_wrapper::svm_wrapper(std::istream& in)
-    : svm_path_{io::packed::read<std::string>(in)}
+    : svm_path_{io::packed::read<std::string>(in)},
+      model_file_{unique_prefix() + ".model"}
 {
     io::packed::read(in, kernel_);
     io::packed::read(in, executable_);
@@ -72,7 +95,7 @@ svm_wrapper::svm_wrapper(std::istream& in)
     for (std::size_t i = 0; i < size; ++i)
         io::packed::read(in, labels_[i]);
 
-    std::ofstream out{"svm-train.model"};
+    std::ofstream out{model_file_};
     auto model_lines = io::packed::read<std::size_t>(in);
     std::string line;
     for (std::size_t i = 0; i < model_lines; ++i)
@@ -94,9 +117,9 @@ void svm_wrapper::save(std::ostream& out) const
     for (const auto& lbl : labels_)
         io::packed::write(out, lbl);
 
-    auto num_lines = filesystem::num_lines("svm-train.model");
+    auto num_lines = filesystem::num_lines(model_file_);
     io::packed::write(out, num_lines);
-    std::ifstream in{"svm-train.model"};
+    std::ifstream in{model_file_};
     std::string line;
     for (std::size_t i = 0; i < num_lines; ++i)
     {
@@ -105,20 +128,17 @@ void svm_wrapper::save(std::ostream& out) const
     }
 }
 
-class_label svm_wrapper::classify(const feature_vector& doc) const
+svm_wrapper::~svm_wrapper()
 {
-    // create input for liblinear
-    {
-        std::ofstream out{"svm-input"};
-        out << "1 "; // dummy label
-        learn::print_liblinear(out, doc);
-        out << "\n";
-    }
+    filesystem::delete_file(model_file_);
+}
 
-// run liblinear/libsvm
+void svm_wrapper::predict(const std::string& input,
+                          const std::string& output) const
+{
 #ifndef _WIN32
-    std::string command = svm_path_ + executable_
-                          + "predict svm-input svm-train.model svm-predicted";
+    std::string command = svm_path_ + executable_ + "predict " + input + " "
+                          + model_file_ + " " + output;
     command += " > /dev/null 2>&1";
 #else
     // first set of quotes is around the exe name to make things work without
@@ -126,29 +146,60 @@ class_label svm_wrapper::classify(const feature_vector& doc) const
     //
     // second set of quotes is around the entire command, since Windows does
     // strange things in making the command to actually be sent to CMD.exe
-    auto command = "\"\"" + svm_path_ + executable_
-                   + "predict.exe\" svm-input svm-train.model svm-predicted";
+    auto command = "\"\"" + svm_path_ + executable_ + "predict.exe\" "
+                   + input + " " + model_file_ + " " + output;
     command += " > NUL 2>&1\"";
 #endif
     system(command.c_str());
+}
+
+class_label svm_wrapper::classify(const feature_vector& doc) const
+{
+    // every call has its own files, so it may run alongside others
+    auto prefix = unique_prefix();
+    auto input = prefix + "-input";
+    auto output = prefix + "-predicted";
+
+    // create input for liblinear
+    {
+        std::ofstream out{input};
+        out << "1 "; // dummy label
+        learn::print_liblinear(out, doc);
+        out << "\n";
+    }
+
+    // run liblinear/libsvm
+    predict(input, output);
 
     // extract answer
     std::string str_val;
     {
-        std::ifstream in{"svm-predicted"};
+        std::ifstream in{output};
         std::getline(in, str_val);
     }
+    filesystem::delete_file(input);
+    filesystem::delete_file(output);
 
     auto lbl = std::stoul(str_val);
     assert(lbl > 0);
     return labels_.at(lbl - 1);
 }
 
+confusion_matrix svm_wrapper::test(multiclass_dataset_view docs,
+                                   parallel::thread_pool&) const
+{
+    return test(std::move(docs));
+}
+
 confusion_matrix svm_wrapper::test(multiclass_dataset_view docs) const
 {
+    auto prefix = unique_prefix();
+    auto input = prefix + "-input";
+    auto output = prefix + "-predicted";
+
     // create input for liblinear/libsvm
     {
-        std::ofstream out{"svm-input"};
+        std::ofstream out{input};
         for (const auto& instance : docs)
         {
             docs.print_liblinear(out, instance);
@@ -156,23 +207,13 @@ confusion_matrix svm_wrapper::test(multiclass_dataset_view docs) const
         }
     }
 
-// run liblinear/libsvm
-#ifndef _WIN32
-    std::string command = svm_path_ + executable_
-                          + "predict svm-input svm-train.model svm-predicted";
-    command += " > /dev/null 2>&1";
-#else
-    // see comment in classify()
-    auto command = "\"\"" + svm_path_ + executable_
-                   + "predict.exe\" svm-input svm-train.model svm-predicted";
-    command += " > NUL 2>&1\"";
-#endif
-    system(command.c_str());
+    // run liblinear/libsvm
+    predict(input, output);
 
     // extract answer
     confusion_matrix matrix;
     {
-        std::ifstream in{"svm-predicted"};
+        std::ifstream in{output};
         std::string str_val;
         for (const auto& instance : docs)
         {
@@ -186,6 +227,8 @@ confusion_matrix svm_wrapper::test(multiclass_dataset_view docs) const
             matrix.add(predicted, actual);
         }
     }
+    filesystem::delete_file(input);
+    filesystem::delete_file(output);
 
     return matrix;
 }
@@ -75,6 +75,7 @@ classifier_loader::classifier_loader()
     reg<logistic_regression>();
     reg<knn>();
     reg<nearest_centroid>();
+    reg<mapped_linear_classifier>();
 }
 
 std::unique_ptr<classifier> load_classifier(std::istream& in)
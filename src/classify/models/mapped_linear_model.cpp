@@ -0,0 +1,499 @@
+/**
+ * @file mapped_linear_model.cpp
+ * @author Chase Geigle
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+#include "meta/classify/models/mapped_linear_model.h"
+#include "meta/io/binary.h"
+#include "meta/io/filesystem.h"
+#include "meta/io/packed.h"
+
+namespace meta
+{
+namespace classify
+{
+
+const constexpr uint64_t mapped_linear_model_writer::alignment;
+
+namespace
+{
+/// "metalinm" in little-endian byte order
+const constexpr uint64_t magic = 0x6d6e696c6174656dull;
+
+/// The version of the file format
+const constexpr uint64_t version = 1;
+
+/// The size of the header in bytes
+const constexpr uint64_t header_size = 128;
+
+/// The row of a feature whose weights are all zero
+const constexpr uint32_t no_row = std::numeric_limits<uint32_t>::max();
+
+/**
+ * The fields of the header, in order.
+ */
+enum header_field
+{
+    MAGIC,
+    VERSION,
+    ENCODING,
+    NUM_CLASSES,
+    NUM_FEATURES,
+    NUM_ROWS,
+    LABELS_POS,
+    BIASES_POS,
+    WEIGHTS_POS,
+    SCALES_POS,
+    ROWS_POS,
+    NUM_FIELDS
+};
+
+/**
+ * Reads packed values directly out of a memory mapped file.
+ */
+struct char_input_stream
+{
+    char_input_stream(const char* input, const char* end)
+        : input_{input}, end_{end}
+    {
+        // nothing
+    }
+
+    char get()
+    {
+        if (input_ == end_)
+            throw mapped_linear_model_exception{
+                "mapped linear model class labels are truncated"};
+        return *input_++;
+    }
+
+    const char* input_;
+    const char* end_;
+};
+
+uint64_t bytes_per_weight(weight_encoding encoding)
+{
+    switch (encoding)
+    {
+        case weight_encoding::float32:
+            return sizeof(float);
+        case weight_encoding::float16:
+            return sizeof(uint16_t);
+        case weight_encoding::int8:
+            return sizeof(int8_t);
+    }
+    throw mapped_linear_model_exception{"unknown weight encoding"};
+}
+
+/**
+ * Converts a float to the nearest half precision float, rounding ties to
+ * even.
+ */
+uint16_t float_to_half(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    auto exponent = static_cast<int32_t>((bits >> 23) & 0xff);
+    uint32_t mantissa = bits & 0x7fffff;
+
+    // infinity or NaN
+    if (exponent == 0xff)
+        return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+    exponent += 15 - 127;
+    if (exponent >= 0x1f)
+        return static_cast<uint16_t>(sign | 0x7c00);
+
+    // too small for a normal half: shift the mantissa, with its leading
+    // one, into a subnormal one
+    uint32_t shift = 13;
+    uint32_t half = 0;
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return static_cast<uint16_t>(sign);
+        mantissa |= 0x800000;
+        shift = static_cast<uint32_t>(14 - exponent);
+    }
+    else
+    {
+        half = static_cast<uint32_t>(exponent) << 10;
+    }
+    half |= mantissa >> shift;
+
+    // a carry out of the mantissa correctly bumps the exponent
+    auto rest = mantissa & ((uint32_t{1} << shift) - 1);
+    auto halfway = uint32_t{1} << (shift - 1);
+    if (rest > halfway || (rest == halfway && (half & 1)))
+        ++half;
+
+    return static_cast<uint16_t>(sign | half);
+}
+
+/**
+ * Converts a half precision float to a float.
+ */
+float half_to_float(uint16_t half)
+{
+    uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ff;
+
+    uint32_t bits;
+    if (exponent == 0x1f)
+    {
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else if (exponent == 0)
+    {
+        // zero or subnormal
+        auto value = std::ldexp(static_cast<float>(mantissa), -24);
+        return sign ? -value : value;
+    }
+    else
+    {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void add_row(const float* weights, double val, double* scores, uint64_t size)
+{
+    for (uint64_t i = 0; i < size; ++i)
+        scores[i] += val * weights[i];
+}
+
+void add_row(const int8_t* weights, double val, double* scores,
+             uint64_t size)
+{
+    for (uint64_t i = 0; i < size; ++i)
+        scores[i] += val * weights[i];
+}
+
+void add_row(const uint16_t* weights, double val, double* scores,
+             uint64_t size)
+{
+    uint64_t i = 0;
+#if defined(__F16C__)
+    // convert eight halves at a time
+    float block[8];
+    for (; i + 8 <= size; i += 8)
+    {
+        auto halves = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(weights + i));
+        _mm256_storeu_ps(block, _mm256_cvtph_ps(halves));
+        for (uint64_t j = 0; j < 8; ++j)
+            scores[i + j] += val * block[j];
+    }
+#endif
+    for (; i < size; ++i)
+        scores[i] += val * half_to_float(weights[i]);
+}
+}
+
+mapped_linear_model::mapped_linear_model(const std::string& path,
+                                         const io::mmap_options& options)
+    : file_{path, options}
+{
+    if (file_.size() < header_size)
+        throw mapped_linear_model_exception{
+            "mapped linear model file is truncated: " + path};
+
+    auto header = reinterpret_cast<const uint64_t*>(file_.begin());
+    if (header[MAGIC] != magic || header[VERSION] != version)
+        throw mapped_linear_model_exception{
+            "not a mapped linear model file: " + path};
+
+    encoding_ = static_cast<weight_encoding>(header[ENCODING]);
+    auto num_classes = header[NUM_CLASSES];
+    num_features_ = header[NUM_FEATURES];
+    auto num_rows = header[NUM_ROWS];
+
+    // every section must lie within the file
+    auto fits = [&](uint64_t pos, uint64_t count, uint64_t size)
+    {
+        return pos >= header_size && pos <= file_.size()
+               && (size == 0 || count <= (file_.size() - pos) / size);
+    };
+    if (!fits(header[LABELS_POS], 0, 1)
+        || !fits(header[BIASES_POS], num_classes, sizeof(double))
+        || !fits(header[WEIGHTS_POS], num_rows,
+                 num_classes * bytes_per_weight(encoding_))
+        || !fits(header[SCALES_POS], num_rows, sizeof(float))
+        || !fits(header[ROWS_POS], num_features_, sizeof(uint32_t)))
+        throw mapped_linear_model_exception{
+            "mapped linear model file is corrupt: " + path};
+
+    char_input_stream labels{file_.begin() + header[LABELS_POS],
+                             file_.begin() + file_.size()};
+    classes_.resize(num_classes);
+    for (auto& lbl : classes_)
+        io::packed::read(labels, lbl);
+
+    biases_ = reinterpret_cast<const double*>(file_.begin()
+                                              + header[BIASES_POS]);
+    weights_ = file_.begin() + header[WEIGHTS_POS];
+    scales_ = reinterpret_cast<const float*>(file_.begin()
+                                             + header[SCALES_POS]);
+    rows_ = reinterpret_cast<const uint32_t*>(file_.begin()
+                                              + header[ROWS_POS]);
+
+    // score() trusts the row table, so check it once here
+    for (uint64_t f = 0; f < num_features_; ++f)
+    {
+        if (rows_[f] != no_row && rows_[f] >= num_rows)
+            throw mapped_linear_model_exception{
+                "mapped linear model file is corrupt: " + path};
+    }
+}
+
+void mapped_linear_model::score(const learn::feature_vector& doc,
+                                std::vector<double>& scores) const
+{
+    auto num_classes = classes_.size();
+    scores.assign(biases_, biases_ + num_classes);
+
+    for (const auto& feat : doc)
+    {
+        if (feat.first >= num_features_)
+            continue;
+
+        auto row = rows_[feat.first];
+        if (row == no_row)
+            continue;
+
+        auto val = feat.second * scales_[row];
+        auto offset = row * num_classes;
+        switch (encoding_)
+        {
+            case weight_encoding::float32:
+                add_row(reinterpret_cast<const float*>(weights_) + offset,
+                        val, scores.data(), num_classes);
+                break;
+            case weight_encoding::float16:
+                add_row(reinterpret_cast<const uint16_t*>(weights_) + offset,
+                        val, scores.data(), num_classes);
+                break;
+            case weight_encoding::int8:
+                add_row(reinterpret_cast<const int8_t*>(weights_) + offset,
+                        val, scores.data(), num_classes);
+                break;
+        }
+    }
+}
+
+class_label mapped_linear_model::best_class(
+    const learn::feature_vector& doc) const
+{
+    std::vector<double> scores;
+    score(doc, scores);
+
+    class_label best_label;
+    double best_score = std::numeric_limits<double>::lowest();
+    for (std::size_t i = 0; i < scores.size(); ++i)
+    {
+        if (scores[i] > best_score)
+        {
+            best_score = scores[i];
+            best_label = classes_[i];
+        }
+    }
+    return best_label;
+}
+
+const std::vector<class_label>& mapped_linear_model::classes() const
+{
+    return classes_;
+}
+
+uint64_t mapped_linear_model::num_features() const
+{
+    return num_features_;
+}
+
+weight_encoding mapped_linear_model::encoding() const
+{
+    return encoding_;
+}
+
+std::string mapped_linear_model::path() const
+{
+    return file_.path();
+}
+
+mapped_linear_model_writer::mapped_linear_model_writer(
+    const std::string& path, const std::vector<class_label>& classes,
+    const std::vector<double>& biases, weight_encoding encoding)
+    : path_{path},
+      file_{path, std::ios::binary | std::ios::trunc},
+      finished_{false},
+      file_write_pos_{0},
+      num_classes_{classes.size()},
+      encoding_{encoding}
+{
+    if (!file_)
+        throw mapped_linear_model_exception{
+            "failed to open mapped linear model file: " + path};
+
+    if (biases.size() != classes.size())
+        throw mapped_linear_model_exception{
+            "mapped linear model needs one bias per class"};
+
+    buffer_.resize(num_classes_ * bytes_per_weight(encoding_));
+
+    // reserve space for the header, which is written last
+    write(std::string(header_size, '\0').data(), header_size);
+
+    labels_pos_ = file_write_pos_;
+    for (const auto& lbl : classes)
+        file_write_pos_ += io::packed::write(file_, lbl);
+
+    pad_to(sizeof(double));
+    biases_pos_ = file_write_pos_;
+    write(biases.data(), biases.size() * sizeof(double));
+
+    pad_to(alignment);
+    weights_pos_ = file_write_pos_;
+}
+
+void mapped_linear_model_writer::insert(const std::vector<double>& weights)
+{
+    if (finished_)
+        throw mapped_linear_model_exception{
+            "mapped linear model has already been finished"};
+
+    if (weights.size() != num_classes_)
+        throw mapped_linear_model_exception{
+            "mapped linear model needs a weight for every class"};
+
+    double max_weight = 0;
+    for (const auto& weight : weights)
+        max_weight = std::max(max_weight, std::abs(weight));
+
+    if (max_weight == 0)
+    {
+        rows_.push_back(no_row);
+        return;
+    }
+
+    if (scales_.size() == no_row)
+        throw mapped_linear_model_exception{
+            "too many features to write a mapped linear model"};
+
+    float scale = 1;
+    switch (encoding_)
+    {
+        case weight_encoding::float32:
+        {
+            auto out = reinterpret_cast<float*>(buffer_.data());
+            for (uint64_t i = 0; i < num_classes_; ++i)
+                out[i] = static_cast<float>(weights[i]);
+            break;
+        }
+        case weight_encoding::float16:
+        {
+            auto out = reinterpret_cast<uint16_t*>(buffer_.data());
+            for (uint64_t i = 0; i < num_classes_; ++i)
+                out[i] = float_to_half(static_cast<float>(weights[i]));
+            break;
+        }
+        case weight_encoding::int8:
+        {
+            // map the largest weight in the row to +/-127; a scale that
+            // underflows to zero would divide by zero below
+            scale = std::max(static_cast<float>(max_weight / 127),
+                             std::numeric_limits<float>::min());
+            auto out = reinterpret_cast<int8_t*>(buffer_.data());
+            for (uint64_t i = 0; i < num_classes_; ++i)
+            {
+                auto quantized = std::round(weights[i] / scale);
+                out[i] = static_cast<int8_t>(
+                    std::max(-127.0, std::min(127.0, quantized)));
+            }
+            break;
+        }
+    }
+
+    rows_.push_back(static_cast<uint32_t>(scales_.size()));
+    scales_.push_back(scale);
+    write(buffer_.data(), buffer_.size());
+}
+
+void mapped_linear_model_writer::pad_to(uint64_t align)
+{
+    while (file_write_pos_ % align != 0)
+    {
+        file_.put('\0');
+        ++file_write_pos_;
+    }
+}
+
+void mapped_linear_model_writer::write(const void* data, uint64_t size)
+{
+    file_.write(static_cast<const char*>(data),
+                static_cast<std::streamsize>(size));
+    file_write_pos_ += size;
+}
+
+void mapped_linear_model_writer::finish()
+{
+    if (finished_)
+        return;
+
+    pad_to(sizeof(float));
+    auto scales_pos = file_write_pos_;
+    write(scales_.data(), scales_.size() * sizeof(float));
+
+    pad_to(sizeof(uint32_t));
+    auto rows_pos = file_write_pos_;
+    write(rows_.data(), rows_.size() * sizeof(uint32_t));
+
+    uint64_t header[NUM_FIELDS];
+    header[MAGIC] = magic;
+    header[VERSION] = version;
+    header[ENCODING] = static_cast<uint64_t>(encoding_);
+    header[NUM_CLASSES] = num_classes_;
+    header[NUM_FEATURES] = rows_.size();
+    header[NUM_ROWS] = scales_.size();
+    header[LABELS_POS] = labels_pos_;
+    header[BIASES_POS] = biases_pos_;
+    header[WEIGHTS_POS] = weights_pos_;
+    header[SCALES_POS] = scales_pos;
+    header[ROWS_POS] = rows_pos;
+
+    file_.seekp(0);
+    for (const auto& field : header)
+        io::write_binary(file_, field);
+
+    file_.close();
+    if (!file_)
+        throw mapped_linear_model_exception{
+            "failed to write mapped linear model file: " + path_};
+    finished_ = true;
+}
+
+mapped_linear_model_writer::~mapped_linear_model_writer()
+{
+    if (finished_)
+        return;
+
+    // without a header, the file would only be rejected when loaded
+    file_.close();
+    filesystem::delete_file(path_);
+}
+}
+}
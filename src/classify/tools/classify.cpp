@@ -24,12 +24,13 @@ using namespace meta;
 
 template <class Creator>
 classify::confusion_matrix cv(Creator&& creator,
-                              classify::multiclass_dataset_view docs, bool even)
+                              classify::multiclass_dataset_view docs, bool even,
+                              std::size_t concurrent_folds = 1)
 {
     classify::confusion_matrix matrix;
     auto msec = common::time([&]() {
         matrix = classify::cross_validate(std::forward<Creator>(creator), docs,
-                                          5, even);
+                                          5, even, concurrent_folds);
     });
     std::cerr << "time elapsed: " << msec.count() / 1000.0 << "s" << std::endl;
     matrix.print();
@@ -94,6 +95,14 @@ int main(int argc, char* argv[])
         creator;
     auto classifier_method = *class_config->get_as<std::string>("method");
     auto even = class_config->get_as<bool>("even-split").value_or(false);
+    // each concurrent fold holds its own model in memory
+    auto concurrent_folds
+        = class_config->get_as<int64_t>("concurrent-folds").value_or(1);
+    if (concurrent_folds < 1)
+    {
+        std::cerr << "concurrent-folds must be at least 1" << std::endl;
+        return 1;
+    }
     if (classifier_method == "knn" || classifier_method == "nearest-centroid")
     {
         auto i_idx = index::make_index<index::inverted_index>(*config);
@@ -109,7 +118,7 @@ int main(int argc, char* argv[])
         };
     }
 
-    cv(creator, dataset, even);
+    cv(creator, dataset, even, static_cast<std::size_t>(concurrent_folds));
 
     return 0;
 }
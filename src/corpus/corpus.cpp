@@ -35,6 +35,16 @@ metadata::schema_type corpus::schema() const
     return schema;
 }
 
+std::vector<std::unique_ptr<corpus>> corpus::split(std::size_t)
+{
+    return {};
+}
+
+bool corpus::has_metadata() const
+{
+    return mdata_parser_ && !mdata_parser_->schema().empty();
+}
+
 const std::string& corpus::encoding() const
 {
     return encoding_;
@@ -22,6 +22,7 @@ corpus_factory::corpus_factory()
     // built-in corpora
     reg<file_corpus>();
     reg<line_corpus>();
+    reg<mmap_line_corpus>();
     reg<gz_corpus>();
     reg<libsvm_corpus>();
 }
@@ -15,11 +15,11 @@ namespace corpus
 const util::string_view gz_corpus::id = "gz-corpus";
 
 gz_corpus::gz_corpus(const std::string& file, std::string encoding,
-                     uint64_t num_docs)
+                     uint64_t num_docs, std::size_t num_threads)
     : corpus{std::move(encoding)},
       cur_id_{0},
       num_lines_{num_docs},
-      corpus_stream_{file + ".gz"},
+      corpus_stream_{file + ".gz", num_threads},
       class_stream_{file + ".labels.gz"}
 {
     // nothing
@@ -67,6 +67,9 @@ std::unique_ptr<corpus> make_corpus<gz_corpus>(util::string_view prefix,
     if (!num_docs)
         throw corpus_exception{"num-docs config param required for gz_corpus"};
 
+    auto num_threads
+        = config.get_as<uint64_t>("decompression-threads").value_or(1);
+
     // string_view doesn't have operator+ overloads...
     auto filename = prefix.to_string();
     filename += "/";
@@ -75,7 +78,7 @@ std::unique_ptr<corpus> make_corpus<gz_corpus>(util::string_view prefix,
     filename.append(dataset.data(), dataset.size());
     filename += ".dat";
 
-    return make_unique<gz_corpus>(filename, encoding, *num_docs);
+    return make_unique<gz_corpus>(filename, encoding, *num_docs, num_threads);
 }
 }
 }
@@ -0,0 +1,247 @@
+/**
+ * @file mmap_line_corpus.cpp
+ * @author Chase Geigle
+ */
+
+#include <algorithm>
+#include <fstream>
+
+#include "meta/corpus/mmap_line_corpus.h"
+#include "meta/io/filesystem.h"
+#include "meta/io/packed.h"
+#include "meta/logging/logger.h"
+#include "meta/util/shim.h"
+
+namespace meta
+{
+namespace corpus
+{
+
+const util::string_view mmap_line_corpus::id = "mmap-line-corpus";
+
+namespace
+{
+/**
+ * Attempts to load cached line offsets for a corpus file. The cache is
+ * only used if it was computed for a file of the same size and
+ * modification time.
+ */
+bool load_offsets(const std::string& filename, uint64_t file_size,
+                  int64_t modified, std::vector<uint64_t>& offsets)
+{
+    std::ifstream in{filename, std::ios::binary};
+    if (!in)
+        return false;
+
+    uint64_t cached_size;
+    int64_t cached_modified;
+    io::packed::read(in, cached_size);
+    io::packed::read(in, cached_modified);
+    if (!in || cached_size != file_size || cached_modified != modified)
+        return false;
+
+    io::packed::read(in, offsets);
+    return in && !offsets.empty() && offsets.back() == file_size;
+}
+
+/**
+ * Computes the starting offset of each line in the file, followed by the
+ * size of the file.
+ */
+std::vector<uint64_t> compute_offsets(const io::mmap_file& file)
+{
+    std::vector<uint64_t> offsets;
+    offsets.push_back(0);
+
+    printing::progress progress{" > Computing line offsets: ", file.size()};
+    auto begin = file.begin();
+    auto end = begin + file.size();
+    for (auto it = begin; it != end;)
+    {
+        progress(static_cast<uint64_t>(it - begin));
+        it = std::find(it, end, '\n');
+        if (it == end)
+            break;
+        ++it;
+        offsets.push_back(static_cast<uint64_t>(it - begin));
+    }
+
+    // if the last line doesn't end with a newline, it is still a line
+    if (offsets.back() != file.size())
+        offsets.push_back(file.size());
+    return offsets;
+}
+}
+
+mmap_line_corpus::mmap_line_corpus(const std::string& file,
+                                   std::string encoding)
+    : corpus{std::move(encoding)}, cur_id_{0}, is_range_{false}
+{
+    auto state = std::make_shared<shared_state>();
+
+    if (!filesystem::file_exists(file))
+        throw corpus_exception{"corpus file " + file + " does not exist"};
+
+    auto file_size = filesystem::file_size(file);
+    auto modified = filesystem::last_modified(file);
+    if (file_size > 0)
+        state->file = io::mmap_file{file};
+
+    auto offsets_file = file + ".offsets";
+    if (!state->file)
+    {
+        state->offsets.push_back(0);
+    }
+    else if (!load_offsets(offsets_file, file_size, modified,
+                           state->offsets))
+    {
+        state->offsets = compute_offsets(*state->file);
+
+        // caching the offsets is best-effort: the corpus may live on a
+        // read-only filesystem
+        std::ofstream out{offsets_file, std::ios::binary};
+        if (out)
+        {
+            io::packed::write(out, file_size);
+            io::packed::write(out, modified);
+            io::packed::write(out, state->offsets);
+        }
+        else
+        {
+            LOG(warning) << "Unable to cache line offsets in " << offsets_file
+                         << ENDLG;
+        }
+    }
+
+    if (filesystem::file_exists(file + ".labels"))
+    {
+        std::ifstream labels{file + ".labels"};
+        std::string label;
+        while (std::getline(labels, label))
+            state->labels.emplace_back(label);
+    }
+
+    end_id_ = doc_id{state->offsets.size() - 1};
+    state_ = std::move(state);
+}
+
+mmap_line_corpus::mmap_line_corpus(std::shared_ptr<const shared_state> state,
+                                   std::string encoding, doc_id begin,
+                                   doc_id end)
+    : corpus{std::move(encoding)},
+      state_{std::move(state)},
+      cur_id_{begin},
+      end_id_{end},
+      is_range_{true}
+{
+    // nothing
+}
+
+bool mmap_line_corpus::has_next() const
+{
+    return cur_id_ < end_id_;
+}
+
+util::string_view mmap_line_corpus::content(doc_id d_id) const
+{
+    const auto& offsets = state_->offsets;
+    if (d_id + 1 >= offsets.size())
+        throw corpus_exception{"document id " + std::to_string(d_id)
+                               + " out of range"};
+
+    auto begin = offsets[d_id];
+    auto end = offsets[d_id + 1];
+
+    // strip the trailing newline, if present
+    if (end > begin && state_->file->begin()[end - 1] == '\n')
+        --end;
+    return {state_->file->begin() + begin, end - begin};
+}
+
+document mmap_line_corpus::next()
+{
+    class_label label{"[none]"};
+    if (cur_id_ < state_->labels.size())
+        label = state_->labels[cur_id_];
+
+    document doc{cur_id_, label};
+    doc.content(content(cur_id_).to_string(), encoding());
+    ++cur_id_;
+
+    // ranges can't share the (sequential) metadata parser; they are only
+    // created when there is no metadata schema
+    std::vector<metadata::field> mdata;
+    if (!is_range_)
+        mdata = next_metadata();
+    if (store_full_text())
+        mdata.insert(mdata.begin(), metadata::field{doc.content()});
+    doc.mdata(std::move(mdata));
+
+    return doc;
+}
+
+uint64_t mmap_line_corpus::size() const
+{
+    return state_->offsets.size() - 1;
+}
+
+std::vector<std::unique_ptr<corpus>> mmap_line_corpus::split(std::size_t n)
+{
+    std::vector<std::unique_ptr<corpus>> ranges;
+    if (n == 0 || has_metadata() || !has_next())
+        return ranges;
+
+    // choose range boundaries so each range has about the same number of
+    // bytes, rather than the same number of documents
+    const auto& offsets = state_->offsets;
+    auto first_byte = offsets[cur_id_];
+    auto total_bytes = offsets[end_id_] - first_byte;
+
+    auto begin = cur_id_;
+    for (std::size_t i = 1; i <= n && begin < end_id_; ++i)
+    {
+        auto end = end_id_;
+        if (i < n)
+        {
+            auto target = first_byte + total_bytes / n * i;
+            auto it = std::lower_bound(offsets.begin() + begin,
+                                       offsets.begin() + end_id_, target);
+            end = doc_id{static_cast<uint64_t>(it - offsets.begin())};
+        }
+
+        if (end > begin)
+        {
+            // private constructor, so make_unique can't be used
+            std::unique_ptr<mmap_line_corpus> range{
+                new mmap_line_corpus{state_, encoding(), begin, end}};
+            range->set_store_full_text(store_full_text());
+            ranges.emplace_back(std::move(range));
+            begin = end;
+        }
+    }
+
+    // the documents now belong to the ranges
+    cur_id_ = end_id_;
+    return ranges;
+}
+
+template <>
+std::unique_ptr<corpus>
+make_corpus<mmap_line_corpus>(util::string_view prefix,
+                              util::string_view dataset,
+                              const cpptoml::table& config)
+{
+    auto encoding = config.get_as<std::string>("encoding").value_or("utf-8");
+
+    // string_view doesn't have operator+ overloads...
+    auto filename = prefix.to_string();
+    filename += "/";
+    filename.append(dataset.data(), dataset.size());
+    filename += "/";
+    filename.append(dataset.data(), dataset.size());
+    filename += ".dat";
+
+    return make_unique<mmap_line_corpus>(filename, encoding);
+}
+}
+}
@@ -114,10 +114,9 @@ class cooccurrence_buffer
 
 namespace
 {
-hashing::probe_map<std::string, uint64_t>
-load_vocab(const std::string& filename)
+hashing::string_arena_map<uint64_t> load_vocab(const std::string& filename)
 {
-    using map_type = hashing::probe_map<std::string, uint64_t>;
+    using map_type = hashing::string_arena_map<uint64_t>;
 
     std::ifstream input{filename, std::ios::binary};
     auto size = io::packed::read<uint64_t>(input);
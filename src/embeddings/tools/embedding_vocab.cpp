@@ -39,7 +39,7 @@ int main(int argc, char** argv)
                         .value_or(std::numeric_limits<int64_t>::max());
 
     auto stream = analyzers::load_filters(*config, *embed_cfg);
-    hashing::probe_map<std::string, uint64_t> vocab;
+    hashing::string_arena_map<uint64_t> vocab;
 
     {
         auto docs = corpus::make_corpus(*config);
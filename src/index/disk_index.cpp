@@ -3,28 +3,126 @@
  * @author Sean Massung
  */
 
+#include <fstream>
 #include <numeric>
 #include <stdexcept>
 
+#include "cpptoml.h"
 #include "meta/analyzers/analyzer.h"
 #include "meta/index/disk_index.h"
 #include "meta/index/disk_index_impl.h"
+#include "meta/index/front_coded_vocabulary_writer.h"
 #include "meta/index/string_list.h"
 #include "meta/index/string_list_writer.h"
 #include "meta/index/vocabulary_map.h"
+#include "meta/index/vocabulary_map_writer.h"
+#include "meta/io/filesystem.h"
+#include "meta/io/packed.h"
+#include "meta/logging/logger.h"
 #include "meta/util/disk_vector.h"
 #include "meta/util/mapping.h"
 #include "meta/util/optional.h"
 #include "meta/util/pimpl.tcc"
+#include "meta/util/printing.h"
 
 namespace meta
 {
 namespace index
 {
 
-disk_index::disk_index(const cpptoml::table&, const std::string& name)
+namespace
+{
+io::mmap_options load_mmap_options(const cpptoml::table& config,
+                                   const std::string& file_type)
+{
+    io::mmap_options options;
+    auto group = config.get_table("mmap");
+    if (!group)
+        return options;
+
+    auto table = group->get_table(file_type);
+    if (!table)
+        return options;
+
+    auto access = table->get_as<std::string>("access").value_or("normal");
+    if (access == "sequential")
+        options.access = io::access_pattern::sequential;
+    else if (access == "random")
+        options.access = io::access_pattern::random;
+    else if (access != "normal")
+        throw io::mmap_file_exception{"unknown mmap access pattern for "
+                                      + file_type + ": " + access};
+
+    options.populate = table->get_as<bool>("populate").value_or(false);
+    options.huge_pages = table->get_as<bool>("huge-pages").value_or(false);
+    options.lock = table->get_as<bool>("lock").value_or(false);
+    return options;
+}
+
+/**
+ * Identifies the vocabulary that the term filter and term id hash were
+ * built from. It is stored at the front of the filter and next to the
+ * hash, and they are rebuilt when it doesn't match the vocabulary on
+ * disk; unlike a modification time, it doesn't depend on the resolution
+ * of the file system's timestamps.
+ */
+struct vocabulary_stamp
+{
+    /// The number of terms in the vocabulary
+    uint64_t num_terms;
+    /// The size of the vocabulary_map's file, in bytes
+    uint64_t num_bytes;
+};
+
+vocabulary_stamp make_stamp(const vocabulary_map& vocab,
+                            const std::string& mapping)
+{
+    return {vocab.size(), filesystem::file_size(mapping)};
+}
+
+void write_stamp(std::ostream& out, const vocabulary_stamp& stamp)
+{
+    io::packed::write(out, stamp.num_terms);
+    io::packed::write(out, stamp.num_bytes);
+}
+
+/**
+ * Reads a stamp from the front of a stream.
+ *
+ * @return whether it was the given stamp
+ */
+bool read_stamp(std::istream& in, const vocabulary_stamp& stamp)
+{
+    uint64_t num_terms = 0;
+    uint64_t num_bytes = 0;
+    io::packed::read(in, num_terms);
+    io::packed::read(in, num_bytes);
+    return in && num_terms == stamp.num_terms
+           && num_bytes == stamp.num_bytes;
+}
+
+/**
+ * @return whether the file at path begins with the given stamp
+ */
+bool has_stamp(const std::string& path, const vocabulary_stamp& stamp)
+{
+    std::ifstream in{path, std::ios::binary};
+    return in && read_stamp(in, stamp);
+}
+}
+
+disk_index::disk_index(const cpptoml::table& config, const std::string& name)
 {
     impl_->index_name_ = name;
+    impl_->postings_mmap_ = load_mmap_options(config, "postings");
+    impl_->vocabulary_mmap_ = load_mmap_options(config, "vocabulary");
+    impl_->metadata_mmap_ = load_mmap_options(config, "metadata");
+    impl_->use_term_id_hash_
+        = config.get_as<bool>("term-id-hash").value_or(false);
+    impl_->use_term_filter_
+        = config.get_as<bool>("term-bloom-filter").value_or(false);
+    impl_->use_term_dictionary_
+        = config.get_as<bool>("term-dictionary").value_or(false);
 }
 
 std::string disk_index::index_name() const
@@ -34,6 +132,18 @@ std::string disk_index::index_name() const
 
 term_id disk_index::get_term_id(const std::string& term)
 {
+    // the filter is read-only, so no lock is needed
+    if (impl_->term_filter_ && !impl_->term_filter_->contains(term))
+        return term_id{impl_->term_id_mapping_->size()};
+
+    if (impl_->term_id_hash_)
+    {
+        // the hash and vocabulary are read-only, so no lock is needed
+        if (auto t_id = impl_->find_term_id(term))
+            return *t_id;
+        return term_id{impl_->term_id_mapping_->size()};
+    }
+
     std::lock_guard<std::mutex> lock{impl_->mutex_};
 
     auto termID = impl_->term_id_mapping_->find(term);
@@ -128,7 +238,7 @@ std::vector<doc_id> disk_index::docs() const
 const std::vector<const char*> disk_index::disk_index_impl::files
     = {"/docs.labels",          "/labelids.mapping", "/postings.index",
        "/postings.index_index", "/termids.mapping",  "/termids.mapping.inverse",
-       "/metadata.db",          "/metadata.index"};
+       "/metadata.db",          "/metadata.index",   "/termids.mapping.fc"};
 
 label_id disk_index::disk_index_impl::get_label_id(const class_label& lbl)
 {
@@ -146,7 +256,7 @@ label_id disk_index::disk_index_impl::get_label_id(const class_label& lbl)
 
 void disk_index::disk_index_impl::initialize_metadata()
 {
-    metadata_ = {index_name_};
+    metadata_ = metadata_file{index_name_, metadata_mmap_};
 }
 
 void disk_index::disk_index_impl::load_labels()
@@ -157,7 +267,118 @@ void disk_index::disk_index_impl::load_labels()
 
 void disk_index::disk_index_impl::load_term_id_mapping()
 {
-    term_id_mapping_ = vocabulary_map{index_name_ + files[TERM_IDS_MAPPING]};
+    auto mapping = index_name_ + files[TERM_IDS_MAPPING];
+    term_id_mapping_ = vocabulary_map{mapping, 4096, vocabulary_mmap_};
+
+    // the dictionary is only written if it is asked for, the first time
+    // the index is loaded with it enabled
+    auto rebuilt = false;
+    if (use_term_dictionary_)
+    {
+        auto dictionary = index_name_ + files[TERM_IDS_DICTIONARY];
+        if (!filesystem::file_exists(dictionary))
+            rebuilt = build_term_dictionary();
+        if (filesystem::file_exists(dictionary))
+            term_dictionary_
+                = front_coded_vocabulary{dictionary, vocabulary_mmap_};
+    }
+
+    // the filter and hash are derived from the vocabulary, so they are
+    // rebuilt along with the dictionary, or if they were built from a
+    // different vocabulary than the one on disk
+    auto stamp = make_stamp(*term_id_mapping_, mapping);
+    if (use_term_filter_ && term_id_mapping_->size() > 0)
+    {
+        auto path = index_name_ + "/termids.bloom";
+        if (rebuilt || !has_stamp(path, stamp))
+            build_term_filter();
+
+        std::ifstream in{path, std::ios::binary};
+        read_stamp(in, stamp);
+        term_filter_ = hashing::blocked_bloom_filter{in};
+    }
+
+    if (!use_term_id_hash_ || term_id_mapping_->size() == 0)
+        return;
+
+    auto prefix = index_name_ + "/termids.mph";
+    if (rebuilt || !has_stamp(prefix + "/vocabulary.stamp", stamp))
+        build_term_id_hash();
+    term_id_hash_ = make_unique<term_id_hash_type>(prefix);
+}
+
+void disk_index::disk_index_impl::build_term_id_hash()
+{
+    using builder_type
+        = hashing::perfect_hash_map_builder<std::string, uint64_t>;
+
+    builder_type::options_type options;
+    options.prefix = index_name_ + "/termids.mph";
+    options.num_keys = term_id_mapping_->size();
+    filesystem::remove_all(options.prefix);
+    filesystem::make_directory(options.prefix);
+
+    builder_type builder{options};
+    for (uint64_t t_id = 0; t_id < options.num_keys; ++t_id)
+        builder(term_id_mapping_->find_term(term_id{t_id}), t_id);
+    builder.write();
+
+    // written last, so a hash that was only partly built is rebuilt
+    std::ofstream stamp{options.prefix + "/vocabulary.stamp",
+                        std::ios::binary};
+    write_stamp(stamp, make_stamp(*term_id_mapping_,
+                                  index_name_ + files[TERM_IDS_MAPPING]));
+}
+
+void disk_index::disk_index_impl::build_term_filter()
+{
+    hashing::blocked_bloom_filter filter{term_id_mapping_->size()};
+    for (uint64_t t_id = 0; t_id < term_id_mapping_->size(); ++t_id)
+        filter.insert(term_id_mapping_->find_term(term_id{t_id}));
+
+    std::ofstream out{index_name_ + "/termids.bloom", std::ios::binary};
+    write_stamp(out, make_stamp(*term_id_mapping_,
+                                index_name_ + files[TERM_IDS_MAPPING]));
+    filter.save(out);
+
+    LOG(info) << "Built term bloom filter: "
+              << printing::bytes_to_units(filter.bytes_used())
+              << ", estimated false positive rate "
+              << filter.false_positive_rate() << ENDLG;
+}
+
+bool disk_index::disk_index_impl::build_term_dictionary()
+{
+    auto dictionary = index_name_ + files[TERM_IDS_DICTIONARY];
+    try
+    {
+        front_coded_vocabulary_writer writer{dictionary};
+        // term ids are assigned in sorted order, as the writer requires
+        for (uint64_t t_id = 0; t_id < term_id_mapping_->size(); ++t_id)
+            writer.insert(term_id_mapping_->find_term(term_id{t_id}));
+    }
+    catch (const vocabulary_map_writer_exception& ex)
+    {
+        LOG(warning) << "Unable to build term dictionary: " << ex.what()
+                     << ENDLG;
+        filesystem::delete_file(dictionary);
+        return false;
+    }
+
+    LOG(info) << "Built term dictionary for " << term_id_mapping_->size()
+              << " terms" << ENDLG;
+    return true;
+}
+
+util::optional<term_id>
+disk_index::disk_index_impl::find_term_id(const std::string& term) const
+{
+    auto t_id = term_id_hash_->at(term);
+    // the fingerprint makes false positives for unknown terms unlikely,
+    // but one comparison against the stored term rules them out
+    if (!t_id || term_id_mapping_->find_term(term_id{*t_id}) != term)
+        return util::nullopt;
+    return term_id{*t_id};
 }
 
 void disk_index::disk_index_impl::load_label_id_mapping()
@@ -170,6 +391,12 @@ void disk_index::disk_index_impl::save_label_id_mapping()
     map::save_mapping(label_ids_, index_name_ + files[LABEL_IDS_MAPPING]);
 }
 
+const io::mmap_options&
+disk_index::disk_index_impl::postings_mmap_options() const
+{
+    return postings_mmap_;
+}
+
 uint64_t disk_index::disk_index_impl::total_unique_terms() const
 {
     return term_id_mapping_->size();
@@ -189,6 +416,20 @@ std::vector<class_label> disk_index::disk_index_impl::class_labels() const
     return labels;
 }
 
+std::vector<term_id>
+disk_index::prefix_terms(const std::string& prefix) const
+{
+    if (!impl_->term_dictionary_)
+        throw disk_index_exception{"index " + index_name()
+                                   + " has no term dictionary to search"};
+
+    std::vector<term_id> ids;
+    auto range = impl_->term_dictionary_->prefix_range(prefix);
+    for (auto it = range.first; it != range.second; ++it)
+        ids.push_back(it.id());
+    return ids;
+}
+
 std::string disk_index::term_text(term_id t_id) const
 {
     if (t_id >= impl_->term_id_mapping_->size())
@@ -54,7 +54,7 @@ class forward_index::impl
      * re-numbering of the old ids.
      */
     void merge_chunks(size_t num_chunks, uint64_t num_docs,
-                      hashing::probe_map<std::string, term_id> vocab);
+                      hashing::string_arena_map<term_id> vocab);
 
     /**
      * @param docs The documents to index (that are in libsvm format)
@@ -139,7 +139,8 @@ bool forward_index::valid() const
     {
         // this is not required if generated directly from libsvm data
         if (f == impl_->files[TERM_IDS_MAPPING]
-            || f == impl_->files[TERM_IDS_MAPPING_INVERSE])
+            || f == impl_->files[TERM_IDS_MAPPING_INVERSE]
+            || f == impl_->files[TERM_IDS_DICTIONARY])
             continue;
 
         if (!filesystem::file_exists(index_name() + "/" + std::string{f}))
@@ -303,7 +304,7 @@ void forward_index::impl::tokenize_docs(corpus::corpus& docs,
     std::mutex vocab_mutex;
     printing::progress progress{" > Tokenizing Docs: ", docs.size()};
 
-    hashing::probe_map<std::string, term_id> vocab;
+    hashing::string_arena_map<term_id> vocab;
     bool exceeded_budget = false;
     std::atomic_size_t chunk_id{0};
 
@@ -382,12 +383,12 @@ void forward_index::impl::tokenize_docs(corpus::corpus& docs,
 
 void forward_index::impl::merge_chunks(
     size_t num_chunks, uint64_t num_docs,
-    hashing::probe_map<std::string, term_id> vocab)
+    hashing::string_arena_map<term_id> vocab)
 {
     std::vector<std::string> keys(vocab.size());
 
     for (const auto& pr : vocab)
-        keys[pr.value()] = pr.key();
+        keys[pr.value()] = pr.key().to_string();
 
     vocab.clear();
     // vocab is now empty, but has enough space for the vocabulary
@@ -504,7 +505,8 @@ void forward_index::impl::create_uninverted_metadata(const std::string& name)
 {
     auto files = {DOC_LABELS,       LABEL_IDS_MAPPING,
                   TERM_IDS_MAPPING, TERM_IDS_MAPPING_INVERSE,
-                  METADATA_DB,      METADATA_INDEX};
+                  METADATA_DB,      METADATA_INDEX,
+                  TERM_IDS_DICTIONARY};
 
     for (const auto& file : files)
         filesystem::copy_file(name + idx_->impl_->files[file],
@@ -552,12 +554,18 @@ auto forward_index::search_primary(doc_id d_id) const
     return fwd_impl_->postings_->find(d_id);
 }
 
-util::optional<postings_stream<term_id, double>>
-forward_index::stream_for(doc_id d_id) const
+auto forward_index::stream_for(doc_id d_id) const
+    -> util::optional<postings_stream_type>
 {
     return fwd_impl_->postings_->find_stream(d_id);
 }
 
+util::optional<util::string_view>
+forward_index::postings_bytes(doc_id d_id) const
+{
+    return fwd_impl_->postings_->find_bytes(d_id);
+}
+
 void forward_index::impl::uninvert(const inverted_index& inv_idx,
                                    uint64_t ram_budget)
 {
@@ -638,7 +646,8 @@ void forward_index::impl::compress(const std::string& filename,
 
 void forward_index::impl::load_postings()
 {
-    postings_ = {idx_->index_name() + idx_->impl_->files[POSTINGS]};
+    postings_ = {idx_->index_name() + idx_->impl_->files[POSTINGS],
+                 idx_->impl_->postings_mmap_options()};
 }
 }
 }
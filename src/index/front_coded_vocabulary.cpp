@@ -0,0 +1,228 @@
+/**
+ * @file front_coded_vocabulary.cpp
+ * @author Chase Geigle
+ */
+
+#include <algorithm>
+
+#include "meta/index/front_coded_vocabulary.h"
+#include "meta/io/packed.h"
+
+namespace meta
+{
+namespace index
+{
+
+namespace
+{
+/**
+ * Reads packed integers directly out of a memory mapped file.
+ */
+struct char_input_stream
+{
+    char_input_stream(const char* input) : input_{input}
+    {
+        // nothing
+    }
+
+    char get()
+    {
+        return *input_++;
+    }
+
+    const char* input_;
+};
+
+uint64_t read_length(const char*& pos)
+{
+    char_input_stream stream{pos};
+    uint64_t len;
+    io::packed::read(stream, len);
+    pos = stream.input_;
+    return len;
+}
+}
+
+front_coded_vocabulary::front_coded_vocabulary(const std::string& path,
+                                               const io::mmap_options& options)
+    : file_{path, options}
+{
+    if (file_.size() < 4 * sizeof(uint64_t))
+        throw front_coded_vocabulary_exception{
+            "front-coded vocabulary file is truncated: " + path};
+
+    auto header = reinterpret_cast<const uint64_t*>(file_.begin());
+    size_ = header[0];
+    bucket_size_ = header[1];
+    num_buckets_ = header[2];
+    auto index_pos = header[3];
+
+    if (bucket_size_ == 0 || index_pos < 4 * sizeof(uint64_t)
+        || index_pos + num_buckets_ * sizeof(uint64_t) > file_.size())
+        throw front_coded_vocabulary_exception{
+            "front-coded vocabulary file is corrupt: " + path};
+
+    buckets_ = reinterpret_cast<const uint64_t*>(file_.begin() + index_pos);
+}
+
+util::string_view front_coded_vocabulary::bucket_head(uint64_t bucket) const
+{
+    const char* pos = file_.begin() + buckets_[bucket];
+    auto len = read_length(pos);
+    return {pos, len};
+}
+
+util::optional<term_id>
+front_coded_vocabulary::find(util::string_view term) const
+{
+    auto it = lower_bound(term);
+    if (it == end() || util::string_view{*it} != term)
+        return util::nullopt;
+    return it.id();
+}
+
+std::string front_coded_vocabulary::find_term(term_id t_id) const
+{
+    const_iterator it{this, term_id{t_id / bucket_size_ * bucket_size_}};
+    while (it.id() < t_id)
+        ++it;
+    return *it;
+}
+
+auto front_coded_vocabulary::lower_bound(util::string_view term) const
+    -> const_iterator
+{
+    // find the last bucket whose head is <= term
+    uint64_t lo = 0;
+    uint64_t hi = num_buckets_;
+    while (lo < hi)
+    {
+        auto mid = lo + (hi - lo) / 2;
+        if (bucket_head(mid) <= term)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    // every head is larger than term, so the first term is the answer
+    if (lo == 0)
+        return begin();
+
+    // otherwise the answer is in bucket lo - 1, or is the head of bucket lo
+    const_iterator it{this, term_id{(lo - 1) * bucket_size_}};
+    auto last = std::min(lo * bucket_size_, size_);
+    while (it.id() < last && util::string_view{*it} < term)
+        ++it;
+    return it;
+}
+
+auto front_coded_vocabulary::prefix_range(util::string_view prefix) const
+    -> std::pair<const_iterator, const_iterator>
+{
+    auto first = lower_bound(prefix);
+
+    // the range ends at the first term that is not less than the smallest
+    // string larger than every string with the prefix
+    std::string upper = prefix.to_string();
+    while (!upper.empty() && static_cast<unsigned char>(upper.back()) == 0xff)
+        upper.pop_back();
+    if (upper.empty())
+        return {first, end()};
+    upper.back() = static_cast<char>(upper.back() + 1);
+
+    return {first, lower_bound(upper)};
+}
+
+auto front_coded_vocabulary::begin() const -> const_iterator
+{
+    return {this, term_id{0}};
+}
+
+auto front_coded_vocabulary::end() const -> const_iterator
+{
+    return {this, term_id{size_}};
+}
+
+uint64_t front_coded_vocabulary::size() const
+{
+    return size_;
+}
+
+front_coded_vocabulary::const_iterator::const_iterator()
+    : vocab_{nullptr}, id_{0}, pos_{nullptr}
+{
+    // nothing
+}
+
+front_coded_vocabulary::const_iterator::const_iterator(
+    const front_coded_vocabulary* vocab, term_id id)
+    : vocab_{vocab}, id_{id}, pos_{nullptr}
+{
+    if (id_ < vocab_->size_)
+    {
+        auto head = vocab_->bucket_head(id_ / vocab_->bucket_size_);
+        term_.assign(head.data(), head.size());
+        pos_ = head.data() + head.size();
+    }
+}
+
+auto front_coded_vocabulary::const_iterator::operator++() -> const_iterator&
+{
+    ++id_;
+    if (id_ >= vocab_->size_)
+    {
+        term_.clear();
+        pos_ = nullptr;
+    }
+    else if (id_ % vocab_->bucket_size_ == 0)
+    {
+        auto head = vocab_->bucket_head(id_ / vocab_->bucket_size_);
+        term_.assign(head.data(), head.size());
+        pos_ = head.data() + head.size();
+    }
+    else
+    {
+        auto lcp = read_length(pos_);
+        auto suffix_len = read_length(pos_);
+        term_.resize(lcp);
+        term_.append(pos_, suffix_len);
+        pos_ += suffix_len;
+    }
+    return *this;
+}
+
+auto front_coded_vocabulary::const_iterator::operator++(int) -> const_iterator
+{
+    auto tmp = *this;
+    ++(*this);
+    return tmp;
+}
+
+auto front_coded_vocabulary::const_iterator::operator*() const -> reference
+{
+    return term_;
+}
+
+auto front_coded_vocabulary::const_iterator::operator->() const -> pointer
+{
+    return &term_;
+}
+
+term_id front_coded_vocabulary::const_iterator::id() const
+{
+    return id_;
+}
+
+bool front_coded_vocabulary::const_iterator::
+operator==(const const_iterator& other) const
+{
+    return vocab_ == other.vocab_ && id_ == other.id_;
+}
+
+bool front_coded_vocabulary::const_iterator::
+operator!=(const const_iterator& other) const
+{
+    return !(*this == other);
+}
+}
+}
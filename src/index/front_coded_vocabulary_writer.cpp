@@ -0,0 +1,93 @@
+/**
+ * @file front_coded_vocabulary_writer.cpp
+ * @author Chase Geigle
+ */
+
+#include <algorithm>
+
+#include "meta/index/front_coded_vocabulary_writer.h"
+#include "meta/index/vocabulary_map_writer.h"
+#include "meta/io/binary.h"
+#include "meta/io/packed.h"
+
+namespace meta
+{
+namespace index
+{
+
+const constexpr uint64_t front_coded_vocabulary_writer::alignment;
+
+front_coded_vocabulary_writer::front_coded_vocabulary_writer(
+    const std::string& path, uint64_t bucket_size)
+    : file_{path, std::ios::binary | std::ios::trunc},
+      file_write_pos_{0},
+      bucket_size_{bucket_size == 0 ? 1 : bucket_size},
+      num_terms_{0}
+{
+    if (!file_)
+        throw vocabulary_map_writer_exception{
+            "failed to open front-coded vocabulary file"};
+
+    // reserve space for the header, which is written last
+    file_.write(std::string(alignment, '\0').data(), alignment);
+    file_write_pos_ = alignment;
+}
+
+void front_coded_vocabulary_writer::insert(const std::string& term)
+{
+    // lookups binary search on the bucket heads, so they would silently
+    // miss terms if the order were wrong
+    if (num_terms_ > 0 && term <= prev_)
+        throw vocabulary_map_writer_exception{
+            "terms must be inserted into the front-coded vocabulary in "
+            "sorted order: \"" + term + "\" after \"" + prev_ + "\""};
+
+    if (num_terms_ % bucket_size_ == 0)
+    {
+        pad_to(alignment);
+        buckets_.push_back(file_write_pos_);
+        file_write_pos_ += io::packed::write(file_, term.size());
+        file_.write(term.data(), static_cast<std::streamsize>(term.size()));
+        file_write_pos_ += term.size();
+    }
+    else
+    {
+        auto mismatch
+            = std::mismatch(prev_.begin(),
+                            prev_.begin() + std::min(prev_.size(), term.size()),
+                            term.begin());
+        auto lcp = static_cast<uint64_t>(mismatch.first - prev_.begin());
+        auto suffix_len = term.size() - lcp;
+        file_write_pos_ += io::packed::write(file_, lcp);
+        file_write_pos_ += io::packed::write(file_, suffix_len);
+        file_.write(term.data() + lcp, static_cast<std::streamsize>(suffix_len));
+        file_write_pos_ += suffix_len;
+    }
+    prev_ = term;
+    ++num_terms_;
+}
+
+void front_coded_vocabulary_writer::pad_to(uint64_t align)
+{
+    while (file_write_pos_ % align != 0)
+    {
+        file_.put('\0');
+        ++file_write_pos_;
+    }
+}
+
+front_coded_vocabulary_writer::~front_coded_vocabulary_writer()
+{
+    pad_to(sizeof(uint64_t));
+    auto index_pos = file_write_pos_;
+    for (const auto& pos : buckets_)
+        io::write_binary(file_, pos);
+
+    file_.seekp(0);
+    io::write_binary(file_, num_terms_);
+    io::write_binary(file_, bucket_size_);
+    io::write_binary(file_, static_cast<uint64_t>(buckets_.size()));
+    io::write_binary(file_, index_pos);
+}
+}
+}
@@ -93,6 +93,9 @@ bool inverted_index::valid() const
 {
     for (auto& f : impl_->files)
     {
+        // the term dictionary is built on load if it is missing
+        if (f == impl_->files[TERM_IDS_DICTIONARY])
+            continue;
         if (!filesystem::file_exists(index_name() + "/" + std::string{f}))
         {
             LOG(info)
@@ -285,7 +288,8 @@ void inverted_index::impl::compress(const std::string& filename,
 
 void inverted_index::impl::load_postings()
 {
-    postings_ = {idx_->index_name() + idx_->impl_->files[POSTINGS]};
+    postings_ = {idx_->index_name() + idx_->impl_->files[POSTINGS],
+                 idx_->impl_->postings_mmap_options()};
 }
 
 uint64_t inverted_index::term_freq(term_id t_id, doc_id d_id) const
@@ -332,10 +336,16 @@ auto inverted_index::search_primary(term_id t_id) const
     return inv_impl_->postings_->find(t_id);
 }
 
-util::optional<postings_stream<doc_id>>
-inverted_index::stream_for(term_id t_id) const
+auto inverted_index::stream_for(term_id t_id) const
+    -> util::optional<postings_stream_type>
 {
     return inv_impl_->postings_->find_stream(t_id);
 }
+
+util::optional<util::string_view>
+inverted_index::postings_bytes(term_id t_id) const
+{
+    return inv_impl_->postings_->find_bytes(t_id);
+}
 }
 }
@@ -35,8 +35,10 @@ struct char_input_stream
 };
 }
 
-metadata_file::metadata_file(const std::string& prefix)
-    : index_{prefix + "/metadata.index"}, md_db_{prefix + "/metadata.db"}
+metadata_file::metadata_file(const std::string& prefix,
+                             const io::mmap_options& options)
+    : index_{prefix + "/metadata.index"},
+      md_db_{prefix + "/metadata.db", options}
 {
     // read in the header to populate the schema
     char_input_stream stream{md_db_.begin(), md_db_.begin() + md_db_.size()};
@@ -6,19 +6,91 @@
 #include <iostream>
 #include <memory>
 
+#include "meta/index/front_coded_vocabulary.h"
 #include "meta/index/vocabulary_map.h"
+#include "meta/io/filesystem.h"
 #include "meta/util/optional.h"
 
+namespace
+{
+/**
+ * @return whether term matches pattern, where '*' matches any sequence of
+ * characters and '?' matches any single character
+ */
+bool wildcard_match(const std::string& pattern, const std::string& term)
+{
+    std::size_t p = 0;
+    std::size_t t = 0;
+    auto star = std::string::npos;
+    std::size_t match = 0;
+    while (t < term.size())
+    {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == term[t]))
+        {
+            ++p;
+            ++t;
+        }
+        else if (p < pattern.size() && pattern[p] == '*')
+        {
+            star = p++;
+            match = t;
+        }
+        else if (star != std::string::npos)
+        {
+            p = star + 1;
+            t = ++match;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    while (p < pattern.size() && pattern[p] == '*')
+        ++p;
+    return p == pattern.size();
+}
+}
+
 int main(int argc, char** argv)
 {
     using namespace meta;
     if (argc < 3)
     {
         std::cout << "Usage: " << argv[0] << " filename term" << std::endl;
+        std::cout << "  term may contain the wildcards '*' and '?'"
+                  << std::endl;
         return 1;
     }
 
-    index::vocabulary_map map{argv[1]};
+    std::string pattern{argv[2]};
+    auto wildcard = pattern.find_first_of("*?");
+    if (wildcard == std::string::npos)
+    {
+        index::vocabulary_map map{argv[1]};
+        if (auto t_id = map.find(pattern))
+            std::cout << *t_id << std::endl;
+        else
+            std::cout << "(not found)" << std::endl;
+        return 0;
+    }
 
-    std::cout << *map.find(argv[2]) << std::endl;
+    auto dictionary = std::string{argv[1]} + ".fc";
+    if (!filesystem::file_exists(dictionary))
+    {
+        std::cerr << "No term dictionary found at " << dictionary
+                  << "; load the index with term-dictionary = true first"
+                  << std::endl;
+        return 1;
+    }
+
+    // only the terms sharing the literal prefix of the pattern need to be
+    // checked against it
+    index::front_coded_vocabulary dict{dictionary};
+    auto range = dict.prefix_range(pattern.substr(0, wildcard));
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (wildcard_match(pattern, *it))
+            std::cout << *it << " " << it.id() << "\n";
+    }
 }
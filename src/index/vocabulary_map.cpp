@@ -13,8 +13,9 @@ namespace meta
 namespace index
 {
 
-vocabulary_map::vocabulary_map(const std::string& path, uint16_t block_size)
-    : file_{path}, inverse_{path + ".inverse"}, block_size_{block_size}
+vocabulary_map::vocabulary_map(const std::string& path, uint16_t block_size,
+                               const io::mmap_options& options)
+    : file_{path, options}, inverse_{path + ".inverse"}, block_size_{block_size}
 {
     // determine the position that denotes the end of the leaf node
     // level---we can use this to determine when to stop our finds later on
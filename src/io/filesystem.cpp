@@ -7,6 +7,9 @@
 #include <fstream>
 #include <vector>
 
+#include <sys/stat.h>
+#include <sys/types.h>
+
 #include "meta/io/filesystem.h"
 #include "meta/io/mmap_file.h"
 #include "meta/util/printing.h"
@@ -228,6 +231,14 @@ std::uintmax_t remove_all(const std::string& path)
 }
 #endif
 
+int64_t last_modified(const std::string& filename)
+{
+    struct stat st;
+    if (::stat(filename.c_str(), &st) != 0)
+        return 0;
+    return static_cast<int64_t>(st.st_mtime);
+}
+
 bool copy_file(const std::string& source, const std::string& dest)
 {
     if (!file_exists(source))
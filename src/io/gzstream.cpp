@@ -3,14 +3,230 @@
  * @author Chase Geigle
  */
 
+#include <cstdio>
+#include <deque>
+#include <future>
 #include <iostream>
+#include <memory>
+
 #include "meta/io/gzstream.h"
+#include "meta/parallel/thread_pool.h"
+#include "meta/util/shim.h"
 
 namespace meta
 {
 namespace io
 {
 
+namespace
+{
+/// The size of the fixed portion of a BGZF member header
+const constexpr std::size_t bgzf_header_size = 18;
+
+/**
+ * @param header The first bgzf_header_size bytes of a gzip member
+ * @return whether the member is a BGZF block (a gzip member with a "BC"
+ * extra subfield containing its total size)
+ */
+bool is_bgzf_header(const uint8_t* header)
+{
+    return header[0] == 31 && header[1] == 139 && header[2] == 8
+           && (header[3] & 4) != 0 && header[10] == 6 && header[11] == 0
+           && header[12] == 'B' && header[13] == 'C' && header[14] == 2
+           && header[15] == 0;
+}
+
+/**
+ * Inflates a single, complete gzip member.
+ * @param member The compressed bytes of the member
+ * @return the decompressed bytes
+ */
+std::vector<char> inflate_member(const std::vector<char>& member)
+{
+    // the last four bytes of a gzip member are its uncompressed size
+    auto isize_ptr
+        = reinterpret_cast<const uint8_t*>(&member[member.size() - 4]);
+    uint32_t isize = static_cast<uint32_t>(isize_ptr[0])
+                     | (static_cast<uint32_t>(isize_ptr[1]) << 8)
+                     | (static_cast<uint32_t>(isize_ptr[2]) << 16)
+                     | (static_cast<uint32_t>(isize_ptr[3]) << 24);
+
+    // zlib refuses a null output buffer, even when nothing will be written
+    std::vector<char> output(isize == 0 ? 1 : isize);
+
+    z_stream stream{};
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+        throw gz_exception{"failed to initialize inflate"};
+
+    stream.next_in
+        = reinterpret_cast<Bytef*>(const_cast<char*>(member.data()));
+    stream.avail_in = static_cast<uInt>(member.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+
+    auto ret = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+    if (ret != Z_STREAM_END)
+        throw gz_exception{"corrupt BGZF member"};
+
+    output.resize(isize);
+    return output;
+}
+
+/**
+ * Produces blocks from a gzip file of any kind by inflating it
+ * sequentially.
+ */
+class gz_producer
+{
+  public:
+    gz_producer(const std::string& name, std::size_t block_size)
+        : file_{gzopen(name.c_str(), "rb")}, block_size_{block_size}
+    {
+        if (!file_)
+            throw gz_exception{"failed to open gzip file " + name};
+        gzbuffer(file_, 128 * 1024);
+    }
+
+    ~gz_producer()
+    {
+        gzclose(file_);
+    }
+
+    bool operator()(std::vector<char>& block)
+    {
+        block.resize(block_size_);
+        auto bytes
+            = gzread(file_, &block[0], static_cast<unsigned>(block.size()));
+        if (bytes < 0)
+            throw gz_exception{"failed to read gzip file"};
+
+        block.resize(static_cast<std::size_t>(bytes));
+        return bytes > 0;
+    }
+
+  private:
+    gzFile file_;
+    std::size_t block_size_;
+};
+
+/**
+ * Produces blocks from a BGZF file by reading its members sequentially
+ * and inflating them in parallel on a thread_pool. The members are
+ * concatenated back together in file order.
+ */
+class bgzf_producer
+{
+  public:
+    bgzf_producer(std::FILE* file, std::size_t num_threads,
+                  std::size_t block_size)
+        : file_{file},
+          pool_{num_threads},
+          block_size_{block_size},
+          max_pending_{2 * num_threads},
+          eof_{false}
+    {
+        // nothing
+    }
+
+    ~bgzf_producer()
+    {
+        // wait for outstanding work before the pool is destroyed
+        for (auto& fut : pending_)
+            fut.wait();
+        std::fclose(file_);
+    }
+
+    bool operator()(std::vector<char>& block)
+    {
+        fill_pending();
+        while (!pending_.empty() && block.size() < block_size_)
+        {
+            auto member = pending_.front().get();
+            pending_.pop_front();
+            block.insert(block.end(), member.begin(), member.end());
+            fill_pending();
+        }
+        return !pending_.empty();
+    }
+
+  private:
+    void fill_pending()
+    {
+        while (!eof_ && pending_.size() < max_pending_)
+        {
+            auto member = std::make_shared<std::vector<char>>();
+            if (!read_member(*member))
+            {
+                eof_ = true;
+                return;
+            }
+            pending_.emplace_back(
+                pool_.submit_task([member]() { return inflate_member(*member); }));
+        }
+    }
+
+    bool read_member(std::vector<char>& member)
+    {
+        member.resize(bgzf_header_size);
+        auto bytes = std::fread(&member[0], 1, bgzf_header_size, file_);
+        if (bytes == 0)
+            return false;
+
+        auto header = reinterpret_cast<const uint8_t*>(member.data());
+        if (bytes != bgzf_header_size || !is_bgzf_header(header))
+            throw gz_exception{"expected a BGZF member header"};
+
+        // BSIZE is the total member size minus one
+        std::size_t size = (static_cast<std::size_t>(header[16])
+                            | (static_cast<std::size_t>(header[17]) << 8))
+                           + 1;
+        if (size < bgzf_header_size + 8)
+            throw gz_exception{"invalid BGZF member size"};
+
+        member.resize(size);
+        auto remaining = size - bgzf_header_size;
+        if (std::fread(&member[bgzf_header_size], 1, remaining, file_)
+            != remaining)
+            throw gz_exception{"truncated BGZF member"};
+        return true;
+    }
+
+    std::FILE* file_;
+    parallel::thread_pool pool_;
+    std::deque<std::future<std::vector<char>>> pending_;
+    std::size_t block_size_;
+    std::size_t max_pending_;
+    bool eof_;
+};
+
+readahead_streambuf::producer_type
+make_gz_producer(const std::string& name, std::size_t num_threads,
+                 std::size_t block_size)
+{
+    if (auto file = std::fopen(name.c_str(), "rb"))
+    {
+        uint8_t header[bgzf_header_size];
+        auto bytes = std::fread(header, 1, bgzf_header_size, file);
+        if (bytes == bgzf_header_size && is_bgzf_header(header))
+        {
+            std::rewind(file);
+            auto producer = std::make_shared<bgzf_producer>(
+                file, num_threads == 0 ? 1 : num_threads, block_size);
+            return [producer](std::vector<char>& block) {
+                return (*producer)(block);
+            };
+        }
+        std::fclose(file);
+    }
+
+    auto producer = std::make_shared<gz_producer>(name, block_size);
+    return [producer](std::vector<char>& block) {
+        return (*producer)(block);
+    };
+}
+}
+
 gzstreambuf::gzstreambuf(const char* filename, const char* openmode,
                          size_t buffer_size)
     : buffer_(buffer_size), file_{gzopen(filename, openmode)}
@@ -97,6 +313,20 @@ void gzifstream::flush()
     buffer_.sync();
 }
 
+readahead_gzifstream::readahead_gzifstream(const std::string& name,
+                                           std::size_t num_threads,
+                                           std::size_t block_size)
+    : std::istream{&buffer_},
+      buffer_{make_gz_producer(name, num_threads, block_size)}
+{
+    clear();
+}
+
+readahead_streambuf* readahead_gzifstream::rdbuf() const
+{
+    return const_cast<readahead_streambuf*>(&buffer_);
+}
+
 gzofstream::gzofstream(std::string name)
     : std::ostream{&buffer_}, buffer_{name.c_str(), "wb"}
 {
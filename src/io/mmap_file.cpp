@@ -21,7 +21,45 @@ namespace meta
 namespace io
 {
 
-mmap_file::mmap_file(const std::string& path)
+namespace
+{
+/**
+ * Applies the advisory hints in the options to a mapped region. These are
+ * only hints, so failures are ignored.
+ */
+void advise(char* start, uint64_t size, const mmap_options& options)
+{
+#ifndef _WIN32
+    switch (options.access)
+    {
+        case access_pattern::normal:
+            break;
+        case access_pattern::sequential:
+            madvise(start, size, MADV_SEQUENTIAL);
+            break;
+        case access_pattern::random:
+            madvise(start, size, MADV_RANDOM);
+            break;
+    }
+
+#ifndef MAP_POPULATE
+    if (options.populate)
+        madvise(start, size, MADV_WILLNEED);
+#endif
+
+#ifdef MADV_HUGEPAGE
+    if (options.huge_pages)
+        madvise(start, size, MADV_HUGEPAGE);
+#endif
+#else
+    (void)start;
+    (void)size;
+    (void)options;
+#endif
+}
+}
+
+mmap_file::mmap_file(const std::string& path, const mmap_options& options)
     : path_{path}, start_{nullptr}, size_{filesystem::file_size(path)}
 {
     file_descriptor_ = open(path_.c_str(), O_RDONLY);
@@ -29,13 +67,29 @@ mmap_file::mmap_file(const std::string& path)
         throw mmap_file_exception{"error obtaining file descriptor for "
                                   + path_};
 
-    start_ = (char*)mmap(nullptr, size_, PROT_READ, MAP_SHARED,
-                         file_descriptor_, 0);
-    if (start_ == nullptr)
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (options.populate)
+        flags |= MAP_POPULATE;
+#endif
+
+    auto start = mmap(nullptr, size_, PROT_READ, flags, file_descriptor_, 0);
+    if (start == MAP_FAILED || start == nullptr)
     {
         close(file_descriptor_);
         throw mmap_file_exception("error memory-mapping " + path_);
     }
+    start_ = static_cast<char*>(start);
+
+    advise(start_, size_, options);
+
+    if (options.lock && mlock(start_, size_) != 0)
+    {
+        munmap(start_, size_);
+        close(file_descriptor_);
+        start_ = nullptr;
+        throw mmap_file_exception("error locking " + path_ + " in memory");
+    }
 }
 
 mmap_file::mmap_file(mmap_file&& other)
@@ -0,0 +1,109 @@
+/**
+ * @file readahead_streambuf.cpp
+ * @author Chase Geigle
+ */
+
+#include "meta/io/readahead_streambuf.h"
+
+namespace meta
+{
+namespace io
+{
+
+readahead_streambuf::readahead_streambuf(producer_type producer,
+                                         std::size_t num_buffers)
+    : producer_{std::move(producer)},
+      num_buffers_{num_buffers == 0 ? 1 : num_buffers},
+      done_{false},
+      stop_{false}
+{
+    setg(nullptr, nullptr, nullptr);
+    thread_ = std::thread{&readahead_streambuf::run, this};
+}
+
+readahead_streambuf::~readahead_streambuf()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        stop_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+}
+
+void readahead_streambuf::run()
+{
+    while (true)
+    {
+        std::vector<char> block;
+        {
+            std::unique_lock<std::mutex> lock{mutex_};
+            cond_.wait(lock,
+                       [&]() { return stop_ || full_.size() < num_buffers_; });
+            if (stop_)
+                return;
+
+            if (!free_.empty())
+            {
+                block = std::move(free_.back());
+                free_.pop_back();
+            }
+        }
+
+        block.clear();
+        bool more;
+        try
+        {
+            more = producer_(block);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            error_ = std::current_exception();
+            done_ = true;
+            cond_.notify_all();
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock{mutex_};
+        if (!block.empty())
+            full_.push_back(std::move(block));
+        if (!more)
+            done_ = true;
+        cond_.notify_all();
+        if (done_)
+            return;
+    }
+}
+
+auto readahead_streambuf::underflow() -> int_type
+{
+    if (gptr() && (gptr() < egptr()))
+        return traits_type::to_int_type(*gptr());
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    cond_.wait(lock, [&]() { return done_ || !full_.empty(); });
+
+    if (full_.empty())
+    {
+        setg(nullptr, nullptr, nullptr);
+        if (error_)
+        {
+            auto error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+        return traits_type::eof();
+    }
+
+    free_.push_back(std::move(current_));
+    current_ = std::move(full_.front());
+    full_.pop_front();
+    lock.unlock();
+    cond_.notify_all();
+
+    setg(&current_[0], &current_[0], &current_[0] + current_.size());
+    return traits_type::to_int_type(*gptr());
+}
+}
+}
@@ -9,6 +9,8 @@
  * http://git.tukaani.org/?p=xz.git;a=blob;f=doc/examples/02_decompress.c
  */
 
+#include <memory>
+
 #include "meta/io/xzstream.h"
 #include "meta/util/string_view.h"
 
@@ -95,7 +97,8 @@ xzstreambuf::~xzstreambuf()
         sync();
     }
 
-    fclose(file_);
+    if (file_)
+        fclose(file_);
     lzma_end(&stream_);
 }
 
@@ -237,6 +240,38 @@ uint64_t xzifstream::bytes_read() const
     return buffer_.bytes_read();
 }
 
+namespace
+{
+std::shared_ptr<xzstreambuf> make_source(const std::string& name,
+                                         std::size_t block_size)
+{
+    auto source = std::make_shared<xzstreambuf>(name.c_str(), "rb", block_size);
+    if (!source->is_open())
+        throw xz_exception{"failed to open xz file " + name, LZMA_OK};
+    return source;
+}
+}
+
+readahead_xzifstream::readahead_xzifstream(const std::string& name,
+                                           std::size_t block_size)
+    : std::istream{&buffer_},
+      buffer_{[block_size, source = make_source(name, block_size)](
+                  std::vector<char>& block) {
+          block.resize(block_size);
+          auto bytes = source->sgetn(&block[0],
+                                     static_cast<std::streamsize>(block_size));
+          block.resize(static_cast<std::size_t>(bytes));
+          return bytes > 0;
+      }}
+{
+    clear();
+}
+
+readahead_streambuf* readahead_xzifstream::rdbuf() const
+{
+    return const_cast<readahead_streambuf*>(&buffer_);
+}
+
 xzofstream::xzofstream(std::string name)
     : std::ostream{&buffer_}, buffer_{name.c_str(), "wb"}
 {
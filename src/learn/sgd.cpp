@@ -4,7 +4,11 @@
  */
 
 #include <cmath>
+#include <limits>
 #include <numeric>
+#include <stdexcept>
+#include <string>
+
 #include "meta/io/packed.h"
 #include "meta/learn/sgd.h"
 
@@ -13,6 +17,66 @@ namespace meta
 namespace learn
 {
 
+namespace
+{
+/**
+ * Begins saved averaged models in place of the number of features, which
+ * can never be this large. Models that are not averaged are saved exactly
+ * as they were before averaging existed, so old streams (and old readers)
+ * keep working.
+ */
+const uint64_t averaged_format_tag = std::numeric_limits<uint64_t>::max();
+
+/**
+ * The version of the averaged model format that follows the tag.
+ */
+const uint64_t averaged_format_version = 1;
+
+/**
+ * Throws if x has a feature past the end of a weight vector of the given
+ * size. Feature vectors are sorted, so only the last feature is checked.
+ */
+void check_bounds(const feature_vector& x, std::size_t size)
+{
+    if (!x.empty() && (x.end() - 1)->first >= size)
+        throw std::out_of_range{"feature id outside of sgd_model"};
+}
+
+void check_bounds(const basic_feature_span<float>& x, std::size_t size)
+{
+    if (!x.empty() && x.ids()[x.size() - 1] >= size)
+        throw std::out_of_range{"feature id outside of sgd_model"};
+}
+
+/**
+ * Computes the dot product of a feature_vector with every Stride-th double
+ * of weights. Feature ids must be in bounds.
+ */
+template <std::size_t Stride>
+double sparse_dot(const double* weights, const feature_vector& x)
+{
+    auto sum = 0.0;
+    for (const auto& pr : x)
+        sum += pr.second * weights[pr.first * Stride];
+    return sum;
+}
+
+/**
+ * Computes the dot product of a basic_feature_span with every Stride-th
+ * double of weights. Feature ids must be in bounds.
+ */
+template <std::size_t Stride>
+double sparse_dot(const double* weights, const basic_feature_span<float>& x)
+{
+    auto ids = x.ids();
+    auto vals = x.values();
+    auto sum = 0.0;
+    for (std::size_t i = 0; i < x.size(); ++i)
+        sum += static_cast<double>(vals[i]) * weights[ids[i] * Stride];
+    return sum;
+}
+}
+
 sgd_model::sgd_model(std::size_t num_features, options_type options)
     : weights_(num_features),
       scale_{1.0},
@@ -20,14 +84,25 @@ sgd_model::sgd_model(std::size_t num_features, options_type options)
       lr_{options.learning_rate},
       l2_regularization_{options.l2_regularizer},
       l1_regularization_{options.l1_regularizer},
-      t_{0}
+      t_{0},
+      averaged_{options.averaged},
+      averages_(options.averaged ? num_features : 0)
 {
     // nothing
 }
 
-sgd_model::sgd_model(std::istream& in)
+sgd_model::sgd_model(std::istream& in) : averaged_{false}
 {
-    auto size = io::packed::read<std::size_t>(in);
+    auto size = io::packed::read<uint64_t>(in);
+    if (size == averaged_format_tag)
+    {
+        auto version = io::packed::read<uint64_t>(in);
+        if (version != averaged_format_version)
+            throw std::runtime_error{"unsupported sgd_model format version "
+                                     + std::to_string(version)};
+        averaged_ = true;
+        size = io::packed::read<uint64_t>(in);
+    }
 
     weights_.resize(size);
     for (auto& weight_val : weights_)
@@ -44,10 +119,27 @@ sgd_model::sgd_model(std::istream& in)
     io::packed::read(in, l2_regularization_);
     io::packed::read(in, l1_regularization_);
     io::packed::read(in, t_);
+    if (averaged_)
+    {
+        averages_.resize(size);
+        for (auto& avg : averages_)
+        {
+            io::packed::read(in, avg.sum);
+            io::packed::read(in, avg.mark);
+        }
+        io::packed::read(in, bias_average_.sum);
+        io::packed::read(in, bias_average_.mark);
+        io::packed::read(in, scale_sum_);
+    }
 }
 
 void sgd_model::save(std::ostream& out) const
 {
+    if (averaged_)
+    {
+        io::packed::write(out, averaged_format_tag);
+        io::packed::write(out, averaged_format_version);
+    }
     io::packed::write(out, weights_.size());
     for (const auto& weight_val : weights_)
     {
@@ -63,22 +155,69 @@ void sgd_model::save(std::ostream& out) const
     io::packed::write(out, l2_regularization_);
     io::packed::write(out, l1_regularization_);
     io::packed::write(out, t_);
+    if (averaged_)
+    {
+        for (const auto& avg : averages_)
+        {
+            io::packed::write(out, avg.sum);
+            io::packed::write(out, avg.mark);
+        }
+        io::packed::write(out, bias_average_.sum);
+        io::packed::write(out, bias_average_.mark);
+        io::packed::write(out, scale_sum_);
+    }
 }
 
-double sgd_model::predict(const feature_vector& x) const
+template <class FeatureRange>
+double sgd_model::predict_impl(const FeatureRange& x) const
 {
-    auto val = scale_ * bias_.weight;
+    if (!averaged_ || t_ == 0)
+        return predict_raw(x);
+
+    check_bounds(x, weights_.size());
+    auto val = average(bias_, bias_average_);
     for (const auto& pr : x)
-        val += pr.second * scale_ * weights_.at(pr.first).weight;
+        val += pr.second * average(weights_[pr.first], averages_[pr.first]);
     return val;
 }
 
-double sgd_model::train_one(const feature_vector& x, double expected_label,
-                            const loss::loss_function& loss)
+template <class FeatureRange>
+double sgd_model::predict_raw(const FeatureRange& x) const
+{
+    static_assert(sizeof(weight_type) % sizeof(double) == 0,
+                  "weight_type must be made of doubles");
+    const constexpr auto stride = sizeof(weight_type) / sizeof(double);
+
+    check_bounds(x, weights_.size());
+    return scale_ * (bias_.weight
+                     + sparse_dot<stride>(&weights_.data()->weight, x));
+}
+
+template <class FeatureRange>
+double sgd_model::train_one_impl(const FeatureRange& x, double expected_label,
+                                 const loss::loss_function& loss)
+{
+    normalize(x);
+    return apply_update(x, predict_raw(x), expected_label, loss);
+}
+
+template <class FeatureRange>
+void sgd_model::accumulate(const FeatureRange& x)
+{
+    check_bounds(x, weights_.size());
+    for (const auto& pr : x)
+        accumulate(weights_[pr.first], averages_[pr.first]);
+    accumulate(bias_, bias_average_);
+}
+
+template <class FeatureRange>
+void sgd_model::normalize(const FeatureRange& x)
 {
     t_ += 1;
 
-    auto predicted = 0.0;
+    if (averaged_)
+        accumulate(x);
+
     for (const auto& pr : x)
     {
         auto abs_val = std::abs(pr.second);
@@ -92,25 +231,28 @@ double sgd_model::train_one(const feature_vector& x, double expected_label,
         if (weight_val.scale > 0)
             update_scale_ += (pr.second * pr.second)
                              / (weight_val.scale * weight_val.scale);
-
-        predicted += pr.second * scale_ * weight_val.weight;
     }
 
     // handle the bias (we treat it as always being 1)
     update_scale_ += 1.0;
-    predicted += scale_ * bias_.weight;
+}
+
+template <class FeatureRange>
+double sgd_model::apply_update(const FeatureRange& x, double predicted,
+                               double expected_label,
+                               const loss::loss_function& loss)
+{
+    // with mini-batches, other instances may have been trained on since
+    // this one was normalized
+    if (averaged_)
+        accumulate(x);
 
     auto error_derivative = loss.derivative(predicted, expected_label);
     scale_ *= (1.0 - lr_ * l2_regularization_);
 
     // renormalize if scalar is too small
     if (scale_ < 1e-10)
-    {
-        for (auto& weight_val : weights_)
-            weight_val.weight *= scale_;
-        bias_.weight *= scale_;
-        scale_ = 1;
-    }
+        fold_scale();
 
     auto delta
         = -lr_ * std::sqrt(t_ / update_scale_) * error_derivative / scale_;
@@ -140,12 +282,198 @@ double sgd_model::train_one(const feature_vector& x, double expected_label,
         bias_.weight += delta * 1.0 / (std::sqrt(bias_.grad_squared));
     }
 
+    if (averaged_)
+        scale_sum_ += scale_;
+
     return loss.loss(predicted, expected_label);
 }
 
+template <class FeatureRange>
+double sgd_model::train_one_impl(const FeatureRange& x, double expected_label,
+                                 const loss::loss_function& loss,
+                                 hogwild_state& state)
+{
+    // this mirrors the serial train_one(), except that scale_ stays 1 and
+    // t_, update_scale_, and bias_ are replaced by the thread's own
+    // copies; other threads may be updating the same weights concurrently
+    state.t += 1;
+
+    auto predicted = 0.0;
+    for (const auto& pr : x)
+    {
+        auto abs_val = std::abs(pr.second);
+        auto& weight_val = weights_.at(pr.first);
+        if (abs_val > weight_val.scale)
+        {
+            weight_val.weight *= weight_val.scale / abs_val;
+            weight_val.scale = abs_val;
+        }
+
+        if (weight_val.scale > 0)
+            state.update_scale += (pr.second * pr.second)
+                                  / (weight_val.scale * weight_val.scale);
+
+        predicted += pr.second * weight_val.weight;
+    }
+
+    // handle the bias (we treat it as always being 1)
+    state.update_scale += 1.0;
+    predicted += state.bias.weight;
+
+    auto error_derivative = loss.derivative(predicted, expected_label);
+    auto shrink = 1.0 - lr_ * l2_regularization_;
+    auto delta = -lr_ * std::sqrt(state.t / state.update_scale)
+                 * error_derivative;
+
+    // the other threads have seen about as many examples as this one
+    auto t = t_ + (state.t - t_) * state.num_threads;
+    for (const auto& pr : x)
+    {
+        if (pr.second == 0.0)
+            continue;
+
+        auto& weight_val = weights_.at(pr.first);
+        weight_val.weight *= shrink;
+        if (delta != 0.0)
+        {
+            // update using NAG update equation
+            weight_val.grad_squared
+                += error_derivative * error_derivative * pr.second * pr.second;
+            weight_val.weight
+                += delta * 1.0
+                   / (weight_val.scale * std::sqrt(weight_val.grad_squared))
+                   * pr.second;
+        }
+
+        // handle the L1 penalization
+        if (l1_regularization_ > 0)
+            penalize(weight_val, t);
+    }
+
+    // handle the bias (we treat it as always being 1)
+    state.bias.weight *= shrink;
+    if (delta != 0.0)
+    {
+        state.bias.grad_squared += error_derivative * error_derivative;
+        state.bias.weight
+            += delta * 1.0 / (std::sqrt(state.bias.grad_squared));
+    }
+
+    return loss.loss(predicted, expected_label);
+}
+
+double sgd_model::predict(const feature_vector& x) const
+{
+    return predict_impl(x);
+}
+
+double sgd_model::predict(const basic_feature_span<float>& x) const
+{
+    return predict_impl(x);
+}
+
+std::size_t sgd_model::num_features() const
+{
+    return weights_.size();
+}
+
+bool sgd_model::averaged() const
+{
+    return averaged_;
+}
+
+double sgd_model::weight(feature_id feature) const
+{
+    const auto& weight_val = weights_.at(feature);
+    if (averaged_ && t_ > 0)
+        return average(weight_val, averages_[feature]);
+    return scale_ * weight_val.weight;
+}
+
+double sgd_model::bias() const
+{
+    if (averaged_ && t_ > 0)
+        return average(bias_, bias_average_);
+    return scale_ * bias_.weight;
+}
+
+double sgd_model::prepare(const feature_vector& x)
+{
+    normalize(x);
+    return predict_raw(x);
+}
+
+double sgd_model::prepare(const basic_feature_span<float>& x)
+{
+    normalize(x);
+    return predict_raw(x);
+}
+
+double sgd_model::update(const feature_vector& x, double predicted,
+                         double expected_label,
+                         const loss::loss_function& loss)
+{
+    return apply_update(x, predicted, expected_label, loss);
+}
+
+double sgd_model::update(const basic_feature_span<float>& x,
+                         double predicted, double expected_label,
+                         const loss::loss_function& loss)
+{
+    return apply_update(x, predicted, expected_label, loss);
+}
+
+double sgd_model::train_one(const feature_vector& x, double expected_label,
+                            const loss::loss_function& loss)
+{
+    return train_one_impl(x, expected_label, loss);
+}
+
+double sgd_model::train_one(const basic_feature_span<float>& x,
+                            double expected_label,
+                            const loss::loss_function& loss)
+{
+    return train_one_impl(x, expected_label, loss);
+}
+
+double sgd_model::train_one(const feature_vector& x, double expected_label,
+                            const loss::loss_function& loss,
+                            hogwild_state& state)
+{
+    return train_one_impl(x, expected_label, loss, state);
+}
+
+double sgd_model::train_one(const basic_feature_span<float>& x,
+                            double expected_label,
+                            const loss::loss_function& loss,
+                            hogwild_state& state)
+{
+    return train_one_impl(x, expected_label, loss, state);
+}
+
+void sgd_model::accumulate(const weight_type& weight_val,
+                           average_type& avg) const
+{
+    // the stored weight has not changed since the last call, but the
+    // actual weight is scale_ times it and scale_ shrinks every example
+    avg.sum += weight_val.weight * (scale_sum_ - avg.mark);
+    avg.mark = scale_sum_;
+}
+
+double sgd_model::average(const weight_type& weight_val,
+                          const average_type& avg) const
+{
+    return (avg.sum + weight_val.weight * (scale_sum_ - avg.mark)) / t_;
+}
+
 void sgd_model::penalize(weight_type& weight_val)
 {
-    auto u = t_ * lr_ * l1_regularization_;
+    penalize(weight_val, t_);
+}
+
+void sgd_model::penalize(weight_type& weight_val, std::size_t t)
+{
+    auto u = t * lr_ * l1_regularization_;
     auto z = weight_val.weight * scale_;
     if (z > 0)
     {
@@ -160,6 +488,21 @@ void sgd_model::penalize(weight_type& weight_val)
     weight_val.cumulative_penalty += (scale_ * weight_val.weight) - z;
 }
 
+void sgd_model::fold_scale()
+{
+    if (averaged_)
+    {
+        for (std::size_t i = 0; i < weights_.size(); ++i)
+            accumulate(weights_[i], averages_[i]);
+        accumulate(bias_, bias_average_);
+    }
+
+    for (auto& weight_val : weights_)
+        weight_val.weight *= scale_;
+    bias_.weight *= scale_;
+    scale_ = 1;
+}
+
 void sgd_model::reset()
 {
     std::fill(weights_.begin(), weights_.end(), weight_type{});
@@ -167,6 +510,9 @@ void sgd_model::reset()
     scale_ = 1;
     update_scale_ = 0;
     t_ = 0;
+    std::fill(averages_.begin(), averages_.end(), average_type{});
+    bias_average_ = average_type{};
+    scale_sum_ = 0;
 }
 
 double sgd_model::l2norm() const
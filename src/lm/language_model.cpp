@@ -11,6 +11,7 @@
 #include "meta/lm/read_arpa.h"
 #include "meta/logging/logger.h"
 #include "meta/util/fixed_heap.h"
+#include "meta/util/printing.h"
 #include "meta/util/shim.h"
 #include "meta/util/time.h"
 
@@ -48,6 +49,8 @@ language_model::language_model(const cpptoml::table& config)
         LOG(info) << "Loading language model from .arpa file: " << *arpa_file
                   << ENDLG;
         prefix_ = *binary_file;
+        // a filter left over from a previous model may be missing words
+        filesystem::delete_file(prefix_ + "0.bloom");
         auto time = common::time([&]() { read_arpa_format(*arpa_file); });
         LOG(info) << "Done. (" << time.count() << "ms)" << ENDLG;
     }
@@ -55,6 +58,9 @@ language_model::language_model(const cpptoml::table& config)
         throw language_model_exception{
             "arpa-file or binary-file-prefix needed in config file"};
 
+    if (table->get_as<bool>("bloom-filter").value_or(false))
+        load_vocab_filter();
+
     // cache this value
     auto unk = vocabulary_.at("<unk>");
     unk_id_ = unk;
@@ -124,6 +130,24 @@ void language_model::load_vocab()
     }
 }
 
+void language_model::load_vocab_filter()
+{
+    auto filename = prefix_ + "0.bloom";
+    if (!filesystem::file_exists(filename))
+    {
+        hashing::blocked_bloom_filter filter{vocabulary_.size()};
+        for (const auto& word : vocabulary_)
+            filter.insert(word.first);
+        filter.save(filename);
+
+        LOG(info) << "Built vocabulary bloom filter: "
+                  << printing::bytes_to_units(filter.bytes_used())
+                  << ", estimated false positive rate "
+                  << filter.false_positive_rate() << ENDLG;
+    }
+    vocab_filter_ = hashing::blocked_bloom_filter{filename};
+}
+
 float language_model::log_prob(const sentence& tokens) const
 {
     return log_prob(token_list{tokens, vocabulary_});
@@ -161,6 +185,9 @@ float language_model::perplexity_per_word(const sentence& tokens) const
 
 term_id language_model::index(const std::string& token) const
 {
+    if (vocab_filter_ && !vocab_filter_->contains(token))
+        return unk_id_;
+
     auto it = vocabulary_.find(token);
     return it != vocabulary_.end() ? it->second : unk_id_;
 }
@@ -148,6 +148,14 @@ void sr_parser::train(std::vector<parse_tree>& trees, training_options options)
     training_data data{trees, options.seed};
     trans_ = data.preprocess();
 
+    // a loaded model is only kept frozen; train it further as a
+    // linear_model, which is then used for scoring
+    if (!frozen_.empty())
+    {
+        model_ = frozen_.to_linear_model();
+        frozen_ = {};
+    }
+
     LOG(info) << "Found " << trans_.size() << " transitions" << ENDLG;
 
     parallel::thread_pool pool{options.num_threads};
@@ -414,11 +422,14 @@ auto sr_parser::best_transition(const feature_vector& features,
                                 bool check_legality /* = false */) const
     -> trans_id
 {
-    return model_.best_class(features, [&](trans_id tid)
-                             {
-                                 return !check_legality
-                                        || state.legal(trans_.at(tid));
-                             });
+    auto filter = [&](trans_id tid)
+    {
+        return !check_legality || state.legal(trans_.at(tid));
+    };
+
+    if (!frozen_.empty())
+        return frozen_.best_class(features, filter);
+    return model_.best_class(features, filter);
 }
 
 auto sr_parser::best_transitions(const feature_vector& features,
@@ -426,11 +437,14 @@ auto sr_parser::best_transitions(const feature_vector& features,
                                  bool check_legality) const
     -> std::vector<scored_trans>
 {
-    return model_.best_classes(features, num, [&](trans_id tid)
-                               {
-                                   return !check_legality
-                                          || state.legal(trans_.at(tid));
-                               });
+    auto filter = [&](trans_id tid)
+    {
+        return !check_legality || state.legal(trans_.at(tid));
+    };
+
+    if (!frozen_.empty())
+        return frozen_.best_classes(features, num, filter);
+    return model_.best_classes(features, num, filter);
 }
 
 void sr_parser::save(const std::string& prefix) const
@@ -438,7 +452,10 @@ void sr_parser::save(const std::string& prefix) const
     trans_.save(prefix);
     io::gzofstream model{prefix + "/parser.model.gz"};
     io::packed::write(model, beam_size_);
-    model_.save(model);
+    if (!frozen_.empty())
+        frozen_.to_linear_model().save(model);
+    else
+        model_.save(model);
 }
 
 void sr_parser::load(const std::string& prefix)
@@ -450,6 +467,11 @@ void sr_parser::load(const std::string& prefix)
     io::gzifstream model{model_file};
     io::packed::read(model, beam_size_);
     model_.load(model);
+
+    // a loaded model is only used for parsing, so keep just the copy
+    // that is laid out for it
+    frozen_ = decltype(frozen_){model_};
+    model_ = {};
 }
 }
 }
@@ -49,6 +49,11 @@ perceptron::perceptron(const std::string& prefix) : perceptron()
     analyzer_.load(prefix);
     io::gzifstream file{prefix + "/tagger.model.gz"};
     model_.load(file);
+
+    // a loaded model is only used for tagging, so keep just the copy that
+    // is laid out for it
+    frozen_ = decltype(frozen_){model_};
+    model_ = {};
 }
 
 void perceptron::tag(sequence& seq) const
@@ -56,7 +61,8 @@ void perceptron::tag(sequence& seq) const
     for (uint64_t t = 0; t < seq.size(); ++t)
     {
         analyzer_.analyze(seq, t);
-        seq[t].label(model_.best_class(seq[t].features()));
+        seq[t].label(frozen_.empty() ? model_.best_class(seq[t].features())
+                                     : frozen_.best_class(seq[t].features()));
         seq[t].tag(analyzer_.tag(seq[t].label()));
     }
 }
@@ -66,6 +72,14 @@ void perceptron::train(std::vector<sequence>& sequences,
 {
     std::default_random_engine rng{options.seed};
 
+    // a loaded model is only kept frozen; train it further as a
+    // linear_model, which is then used for tagging
+    if (!frozen_.empty())
+    {
+        model_ = frozen_.to_linear_model();
+        frozen_ = {};
+    }
+
     std::vector<size_t> indices(sequences.size());
     std::iota(indices.begin(), indices.end(), 0);
 
@@ -139,7 +153,10 @@ void perceptron::save(const std::string& prefix) const
 {
     analyzer_.save(prefix);
     io::gzofstream file{prefix + "/tagger.model.gz"};
-    model_.save(file);
+    if (!frozen_.empty())
+        frozen_.to_linear_model().save(file);
+    else
+        model_.save(file);
 }
 }
 }
@@ -0,0 +1,125 @@
+/**
+ * @file cache_bench.cpp
+ * @author Chase Geigle
+ *
+ * Measures the throughput of the maps used inside caches, and of a
+ * dblru_cache over each of them, with an increasing number of threads.
+ */
+
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "meta/caching/dblru_cache.h"
+#include "meta/caching/maps/concurrent_map.h"
+#include "meta/caching/maps/locking_map.h"
+#include "meta/util/time.h"
+
+using namespace meta;
+
+namespace
+{
+
+/// The values stored are shared, like the postings_data in cached_index
+using value_type = std::shared_ptr<const uint64_t>;
+
+/**
+ * Runs a mixed find/insert workload on a cache from several threads.
+ *
+ * @param cache The cache (or map) to run on
+ * @param num_threads The number of threads to use
+ * @param ops The number of operations each thread performs
+ * @param num_keys The size of the key space
+ * @param write_pct The percent of operations that are inserts
+ * @return the total number of operations per second
+ */
+template <class Cache>
+double run(Cache& cache, uint64_t num_threads, uint64_t ops,
+           uint64_t num_keys, uint64_t write_pct)
+{
+    std::vector<std::thread> threads;
+    auto time = common::time([&]() {
+        for (uint64_t t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]() {
+                std::mt19937_64 rng{t + 1};
+                std::uniform_int_distribution<uint64_t> key_dist{0,
+                                                                 num_keys - 1};
+                std::uniform_int_distribution<uint64_t> pct_dist{0, 99};
+                auto value = std::make_shared<const uint64_t>(t);
+                uint64_t found = 0;
+                for (uint64_t i = 0; i < ops; ++i)
+                {
+                    auto key = key_dist(rng);
+                    if (pct_dist(rng) < write_pct)
+                        cache.insert(key, value);
+                    else if (cache.find(key))
+                        ++found;
+                }
+                // keep the finds from being optimized away
+                if (found == ops + 1)
+                    std::cout << found;
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+    });
+
+    return static_cast<double>(num_threads * ops)
+           / (static_cast<double>(time.count()) / 1000.0);
+}
+
+template <class Cache, class... Args>
+void bench(const std::string& name, uint64_t max_threads, uint64_t ops,
+           uint64_t num_keys, uint64_t write_pct, Args&&... args)
+{
+    std::cout << name << "\n";
+    for (uint64_t threads = 1; threads <= max_threads; threads *= 2)
+    {
+        Cache cache(std::forward<Args>(args)...);
+        // warm the cache so that most finds hit
+        for (uint64_t key = 0; key < num_keys; ++key)
+            cache.insert(key, std::make_shared<const uint64_t>(key));
+
+        auto ops_per_sec = run(cache, threads, ops, num_keys, write_pct);
+        std::cout << "  " << threads << " threads: "
+                  << static_cast<uint64_t>(ops_per_sec) << " ops/sec"
+                  << std::endl;
+    }
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && (std::string{argv[1]} == "-h"
+                     || std::string{argv[1]} == "--help"))
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [max-threads] [ops-per-thread] [keys] [write-percent]"
+                  << std::endl;
+        return 1;
+    }
+
+    uint64_t max_threads = argc > 1 ? std::stoull(argv[1]) : 64;
+    uint64_t ops = argc > 2 ? std::stoull(argv[2]) : 1000000;
+    uint64_t num_keys = argc > 3 ? std::stoull(argv[3]) : 10000;
+    uint64_t write_pct = argc > 4 ? std::stoull(argv[4]) : 5;
+
+    bench<caching::locking_map<uint64_t, value_type>>(
+        "locking_map", max_threads, ops, num_keys, write_pct);
+    bench<caching::concurrent_map<uint64_t, value_type>>(
+        "concurrent_map", max_threads, ops, num_keys, write_pct);
+
+    // the cache is large enough that the warm-up does not evict
+    bench<caching::dblru_cache<uint64_t, value_type, caching::locking_map>>(
+        "dblru_cache<locking_map>", max_threads, ops, num_keys, write_pct,
+        num_keys * 2);
+    bench<caching::dblru_cache<uint64_t, value_type, caching::concurrent_map>>(
+        "dblru_cache<concurrent_map>", max_threads, ops, num_keys, write_pct,
+        num_keys * 2);
+
+    return 0;
+}
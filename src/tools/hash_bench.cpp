@@ -0,0 +1,151 @@
+/**
+ * @file hash_bench.cpp
+ * @author Chase Geigle
+ *
+ * Measures the throughput of the hash functions in meta/hashing on short
+ * strings like the tokens that are hashed into feature maps, and of
+ * hashing::hash_many against hashing the same keys one at a time.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "meta/hashing/hash.h"
+#include "meta/util/time.h"
+
+using namespace meta;
+
+namespace
+{
+
+/**
+ * Generates random lowercase strings with lengths in [min_len, max_len].
+ */
+std::vector<std::string> make_keys(uint64_t num_keys, uint64_t min_len,
+                                   uint64_t max_len)
+{
+    std::mt19937_64 rng{47};
+    std::uniform_int_distribution<uint64_t> len_dist{min_len, max_len};
+    std::uniform_int_distribution<int> char_dist{'a', 'z'};
+
+    std::vector<std::string> keys(num_keys);
+    for (auto& key : keys)
+    {
+        key.resize(len_dist(rng));
+        for (auto& c : key)
+            c = static_cast<char>(char_dist(rng));
+    }
+    return keys;
+}
+
+/**
+ * Hashes every key rounds times.
+ * @return the number of nanoseconds per key
+ */
+template <class Hash>
+double run(const Hash& hash, const std::vector<std::string>& keys,
+           uint64_t rounds)
+{
+    uint64_t sum = 0;
+    auto time = common::time<std::chrono::nanoseconds>([&]() {
+        for (uint64_t r = 0; r < rounds; ++r)
+            for (const auto& key : keys)
+                sum += hash(key);
+    });
+    // keep the hashes from being optimized away
+    if (sum == 1)
+        std::cout << sum;
+    return static_cast<double>(time.count()) / (keys.size() * rounds);
+}
+
+/**
+ * Hashes a key with a streaming hasher, without using any of the
+ * hasher's fast paths.
+ */
+template <class HashAlgorithm>
+struct streaming_hash
+{
+    uint64_t operator()(const std::string& key) const
+    {
+        HashAlgorithm h(47);
+        hashing::hash_append(h, key);
+        return static_cast<uint64_t>(h);
+    }
+};
+
+void bench_lengths(uint64_t num_keys, uint64_t rounds)
+{
+    std::cout << "ns/key (" << num_keys << " keys, cached)\n";
+    std::cout << "length\tfarm\tfarm-stream\tmetro\tmurmur\tstd::hash\n";
+
+    const std::vector<std::pair<uint64_t, uint64_t>> lengths
+        = {{1, 4}, {5, 8}, {9, 16}, {17, 24}, {25, 32}, {1, 32}};
+    for (const auto& range : lengths)
+    {
+        auto keys = make_keys(num_keys, range.first, range.second);
+        std::cout << range.first << "-" << range.second << "\t"
+                  << run(hashing::seeded_hash<hashing::farm_hash_seeded>{47},
+                         keys, rounds)
+                  << "\t"
+                  << run(streaming_hash<hashing::farm_hash_seeded>{}, keys,
+                         rounds)
+                  << "\t\t"
+                  << run(streaming_hash<hashing::metro_hash>{}, keys, rounds)
+                  << "\t"
+                  << run(streaming_hash<hashing::murmur_hash<>>{}, keys,
+                         rounds)
+                  << "\t" << run(std::hash<std::string>{}, keys, rounds)
+                  << "\n";
+    }
+}
+
+void bench_batch(uint64_t num_keys)
+{
+    // longer than the small string buffer, so each key's bytes are a
+    // separate allocation, and shuffled so they are visited out of order
+    auto keys = make_keys(num_keys, 17, 32);
+    std::mt19937_64 rng{47};
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    hashing::hash<> hash;
+    std::vector<uint64_t> hashes(keys.size());
+
+    auto one_at_a_time = common::time<std::chrono::nanoseconds>([&]() {
+        std::transform(keys.begin(), keys.end(), hashes.begin(), hash);
+    });
+    auto batched = common::time<std::chrono::nanoseconds>([&]() {
+        hashing::hash_many(hash, keys.begin(), keys.end(), hashes.begin());
+    });
+
+    std::cout << "\nns/key (" << num_keys << " keys, uncached)\n"
+              << "one at a time\t"
+              << static_cast<double>(one_at_a_time.count()) / keys.size()
+              << "\nhash_many\t"
+              << static_cast<double>(batched.count()) / keys.size() << "\n";
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && (std::string{argv[1]} == "-h"
+                     || std::string{argv[1]} == "--help"))
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [cached-keys] [rounds] [uncached-keys]" << std::endl;
+        return 1;
+    }
+
+    uint64_t cached_keys = argc > 1 ? std::stoull(argv[1]) : 10000;
+    uint64_t rounds = argc > 2 ? std::stoull(argv[2]) : 500;
+    uint64_t uncached_keys = argc > 3 ? std::stoull(argv[3]) : 4000000;
+
+    bench_lengths(cached_keys, rounds);
+    bench_batch(uncached_keys);
+
+    return 0;
+}
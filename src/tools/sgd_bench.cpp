@@ -0,0 +1,207 @@
+/**
+ * @file sgd_bench.cpp
+ * @author Chase Geigle
+ *
+ * Compares the training throughput and accuracy of learn::sgd_model when
+ * trained one instance at a time, on mini-batches, from a csr_dataset, and
+ * with averaging, on a binary libsvm-formatted corpus (or on a synthetic
+ * one if none is given).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "meta/io/libsvm_parser.h"
+#include "meta/learn/csr_dataset.h"
+#include "meta/learn/dataset.h"
+#include "meta/learn/loss/hinge.h"
+#include "meta/learn/sgd.h"
+#include "meta/util/time.h"
+
+using namespace meta;
+
+namespace
+{
+
+/**
+ * An instance of the corpus: its features and whether it is positive.
+ */
+struct example
+{
+    learn::feature_vector features;
+    bool label;
+
+    operator learn::feature_vector() const
+    {
+        return features;
+    }
+
+    operator bool() const
+    {
+        return label;
+    }
+};
+
+using dataset_type = learn::labeled_dataset<bool>;
+
+/**
+ * Reads a libsvm file, treating labels of 1 or +1 as positive and any
+ * others as negative.
+ */
+std::vector<example> read_libsvm(const std::string& path,
+                                 uint64_t& num_features)
+{
+    std::vector<example> examples;
+    std::ifstream in{path};
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (line.empty())
+            continue;
+        auto lbl = io::libsvm_parser::label(line);
+        auto counts = io::libsvm_parser::counts(line);
+        example ex{{counts.begin(), counts.end()},
+                   lbl == "1"_cl || lbl == "+1"_cl};
+        if (!ex.features.empty())
+            num_features = std::max<uint64_t>(
+                num_features, (ex.features.end() - 1)->first + 1);
+        examples.push_back(std::move(ex));
+    }
+    return examples;
+}
+
+/**
+ * Generates a corpus with skewed feature frequencies and labels from a
+ * random linear model.
+ */
+std::vector<example> make_synthetic(uint64_t num_docs, uint64_t num_features)
+{
+    std::mt19937_64 rng{47};
+    std::normal_distribution<double> normal;
+    std::vector<double> truth(num_features);
+    for (auto& w : truth)
+        w = normal(rng);
+
+    // skew the feature ids towards zero by cubing a uniform variate
+    std::uniform_real_distribution<double> uniform;
+    std::vector<example> examples(num_docs);
+    for (auto& ex : examples)
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            auto u = uniform(rng);
+            term_id id{static_cast<uint64_t>(u * u * u * num_features)};
+            ex.features[id] += 1;
+        }
+        auto score = 0.0;
+        for (const auto& pr : ex.features)
+            score += truth[pr.first] * pr.second;
+        ex.label = score > 0;
+    }
+    return examples;
+}
+
+/**
+ * Trains a model for a number of epochs with a training function.
+ */
+template <class TrainFunction>
+void run(const std::string& name, learn::sgd_model model,
+         const dataset_type& dset, uint64_t epochs, TrainFunction&& train)
+{
+    auto time = common::time<std::chrono::milliseconds>([&]() {
+        for (uint64_t i = 0; i < epochs; ++i)
+            train(model);
+    });
+
+    uint64_t correct = 0;
+    for (const auto& inst : dset)
+        correct += (model.predict(inst.weights) > 0) == dset.label(inst);
+
+    std::cout << name << "\t"
+              << static_cast<double>(time.count()) / epochs << "\t"
+              << static_cast<double>(correct) / dset.size() << "\n";
+}
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && (std::string{argv[1]} == "-h"
+                     || std::string{argv[1]} == "--help"))
+    {
+        std::cerr << "Usage: " << argv[0] << " [libsvm-file] [epochs]"
+                  << std::endl;
+        return 1;
+    }
+
+    uint64_t num_features = 0;
+    std::vector<example> examples;
+    if (argc > 1)
+    {
+        examples = read_libsvm(argv[1], num_features);
+    }
+    else
+    {
+        num_features = 1000000;
+        examples = make_synthetic(200000, num_features);
+    }
+    uint64_t epochs = argc > 2 ? std::stoul(argv[2]) : 5;
+
+    dataset_type dset{examples.begin(), examples.end(), num_features};
+    learn::csr_dataset csr{dset};
+    std::vector<int> labels;
+    for (const auto& inst : dset)
+        labels.push_back(dset.label(inst) ? +1 : -1);
+    auto labeler
+        = [&](const learn::instance& inst) { return labels[inst.id]; };
+
+    learn::loss::hinge loss;
+    learn::sgd_model::options_type averaged;
+    averaged.averaged = true;
+
+    std::cout << dset.size() << " instances, " << num_features
+              << " features, " << epochs << " epochs\n"
+              << "method\t\tms/epoch\ttrain accuracy\n";
+
+    run("train_one", learn::sgd_model{num_features}, dset, epochs,
+        [&](learn::sgd_model& model) {
+            for (const auto& inst : dset)
+                model.train_one(inst.weights, labeler(inst), loss);
+        });
+
+    for (uint64_t batch_size : {32, 256})
+    {
+        run("batch-" + std::to_string(batch_size),
+            learn::sgd_model{num_features}, dset, epochs,
+            [&](learn::sgd_model& model) {
+                for (auto it = dset.begin(); it != dset.end();)
+                {
+                    auto end = it + static_cast<std::ptrdiff_t>(std::min<
+                                        uint64_t>(batch_size, dset.end() - it));
+                    model.train_batch(it, end, loss, labeler);
+                    it = end;
+                }
+            });
+    }
+
+    run("csr-one", learn::sgd_model{num_features}, dset, epochs,
+        [&](learn::sgd_model& model) {
+            for (std::size_t i = 0; i < csr.size(); ++i)
+            {
+                auto inst = csr(i);
+                model.train_one(inst.weights, labels[inst.id], loss);
+            }
+        });
+
+    run("averaged", learn::sgd_model{num_features, averaged}, dset, epochs,
+        [&](learn::sgd_model& model) {
+            for (const auto& inst : dset)
+                model.train_one(inst.weights, labeler(inst), loss);
+        });
+
+    return 0;
+}
@@ -101,4 +101,66 @@ go_bandit([]() {
             check_analyzer_expected(*ana, doc, 93 + 159, 168 + 166);
         });
     });
+
+    describe("[analyzers]: batch analysis", [&]() {
+
+        it("should produce the same counts as analyze()", [&]() {
+            std::vector<corpus::document> docs;
+            docs.emplace_back(doc_id{0});
+            docs.back().content("one one two two two three four one five");
+            docs.emplace_back(doc_id{1});
+            docs.back().content(
+                filesystem::file_text("../data/sample-document.txt"));
+            docs.emplace_back(doc_id{2});
+            docs.back().content("two three three");
+
+            analyzers::ngram_word_analyzer ana{1, make_filter()};
+            parallel::thread_pool pool{2};
+            auto mat = analyzers::analyze_batch<uint64_t>(ana, docs, pool);
+
+            AssertThat(mat.rows(), Equals(docs.size()));
+            AssertThat(std::is_sorted(mat.vocabulary().begin(),
+                                      mat.vocabulary().end()),
+                       IsTrue());
+
+            uint64_t nnz = 0;
+            for (uint64_t row = 0; row < mat.rows(); ++row)
+            {
+                auto counts = ana.analyze<uint64_t>(docs[row]);
+                auto feats = mat.features(row);
+                auto vals = mat.values(row);
+                AssertThat(feats.size(), Equals(counts.size()));
+                AssertThat(std::is_sorted(feats.begin(), feats.end()),
+                           IsTrue());
+                for (uint64_t i = 0; i < feats.size(); ++i)
+                    AssertThat(vals[i],
+                               Equals(counts.at(mat.feature(feats[i]))));
+                nnz += feats.size();
+            }
+            AssertThat(mat.nnz(), Equals(nnz));
+        });
+
+        it("should reuse a feature buffer across documents", [&]() {
+            corpus::document first;
+            first.content(
+                filesystem::file_text("../data/sample-document.txt"));
+            corpus::document second;
+            second.content("two three three");
+
+            analyzers::ngram_word_analyzer ana{1, make_filter()};
+            analyzers::feature_buffer<uint64_t> buffer;
+            for (const auto& doc : {first, second, first}) {
+                ana.analyze(doc, buffer);
+                auto counts = ana.analyze<uint64_t>(doc);
+                AssertThat(buffer.size(), Equals(counts.size()));
+
+                std::string prev;
+                for (const auto& count : buffer) {
+                    AssertThat(count.first, IsGreaterThan(prev));
+                    AssertThat(count.second, Equals(counts.at(count.first)));
+                    prev = count.first;
+                }
+            }
+        });
+    });
 });
@@ -0,0 +1,145 @@
+/**
+ * @file caching_test.cpp
+ * @author Chase Geigle
+ */
+
+#include <memory>
+#include <vector>
+
+#include "bandit/bandit.h"
+#include "meta/caching/all.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace {
+
+struct sized_value {
+    uint64_t bytes;
+
+    uint64_t bytes_used() const {
+        return bytes;
+    }
+};
+}
+
+go_bandit([]() {
+
+    describe("[caching] default_weigher", []() {
+
+        it("should use bytes_used() when available", []() {
+            caching::default_weigher<sized_value> weigh;
+            AssertThat(weigh(sized_value{100}), Equals(100ul));
+        });
+
+        it("should weigh shared_ptrs by their pointee", []() {
+            caching::default_weigher<std::shared_ptr<sized_value>> weigh;
+            auto ptr = std::make_shared<sized_value>(sized_value{100});
+            AssertThat(weigh(ptr), Equals(100ul + sizeof(ptr)));
+        });
+
+        it("should fall back to sizeof", []() {
+            caching::default_weigher<uint64_t> weigh;
+            AssertThat(weigh(5), Equals(sizeof(uint64_t)));
+        });
+    });
+
+    describe("[caching] tinylfu_cache", []() {
+
+        using cache_type = caching::tinylfu_cache<uint64_t, sized_value>;
+
+        it("should stay within its byte budget", []() {
+            cache_type cache{1000};
+            for (uint64_t i = 0; i < 100; ++i) {
+                cache.find(i);
+                cache.insert(i, sized_value{100});
+                AssertThat(cache.bytes(), IsLessThanOrEqualTo(1000ul));
+            }
+            AssertThat(cache.size(), Equals(10ul));
+        });
+
+        it("should reject values larger than the cache", []() {
+            cache_type cache{1000};
+            cache.insert(1, sized_value{1001});
+            AssertThat(cache.size(), Equals(0ul));
+            AssertThat(cache.rejections(), Equals(1ul));
+        });
+
+        it("should keep frequent keys during a scan", []() {
+            cache_type cache{1000};
+            // ten hot keys that fill the cache, each requested many times
+            for (int round = 0; round < 5; ++round) {
+                for (uint64_t i = 0; i < 10; ++i) {
+                    if (!cache.find(i))
+                        cache.insert(i, sized_value{100});
+                }
+            }
+
+            // a scan over many keys, each requested once
+            for (uint64_t i = 1000; i < 2000; ++i) {
+                if (!cache.find(i))
+                    cache.insert(i, sized_value{100});
+            }
+
+            for (uint64_t i = 0; i < 10; ++i)
+                AssertThat(static_cast<bool>(cache.find(i)), IsTrue());
+            AssertThat(cache.rejections(), Equals(1000ul));
+            AssertThat(cache.evictions(), Equals(0ul));
+        });
+
+        it("should admit keys that become popular", []() {
+            cache_type cache{1000};
+            for (uint64_t i = 0; i < 10; ++i) {
+                cache.find(i);
+                cache.insert(i, sized_value{100});
+            }
+
+            // a large value needs several victims to be evicted
+            for (int round = 0; round < 5; ++round)
+                cache.find(42);
+            cache.insert(42, sized_value{250});
+
+            AssertThat(static_cast<bool>(cache.find(42)), IsTrue());
+            AssertThat(cache.evictions(), Equals(3ul));
+            AssertThat(cache.bytes(), Equals(950ul));
+        });
+
+        it("should replace the values of resident keys", []() {
+            cache_type cache{1000};
+            for (uint64_t i = 0; i < 10; ++i) {
+                cache.find(i);
+                cache.insert(i, sized_value{100});
+            }
+
+            // a larger value for a key that is already cached is not
+            // subject to admission; it evicts the least recent entries
+            cache.insert(9, sized_value{300});
+            AssertThat(cache.find(9)->bytes, Equals(300ul));
+            AssertThat(cache.rejections(), Equals(0ul));
+            AssertThat(cache.evictions(), Equals(2ul));
+            AssertThat(cache.bytes(), Equals(1000ul));
+            AssertThat(static_cast<bool>(cache.find(0)), IsFalse());
+
+            // a value too large for the cache leaves the old one in place
+            cache.insert(9, sized_value{1001});
+            AssertThat(cache.rejections(), Equals(1ul));
+            AssertThat(cache.find(9)->bytes, Equals(300ul));
+        });
+
+        it("should track its hit rate", []() {
+            cache_type cache{1000};
+            cache.insert(1, sized_value{10});
+            cache.find(1);
+            cache.find(1);
+            cache.find(1);
+            cache.find(2);
+            AssertThat(cache.hits(), Equals(3ul));
+            AssertThat(cache.misses(), Equals(1ul));
+            AssertThat(cache.hit_rate(), EqualsWithDelta(0.75, 1e-9));
+
+            cache.clear();
+            AssertThat(cache.size(), Equals(0ul));
+            AssertThat(cache.hits(), Equals(0ul));
+        });
+    });
+});
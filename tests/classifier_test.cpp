@@ -11,11 +11,57 @@
 #include "bandit/bandit.h"
 #include "classifier_test_helper.h"
 #include "cpptoml.h"
+#include "meta/classify/batch_training.h"
+#include "meta/classify/models/frozen_linear_model.h"
 
 using namespace bandit;
 using namespace meta;
 
 namespace {
+
+/**
+ * A ranker that ignores the query and returns the same (legal) results,
+ * best first, for every query.
+ */
+class fixed_ranker : public index::ranker {
+  public:
+    fixed_ranker(std::vector<index::search_result> results)
+        : results_{std::move(results)} {
+    }
+
+    void save(std::ostream&) const override {
+        throw std::logic_error{"fixed_ranker cannot be saved"};
+    }
+
+    std::vector<index::search_result>
+    rank(index::ranker_context&, uint64_t num_results,
+         const filter_function_type& filter) override {
+        std::vector<index::search_result> results;
+        for (const auto& result : results_) {
+            if (results.size() < num_results && filter(result.d_id))
+                results.push_back(result);
+        }
+        return results;
+    }
+
+  private:
+    std::vector<index::search_result> results_;
+};
+
+/**
+ * @return the first two documents in the index with the given label, or
+ * (if other is true) with any other label
+ */
+std::vector<doc_id> find_docs(index::inverted_index& idx,
+                              const class_label& label, bool other) {
+    std::vector<doc_id> ids;
+    for (doc_id d_id{0}; d_id < idx.num_docs() && ids.size() < 2; ++d_id) {
+        if ((idx.label(d_id) == label) != other)
+            ids.push_back(d_id);
+    }
+    return ids;
+}
+
 void run_tests(const std::string& index_type) {
 
     using namespace classify;
@@ -37,6 +83,21 @@ void run_tests(const std::string& index_type) {
             check_cv(f_idx, *cfg, 0.95);
         });
 
+        it("should cross-validate the same with concurrent folds", [&]() {
+            auto table = cpptoml::make_table();
+            table->insert("method", naive_bayes::id.to_string());
+            const cpptoml::table& cfg = *table;
+
+            multiclass_dataset dataset{f_idx};
+            multiclass_dataset_view mcdv{dataset, std::mt19937_64{47}};
+            auto serial = cross_validate(cfg, mcdv, 5);
+            auto concurrent = cross_validate(cfg, mcdv, 5, false, 3);
+
+            AssertThat(concurrent.accuracy(), Equals(serial.accuracy()));
+            AssertThat(concurrent.fold_accuracy(),
+                       Equals(serial.fold_accuracy()));
+        });
+
         it("should create naive-bayes classifier with train/test split", [&]() {
             auto cfg = cpptoml::make_table();
             cfg->insert("method", naive_bayes::id.to_string());
@@ -57,6 +118,61 @@ void run_tests(const std::string& index_type) {
             }, 0.89);
         });
 
+        it("should sum fractional knn votes when weighted", [&]() {
+            auto label = i_idx->label(doc_id{0});
+            auto xs = find_docs(*i_idx, label, false);
+            auto ys = find_docs(*i_idx, label, true);
+            auto other = i_idx->label(ys[0]);
+
+            // the two lower scores outweigh the higher one, but not if
+            // each vote were truncated to an integer
+            multiclass_dataset dataset{f_idx};
+            knn cls{multiclass_dataset_view{dataset}, i_idx, 3,
+                    make_unique<fixed_ranker>(
+                        std::vector<index::search_result>{
+                            {ys[0], 1.1f}, {xs[0], 0.9f}, {xs[1], 0.9f}}),
+                    true};
+            AssertThat(cls.classify(learn::feature_vector{}), Equals(label));
+
+            // and a high enough score outweighs them both
+            knn outweighed{multiclass_dataset_view{dataset}, i_idx, 3,
+                           make_unique<fixed_ranker>(
+                               std::vector<index::search_result>{
+                                   {ys[0], 2.5f}, {xs[0], 1.0f},
+                                   {xs[1], 1.0f}}),
+                           true};
+            AssertThat(outweighed.classify(learn::feature_vector{}),
+                       Equals(other));
+        });
+
+        it("should break knn ties by the best-ranked neighbor", [&]() {
+            auto label = i_idx->label(doc_id{0});
+            auto xs = find_docs(*i_idx, label, false);
+            auto ys = find_docs(*i_idx, label, true);
+            auto other = i_idx->label(ys[0]);
+
+            multiclass_dataset dataset{f_idx};
+            for (bool weighted : {false, true}) {
+                knn x_first{multiclass_dataset_view{dataset}, i_idx, 4,
+                            make_unique<fixed_ranker>(
+                                std::vector<index::search_result>{
+                                    {xs[0], 2.0f}, {ys[0], 2.0f},
+                                    {ys[1], 1.0f}, {xs[1], 1.0f}}),
+                            weighted};
+                AssertThat(x_first.classify(learn::feature_vector{}),
+                           Equals(label));
+
+                knn y_first{multiclass_dataset_view{dataset}, i_idx, 4,
+                            make_unique<fixed_ranker>(
+                                std::vector<index::search_result>{
+                                    {ys[0], 2.0f}, {xs[0], 2.0f},
+                                    {xs[1], 1.0f}, {ys[1], 1.0f}}),
+                            weighted};
+                AssertThat(y_first.classify(learn::feature_vector{}),
+                           Equals(other));
+            }
+        });
+
         it("should create nearest centroid classifier with CV", [&]() {
             check_cv(f_idx, [&](multiclass_dataset_view docs) {
                 return make_unique<nearest_centroid>(std::move(docs), i_idx);
@@ -70,6 +186,33 @@ void run_tests(const std::string& index_type) {
                    return make_unique<nearest_centroid>(std::move(docs), i_idx);
                }, 0.85);
            });
+
+        it("should train the same from a compact dataset", [&]() {
+            // load every other document straight from the index, without
+            // building a multiclass_dataset for them
+            std::vector<doc_id> ids;
+            for (uint64_t d_id = 0; d_id < f_idx->num_docs(); d_id += 2)
+                ids.emplace_back(d_id);
+            multiclass_csr_dataset csr{f_idx, ids.begin(), ids.end(),
+                                       [&](doc_id d_id) {
+                                           return f_idx->label(d_id);
+                                       }};
+            multiclass_dataset dataset{f_idx, ids};
+
+            naive_bayes expected_nb{multiclass_dataset_view{dataset}};
+            naive_bayes actual_nb{multiclass_csr_view{csr}};
+            nearest_centroid expected_nc{multiclass_dataset_view{dataset},
+                                         i_idx};
+            nearest_centroid actual_nc{multiclass_csr_view{csr}, i_idx};
+
+            multiclass_dataset all{f_idx};
+            for (const auto& inst : all) {
+                AssertThat(actual_nb.classify(inst.weights),
+                           Equals(expected_nb.classify(inst.weights)));
+                AssertThat(actual_nc.classify(inst.weights),
+                           Equals(expected_nc.classify(inst.weights)));
+            }
+        });
     });
 
     describe_msg
@@ -136,6 +279,37 @@ void run_tests(const std::string& index_type) {
         hinge_base_cfg->erase("l2-regularization");
         hinge_base_cfg->erase("l1-regularization");
 
+        // lock-free parallel training should be about as accurate as the
+        // serial trainer above
+        hinge_base_cfg->insert("train-threads", 4);
+        perc_base_cfg->insert("train-threads", 4);
+
+        it("should run one-vs-all using parallel SGD with CV", [&]() {
+            check_cv(f_idx, *hinge_sgd_cfg, 0.93);
+            check_cv(f_idx, *perc_sgd_cfg, 0.92);
+        });
+
+        it("should run one-vs-all using parallel SGD with train/test split",
+           [&]() {
+               check_split(f_idx, *hinge_sgd_cfg, 0.90);
+               check_split(f_idx, *perc_sgd_cfg, 0.89);
+           });
+
+        hinge_base_cfg->erase("train-threads");
+        perc_base_cfg->erase("train-threads");
+
+        it("should run one-vs-all using mini-batch SGD with CV", [&]() {
+            hinge_base_cfg->insert("batch-size", 32);
+            check_cv(f_idx, *hinge_sgd_cfg, 0.93);
+            hinge_base_cfg->erase("batch-size");
+        });
+
+        it("should run one-vs-all using averaged SGD with CV", [&]() {
+            hinge_base_cfg->insert("averaged", true);
+            check_cv(f_idx, *hinge_sgd_cfg, 0.93);
+            hinge_base_cfg->erase("averaged");
+        });
+
         it("should run one-vs-one using SGD with CV", [&]() {
             check_cv(f_idx, *hinge_sgd_ovo, 0.93);
             check_cv(f_idx, *perc_sgd_ovo, 0.91);
@@ -176,6 +350,27 @@ void run_tests(const std::string& index_type) {
         });
     });
 
+    describe("[classifier] linear SVM", [&]() {
+        // the same solver liblinear uses, so it should do about as well as
+        // the SVM wrapper below
+        auto svm_cfg = cpptoml::make_table();
+        svm_cfg->insert("method", one_vs_all::id.to_string());
+        auto svm_base_cfg = cpptoml::make_table();
+        svm_base_cfg->insert("method", linear_svm::id.to_string());
+        svm_cfg->insert("base", svm_base_cfg);
+
+        it("should run with CV", [&]() { check_cv(f_idx, *svm_cfg, 0.93); });
+
+        it("should run with train/test split",
+           [&]() { check_split(f_idx, *svm_cfg, 0.87); });
+
+        it("should run with the L1 loss", [&]() {
+            svm_base_cfg->insert("loss", "l1");
+            check_cv(f_idx, *svm_cfg, 0.93);
+            svm_base_cfg->erase("loss");
+        });
+    });
+
     describe("[classifier] SVM wrapper", [&]() {
         auto svm_cfg = cpptoml::make_table();
         svm_cfg->insert("method", svm_wrapper::id.to_string());
@@ -263,6 +458,15 @@ go_bandit([]() {
             tests::run_save_load_single(f_idx, *cfg, 0.86);
         });
 
+        it("should save and load linear SVM models", [&]() {
+            auto cfg = cpptoml::make_table();
+            cfg->insert("method", one_vs_all::id.to_string());
+            auto base_cfg = cpptoml::make_table();
+            base_cfg->insert("method", linear_svm::id.to_string());
+            cfg->insert("base", base_cfg);
+            tests::run_save_load_single(f_idx, *cfg, 0.87);
+        });
+
         it("should save and SVM wrapper models", [&]() {
             auto cfg = cpptoml::make_table();
             cfg->insert("method", svm_wrapper::id.to_string());
@@ -274,8 +478,167 @@ go_bandit([]() {
         });
     });
 
+    describe("[classifier] streaming datasets", [&]() {
+        using namespace classify;
+
+        auto line_cfg = tests::create_config("line");
+        auto f_idx = index::make_index<index::forward_index>(*line_cfg);
+        auto docs = f_idx->docs();
+
+        it("should read every document once per pass", [&]() {
+            multiclass_dataset full{f_idx};
+            auto data = make_streaming_dataset(f_idx, docs, 100);
+            AssertThat(data->num_batches(), Equals(11ul));
+
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                data->shuffle();
+                uint64_t num_docs = 0;
+                double total_weight = 0;
+                while (auto batch = data->next())
+                {
+                    AssertThat(batch->size(), IsLessThanOrEqualTo(100ul));
+                    num_docs += batch->size();
+                    for (const auto& inst : *batch)
+                        for (const auto& pr : inst.weights)
+                            total_weight += pr.second;
+                }
+                AssertThat(num_docs, Equals(full.size()));
+
+                double expected = 0;
+                for (const auto& inst : full)
+                    for (const auto& pr : inst.weights)
+                        expected += pr.second;
+                AssertThat(total_weight, EqualsWithDelta(expected, 1e-6));
+            }
+        });
+
+        it("should train online classifiers in batches", [&]() {
+            auto hinge_sgd_cfg = cpptoml::make_table();
+            hinge_sgd_cfg->insert("method", one_vs_all::id.to_string());
+            auto hinge_base_cfg = cpptoml::make_table();
+            hinge_base_cfg->insert("method", sgd::id.to_string());
+            hinge_base_cfg->insert("loss", learn::loss::hinge::id.to_string());
+            hinge_sgd_cfg->insert("base", hinge_base_cfg);
+
+            auto none = util::range(0_did, 0_did);
+            multiclass_dataset empty{f_idx, none.end(), none.end()};
+            auto cls = make_classifier(*hinge_sgd_cfg, empty);
+            auto online = dynamic_cast<online_classifier*>(cls.get());
+            AssertThat(online, Is().Not().EqualTo(nullptr));
+
+            // documents are ordered by class, so the test set is drawn at
+            // random and the blocks of training documents are shuffled
+            // for the batches to be representative
+            auto shuffled = docs;
+            std::mt19937_64 rng{47};
+            random::shuffle(shuffled.begin(), shuffled.end(), rng);
+            auto split = shuffled.begin()
+                         + static_cast<std::ptrdiff_t>(shuffled.size() / 8);
+            std::vector<doc_id> test_set{shuffled.begin(), split};
+            std::vector<doc_id> training_set{split, shuffled.end()};
+            std::sort(training_set.begin(), training_set.end());
+            learn::streaming_dataset<multiclass_dataset> data{
+                training_set, 100,
+                [&](std::vector<doc_id>::const_iterator begin,
+                    std::vector<doc_id>::const_iterator end) {
+                    return multiclass_dataset{f_idx, begin, end,
+                                              printing::no_progress_trait{}};
+                },
+                16};
+            for (int epoch = 0; epoch < 3; ++epoch)
+            {
+                data.shuffle();
+                batch_train(*online, data);
+            }
+
+            multiclass_dataset test_data{f_idx, test_set.begin(),
+                                         test_set.end()};
+            AssertThat(cls->test(test_data).accuracy(), IsGreaterThan(0.80));
+        });
+    });
+
     filesystem::remove_all("ceeaus");
 
+    describe("[classifier] frozen linear model", [&]() {
+        using model_type = classify::linear_model<std::string, float, label_id>;
+
+        // a model where some features have weights for most classes and
+        // the rest only have a few
+        model_type model;
+        std::mt19937_64 rng{47};
+        std::uniform_real_distribution<float> weight_dist{-1, 1};
+        for (uint32_t f = 0; f < 200; ++f) {
+            auto num_classes = f % 10 == 0 ? 40u : 1 + f % 3;
+            for (uint32_t c = 0; c < num_classes; ++c)
+                model.update(label_id{(f * 7 + c * 13) % 50},
+                             "f" + std::to_string(f), weight_dist(rng));
+        }
+
+        classify::frozen_linear_model<std::string, float, label_id> frozen{
+            model};
+
+        it("should store dense and sparse features", [&]() {
+            AssertThat(frozen.num_features(), Equals(200ul));
+            AssertThat(frozen.num_classes(), Equals(50ul));
+            AssertThat(frozen.num_dense_features(), Equals(20ul));
+        });
+
+        it("should score like the model it was built from", [&]() {
+            std::uniform_int_distribution<uint32_t> feat_dist{0, 250};
+            auto even = [](label_id lbl) { return lbl % 2 == 0; };
+            for (int i = 0; i < 200; ++i) {
+                std::unordered_map<std::string, float> features;
+                for (int j = 0; j < 10; ++j)
+                    features["f" + std::to_string(feat_dist(rng))]
+                        = weight_dist(rng);
+
+                AssertThat(frozen.best_class(features),
+                           Equals(model.best_class(features)));
+                AssertThat(frozen.best_class(features, even),
+                           Equals(model.best_class(features, even)));
+
+                auto expected = model.best_classes(features, 5, even);
+                auto actual = frozen.best_classes(features, 5, even);
+                AssertThat(actual.size(), Equals(expected.size()));
+                for (std::size_t k = 0; k < actual.size(); ++k) {
+                    AssertThat(actual[k].first, Equals(expected[k].first));
+                    AssertThat(actual[k].second, Equals(expected[k].second));
+                }
+            }
+        });
+
+        it("should convert back to the model it was built from", [&]() {
+            auto thawed = frozen.to_linear_model();
+            AssertThat(thawed.weights().size(), Equals(model.weights().size()));
+            for (const auto& feat_vec : model.weights()) {
+                const auto& weights = thawed.weights().at(feat_vec.first);
+                AssertThat(weights.size(), Equals(feat_vec.second.size()));
+                for (const auto& weight : feat_vec.second)
+                    AssertThat(weights.at(weight.first),
+                               Equals(weight.second));
+            }
+        });
+
+        it("should score nothing with an empty model", [&]() {
+            // a feature with no weights for any class
+            model_type::weight_vectors updates;
+            updates["f0"];
+            model_type empty;
+            empty.update(updates);
+
+            classify::frozen_linear_model<std::string, float, label_id>
+                frozen_empty{empty};
+            AssertThat(frozen_empty.empty(), IsTrue());
+
+            std::unordered_map<std::string, float> features{{"f0", 1.0f}};
+            AssertThat(frozen_empty.best_class(features),
+                       Equals(empty.best_class(features)));
+            AssertThat(frozen_empty.best_classes(features, 5).empty(),
+                       IsTrue());
+        });
+    });
+
     describe("[classifier] confusion matrix", [&]() {
 
         // We have 3 classes {A, B, C} and get the following predictions:
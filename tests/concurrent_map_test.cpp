@@ -0,0 +1,190 @@
+/**
+ * @file concurrent_map_test.cpp
+ * @author Chase Geigle
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "bandit/bandit.h"
+#include "meta/caching/dblru_cache.h"
+#include "meta/caching/maps/concurrent_map.h"
+
+using namespace bandit;
+using namespace meta;
+
+go_bandit([]() {
+
+    describe("[caching] concurrent_map", []() {
+
+        it("should insert, find, and erase keys", []()
+           {
+               caching::concurrent_map<uint64_t, uint64_t> map;
+               AssertThat(map.size(), Equals(0ul));
+               AssertThat(static_cast<bool>(map.find(1)), IsFalse());
+               AssertThat(map.erase(1), IsFalse());
+
+               map.insert(1, 10);
+               map.insert(2, 20);
+               AssertThat(map.size(), Equals(2ul));
+               AssertThat(*map.find(1), Equals(10ul));
+               AssertThat(*map.find(2), Equals(20ul));
+
+               // insert replaces, emplace does not
+               map.insert(1, 11);
+               map.emplace(2, 21);
+               AssertThat(map.size(), Equals(2ul));
+               AssertThat(*map.find(1), Equals(11ul));
+               AssertThat(*map.find(2), Equals(20ul));
+
+               AssertThat(map.erase(1), IsTrue());
+               AssertThat(map.erase(1), IsFalse());
+               AssertThat(static_cast<bool>(map.find(1)), IsFalse());
+               AssertThat(*map.find(2), Equals(20ul));
+               AssertThat(map.size(), Equals(1ul));
+
+               map.insert(1, 12);
+               AssertThat(*map.find(1), Equals(12ul));
+               AssertThat(map.size(), Equals(2ul));
+           });
+
+        it("should find keys past erased ones as it grows", []()
+           {
+               // a single stripe puts every key in the same table
+               caching::concurrent_map<uint64_t, uint64_t> map{1};
+               AssertThat(map.num_stripes(), Equals(1ul));
+
+               const uint64_t num_keys = 10000;
+               for (uint64_t i = 0; i < num_keys; ++i)
+                   map.insert(i, i * 2);
+               for (uint64_t i = 0; i < num_keys; i += 2)
+                   AssertThat(map.erase(i), IsTrue());
+               AssertThat(map.size(), Equals(num_keys / 2));
+
+               for (uint64_t i = 0; i < num_keys; ++i)
+               {
+                   auto val = map.find(i);
+                   AssertThat(static_cast<bool>(val), Equals(i % 2 == 1));
+                   if (val)
+                       AssertThat(*val, Equals(i * 2));
+               }
+
+               // reuse the erased slots
+               for (uint64_t i = 0; i < num_keys; i += 2)
+                   map.insert(i, i * 3);
+               for (uint64_t i = 0; i < num_keys; ++i)
+                   AssertThat(*map.find(i), Equals(i * (i % 2 == 0 ? 3 : 2)));
+           });
+
+        it("should round the number of stripes up to a power of two", []()
+           {
+               AssertThat(
+                   (caching::concurrent_map<uint64_t, uint64_t>{5}.num_stripes()),
+                   Equals(8ul));
+               AssertThat(
+                   (caching::concurrent_map<uint64_t, uint64_t>{0}.num_stripes()),
+                   Equals(1ul));
+           });
+
+        it("should be safe to use from several threads", []()
+           {
+               caching::concurrent_map<uint64_t, uint64_t> map{4};
+               const uint64_t num_threads = 4;
+               const uint64_t keys_per_thread = 5000;
+               std::atomic<uint64_t> bad_values{0};
+
+               const uint64_t num_keys = num_threads * keys_per_thread;
+               auto worker = [&](uint64_t first)
+               {
+                   for (auto k = first; k < first + keys_per_thread; ++k)
+                   {
+                       map.insert(k, k * 2);
+                       // churn the nodes that readers may be looking at
+                       if (k % 3 == 0)
+                       {
+                           map.erase(k);
+                           map.insert(k, k * 2);
+                       }
+                       auto other = (k * 7919) % num_keys;
+                       auto val = map.find(other);
+                       if (val && *val != other * 2)
+                           ++bad_values;
+                   }
+               };
+
+               std::vector<std::thread> threads;
+               for (uint64_t t = 0; t < num_threads; ++t)
+                   threads.emplace_back(worker, t * keys_per_thread);
+               for (auto& thread : threads)
+                   thread.join();
+
+               AssertThat(bad_values.load(), Equals(0ul));
+               AssertThat(map.size(), Equals(num_keys));
+               for (uint64_t k = 0; k < num_keys; ++k)
+                   AssertThat(*map.find(k), Equals(k * 2));
+           });
+    });
+
+    describe("[caching] concurrent_map reclamation", []() {
+
+        it("should free retired nodes while reads continue", []()
+           {
+               caching::concurrent_map<uint64_t, uint64_t> map{1};
+               map.insert(0, 0);
+
+               // readers that never pause, all on the only stripe
+               const uint64_t num_readers = 3;
+               std::atomic<bool> done{false};
+               std::vector<std::atomic<uint64_t>> reads(num_readers);
+               std::vector<std::thread> threads;
+               for (uint64_t t = 0; t < num_readers; ++t)
+               {
+                   reads[t].store(0);
+                   threads.emplace_back([&, t]()
+                                        {
+                                            while (!done.load())
+                                            {
+                                                map.find(0);
+                                                ++reads[t];
+                                            }
+                                        });
+               }
+
+               // every replacement retires the old node
+               for (uint64_t i = 1; i <= 10000; ++i)
+                   map.insert(0, i);
+
+               // once every reader has started a new read, only the last
+               // node retired can still be in use
+               std::vector<uint64_t> seen(num_readers);
+               for (uint64_t t = 0; t < num_readers; ++t)
+                   seen[t] = reads[t].load();
+               for (uint64_t t = 0; t < num_readers; ++t)
+               {
+                   while (reads[t].load() < seen[t] + 2)
+                       std::this_thread::yield();
+               }
+               map.insert(0, 10001);
+               AssertThat(map.num_retired(), IsLessThanOrEqualTo(1ul));
+
+               done.store(true);
+               for (auto& thread : threads)
+                   thread.join();
+               AssertThat(*map.find(0), Equals(10001ul));
+           });
+    });
+
+    describe("[caching] dblru_cache with concurrent_map", []() {
+
+        it("should keep recently used values", []()
+           {
+               caching::dblru_cache<uint64_t, uint64_t> cache{100};
+               for (uint64_t i = 0; i < 1000; ++i)
+               {
+                   cache.insert(i, i + 1);
+                   AssertThat(*cache.find(i), Equals(i + 1));
+               }
+           });
+    });
+});
@@ -0,0 +1,150 @@
+/**
+ * @file csr_dataset_test.cpp
+ * @author Chase Geigle
+ */
+
+#include <algorithm>
+#include <numeric>
+
+#include "bandit/bandit.h"
+#include "learn_test_helper.h"
+#include "meta/classify/binary_dataset_view.h"
+#include "meta/classify/classifier/sgd.h"
+#include "meta/learn/csr_dataset.h"
+#include "meta/learn/loss/hinge.h"
+#include "meta/learn/sgd.h"
+
+using namespace bandit;
+using namespace meta;
+
+go_bandit([]() {
+
+    describe("[learn] csr_dataset", []() {
+
+        auto vectors = tests::make_vectors(500, 1000);
+        learn::dataset dset{vectors.begin(), vectors.end(), 1000};
+
+        it("should store the same features as a dataset", [&]() {
+            learn::csr_dataset csr{dset};
+            AssertThat(csr.size(), Equals(dset.size()));
+            AssertThat(csr.total_features(), Equals(dset.total_features()));
+
+            uint64_t nonzeros = 0;
+            for (std::size_t i = 0; i < dset.size(); ++i) {
+                auto inst = csr(i);
+                AssertThat(inst.id, Equals(dset(i).id));
+                AssertThat(inst.weights.size(), Equals(dset(i).weights.size()));
+                nonzeros += inst.weights.size();
+
+                auto it = dset(i).weights.begin();
+                for (const auto& pr : inst.weights) {
+                    AssertThat(pr.first, Equals(it->first));
+                    AssertThat(pr.second, Equals(it->second));
+                    ++it;
+                }
+            }
+            AssertThat(csr.num_nonzeros(), Equals(nonzeros));
+            AssertThat(csr.bytes_used(),
+                       IsLessThan(nonzeros * sizeof(std::pair<term_id, double>)));
+        });
+
+        it("should round and saturate quantized weights", [&]() {
+            std::vector<learn::feature_vector> big(1);
+            big[0].emplace_back(0_tid, 2.4);
+            big[0].emplace_back(1_tid, 2.6);
+            big[0].emplace_back(2_tid, 1e6);
+            learn::dataset big_dset{big.begin(), big.end(), 3};
+
+            learn::basic_csr_dataset<uint16_t> csr{big_dset};
+            auto weights = csr(0).weights.to_feature_vector();
+            AssertThat(weights.at(0_tid), Equals(2.0));
+            AssertThat(weights.at(1_tid), Equals(3.0));
+            AssertThat(weights.at(2_tid), Equals(65535.0));
+        });
+
+        it("should visit every instance from a shuffled view", [&]() {
+            learn::csr_dataset csr{dset};
+            learn::csr_dataset_view<learn::csr_dataset> view{csr};
+            view.shuffle();
+
+            std::vector<bool> seen(csr.size(), false);
+            for (const auto& inst : view) {
+                AssertThat(seen[inst.id], IsFalse());
+                seen[inst.id] = true;
+            }
+            AssertThat(std::count(seen.begin(), seen.end(), true),
+                       Equals(static_cast<long>(csr.size())));
+        });
+
+        it("should train sgd like the dataset it was made from", [&]() {
+            auto labels = tests::make_labels(vectors, 1000);
+            auto labeler = [&](learn::instance_id id) { return labels[id]; };
+
+            learn::csr_dataset csr{dset};
+            learn::loss::hinge loss;
+            learn::sgd_model expected{1000};
+            learn::sgd_model actual{1000};
+            for (std::size_t i = 0; i < dset.size(); ++i) {
+                expected.train_one(dset(i).weights, labeler(dset(i).id), loss);
+                actual.train_one(csr(i).weights, labeler(csr(i).id), loss);
+            }
+
+            for (std::size_t i = 0; i < dset.size(); ++i)
+                AssertThat(actual.predict(csr(i).weights),
+                           EqualsWithDelta(expected.predict(dset(i).weights),
+                                           1e-9));
+        });
+
+        it("should train the sgd classifier from a compact view", [&]() {
+            // enough instances that more than one thread is used
+            auto train_vectors = tests::make_vectors(2000, 1000);
+            auto labels = tests::make_labels(train_vectors, 1000);
+            std::vector<std::size_t> ids(train_vectors.size());
+            std::iota(ids.begin(), ids.end(), 0);
+            classify::binary_dataset bdset{
+                ids.begin(), ids.end(), 1000,
+                [&](std::size_t id) { return train_vectors[id]; },
+                [&](std::size_t id) { return labels[id] > 0; }};
+            classify::binary_csr_dataset csr{bdset};
+            classify::binary_csr_view view{csr};
+            for (const auto& inst : view)
+                AssertThat(view.label(inst), Equals(labels[inst.id] > 0));
+
+            // subset views see the same instances as the range they copy
+            classify::binary_csr_view half{view, view.begin() + 500,
+                                           view.begin() + 1500};
+            AssertThat(half.size(), Equals(1000ul));
+            AssertThat((*half.begin()).id, Equals(view.begin()[500].id));
+
+            auto check = [&](const classify::sgd& model) {
+                uint64_t true_positives = 0;
+                uint64_t true_negatives = 0;
+                for (const auto& inst : bdset) {
+                    auto predicted = model.predict(inst.weights) > 0;
+                    if (bdset.label(inst))
+                        true_positives += predicted;
+                    else
+                        true_negatives += !predicted;
+                }
+                AssertThat(true_positives, IsGreaterThan(900ul));
+                AssertThat(true_negatives, IsGreaterThan(900ul));
+            };
+
+            for (std::size_t threads : {1, 2}) {
+                check(classify::sgd{view, make_unique<learn::loss::hinge>(),
+                                    {},
+                                    1e-3,
+                                    20,
+                                    false,
+                                    threads});
+            }
+            check(classify::sgd{view, make_unique<learn::loss::hinge>(), {},
+                                1e-3, 20, true});
+
+            classify::binary_dataset_view bdv{bdset, std::mt19937_64{47}};
+            parallel::thread_pool pool{2};
+            check(classify::sgd{bdv, make_unique<learn::loss::hinge>(), {},
+                                pool, 1e-3, 20});
+        });
+    });
+});
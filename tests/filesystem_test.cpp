@@ -8,6 +8,7 @@
 
 #include "bandit/bandit.h"
 #include "meta/io/filesystem.h"
+#include "meta/io/mmap_file.h"
 
 using namespace bandit;
 using namespace meta;
@@ -41,4 +42,58 @@ go_bandit([]() {
 
         filesystem::delete_file(filename);
     });
+
+    describe("[filesystem] mmap_file", []() {
+        const std::string filename{"mmap-temp.txt"};
+        const std::string data = "this file is memory mapped\n";
+        {
+            std::ofstream file{filename, std::ios::binary};
+            file.write(data.c_str(),
+                       static_cast<std::streamsize>(data.length()));
+        }
+
+        auto check_mapping = [&](const io::mmap_options& options) {
+            io::mmap_file file{filename, options};
+            AssertThat(file.size(), Equals(data.length()));
+            AssertThat(std::string(file.begin(), file.size()), Equals(data));
+        };
+
+        it("should map files with each access pattern", [&]() {
+            io::mmap_options options;
+            for (auto access :
+                 {io::access_pattern::normal, io::access_pattern::sequential,
+                  io::access_pattern::random}) {
+                options.access = access;
+                check_mapping(options);
+            }
+        });
+
+        it("should map files with their pages populated", [&]() {
+            io::mmap_options options;
+            options.populate = true;
+            check_mapping(options);
+        });
+
+        it("should map files with huge pages requested", [&]() {
+            io::mmap_options options;
+            options.huge_pages = true;
+            check_mapping(options);
+        });
+
+        it("should lock files or fail to map them", [&]() {
+            io::mmap_options options;
+            options.access = io::access_pattern::random;
+            options.populate = true;
+            options.lock = true;
+            // whether mlock() succeeds depends on RLIMIT_MEMLOCK, but a
+            // failure must be reported rather than ignored
+            try {
+                check_mapping(options);
+            } catch (const io::mmap_file_exception&) {
+                // the limit was too low
+            }
+        });
+
+        filesystem::delete_file(filename);
+    });
 });
@@ -222,6 +222,11 @@ go_bandit([]() {
             doc.content(text);
             AssertThrows(index::forward_index_exception, idx->tokenize(doc));
         });
+
+        it("should not search terms by prefix", [&]() {
+            auto idx = index::make_index<index::forward_index>(*svm_cfg);
+            AssertThrows(index::disk_index_exception, idx->prefix_terms("a"));
+        });
     });
 
     describe("[forward-index] with zlib", []() {
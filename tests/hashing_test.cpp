@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "bandit/bandit.h"
+#include "meta/hashing/blocked_bloom_filter.h"
 #include "meta/hashing/probe_map.h"
 #include "meta/hashing/probe_set.h"
 #include "meta/io/filesystem.h"
@@ -258,6 +259,37 @@ go_bandit([]() {
     describe("[hashing] farm_hash x64", []() {
         it("should match test vectors from FarmHash",
            []() { farm_hash_self_test(); });
+
+        it("should hash whole strings the same as streaming", []() {
+            std::string key;
+            for (uint64_t len = 0; len <= 100; ++len) {
+                for (uint64_t seed : {0ul, 47ul}) {
+                    hashing::farm_hash_seeded streaming{seed};
+                    hash_append(streaming, key);
+                    auto expected = static_cast<uint64_t>(streaming);
+
+                    hashing::seeded_hash<hashing::farm_hash_seeded> hash{
+                        seed};
+                    AssertThat(hash(key), Equals(expected));
+                    AssertThat(hash(util::string_view{key}), Equals(expected));
+                }
+                key.push_back(static_cast<char>('a' + len % 26));
+            }
+        });
+
+        it("should hash many keys the same as one at a time", []() {
+            std::vector<std::string> keys;
+            for (uint64_t i = 0; i < 100; ++i)
+                keys.push_back("key-" + std::to_string(i * i));
+
+            hashing::hash<> hash;
+            std::vector<uint64_t> hashes(keys.size());
+            auto end = hashing::hash_many(hash, keys.begin(), keys.end(),
+                                          hashes.begin());
+            AssertThat(end == hashes.end(), IsTrue());
+            for (uint64_t i = 0; i < keys.size(); ++i)
+                AssertThat(hashes[i], Equals(hash(keys[i])));
+        });
     });
 
     describe("[hashing] ints", []() {
@@ -299,6 +331,11 @@ go_bandit([]() {
             count_unique(set, numbers);
         });
 
+        it("should use group probing (probe_set)", [&]() {
+            hashing::probe_set<uint64_t, group> set;
+            count_unique(set, numbers);
+        });
+
         it("should use linear probing (probe_map)", [&]() {
             hashing::probe_map<uint64_t, uint64_t, linear> map;
             count(map, numbers);
@@ -327,6 +364,18 @@ go_bandit([]() {
             map.resize_ratio(2.0);
             count(map, numbers);
         });
+
+        it("should use group probing (probe_map)", [&]() {
+            hashing::probe_map<uint64_t, uint64_t, group> map;
+            count(map, numbers);
+        });
+
+        it("should only store control bytes for group probing", [&]() {
+            using group_map = hashing::probe_map<uint64_t, uint64_t, group>;
+            using binary_map = hashing::probe_map<uint64_t, uint64_t, binary>;
+            AssertThat(sizeof(group_map) - sizeof(binary_map),
+                       Equals(sizeof(hashing::control_bytes<group>)));
+        });
     });
 
     describe("[hashing] strings", []() {
@@ -367,6 +416,11 @@ go_bandit([]() {
             count_unique(set, tokens);
         });
 
+        it("should use group probing (probe_set)", [&]() {
+            hashing::probe_set<std::string, group> set;
+            count_unique(set, tokens);
+        });
+
         it("should use linear probing (probe_map)", [&]() {
             hashing::probe_map<std::string, uint64_t, linear> map;
             count(map, tokens);
@@ -395,6 +449,42 @@ go_bandit([]() {
             map.resize_ratio(2.0);
             count(map, tokens);
         });
+
+        it("should use group probing (probe_map)", [&]() {
+            hashing::probe_map<std::string, uint64_t, group> map;
+            count(map, tokens);
+        });
+
+        it("should store keys in an arena (probe_map)", [&]() {
+            hashing::string_arena_map<uint64_t> map;
+            std::unordered_map<std::string, uint64_t> gold;
+            for (const auto& token : tokens) {
+                ++gold[token];
+                ++map[token];
+            }
+
+            AssertThat(map.size(), Equals(gold.size()));
+            for (const auto& pr : map)
+                AssertThat(pr.value(), Equals(gold.at(pr.key().to_string())));
+
+            auto items = std::move(map).extract();
+            AssertThat(items.size(), Equals(gold.size()));
+            for (const auto& pr : items)
+                AssertThat(pr.second, Equals(gold.at(pr.first)));
+        });
+
+        it("should release arena keys on clear (probe_map)", [&]() {
+            hashing::string_arena_map<uint64_t, group> map;
+            for (const auto& token : tokens)
+                ++map[token];
+
+            map.clear();
+            AssertThat(map.empty(), IsTrue());
+            AssertThat(map.find(tokens.front()) == map.end(), IsTrue());
+
+            ++map[tokens.front()];
+            AssertThat(map.at(tokens.front()), Equals(1ul));
+        });
     });
 
     describe("[hashing] probing", []() {
@@ -417,5 +507,48 @@ go_bandit([]() {
 
         it("should visit all slots in the table (quadratic)",
            []() { check_range<hashing::probing::quadratic>(); });
+
+        it("should visit all slots in the table (group)",
+           []() { check_range<hashing::probing::group>(); });
+    });
+
+    describe("[hashing] blocked_bloom_filter", []() {
+
+        const uint64_t num_keys = 10000;
+        hashing::blocked_bloom_filter filter{num_keys};
+        for (uint64_t i = 0; i < num_keys; ++i)
+            filter.insert("key-" + std::to_string(i));
+
+        it("should contain every inserted key", [&]() {
+            AssertThat(filter.size(), Equals(num_keys));
+            for (uint64_t i = 0; i < num_keys; ++i)
+                AssertThat(filter.contains("key-" + std::to_string(i)),
+                           IsTrue());
+        });
+
+        it("should have about the estimated false positive rate", [&]() {
+            auto estimate = filter.false_positive_rate();
+            AssertThat(estimate, IsLessThan(0.02));
+
+            uint64_t false_positives = 0;
+            const uint64_t num_queries = 100000;
+            for (uint64_t i = 0; i < num_queries; ++i)
+                false_positives += filter.contains("oov-" + std::to_string(i));
+            auto rate = static_cast<double>(false_positives) / num_queries;
+            AssertThat(rate, IsLessThan(estimate * 1.5));
+            AssertThat(rate, IsGreaterThan(estimate / 1.5));
+        });
+
+        it("should be the same after saving and loading", [&]() {
+            filter.save("bloom-filter-unit-test.bin");
+            hashing::blocked_bloom_filter loaded{"bloom-filter-unit-test.bin"};
+            AssertThat(loaded.size(), Equals(filter.size()));
+            AssertThat(loaded.bytes_used(), Equals(filter.bytes_used()));
+            for (uint64_t i = 0; i < num_keys; ++i) {
+                auto key = "oov-" + std::to_string(i);
+                AssertThat(loaded.contains(key), Equals(filter.contains(key)));
+            }
+            filesystem::delete_file("bloom-filter-unit-test.bin");
+        });
     });
 });
@@ -7,17 +7,31 @@
 
 #include "bandit/bandit.h"
 #include "meta/caching/all.h"
+#include "meta/hashing/blocked_bloom_filter.h"
 #include "cpptoml.h"
 #include "create_config.h"
 #include "meta/index/inverted_index.h"
 #include "meta/index/postings_data.h"
 #include "meta/io/filesystem.h"
+#include "meta/io/mmap_file.h"
+#include "meta/io/packed.h"
 
 using namespace bandit;
 using namespace meta;
 
 namespace {
 
+/**
+ * Writes the stamp that identifies the vocabulary a term filter or term id
+ * hash was built from, for a vocabulary with the given number of terms
+ * and the size of ceeaus's.
+ */
+void write_stamp(std::ostream& out, uint64_t num_terms) {
+    io::packed::write(out, num_terms);
+    io::packed::write(out,
+                      filesystem::file_size("ceeaus/inv/termids.mapping"));
+}
+
 template <class Index>
 void check_ceeaus_expected(Index& idx) {
     AssertThat(idx.num_docs(), Equals(1008ul));
@@ -98,6 +112,8 @@ go_bandit([]() {
 
         filesystem::remove_all("ceeaus");
         auto line_cfg = tests::create_config("line");
+        auto dict_cfg = tests::create_config("line");
+        dict_cfg->insert("term-dictionary", true);
 
         it("should create the index", [&]() {
             auto idx = index::make_index<index::inverted_index>(*line_cfg);
@@ -113,6 +129,40 @@ go_bandit([]() {
             check_term_id(*idx); // twice to check splay_caching
         });
 
+        it("should only write a term dictionary if asked to", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*line_cfg);
+            AssertThrows(index::disk_index_exception, idx->prefix_terms("a"));
+            auto dictionary = "ceeaus/inv/termids.mapping.fc";
+            AssertThat(filesystem::file_exists(dictionary), IsFalse());
+        });
+
+        it("should find terms by prefix", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*dict_cfg);
+            auto ids = idx->prefix_terms("japan");
+            AssertThat(ids.empty(), IsFalse());
+            std::string prev;
+            for (const auto& t_id : ids) {
+                auto text = idx->term_text(t_id);
+                AssertThat(text, StartsWith("japan"));
+                AssertThat(text, IsGreaterThan(prev));
+                prev = text;
+            }
+            AssertThat(idx->prefix_terms("zzzzzz").empty(), IsTrue());
+        });
+
+        it("should rebuild a missing term dictionary", [&]() {
+            auto expected
+                = index::make_index<index::inverted_index>(*dict_cfg)
+                      ->prefix_terms("japan");
+            auto dictionary = "ceeaus/inv/termids.mapping.fc";
+            filesystem::delete_file(dictionary);
+
+            auto idx = index::make_index<index::inverted_index>(*dict_cfg);
+            check_ceeaus_expected(*idx);
+            AssertThat(idx->prefix_terms("japan"), Equals(expected));
+            AssertThat(filesystem::file_exists(dictionary), IsTrue());
+        });
+
         filesystem::remove_all("ceeaus");
         it("should be able to store full text metadata", [&]() {
             auto docs = corpus::make_corpus(*line_cfg);
@@ -120,6 +170,68 @@ go_bandit([]() {
         });
     });
 
+    describe("[inverted-index] from mmap line config", []() {
+
+        filesystem::remove_all("ceeaus");
+        auto mmap_cfg = tests::create_config("mmap-line");
+
+        // the mmap-line-corpus reads the same files as the line-corpus;
+        // they are copied to a temporary prefix so that its corpus spec
+        // and offsets cache are not left in the data directory
+        auto data_dir = *mmap_cfg->get_as<std::string>("prefix") + "/ceeaus/";
+        const std::string prefix = "meta-tmp-mmap-line";
+        auto corpus_dir = prefix + "/ceeaus/";
+        filesystem::remove_all(prefix);
+        filesystem::make_directories(corpus_dir);
+        for (const std::string name : {"ceeaus.dat", "ceeaus.dat.labels"})
+            filesystem::copy_file(data_dir + name, corpus_dir + name);
+        {
+            auto line_spec = filesystem::file_text(data_dir + "line.toml");
+            auto pos = line_spec.find("line-corpus");
+            line_spec.replace(pos, 0, "mmap-");
+            std::ofstream spec{corpus_dir + "mmap-line.toml"};
+            spec << line_spec;
+        }
+        mmap_cfg->insert("prefix", prefix);
+
+        it("should split into ranges", [&]() {
+            auto docs = corpus::make_corpus(*mmap_cfg);
+            auto ranges = docs->split(4);
+            AssertThat(ranges.size(), Equals(4ul));
+            AssertThat(docs->has_next(), IsFalse());
+
+            doc_id expected{0};
+            for (auto& range : ranges)
+            {
+                while (range->has_next())
+                {
+                    AssertThat(range->next().id(), Equals(expected));
+                    ++expected;
+                }
+            }
+            AssertThat(expected, Equals(doc_id{1008}));
+        });
+
+        it("should create the index", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*mmap_cfg);
+            check_ceeaus_expected(*idx);
+        });
+
+        it("should load the index", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*mmap_cfg);
+            check_ceeaus_expected(*idx);
+            check_term_id(*idx);
+        });
+
+        filesystem::remove_all("ceeaus");
+        it("should be able to store full text metadata", [&]() {
+            auto docs = corpus::make_corpus(*mmap_cfg);
+            check_full_text(*docs, *mmap_cfg);
+        });
+
+        filesystem::remove_all(prefix);
+    });
+
     describe("[inverted-index] with caches", []() {
 
         auto line_cfg = tests::create_config("line");
@@ -146,6 +258,174 @@ go_bandit([]() {
             check_term_id(*idx);
             check_term_id(*idx);
         });
+
+        it("should be able to use tinylfu_cache", [&]() {
+            auto idx = index::make_index<index::inverted_index,
+                                         caching::default_tinylfu_cache>(
+                *line_cfg, uint64_t{1 << 20});
+            check_term_id(*idx);
+            check_term_id(*idx);
+            AssertThat(idx->cache().hits(), Equals(1ul));
+            AssertThat(idx->cache().bytes(),
+                       IsLessThanOrEqualTo(idx->cache().max_bytes()));
+        });
+
+        it("should be able to cache compressed postings", [&]() {
+            using index_type
+                = index::compressed_cached_index<index::inverted_index,
+                                                 caching::default_tinylfu_cache>;
+            auto idx = index::make_index<index_type>(*line_cfg,
+                                                     uint64_t{1 << 20});
+            check_term_id(*idx);
+            check_term_id(*idx);
+            AssertThat(idx->cache().hits(), Equals(1ul));
+
+            // streams must outlive the cache's copy of their bytes
+            auto t_id = idx->get_term_id("japanes");
+            auto stream = idx->stream_for(t_id);
+            idx->clear_cache();
+            AssertThat(stream->size(), Equals(69ul));
+            uint64_t count = 0;
+            for (const auto& pr : *stream)
+                count += pr.second;
+            AssertThat(count, Equals(stream->total_counts()));
+        });
+    });
+
+    describe("[inverted-index] with term-id hash", []() {
+
+        filesystem::remove_all("ceeaus");
+        auto hash_cfg = tests::create_config("line");
+        hash_cfg->insert("term-id-hash", true);
+
+        it("should create the index", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*hash_cfg);
+            check_ceeaus_expected(*idx);
+            check_term_id(*idx);
+        });
+
+        it("should agree with the vocabulary", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*hash_cfg);
+            for (term_id t_id{0}; t_id < idx->unique_terms(); ++t_id)
+                AssertThat(idx->get_term_id(idx->term_text(t_id)),
+                           Equals(t_id));
+            AssertThat(idx->get_term_id("not-a-term-in-ceeaus"),
+                       Equals(term_id{idx->unique_terms()}));
+        });
+
+        it("should rebuild a hash built from another vocabulary", [&]() {
+            {
+                std::ofstream stamp{"ceeaus/inv/termids.mph/vocabulary.stamp",
+                                    std::ios::binary};
+                write_stamp(stamp, 4225);
+            }
+            // loading the hash without rebuilding it would fail
+            filesystem::delete_file("ceeaus/inv/termids.mph/values.bin");
+
+            auto idx = index::make_index<index::inverted_index>(*hash_cfg);
+            for (term_id t_id{0}; t_id < idx->unique_terms(); ++t_id)
+                AssertThat(idx->get_term_id(idx->term_text(t_id)),
+                           Equals(t_id));
+        });
+    });
+
+    describe("[inverted-index] with term bloom filter", []() {
+
+        filesystem::remove_all("ceeaus");
+        auto bloom_cfg = tests::create_config("line");
+        bloom_cfg->insert("term-bloom-filter", true);
+        bloom_cfg->insert("term-dictionary", true);
+
+        it("should create the index", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*bloom_cfg);
+            check_ceeaus_expected(*idx);
+            check_term_id(*idx);
+        });
+
+        it("should agree with the vocabulary", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*bloom_cfg);
+            for (term_id t_id{0}; t_id < idx->unique_terms(); ++t_id)
+                AssertThat(idx->get_term_id(idx->term_text(t_id)),
+                           Equals(t_id));
+            AssertThat(idx->get_term_id("not-a-term-in-ceeaus"),
+                       Equals(term_id{idx->unique_terms()}));
+        });
+
+        it("should rebuild a filter built from another vocabulary", [&]() {
+            {
+                // a filter with no terms in it would reject every term
+                std::ofstream out{"ceeaus/inv/termids.bloom",
+                                  std::ios::binary};
+                write_stamp(out, 4225);
+                hashing::blocked_bloom_filter{1}.save(out);
+            }
+
+            auto idx = index::make_index<index::inverted_index>(*bloom_cfg);
+            for (term_id t_id{0}; t_id < idx->unique_terms(); ++t_id)
+                AssertThat(idx->get_term_id(idx->term_text(t_id)),
+                           Equals(t_id));
+        });
+
+        it("should rebuild the filter with the term dictionary", [&]() {
+            {
+                std::ofstream out{"ceeaus/inv/termids.bloom",
+                                  std::ios::binary};
+                write_stamp(out, 4224);
+                hashing::blocked_bloom_filter{1}.save(out);
+            }
+            filesystem::delete_file("ceeaus/inv/termids.mapping.fc");
+
+            auto idx = index::make_index<index::inverted_index>(*bloom_cfg);
+            for (term_id t_id{0}; t_id < idx->unique_terms(); ++t_id)
+                AssertThat(idx->get_term_id(idx->term_text(t_id)),
+                           Equals(t_id));
+        });
+    });
+
+    describe("[inverted-index] with mmap options", []() {
+
+        filesystem::remove_all("ceeaus");
+        auto mmap_cfg = tests::create_config("line");
+        auto mmap = cpptoml::make_table();
+
+        auto postings = cpptoml::make_table();
+        postings->insert("access", "random");
+        postings->insert("populate", true);
+        mmap->insert("postings", postings);
+
+        auto vocabulary = cpptoml::make_table();
+        vocabulary->insert("access", "sequential");
+        vocabulary->insert("huge-pages", true);
+        mmap->insert("vocabulary", vocabulary);
+
+        auto metadata = cpptoml::make_table();
+        metadata->insert("access", "normal");
+        mmap->insert("metadata", metadata);
+
+        mmap_cfg->insert("mmap", mmap);
+
+        it("should create the index", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*mmap_cfg);
+            check_ceeaus_expected(*idx);
+        });
+
+        it("should load the index", [&]() {
+            auto idx = index::make_index<index::inverted_index>(*mmap_cfg);
+            check_ceeaus_expected(*idx);
+            check_term_id(*idx);
+        });
+
+        it("should reject unknown access patterns", [&]() {
+            auto bad_cfg = tests::create_config("line");
+            auto bad_mmap = cpptoml::make_table();
+            auto bad_postings = cpptoml::make_table();
+            bad_postings->insert("access", "backwards");
+            bad_mmap->insert("postings", bad_postings);
+            bad_cfg->insert("mmap", bad_mmap);
+
+            AssertThrows(io::mmap_file_exception,
+                         index::make_index<index::inverted_index>(*bad_cfg));
+        });
     });
 
     describe("[inverted-index] with zlib", []() {
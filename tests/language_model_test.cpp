@@ -124,9 +124,22 @@ go_bandit([]() {
         it("should read binary files with correct output",
            [&]() { run_test(*line_cfg); });
 
+        it("should reject unknown tokens with a bloom filter", [&]() {
+            auto filter_cfg = tests::create_config("line");
+            filter_cfg->get_table("language-model")->insert("bloom-filter",
+                                                            true);
+            run_test(*filter_cfg);
+
+            lm::language_model model{*filter_cfg};
+            AssertThat(model.index("octopus"), Equals(model.unk()));
+            AssertThat(model.index("statement"),
+                       Is().Not().EqualTo(model.unk()));
+        });
+
         filesystem::delete_file("test-lm-0.binlm");
         filesystem::delete_file("test-lm-1.binlm");
         filesystem::delete_file("test-lm-2.binlm");
         filesystem::delete_file("test-lm-0.strings");
+        filesystem::delete_file("test-lm-0.bloom");
     });
 });
@@ -0,0 +1,87 @@
+/**
+ * @file learn_test_helper.h
+ * @author Chase Geigle
+ *
+ * All files in META are dual-licensed under the MIT and NCSA licenses. For more
+ * details, consult the file LICENSE.mit and LICENSE.ncsa in the root of the
+ * project.
+ */
+
+#ifndef META_TESTS_LEARN_TEST_HELPER_H_
+#define META_TESTS_LEARN_TEST_HELPER_H_
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "meta/meta.h"
+#include "meta/learn/instance.h"
+
+namespace meta
+{
+namespace tests
+{
+
+/**
+ * @param num_vectors The number of vectors to generate
+ * @param num_features The number of distinct features
+ * @return random sparse feature vectors with about twenty nonzero counts
+ * each
+ */
+inline std::vector<learn::feature_vector> make_vectors(uint64_t num_vectors,
+                                                       uint64_t num_features)
+{
+    std::mt19937_64 rng{47};
+    std::uniform_int_distribution<uint64_t> feature_dist{0, num_features - 1};
+    std::uniform_int_distribution<int> count_dist{1, 5};
+
+    std::vector<learn::feature_vector> vectors(num_vectors);
+    for (auto& vec : vectors)
+    {
+        for (int i = 0; i < 20; ++i)
+            vec[term_id{feature_dist(rng)}] += count_dist(rng);
+    }
+    return vectors;
+}
+
+/**
+ * Labels vectors by a random hyperplane through their median score, so
+ * the labels are linearly separable and half of them are positive.
+ *
+ * @param vectors The vectors to label
+ * @param num_features The number of distinct features
+ * @return a label of +1 or -1 for each vector
+ */
+inline std::vector<int>
+make_labels(const std::vector<learn::feature_vector>& vectors,
+            uint64_t num_features)
+{
+    std::mt19937_64 rng{2017};
+    std::normal_distribution<double> weight_dist;
+    std::vector<double> weights(num_features);
+    for (auto& w : weights)
+        w = weight_dist(rng);
+
+    std::vector<double> scores;
+    scores.reserve(vectors.size());
+    for (const auto& vec : vectors)
+    {
+        auto score = 0.0;
+        for (const auto& pr : vec)
+            score += weights[pr.first] * pr.second;
+        scores.push_back(score);
+    }
+
+    auto sorted = scores;
+    auto mid = sorted.begin() + sorted.size() / 2;
+    std::nth_element(sorted.begin(), mid, sorted.end());
+
+    std::vector<int> labels;
+    labels.reserve(scores.size());
+    for (const auto& score : scores)
+        labels.push_back(score >= *mid ? 1 : -1);
+    return labels;
+}
+}
+}
+#endif
@@ -0,0 +1,244 @@
+/**
+ * @file mapped_linear_model_test.cpp
+ * @author Chase Geigle
+ */
+
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include "bandit/bandit.h"
+#include "meta/classify/classifier/all.h"
+#include "meta/classify/classifier_factory.h"
+#include "meta/io/filesystem.h"
+#include "meta/learn/loss/all.h"
+
+using namespace bandit;
+using namespace meta;
+
+namespace
+{
+
+struct example
+{
+    learn::feature_vector features;
+    class_label label;
+};
+
+std::vector<example> make_examples(uint64_t num_examples,
+                                   uint64_t num_features,
+                                   uint64_t num_classes)
+{
+    std::mt19937_64 rng{47};
+    std::uniform_int_distribution<uint64_t> class_dist{0, num_classes - 1};
+    std::uniform_int_distribution<uint64_t> feature_dist{0, num_features - 1};
+    auto per_class = num_features / num_classes;
+    std::uniform_int_distribution<uint64_t> class_feature_dist{0,
+                                                               per_class - 1};
+
+    // each class prefers its own block of features
+    std::vector<example> examples(num_examples);
+    for (auto& ex : examples)
+    {
+        auto cls = class_dist(rng);
+        ex.label = class_label{"class-" + std::to_string(cls)};
+        for (int i = 0; i < 20; ++i)
+        {
+            auto id = i % 2 == 0 ? cls * per_class + class_feature_dist(rng)
+                                 : feature_dist(rng);
+            ex.features[term_id{id}] += 1;
+        }
+    }
+    return examples;
+}
+
+uint64_t count_agreement(const classify::classifier& expected,
+                         const classify::classifier& actual,
+                         const std::vector<example>& examples)
+{
+    uint64_t agree = 0;
+    for (const auto& ex : examples)
+        agree += expected.classify(ex.features)
+                 == actual.classify(ex.features);
+    return agree;
+}
+}
+
+go_bandit([]() {
+
+    describe("[classifier] mapped linear model", []() {
+
+        using namespace classify;
+
+        auto examples = make_examples(1000, 500, 5);
+        multiclass_dataset dset{examples.begin(), examples.end(), 500,
+                                [](const example& ex)
+                                {
+                                    return ex.features;
+                                },
+                                [](const example& ex)
+                                {
+                                    return ex.label;
+                                }};
+
+        auto base = cpptoml::make_table();
+        base->insert("method", sgd::id.to_string());
+        base->insert("loss", learn::loss::hinge::id.to_string());
+        one_vs_all ova{multiclass_dataset_view{dset}, *base};
+
+        const std::string filename = "meta-tmp-test.mlm";
+
+        it("should score like the original model", [&]()
+           {
+               ova.save_mapped(filename);
+               {
+                   mapped_linear_classifier mapped{filename};
+                   AssertThat(mapped.model().classes().size(), Equals(5ul));
+                   AssertThat(mapped.model().num_features(), Equals(500ul));
+
+                   // weights are rounded to floats, so only near-ties may
+                   // come out differently
+                   AssertThat(count_agreement(ova, mapped, examples),
+                              IsGreaterThan(examples.size() * 99 / 100));
+               }
+               filesystem::delete_file(filename);
+           });
+
+        it("should score with float16 weights", [&]()
+           {
+               ova.save_mapped(filename, weight_encoding::float16);
+               {
+                   mapped_linear_classifier mapped{filename};
+                   AssertThat(mapped.model().encoding(),
+                              Equals(weight_encoding::float16));
+                   AssertThat(count_agreement(ova, mapped, examples),
+                              IsGreaterThan(examples.size() * 98 / 100));
+               }
+               filesystem::delete_file(filename);
+           });
+
+        it("should score with int8 weights", [&]()
+           {
+               ova.save_mapped(filename, weight_encoding::int8);
+               {
+                   mapped_linear_classifier mapped{filename};
+                   AssertThat(mapped.model().encoding(),
+                              Equals(weight_encoding::int8));
+                   AssertThat(count_agreement(ova, mapped, examples),
+                              IsGreaterThan(examples.size() * 95 / 100));
+               }
+               filesystem::delete_file(filename);
+           });
+
+        it("should ignore unknown and zero-weight features", [&]()
+           {
+               {
+                   mapped_linear_model_writer writer{
+                       filename, {"a"_cl, "b"_cl}, {0.5, -0.5}};
+                   writer.insert({1.0, -1.0});
+                   writer.insert({0.0, 0.0});
+                   writer.insert({-2.0, 3.0});
+                   writer.finish();
+               }
+               {
+                   mapped_linear_model model{filename};
+                   learn::feature_vector doc;
+                   doc[0_tid] = 1;
+                   doc[1_tid] = 5;
+                   doc[2_tid] = 0.5;
+                   doc[7_tid] = 10;
+
+                   std::vector<double> scores;
+                   model.score(doc, scores);
+                   AssertThat(scores.size(), Equals(2ul));
+                   AssertThat(scores[0], EqualsWithDelta(0.5, 1e-6));
+                   AssertThat(scores[1], EqualsWithDelta(0.0, 1e-6));
+                   AssertThat(model.best_class(doc), Equals("a"_cl));
+               }
+               filesystem::delete_file(filename);
+           });
+
+        it("should keep tiny int8 weights finite", [&]()
+           {
+               {
+                   mapped_linear_model_writer writer{filename,
+                                                     {"a"_cl, "b"_cl},
+                                                     {0.0, 0.0},
+                                                     weight_encoding::int8};
+                   writer.insert({1e-300, -1e-300});
+                   writer.insert({1.0, -1.0});
+                   writer.finish();
+               }
+               {
+                   mapped_linear_model model{filename};
+                   learn::feature_vector doc;
+                   doc[0_tid] = 1;
+                   doc[1_tid] = 1;
+
+                   std::vector<double> scores;
+                   model.score(doc, scores);
+                   AssertThat(scores[0], EqualsWithDelta(1.0, 1e-6));
+                   AssertThat(scores[1], EqualsWithDelta(-1.0, 1e-6));
+               }
+               filesystem::delete_file(filename);
+           });
+
+        it("should save and load through the classifier loader", [&]()
+           {
+               ova.save_mapped(filename);
+               {
+                   std::stringstream ss;
+                   mapped_linear_classifier{filename}.save(ss);
+                   auto loaded = load_classifier(ss);
+                   mapped_linear_classifier mapped{filename};
+                   AssertThat(count_agreement(mapped, *loaded, examples),
+                              Equals(examples.size()));
+               }
+               filesystem::delete_file(filename);
+           });
+
+        it("should delete files that were never finished", [&]()
+           {
+               {
+                   mapped_linear_model_writer writer{
+                       filename, {"a"_cl, "b"_cl}, {0.5, -0.5}};
+                   writer.insert({1.0, -1.0});
+               }
+               AssertThat(filesystem::file_exists(filename), IsFalse());
+           });
+
+        it("should reject files that are not models", [&]()
+           {
+               {
+                   std::ofstream out{filename};
+                   out << std::string(200, 'x');
+               }
+               AssertThrows(mapped_linear_model_exception,
+                            mapped_linear_model{filename});
+               filesystem::delete_file(filename);
+           });
+
+        it("should reject rows past the end of the weights", [&]()
+           {
+               {
+                   mapped_linear_model_writer writer{
+                       filename, {"a"_cl, "b"_cl}, {0.5, -0.5}};
+                   writer.insert({1.0, -1.0});
+                   writer.finish();
+               }
+               {
+                   // point the only feature at a row that does not exist
+                   std::fstream file{filename, std::ios::binary | std::ios::in
+                                                   | std::ios::out};
+                   file.seekg(-static_cast<std::streamoff>(sizeof(uint32_t)),
+                              std::ios::end);
+                   uint32_t row = 1;
+                   file.write(reinterpret_cast<const char*>(&row),
+                              sizeof(row));
+               }
+               AssertThrows(mapped_linear_model_exception,
+                            mapped_linear_model{filename});
+               filesystem::delete_file(filename);
+           });
+    });
+});
@@ -108,5 +108,47 @@ go_bandit([]() {
             filesystem::remove_all("perfect-hash-unit-test");
         });
 
+        it("should generate the same hash for any number of threads", []() {
+            using mph_builder = hashing::perfect_hash_builder<std::string>;
+            using options_type = mph_builder::options;
+
+            auto build = [](const std::string& prefix, std::size_t threads,
+                            uint64_t max_ram) {
+                filesystem::remove_all(prefix);
+
+                options_type options;
+                options.prefix = prefix;
+                options.num_keys
+                    = filesystem::num_lines("../data/lemur-stopwords.txt");
+                options.max_ram = max_ram;
+                options.num_threads = threads;
+
+                mph_builder builder{options};
+                std::ifstream input{"../data/lemur-stopwords.txt"};
+                std::string line;
+                while (std::getline(input, line))
+                    builder(line);
+                builder.write();
+            };
+
+            // a tiny max_ram forces the keys to be split over many chunks
+            build("perfect-hash-unit-test-1", 1, 1024 * 1024);
+            build("perfect-hash-unit-test-4", 4, 4096);
+
+            {
+                hashing::perfect_hash<std::string> mph1{
+                    "perfect-hash-unit-test-1"};
+                hashing::perfect_hash<std::string> mph4{
+                    "perfect-hash-unit-test-4"};
+
+                std::ifstream input{"../data/lemur-stopwords.txt"};
+                std::string line;
+                while (std::getline(input, line))
+                    AssertThat(mph4(line), Equals(mph1(line)));
+            }
+
+            filesystem::remove_all("perfect-hash-unit-test-1");
+            filesystem::remove_all("perfect-hash-unit-test-4");
+        });
     });
 });
@@ -0,0 +1,154 @@
+/**
+ * @file readahead_stream_test.cpp
+ * @author Chase Geigle
+ */
+
+#include <fstream>
+#include <iterator>
+
+#include <zlib.h>
+
+#include "bandit/bandit.h"
+#include "meta/io/filesystem.h"
+#include "meta/io/gzstream.h"
+#if META_HAS_LIBLZMA
+#include "meta/io/xzstream.h"
+#endif
+
+using namespace bandit;
+using namespace meta;
+
+namespace
+{
+
+std::string make_text()
+{
+    std::string text;
+    for (int i = 0; i < 50000; ++i)
+        text += "line " + std::to_string(i) + " of the readahead test\n";
+    return text;
+}
+
+std::string read_all(std::istream& stream)
+{
+    return {std::istreambuf_iterator<char>{stream},
+            std::istreambuf_iterator<char>{}};
+}
+
+void write_le(std::string& out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+/**
+ * Writes text as a BGZF file (as bgzip would), with at most member_size
+ * uncompressed bytes per member, followed by the empty EOF member.
+ */
+void write_bgzf(const std::string& filename, const std::string& text,
+                std::size_t member_size)
+{
+    std::ofstream file{filename, std::ios::binary};
+    for (std::size_t pos = 0; pos <= text.size(); pos += member_size)
+    {
+        auto chunk = text.substr(pos, member_size);
+
+        z_stream stream{};
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS,
+                     8, Z_DEFAULT_STRATEGY);
+        std::string deflated(deflateBound(&stream, chunk.size()), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(&chunk[0]);
+        stream.avail_in = static_cast<uInt>(chunk.size());
+        stream.next_out = reinterpret_cast<Bytef*>(&deflated[0]);
+        stream.avail_out = static_cast<uInt>(deflated.size());
+        deflate(&stream, Z_FINISH);
+        deflated.resize(stream.total_out);
+        deflateEnd(&stream);
+
+        std::string member{"\x1f\x8b\x08\x04", 4};
+        write_le(member, 0, 4); // mtime
+        member.push_back('\0'); // extra flags
+        member.push_back('\xff'); // os
+        write_le(member, 6, 2); // extra length
+        member += "BC";
+        write_le(member, 2, 2);
+        write_le(member, 18 + deflated.size() + 8 - 1, 2);
+        member += deflated;
+        write_le(member,
+                 crc32(0, reinterpret_cast<const Bytef*>(chunk.data()),
+                       static_cast<uInt>(chunk.size())),
+                 4);
+        write_le(member, chunk.size(), 4);
+        file.write(member.data(), static_cast<std::streamsize>(member.size()));
+
+        if (chunk.empty())
+            break;
+    }
+}
+}
+
+go_bandit([]() {
+
+    describe("[readahead] gzip", []() {
+
+        const std::string filename = "meta-tmp-readahead.gz";
+        auto text = make_text();
+
+        it("should read plain gzip files", [&]()
+           {
+               {
+                   io::gzofstream out{filename};
+                   out << text;
+               }
+               {
+                   io::readahead_gzifstream in{filename, 1, 4096};
+                   AssertThat(read_all(in), Equals(text));
+               }
+               filesystem::delete_file(filename);
+           });
+
+        it("should read BGZF files in parallel", [&]()
+           {
+               write_bgzf(filename, text, 65280);
+               for (std::size_t threads : {1, 3})
+               {
+                   io::readahead_gzifstream in{filename, threads, 4096};
+                   AssertThat(read_all(in), Equals(text));
+               }
+               filesystem::delete_file(filename);
+           });
+
+        it("should throw when the file is missing", [&]()
+           {
+               AssertThrows(io::gz_exception,
+                            io::readahead_gzifstream{"meta-tmp-missing.gz"});
+           });
+    });
+
+#if META_HAS_LIBLZMA
+    describe("[readahead] xz", []() {
+
+        const std::string filename = "meta-tmp-readahead.xz";
+        auto text = make_text();
+
+        it("should read xz files", [&]()
+           {
+               {
+                   io::xzofstream out{filename};
+                   out << text;
+               }
+               {
+                   io::readahead_xzifstream in{filename, 4096};
+                   AssertThat(read_all(in), Equals(text));
+               }
+               filesystem::delete_file(filename);
+           });
+
+        it("should throw when the file is missing", [&]()
+           {
+               AssertThrows(io::xz_exception,
+                            io::readahead_xzifstream{"meta-tmp-missing.xz"});
+           });
+    });
+#endif
+});
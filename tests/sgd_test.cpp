@@ -0,0 +1,212 @@
+/**
+ * @file sgd_test.cpp
+ * @author Chase Geigle
+ */
+
+#include <numeric>
+#include <sstream>
+
+#include "bandit/bandit.h"
+#include "learn_test_helper.h"
+#include "meta/classify/binary_dataset_view.h"
+#include "meta/classify/classifier/sgd.h"
+#include "meta/io/packed.h"
+#include "meta/learn/dataset.h"
+#include "meta/learn/loss/hinge.h"
+#include "meta/learn/sgd.h"
+
+using namespace bandit;
+using namespace meta;
+
+go_bandit([]() {
+
+    describe("[learn] sgd_model", []() {
+
+        auto vectors = tests::make_vectors(500, 1000);
+        learn::dataset dset{vectors.begin(), vectors.end(), 1000};
+
+        auto labels = tests::make_labels(vectors, 1000);
+        auto labeler
+            = [&](const learn::instance& inst) { return labels[inst.id]; };
+
+        learn::loss::hinge loss;
+
+        it("should train batches of one like train_one", [&]() {
+            learn::sgd_model expected{1000};
+            learn::sgd_model actual{1000};
+            for (auto it = dset.begin(); it != dset.end(); ++it) {
+                expected.train_one(it->weights, labeler(*it), loss);
+                actual.train_batch(it, it + 1, loss, labeler);
+            }
+
+            for (const auto& inst : dset)
+                AssertThat(actual.predict(inst.weights),
+                           Equals(expected.predict(inst.weights)));
+        });
+
+        it("should train on larger batches", [&]() {
+            learn::sgd_model model{1000};
+            auto total_loss = 0.0;
+            for (int iter = 0; iter < 5; ++iter) {
+                total_loss = 0;
+                for (auto it = dset.begin(); it != dset.end(); it += 50)
+                    total_loss += model.train_batch(it, it + 50, loss, labeler);
+            }
+
+            // the labels are balanced, so check the recall of each class
+            // rather than overall accuracy
+            uint64_t positives = 0;
+            uint64_t true_positives = 0;
+            uint64_t true_negatives = 0;
+            for (const auto& inst : dset) {
+                auto predicted = model.predict(inst.weights) > 0;
+                if (labeler(inst) > 0) {
+                    ++positives;
+                    true_positives += predicted;
+                } else {
+                    true_negatives += !predicted;
+                }
+            }
+            auto negatives = dset.size() - positives;
+            AssertThat(positives, Equals(dset.size() / 2));
+            AssertThat(true_positives, IsGreaterThan(positives * 9 / 10));
+            AssertThat(true_negatives, IsGreaterThan(negatives * 9 / 10));
+            AssertThat(total_loss / dset.size(), IsLessThan(0.5));
+        });
+
+        it("should predict with the average of the weights", [&]() {
+            learn::sgd_model::options_type options;
+            options.averaged = true;
+            learn::sgd_model averaged{1000, options};
+            learn::sgd_model latest{1000};
+
+            // predictions are linear in the weights, so the prediction of
+            // the averaged weights is the average of the predictions
+            std::vector<double> sums(dset.size(), 0.0);
+            for (const auto& inst : dset) {
+                averaged.train_one(inst.weights, labeler(inst), loss);
+                latest.train_one(inst.weights, labeler(inst), loss);
+                for (std::size_t i = 0; i < dset.size(); ++i)
+                    sums[i] += latest.predict(dset(i).weights);
+            }
+
+            for (std::size_t i = 0; i < dset.size(); ++i)
+                AssertThat(averaged.predict(dset(i).weights),
+                           EqualsWithDelta(sums[i] / dset.size(), 1e-6));
+        });
+
+        it("should save and load averaged models", [&]() {
+            learn::sgd_model::options_type options;
+            options.averaged = true;
+            learn::sgd_model model{1000, options};
+            for (const auto& inst : dset)
+                model.train_one(inst.weights, labeler(inst), loss);
+
+            std::stringstream ss;
+            model.save(ss);
+            learn::sgd_model loaded{ss};
+            for (const auto& inst : dset)
+                AssertThat(loaded.predict(inst.weights),
+                           Equals(model.predict(inst.weights)));
+        });
+
+        it("should load models saved before averaging existed", [&]() {
+            std::stringstream ss;
+            io::packed::write(ss, uint64_t{3});
+            for (double weight : {1.0, -2.0, 0.5}) {
+                io::packed::write(ss, weight);
+                io::packed::write(ss, 1.0); // scale
+                io::packed::write(ss, 0.0); // grad_squared
+            }
+            io::packed::write(ss, 0.25); // bias weight
+            io::packed::write(ss, 0.0);  // bias grad_squared
+            io::packed::write(ss, 2.0);  // scale
+            io::packed::write(ss, 0.0);  // update scale
+            io::packed::write(ss, 0.5);  // learning rate
+            io::packed::write(ss, 1e-7); // l2 regularizer
+            io::packed::write(ss, 0.0);  // l1 regularizer
+            io::packed::write(ss, std::size_t{10});
+            auto old_format = ss.str();
+
+            learn::sgd_model model{ss};
+            AssertThat(model.num_features(), Equals(3ul));
+
+            learn::feature_vector doc;
+            doc[0_tid] = 1;
+            doc[2_tid] = 2;
+            AssertThat(model.predict(doc), EqualsWithDelta(4.5, 1e-12));
+
+            // models that are not averaged are still saved the old way
+            std::stringstream out;
+            model.save(out);
+            AssertThat(out.str(), Equals(old_format));
+        });
+
+        it("should predict with the weights it exposes", [&]() {
+            for (bool avg : {false, true}) {
+                learn::sgd_model::options_type options;
+                options.averaged = avg;
+                learn::sgd_model model{1000, options};
+                for (const auto& inst : dset)
+                    model.train_one(inst.weights, labeler(inst), loss);
+
+                AssertThat(model.num_features(), Equals(1000ul));
+                for (const auto& inst : dset) {
+                    auto expected = model.bias();
+                    for (const auto& pr : inst.weights)
+                        expected += model.weight(pr.first) * pr.second;
+                    AssertThat(model.predict(inst.weights),
+                               EqualsWithDelta(expected, 1e-9));
+                }
+            }
+        });
+
+        it("should not train averaged models with hogwild", [&]() {
+            learn::sgd_model::options_type options;
+            options.averaged = true;
+            learn::sgd_model model{1000, options};
+            parallel::thread_pool pool{2};
+            AssertThrows(std::logic_error,
+                         model.train_hogwild(dset, loss, labeler, pool));
+        });
+
+        it("should train averaged classifiers from one thread", [&]() {
+            // enough instances that a pool would otherwise be used
+            auto train_vectors = tests::make_vectors(2000, 1000);
+            auto train_labels = tests::make_labels(train_vectors, 1000);
+            std::vector<std::size_t> ids(train_vectors.size());
+            std::iota(ids.begin(), ids.end(), 0);
+            classify::binary_dataset bdset{
+                ids.begin(), ids.end(), 1000,
+                [&](std::size_t id) { return train_vectors[id]; },
+                [&](std::size_t id) { return train_labels[id] > 0; }};
+
+            // every view shuffles the same way
+            auto view = [&]() {
+                return classify::binary_dataset_view{bdset,
+                                                     std::mt19937_64{47}};
+            };
+
+            learn::sgd_model::options_type options;
+            options.averaged = true;
+            parallel::thread_pool pool{2};
+            classify::sgd pooled{view(), make_unique<learn::loss::hinge>(),
+                                 options, pool};
+            classify::sgd threaded{view(), make_unique<learn::loss::hinge>(),
+                                   options,
+                                   classify::sgd::default_gamma,
+                                   classify::sgd::default_max_iter,
+                                   false,
+                                   2};
+            classify::sgd serial{view(), make_unique<learn::loss::hinge>(),
+                                 options};
+
+            for (const auto& inst : bdset) {
+                AssertThat(pooled.predict(inst.weights),
+                           Equals(serial.predict(inst.weights)));
+                AssertThat(threaded.predict(inst.weights),
+                           Equals(serial.predict(inst.weights)));
+            }
+        });
+    });
+});
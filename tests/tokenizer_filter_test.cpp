@@ -179,6 +179,26 @@ go_bandit([]() {
                    "inform", "retrieval,", "stem"};
             check_expected(*norm, expected);
         });
+
+        it("should produce the same stems from its cache", [&]() {
+            auto tok = make_unique<tokenizers::whitespace_tokenizer>();
+            auto norm = make_unique<filters::porter2_filter>(std::move(tok));
+            norm->set_content("stemming stemming stemming");
+            std::vector<std::string> expected = {"stem", "stem", "stem"};
+            check_expected(*norm, expected);
+            AssertThat(norm->cache().hits(), Equals(2ul));
+            AssertThat(norm->cache().misses(), Equals(1ul));
+        });
+
+        it("should work without a cache", [&]() {
+            auto tok = make_unique<tokenizers::whitespace_tokenizer>();
+            auto norm
+                = make_unique<filters::porter2_filter>(std::move(tok), 0);
+            norm->set_content("stemming stemming");
+            std::vector<std::string> expected = {"stem", "stem"};
+            check_expected(*norm, expected);
+            AssertThat(norm->cache().hits(), Equals(0ul));
+        });
     });
 
     describe("[tokenizer-filter] ptb_normalizer", [&]() {
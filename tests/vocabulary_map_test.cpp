@@ -9,6 +9,8 @@
 #include "bandit/bandit.h"
 #include "meta/io/binary.h"
 #include "meta/io/filesystem.h"
+#include "meta/index/front_coded_vocabulary.h"
+#include "meta/index/front_coded_vocabulary_writer.h"
 #include "meta/index/vocabulary_map_writer.h"
 #include "meta/index/vocabulary_map.h"
 #include "meta/util/disk_vector.h"
@@ -103,6 +105,54 @@ void read_file(uint16_t size) {
     AssertThat(static_cast<bool>(map.find("zabawe")), IsFalse());
     AssertThat(map.size(), Equals(14ul));
 }
+
+void check_front_coded(uint64_t bucket_size) {
+    std::vector<std::string> terms
+        = {"apple", "application", "apply", "banana", "band", "bandana",
+           "bandit", "can", "candle", "candy", "cane", "zebra"};
+    {
+        index::front_coded_vocabulary_writer writer{"meta-tmp-test.fc",
+                                                    bucket_size};
+        for (const auto& term : terms)
+            writer.insert(term);
+    }
+
+    index::front_coded_vocabulary vocab{"meta-tmp-test.fc"};
+    AssertThat(vocab.size(), Equals(terms.size()));
+
+    term_id t_id{0};
+    for (auto it = vocab.begin(); it != vocab.end(); ++it, ++t_id) {
+        AssertThat(*it, Equals(terms[t_id]));
+        AssertThat(it.id(), Equals(t_id));
+        AssertThat(vocab.find_term(t_id), Equals(terms[t_id]));
+        auto found = vocab.find(terms[t_id]);
+        AssertThat(static_cast<bool>(found), IsTrue());
+        AssertThat(*found, Equals(t_id));
+    }
+    AssertThat(t_id, Equals(terms.size()));
+
+    AssertThat(static_cast<bool>(vocab.find("a")), IsFalse());
+    AssertThat(static_cast<bool>(vocab.find("bandanas")), IsFalse());
+    AssertThat(static_cast<bool>(vocab.find("zzz")), IsFalse());
+
+    AssertThat(vocab.lower_bound("a").id(), Equals(0_tid));
+    AssertThat(*vocab.lower_bound("b"), Equals("banana"));
+    AssertThat(*vocab.lower_bound("bandb"), Equals("bandit"));
+    AssertThat(*vocab.lower_bound("cane"), Equals("cane"));
+    AssertThat(vocab.lower_bound("zzz") == vocab.end(), IsTrue());
+
+    std::vector<std::string> found;
+    auto range = vocab.prefix_range("band");
+    for (auto it = range.first; it != range.second; ++it)
+        found.push_back(*it);
+    AssertThat(found, Equals(std::vector<std::string>{"band", "bandana",
+                                                      "bandit"}));
+
+    range = vocab.prefix_range("dog");
+    AssertThat(range.first == range.second, IsTrue());
+
+    filesystem::delete_file("meta-tmp-test.fc");
+}
 }
 
 go_bandit([]() {
@@ -129,4 +179,27 @@ go_bandit([]() {
             read_file(23);
         });
     });
+
+    describe("[front-coded-vocabulary]", []() {
+
+        it("should read single-term buckets", []() { check_front_coded(1); });
+
+        it("should read partial buckets", []() { check_front_coded(5); });
+
+        it("should read a single bucket", []() { check_front_coded(16); });
+
+        it("should reject terms out of order", []() {
+            {
+                index::front_coded_vocabulary_writer writer{
+                    "meta-tmp-test.fc"};
+                writer.insert("banana");
+                AssertThrows(index::vocabulary_map_writer_exception,
+                             writer.insert("apple"));
+                AssertThrows(index::vocabulary_map_writer_exception,
+                             writer.insert("banana"));
+                writer.insert("cherry");
+            }
+            filesystem::delete_file("meta-tmp-test.fc");
+        });
+    });
 });